@@ -0,0 +1,62 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcBinCtrlObj.h
+
+#ifndef UFXCBINCTRLOBJ_H
+#define UFXCBINCTRLOBJ_H
+
+#include "lima/Debug.h"
+#include "UfxcCompatibility.h"
+#include "lima/HwBinCtrlObj.h"
+
+namespace lima
+{
+  namespace Ufxc
+  {
+    class Camera;
+
+    /*******************************************************************
+     * \class BinCtrlObj
+     * \brief Control object providing the Ufxc hardware binning applied by the fill workers
+     *******************************************************************/
+
+    class LIBUFXC_API BinCtrlObj: public HwBinCtrlObj
+    {
+    DEB_CLASS_NAMESPC(DebModCamera, "BinCtrlObj", "Ufxc");
+
+    public:
+    	BinCtrlObj(Camera& cam);
+    	virtual ~BinCtrlObj();
+
+    	virtual void setBin(const Bin& bin);
+    	virtual void getBin(Bin& bin);
+    	virtual void checkBin(Bin& bin);
+
+    private:
+    	Camera& m_cam;
+    };
+
+  } // namespace Ufxc
+} // namespace lima
+
+#endif // UFXCBINCTRLOBJ_H
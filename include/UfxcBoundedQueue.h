@@ -0,0 +1,170 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcBoundedQueue.h
+// Bounded multi-producer/multi-consumer lock-free queue (D. Vyukov's
+// sequence-numbered ring) used between the acquisition pipeline stages.
+
+#ifndef UFXCBOUNDEDQUEUE_H_
+#define UFXCBOUNDEDQUEUE_H_
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class BoundedQueue
+ * \brief fixed capacity lock-free queue, capacity is rounded up to a
+ *        power of two. push/pop never block, they return false when
+ *        the queue is full/empty.
+ *******************************************************************/
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t capacity = 2)
+    {
+        resize(capacity);
+    }
+
+    // not thread safe, only call it when no producer/consumer is running
+    void resize(std::size_t capacity)
+    {
+        std::size_t size = 2;
+
+        while(size < capacity)
+            size <<= 1;
+
+        std::vector<Cell> cells(size);
+        m_cells.swap(cells);
+        m_mask = size - 1;
+
+        for(std::size_t index = 0 ; index < size ; index++)
+            m_cells[index].sequence.store(index, std::memory_order_relaxed);
+
+        m_enqueue_pos.store(0, std::memory_order_relaxed);
+        m_dequeue_pos.store(0, std::memory_order_relaxed);
+    }
+
+    std::size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    bool push(const T& data)
+    {
+        Cell *      cell;
+        std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+
+        for(;;)
+        {
+            cell = &m_cells[pos & m_mask];
+            std::size_t seq  = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if(diff == 0)
+            {
+                if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else
+            if(diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = data;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& data)
+    {
+        Cell *      cell;
+        std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+
+        for(;;)
+        {
+            cell = &m_cells[pos & m_mask];
+            std::size_t seq  = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if(diff == 0)
+            {
+                if(m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else
+            if(diff < 0)
+            {
+                return false; // empty
+            }
+            else
+            {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        data = cell->data;
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return (m_enqueue_pos.load(std::memory_order_acquire) == m_dequeue_pos.load(std::memory_order_acquire));
+    }
+
+private:
+    struct Cell
+    {
+        Cell() : sequence(0) {}
+        Cell(const Cell& other) : sequence(other.sequence.load()), data(other.data) {}
+
+        std::atomic<std::size_t> sequence;
+        T                        data    ;
+    };
+
+    // producers and consumers work on separate cache lines
+    std::vector<Cell>        m_cells;
+    std::size_t              m_mask ;
+    char                     m_pad0[64];
+    std::atomic<std::size_t> m_enqueue_pos;
+    char                     m_pad1[64];
+    std::atomic<std::size_t> m_dequeue_pos;
+    char                     m_pad2[64];
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCBOUNDEDQUEUE_H_ */
@@ -31,6 +31,23 @@
 #include <ostream>
 #include <map>
 #include "UfxcCompatibility.h"
+#include "UfxcFramePipeline.h"
+#include "UfxcWaitStrategy.h"
+#include "UfxcPlacement.h"
+#include "UfxcReorderWindow.h"
+#include "UfxcStatusBlock.h"
+#include "UfxcRegisterCache.h"
+#include "UfxcRegisterBatch.h"
+#include "UfxcPixelUnpacker.h"
+#include "UfxcGeometryRemap.h"
+#include "UfxcFrameAccumulator.h"
+#include "UfxcFrameBinRoi.h"
+#include "UfxcPixelCorrection.h"
+#include "UfxcProbeChannels.h"
+#include "UfxcDetectorBackend.h"
+#include "UfxcDetectorSimulator.h"
+#include "UfxcCaptureBackend.h"
+#include "UfxcReplayBackend.h"
 #include "lima/HwBufferMgr.h"
 #include "lima/HwInterface.h"
 #include "lima/HwEventCtrlObj.h"
@@ -88,6 +105,20 @@ public:
         SelectDefault    ,
     };
 
+    // conversion of the raw counting modes into Lima pixels
+    enum PixelDecoding
+    {
+        SdkDecoding   , // ufxclib fills the Lima buffers
+        PluginDecoding, // the fill workers unpack the raw frames (simulator only, ufxclib gives no raw frames)
+    };
+
+    // where the geometrical correction is done
+    enum GeometricalCorrectionEngine
+    {
+        SdkCorrection   , // ufxclib corrects the images
+        PluginCorrection, // the fill workers apply a precomputed remap table
+    };
+
     //==================================================================
     // constructor
     Camera( const std::string&  Ufxc_Model     ,                            //- Detector model (label) 
@@ -98,7 +129,10 @@ public:
             unsigned long       SFP_MTU        ,                            //- MTU value of the SFP ports
             unsigned long       timeout_ms     ,                            //- timeout in ms
             unsigned long       pixel_depth    ,                            //- pixel depth from the generic device properties
-            std::string         counting_mode  );                           //- counting mode from the specific properties
+            std::string         counting_mode  ,                            //- counting mode from the specific properties
+            const ThreadPlacement& acq_thread_placement     = ThreadPlacement(), //- cpus and scheduling of the acquisition thread
+            const ThreadPlacement& helper_threads_placement = ThreadPlacement(), //- cpus and scheduling of the pipeline threads
+            int                 numa_node      = -1 );                      //- NUMA node of the Lima buffers (-1: node of the SFP interface)
 
     virtual ~Camera();
 
@@ -108,6 +142,7 @@ public:
     void startAcq();
     void stopAcq();
     void getStatus(Camera::Status& status);
+    void getStatus(Camera::Status& status, double& age); // age (s) of the cached detector status
     int  getNbHwAcquiredFrames();
 
     // -- detector info object
@@ -141,6 +176,76 @@ public:
     void getNbFrames(int& nb_frames);
 
     bool is_thread_running();
+    void getStatusSnapshot(StatusSnapshot& snapshot); // lock free, for the pollers
+    void setStatusRefreshPeriod(double period_ms); // detector status read by the status monitor
+    void getStatusRefreshPeriod(double& period_ms);
+
+    //-- acquisition pipeline
+    void setNbFillWorkers(int nb_workers);
+    void getNbFillWorkers(int& nb_workers);
+
+    //-- Lima buffers number recommended to the control layer (applied before prepareAcq)
+    void setBufferLatencyTolerance(double latency); // time (s) the consumers can be late
+    void getBufferLatencyTolerance(double& latency);
+    void setBufferMemoryBudget(double memory_mb);    // max memory (MB) of the Lima buffers
+    void getBufferMemoryBudget(double& memory_mb);
+    void getRecommendedBufferSizing(int& nb_buffers, double& memory_mb); // current settings and image
+
+    //-- wait for the SDK built images
+    void setWaitPolicy(WaitStrategy::Policy policy);
+    void getWaitPolicy(WaitStrategy::Policy& policy);
+    void getEffectiveWaitPolicy(WaitStrategy::Policy& policy);
+    void setWaitSpinBudget(double spin_budget_us);
+    void getWaitSpinBudget(double& spin_budget_us);
+    void getMeasuredFramePeriod(double& frame_period_ms);
+
+    //-- threads and Lima buffers placement (used at the next acquisition)
+    void setAcqThreadPlacement(const ThreadPlacement& placement);
+    void getAcqThreadPlacement(ThreadPlacement& placement);
+    void setHelperThreadsPlacement(const ThreadPlacement& placement);
+    void getHelperThreadsPlacement(ThreadPlacement& placement);
+    void setNumaNode(int numa_node); // -1: node of the SFP network interface
+    void getNumaNode(int& numa_node); // effective node, -1 if unknown
+    void getPlacementReport(std::string& report);
+
+    //-- images placed by their hardware index, missing ones replaced by blank frames
+    void setReorderWindowSize(int nb_frames);
+    void getReorderWindowSize(int& nb_frames);
+    void setReorderTimeout(double timeout_ms);
+    void getReorderTimeout(double& timeout_ms);
+    void getNbLostFrames(int& nb_frames);
+    void getLostFrames(std::vector<int>& lost_frames); // first lost frames of the acquisition
+    void getNbDroppedFrames(int& nb_frames);
+
+    //-- shadow copy of the DAQ registers
+    void setRegisterCacheEnabled(bool enabled);
+    void getRegisterCacheEnabled(bool& enabled);
+    void getRegisterCacheStats(unsigned long& nb_hits, unsigned long& nb_misses);
+    void resyncFromHardware(); // after a change done outside of the plugin
+
+    //-- acquisition registers written at prepareAcq
+    void setDeferredRegisterWrites(bool enabled);
+    void getDeferredRegisterWrites(bool& enabled);
+    void getRegisterWritesStats(unsigned long& nb_writes, unsigned long& nb_skipped_writes);
+    void getLastPrepareTime(double& prepare_time, double& commit_time, int& nb_writes); // s
+    void getPrepareTimeStats(double& mean_time, double& max_time, unsigned long& nb_prepares); // s
+    void resetPrepareTimeStats();
+
+    //-- decoding of the raw counting modes (used at the next prepareAcq)
+    void setPixelDecoding(PixelDecoding decoding);
+    void getPixelDecoding(PixelDecoding& decoding);
+    void setPixelUnpackerKernel(PixelUnpacker::Kernel kernel);
+    void getPixelUnpackerKernel(PixelUnpacker::Kernel& kernel);
+    void getEffectivePixelUnpackerKernel(PixelUnpacker::Kernel& kernel);
+    void runPixelUnpackerBenchmark(int nb_frames, std::string& report); // each counting mode and kernel
+
+    //-- hardware roi (in the binned image) and binning done by the fill workers
+    void checkRoi(const Roi& set_roi, Roi& hw_roi);
+    void setRoi(const Roi& set_roi);
+    void getRoi(Roi& hw_roi);
+    void checkBin(Bin& bin);
+    void setBin(const Bin& bin);
+    void getBin(Bin& bin);
     
     ///////////////////////////////
     // -- ufxc specific functions
@@ -165,6 +270,52 @@ public:
     void getCountingMode(CountingModes& mode);
     void setGeometricalCorrection(bool enabled);
     void getGeometricalCorrection(bool& enabled);
+    void setGeometricalCorrectionEngine(GeometricalCorrectionEngine engine);
+    void getGeometricalCorrectionEngine(GeometricalCorrectionEngine& engine);
+    void setChipLayout(const ChipLayout& layout); // used by the plugin correction
+    void getChipLayout(ChipLayout& layout);
+    void setPackedPixelOutput(bool enabled); // Continuous_2/4 counters packed in Bpp8 frames
+    void getPackedPixelOutput(bool& enabled);
+    void unpackFrame(const void * packed_frame, void * pixels); // one byte per pixel
+    void setAccumulationNbFrames(int nb_frames); // Continuous_2/4/8 frames summed in a Lima frame (1: off)
+    void getAccumulationNbFrames(int& nb_frames);
+    void setAccumulationImageType(ImageType type); // Bpp16 or Bpp32
+    void getAccumulationImageType(ImageType& type);
+    void setSparseOutput(bool enabled); // low occupancy frames given as photon events records
+    void getSparseOutput(bool& enabled);
+    void setSparseOccupancyThreshold(double threshold); // max fraction of non zero pixels of a sparse record
+    void getSparseOccupancyThreshold(double& threshold);
+    void getSparseOutputStats(unsigned long& nb_sparse_frames, unsigned long& nb_dense_frames);
+    void decodeSparseFrame(const void * record, void * pixels); // pixels of the counting mode image
+    void setCompressionCodec(FrameCompressor::Codec codec); // frames compressed in the Lima buffers
+    void getCompressionCodec(FrameCompressor::Codec& codec);
+    void getCompressionStats(double& ratio, double& mean_frame_time, unsigned long& nb_frames); // time in s
+    void decompressFrame(const void * record, void * frame); // frame before the compression
+    void setPixelCorrectionEnabled(bool enabled); // pixel mask and flat-field applied by the fill workers
+    void getPixelCorrectionEnabled(bool& enabled);
+    void setPixelCorrectionPath(const std::string& directory); // directory of the <model>_<W>x<H>.mask/.flat files
+    void getPixelCorrectionPath(std::string& directory);
+    void reloadPixelCorrection(); // the files are read again at the next prepareAcq
+    void getPixelCorrectionNbMaskedPixels(int& nb_pixels);
+    void setProbeChannelsOutput(bool enabled); // PumpProbeProbe_32 probes split in two images of a Bpp16 frame
+    void getProbeChannelsOutput(bool& enabled);
+    void getProbeChannelView(const void * frame, int channel, ProbeChannels::View& view); // no copy
+    void setFrameStatisticsEnabled(bool enabled); // sum, max, saturated pixels and histogram of each frame
+    void getFrameStatisticsEnabled(bool& enabled);
+    void setFrameStatisticsSaturation(uint32_t level); // 0: max value of the counters
+    void getFrameStatisticsSaturation(uint32_t& level);
+    void getFrameStatistics(int acq_frame_nb, FrameStats& stats); // the frame must be in the ring
+    void readFrameStatistics(int first_frame_nb, int max_nb_frames, std::vector<FrameStats>& stats); // consecutive frames in the ring
+    void setCaptureFile(const std::string& file_name); // frames and register writes of the next acquisitions, empty: no capture
+    void getCaptureFile(std::string& file_name);
+    void getCaptureStats(unsigned long& nb_frames, unsigned long& nb_dropped, double& size_mb); // dropped: capture queue full
+    void setReplaySpeed(double speed); // REPLAY model: 1 captured rate, 0 as fast as possible
+    void getReplaySpeed(double& speed);
+    void setSimulatorTransactionTime(double time_ms); // SIMULATOR models: round trip of a DAQ transaction
+    void getSimulatorTransactionTime(double& time_ms);
+    void getSimulatorTransactionStats(unsigned long& nb_reads, unsigned long& nb_writes);
+    void resetSimulatorTransactionStats();
+    void getSimulatorAcquisitionTiming(double& start_time, double& image_period); // SIMULATOR models: last acquisition
     TrigMode getDefaultTrigMode() const;
     std::string getTrigLabel(TrigMode& mode) const;
 
@@ -190,22 +341,55 @@ public:
 private:
     //get frame from API/Driver/etc ...
     bool readFrames(void);
+    void abortReadFrames(); // readFrames error: the pushed frames are published, the plugin unregistered
+    void pushLostFrame(int frame_index);
+    void pushAccumulatedFrame(int frame_index, const void * frame);
     void setStatus(Camera::Status status, bool force);
+    void refreshDetectorStatus();
+    double readRegister(RegisterCache::Key key) const;
+    double readHardwareRegister(RegisterCache::Key key) const;
+    void setRegister(RegisterBatch::Register reg, double value);
+    void applyGeometricalCorrection(bool enabled);
+    bool usePluginCorrection() const;
+    void updateGeometryRemap();
+    bool usePackedOutput() const;
+    int  getAccumulationFactor() const;
+    bool useSparseOutput() const;
+    bool useCompression() const;
+    bool useProbeChannelsOutput() const;
+    uint32_t getStatisticsSaturationLevel();
+    Size getFrameContentSize() const;
+    int  getFramePixelSize() const;
+    bool useHwBinRoi() const;
+    bool isHwBinRoiSupported() const;
+    bool isHwBinSupported() const;
+    Roi  getFullBinnedRoi() const;
+    Size getSdkImageSize() const;
+    Size getPixelImageSize() const;
+    int  commitRegisters() const;
+    bool commitRegister(RegisterBatch::Register reg) const;
+    void writeHardwareRegister(RegisterBatch::Register reg, double value) const;
+    void computeBufferSizing(int& nb_buffers, double& memory_mb); // with the camera lock
+    void checkBufferPool();
+    void bindFrameBuffers();
+    void updateNumaNode();
     void internalStopAcq(); // called only by the acquisition thread
     //////////////////////////////
     // -- ufxc specific members
     //////////////////////////////
     void SetHardwareRegisters();
+    void releaseBackend(); // closes the connection and deletes the backends
 
     class AcqThread;
+    class StatusMonitorThread;
 
     AcqThread *         m_acq_thread;
+    StatusMonitorThread * m_status_monitor;
     TrigMode            m_trigger_mode;
     double              m_exp_time;
     double              m_lat_time;
     ImageType           m_image_type;
     int                 m_nb_frames; // nos of frames to acquire
-    bool                m_thread_running;
     bool                m_wait_flag;
     bool                m_quit;
     int                 m_acq_frame_nb; // nb of frames acquired
@@ -213,12 +397,20 @@ private:
     long                m_depth; // depth value can be 2/4/8/14/28/32
     int                 m_pump_probe_nb_frames;
     bool                m_is_geometrical_correction_enabled;    
-    Camera::Status      m_status;
+    StatusBlock         m_status_block; // status and counters read without the lock
 
     Camera::CountingModes m_counting_mode;
 
-    // UFXC lib main object
-    ufxclib::UFXCInterface* m_ufxc_interface;
+    // UFXC lib main object, or the simulator
+    DetectorBackend*    m_ufxc_interface;
+    CaptureBackend*     m_capture_backend; // m_ufxc_interface recording its calls, NULL with a replay
+    ReplayBackend*      m_replay_backend;  // m_ufxc_interface with a REPLAY model
+    DetectorSimulator*  m_simulator;       // backend of the capture with a SIMULATOR model
+    // shadow copy of the registers read through ufxclib
+    mutable RegisterCache   m_register_cache;
+    // acquisition registers not yet written
+    mutable RegisterBatch   m_register_batch;
+    bool                    m_deferred_register_writes;
     // Registers configuration
     std::map<ufxclib::EnumAcquisitionConfigKey, std::string> m_acquisition_registers;
     std::map<ufxclib::EnumDetectorConfigKey, std::string> m_detector_registers;
@@ -245,6 +437,80 @@ private:
     // Lima event control object
     HwEventCtrlObj      m_event_ctrl_obj;
 
+    // receive/fill/publish pipeline fed by the acquisition thread
+    FramePipeline *     m_frame_pipeline;
+
+    // wait policy of the acquisition thread
+    WaitStrategy        m_wait_strategy;
+
+    // reorder of the received images, gap filling
+    ReorderWindow       m_reorder_window;
+    std::vector<char>   m_drop_buffer;              // receives the dropped images
+
+    // Lima buffers sizing recommendation
+    double              m_buffer_latency_tolerance; // s
+    double              m_buffer_memory_budget;     // MB
+
+    // threads and Lima buffers placement
+    ThreadPlacement     m_acq_thread_placement;
+    bool                m_acq_thread_placement_changed;
+    std::string         m_acq_thread_effective_placement;
+    ThreadPlacement     m_helper_threads_placement;
+    int                 m_numa_node_config;         // -1: node of the SFP network interface
+    int                 m_numa_node;                // effective node, -1 if unknown
+    std::string         m_sfp_ip_address;
+    std::string         m_sfp_interface_name;
+    std::vector<void *> m_bound_frame_buffers;      // Lima buffers already moved on m_bound_numa_node
+    int                 m_bound_numa_node;
+    int                 m_bound_frame_mem_size;
+
+    // prepareAcq dead time (s)
+    double              m_prepare_time;
+    double              m_prepare_commit_time;
+    int                 m_prepare_nb_writes;
+    double              m_prepare_total_time;
+    double              m_prepare_max_time;
+    unsigned long       m_nb_prepares;
+
+    // decoding of the raw counting modes
+    PixelDecoding       m_pixel_decoding;
+    PixelUnpacker       m_pixel_unpacker;
+
+    // plugin side geometrical correction
+    GeometricalCorrectionEngine m_geometrical_correction_engine;
+    ChipLayout          m_chip_layout;
+    GeometryRemap       m_geometry_remap;           // rebuilt when the image format changes
+
+    // 2/4 bits counters packed in the Lima buffers
+    bool                m_packed_pixel_output;
+
+    // sum of the continuous modes frames in the Lima buffers
+    FrameAccumulator    m_frame_accumulator;
+
+    // photon events records of the low occupancy frames
+    SparseEncoder       m_sparse_encoder;
+    bool                m_sparse_output;
+
+    // lossless compression of the Lima frames
+    FrameCompressor     m_frame_compressor;
+
+    // hardware binning and roi
+    Bin                 m_hw_bin;
+    Roi                 m_hw_roi;                   // empty: the whole binned image
+    FrameBinRoi         m_frame_bin_roi;
+
+    // probe counters of the pump-probe-probe frames in two images
+    bool                m_probe_channels_output;
+
+    // online statistics of the frames
+    bool                m_frame_statistics_enabled;
+    uint32_t            m_frame_statistics_saturation; // 0: max value of the counters
+
+    // pixel mask and flat-field
+    bool                m_pixel_correction_enabled;
+    std::string         m_pixel_correction_path;
+    PixelCorrection     m_pixel_correction;         // rebuilt when the files or the image format change
+
     // for the dynamic change of size or/and pixel depth
     #define UFXCCAMERA_USE_DYNAMIC_COUNTING_MODE_CHANGE
 
@@ -269,6 +535,30 @@ private:
     Camera& m_cam;
 } ;
 
+/*******************************************************************
+ * \class StatusMonitorThread
+ * \brief Thread reading the detector status at a fixed period
+ *******************************************************************/
+class Camera::StatusMonitorThread : public Thread
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "Camera", "StatusMonitorThread");
+public:
+    StatusMonitorThread(Camera &aCam, double period);
+    virtual ~StatusMonitorThread();
+
+    void   setPeriod(double period); // s
+    double getPeriod();
+
+protected:
+    virtual void threadFunction();
+
+private:
+    Camera& m_cam;
+    Cond    m_cond;
+    double  m_period;
+    bool    m_quit;
+} ;
+
 } // namespace Ufxc
 } // namespace lima
 
@@ -0,0 +1,176 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcCaptureBackend.h
+
+#ifndef UFXCCAPTUREBACKEND_H_
+#define UFXCCAPTUREBACKEND_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "UfxcDetectorBackend.h"
+#include "UfxcCaptureFormat.h"
+#include "UfxcBoundedQueue.h"
+#include "lima/ThreadUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class CaptureBackend
+ * \brief records the acquisitions of another backend
+ *
+ * Forwards all the calls to the backend it owns. When a capture file
+ * is set, the register writes, the acquisition starts and stops and
+ * the frames given to the camera (with their hardware index and time)
+ * are written in the file, for the ReplayBackend.
+ * The frames are recorded as the camera asks them: raw bit streams
+ * with the plugin decoding, decoded images with the SDK decoding.
+ * The acquisition thread only copies the frames in a bounded queue,
+ * a writer thread encodes and writes them: a frame is not captured
+ * (capture drop) when the queue is full, the acquisition is not slowed.
+ * A write error stops the capture, not the acquisition.
+ *******************************************************************/
+class LIBUFXC_API CaptureBackend : public DetectorBackend
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "CaptureBackend", "Ufxc");
+
+public:
+    explicit CaptureBackend(DetectorBackend * backend); // owned
+    virtual ~CaptureBackend();
+
+    // a new file is truncated, empty: no capture
+    void        setCaptureFile(const std::string& file_name);
+    std::string getCaptureFile() const;
+    void        getCaptureStats(unsigned long& nb_frames, unsigned long& nb_dropped, double& size_mb) const; // since the file was set
+
+    virtual void open_connection(const std::string& model,
+                                 const ufxclib::DaqCnxConfig& tcp_cnx , const ufxclib::DaqCnxConfig& sfp1_cnx,
+                                 const ufxclib::DaqCnxConfig& sfp2_cnx, const ufxclib::DaqCnxConfig& sfp3_cnx,
+                                 unsigned long sfp_mtu);
+    virtual void close_connection();
+    virtual void set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& names);
+    virtual void set_detector_registers_names   (const std::map<ufxclib::EnumDetectorConfigKey   , std::string>& names);
+    virtual void set_monitoring_registers_names (const std::map<ufxclib::EnumMonitoringKey       , std::string>& names);
+    virtual void set_detector_config_file(const std::string& file_name);
+
+    virtual std::string   get_detector_name();
+    virtual std::string   get_detector_type();
+    virtual std::string   get_lib_version();
+    virtual std::string   get_firmware_version();
+    virtual unsigned long get_detector_temp();
+    virtual ufxclib::EnumDetectorStatus get_detector_status();
+
+    virtual void        set_acq_mode(ufxclib::EnumAcquisitionMode mode);
+    virtual void        set_counting_time_ms(double time_ms);
+    virtual double      get_counting_time_ms();
+    virtual void        set_waiting_time_ms(double time_ms);
+    virtual double      get_waiting_time_ms();
+    virtual void        set_images_number(std::size_t images_number);
+    virtual std::size_t get_images_number();
+    virtual void        set_triggers_number(std::size_t triggers_number);
+    virtual std::size_t get_triggers_number();
+    virtual void        set_low_1_threshold (float threshold);
+    virtual double      get_low_1_threshold ();
+    virtual void        set_low_2_threshold (float threshold);
+    virtual double      get_low_2_threshold ();
+    virtual void        set_high_1_threshold(float threshold);
+    virtual double      get_high_1_threshold();
+    virtual void        set_high_2_threshold(float threshold);
+    virtual double      get_high_2_threshold();
+    virtual void        set_pump_probe_frequency_Hz(double frequency);
+    virtual double      get_pump_probe_frequency_Hz();
+    virtual void        set_geometrical_correction(bool enabled);
+    virtual bool        get_geometrical_correction();
+    virtual std::size_t get_current_width ();
+    virtual std::size_t get_current_height();
+    virtual double      get_min_exposure_time_ms();
+    virtual double      get_max_exposure_time_ms();
+    virtual double      get_min_latency_time_ms ();
+    virtual double      get_max_latency_time_ms ();
+
+    virtual void        start_acquisition();
+    virtual void        stop_acquisition ();
+    virtual void        register_acquisition_customer  (const std::string& name);
+    virtual void        unregister_acquisition_customer(const std::string& name);
+    virtual void        waiting_built_images();
+    virtual std::size_t get_built_images_nb();
+    virtual std::size_t get_first_built_image_index();
+    virtual bool        fill_image_buffer    (char * buffer, int buffer_size);
+    virtual bool        fill_raw_image_buffer(char * buffer, int buffer_size);
+    virtual bool        is_raw_images_supported() const;
+    virtual bool        end_of_transfer();
+    virtual bool        failed_acquisition();
+    virtual void        log_acquisition_stats();
+
+private:
+    class WriterThread;
+
+    // frame copied by the acquisition thread, written by the writer thread
+    struct QueuedFrame
+    {
+        std::vector<char> data ;
+        uint64_t          index;
+        double            time ; // s
+        bool              raw  ;
+    };
+
+    // the records are written with the lock, the errors close the file
+    void   writeRegister(CaptureFormat::RegisterId id, double value);
+    void   writeEvent   (CaptureFormat::RecordType type, uint8_t value);
+    void   queueFrame   (bool raw, const char * buffer, int size);
+    void   writeFrame   (const QueuedFrame& frame);
+    void   writerLoop   ();
+    void   drainFrames  (); // the other records follow the queued frames, called without the lock
+    void   closeFile    ();
+    double getTime      () const;
+
+    DetectorBackend *   m_backend          ;
+    std::string         m_file_name        ;
+    FILE *              m_file             ;
+    std::vector<char>   m_file_buffer      ; // stdio buffer
+    std::atomic<bool>   m_capturing        ; // checked without the lock
+    double              m_capture_start    ; // s
+    uint64_t            m_frame_index      ; // last get_first_built_image_index
+    std::vector<char>   m_encoded          ; // frame being written
+    unsigned long       m_nb_frames        ;
+    uint64_t            m_nb_bytes         ;
+    mutable Mutex       m_mutex            ; // file
+
+    std::vector<QueuedFrame> m_frames      ; // slots of the queue
+    BoundedQueue<int>   m_free_frames      ; // acquisition thread <- writer
+    BoundedQueue<int>   m_queued_frames    ; // acquisition thread -> writer
+    std::atomic<int>    m_nb_queued_frames ; // not written yet
+    std::atomic<unsigned long> m_nb_dropped; // queue full
+    WriterThread *      m_writer           ; // started by the first capture file
+    bool                m_writer_quit      ;
+    Cond                m_writer_cond      ; // queued and written frames
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCCAPTUREBACKEND_H_ */
@@ -0,0 +1,134 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcCaptureFormat.h
+
+#ifndef UFXCCAPTUREFORMAT_H_
+#define UFXCCAPTUREFORMAT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class CaptureFormat
+ * \brief file of the captured acquisitions
+ *
+ * A header (magic, version, detector informations) followed by
+ * records: a type byte, the time (s) since the capture start, then
+ * the fields of the type. The values are written in the host byte
+ * order. The frames are written as runs of zero bytes and literal
+ * bytes, the counters of the UFXC frames are mostly zeros.
+ *******************************************************************/
+class LIBUFXC_API CaptureFormat
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "CaptureFormat", "Ufxc");
+
+public:
+    enum RecordType
+    {
+        Register  = 1, // id (uint8), value (double)
+        ConfigFile= 2, // file name (string)
+        Start     = 3, // width, height (uint32)
+        Frame     = 4, // hardware index (uint64), raw (uint8), size, encoded size (uint32), encoded bytes
+        Stop      = 5, // stop asked by the camera
+        Failed    = 6, // failed_acquisition result (uint8)
+    };
+
+    // acquisition registers written by the camera
+    enum RegisterId
+    {
+        AcqMode              = 0,
+        CountingTime         ,
+        WaitingTime          ,
+        ImagesNumber         ,
+        TriggersNumber       ,
+        Low1Threshold        ,
+        Low2Threshold        ,
+        High1Threshold       ,
+        High2Threshold       ,
+        PumpProbeFrequency   ,
+        GeometricalCorrection,
+        NbRegisters          ,
+    };
+
+    struct Header
+    {
+        std::string detector_name   ;
+        std::string detector_type   ; // Ufxc_Model label
+        std::string lib_version     ;
+        std::string firmware_version;
+    };
+
+    static const char *   getRegisterName(int id);
+
+    static void writeHeader(FILE * file, const Header& header);
+    static void readHeader (FILE * file, Header& header);
+
+    // the writes throw if the disk is full
+    static void writeRecordStart(FILE * file, RecordType type, double time);
+    static void writeString     (FILE * file, const std::string& text);
+    template<typename T> static void writeValue(FILE * file, T value);
+
+    // false at the end of the file
+    static bool readRecordStart(FILE * file, RecordType& type, double& time);
+    static void readString     (FILE * file, std::string& text);
+    template<typename T> static void readValue(FILE * file, T& value);
+
+    static void writeBytes(FILE * file, const void * data, std::size_t size);
+    static void readBytes (FILE * file, void * data, std::size_t size);
+
+    // zero runs encoding of the frames
+    static void encode(const char * data, int size, std::vector<char>& encoded);
+    static bool decode(const char * encoded, int encoded_size, char * data, int size);
+};
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+template<typename T>
+void CaptureFormat::writeValue(FILE * file, T value)
+{
+    writeBytes(file, &value, sizeof(value));
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+template<typename T>
+void CaptureFormat::readValue(FILE * file, T& value)
+{
+    readBytes(file, &value, sizeof(value));
+}
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCCAPTUREFORMAT_H_ */
@@ -0,0 +1,200 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcDetectorBackend.h
+
+#ifndef UFXCDETECTORBACKEND_H_
+#define UFXCDETECTORBACKEND_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+#include "ufxc/UFXCInterface.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class DetectorBackend
+ * \brief the part of ufxclib::UFXCInterface used by the camera
+ *
+ * The methods keep the names of ufxclib. The camera talks to the DAQ
+ * through this interface: SdkBackend forwards the calls to ufxclib,
+ * DetectorSimulator produces synthetic frames without hardware.
+ * get_detector_status is called by the status monitor without the
+ * camera lock, the backends serialize it with their other calls.
+ *******************************************************************/
+class LIBUFXC_API DetectorBackend
+{
+public:
+    virtual ~DetectorBackend() {}
+
+    // connection, model: Ufxc_Model label
+    virtual void open_connection(const std::string& model,
+                                 const ufxclib::DaqCnxConfig& tcp_cnx , const ufxclib::DaqCnxConfig& sfp1_cnx,
+                                 const ufxclib::DaqCnxConfig& sfp2_cnx, const ufxclib::DaqCnxConfig& sfp3_cnx,
+                                 unsigned long sfp_mtu) = 0;
+    virtual void close_connection() = 0;
+    virtual void set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& names) = 0;
+    virtual void set_detector_registers_names   (const std::map<ufxclib::EnumDetectorConfigKey   , std::string>& names) = 0;
+    virtual void set_monitoring_registers_names (const std::map<ufxclib::EnumMonitoringKey       , std::string>& names) = 0;
+    virtual void set_detector_config_file(const std::string& file_name) = 0;
+
+    // informations
+    virtual std::string   get_detector_name() = 0;
+    virtual std::string   get_detector_type() = 0;
+    virtual std::string   get_lib_version() = 0;
+    virtual std::string   get_firmware_version() = 0;
+    virtual unsigned long get_detector_temp() = 0;
+    virtual ufxclib::EnumDetectorStatus get_detector_status() = 0;
+
+    // registers
+    virtual void        set_acq_mode(ufxclib::EnumAcquisitionMode mode) = 0;
+    virtual void        set_counting_time_ms(double time_ms) = 0;
+    virtual double      get_counting_time_ms() = 0;
+    virtual void        set_waiting_time_ms(double time_ms) = 0;
+    virtual double      get_waiting_time_ms() = 0;
+    virtual void        set_images_number(std::size_t images_number) = 0;
+    virtual std::size_t get_images_number() = 0;
+    virtual void        set_triggers_number(std::size_t triggers_number) = 0;
+    virtual std::size_t get_triggers_number() = 0;
+    virtual void        set_low_1_threshold (float threshold) = 0;
+    virtual double      get_low_1_threshold () = 0;
+    virtual void        set_low_2_threshold (float threshold) = 0;
+    virtual double      get_low_2_threshold () = 0;
+    virtual void        set_high_1_threshold(float threshold) = 0;
+    virtual double      get_high_1_threshold() = 0;
+    virtual void        set_high_2_threshold(float threshold) = 0;
+    virtual double      get_high_2_threshold() = 0;
+    virtual void        set_pump_probe_frequency_Hz(double frequency) = 0;
+    virtual double      get_pump_probe_frequency_Hz() = 0;
+    virtual void        set_geometrical_correction(bool enabled) = 0;
+    virtual bool        get_geometrical_correction() = 0;
+    virtual std::size_t get_current_width () = 0;
+    virtual std::size_t get_current_height() = 0;
+    virtual double      get_min_exposure_time_ms() = 0;
+    virtual double      get_max_exposure_time_ms() = 0;
+    virtual double      get_min_latency_time_ms () = 0;
+    virtual double      get_max_latency_time_ms () = 0;
+
+    // acquisition
+    virtual void        start_acquisition() = 0;
+    virtual void        stop_acquisition () = 0;
+    virtual void        register_acquisition_customer  (const std::string& name) = 0;
+    virtual void        unregister_acquisition_customer(const std::string& name) = 0;
+    virtual void        waiting_built_images() = 0;
+    virtual std::size_t get_built_images_nb() = 0;
+    virtual std::size_t get_first_built_image_index() = 0;
+    virtual bool        fill_image_buffer    (char * buffer, int buffer_size) = 0;
+    // raw bit streams in the PixelUnpacker layout, not a ufxclib call: only the simulator and its replays give them
+    virtual bool        fill_raw_image_buffer(char * buffer, int buffer_size) = 0;
+    virtual bool        is_raw_images_supported() const = 0; // fill_raw_image_buffer available
+    virtual bool        end_of_transfer() = 0;
+    virtual bool        failed_acquisition() = 0;
+    virtual void        log_acquisition_stats() = 0;
+};
+
+/*******************************************************************
+ * \class SdkBackend
+ * \brief the UFXC DAQ through ufxclib
+ *******************************************************************/
+class LIBUFXC_API SdkBackend : public DetectorBackend
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "SdkBackend", "Ufxc");
+
+public:
+    SdkBackend();
+    virtual ~SdkBackend();
+
+    virtual void open_connection(const std::string& model,
+                                 const ufxclib::DaqCnxConfig& tcp_cnx , const ufxclib::DaqCnxConfig& sfp1_cnx,
+                                 const ufxclib::DaqCnxConfig& sfp2_cnx, const ufxclib::DaqCnxConfig& sfp3_cnx,
+                                 unsigned long sfp_mtu);
+    virtual void close_connection();
+    virtual void set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& names);
+    virtual void set_detector_registers_names   (const std::map<ufxclib::EnumDetectorConfigKey   , std::string>& names);
+    virtual void set_monitoring_registers_names (const std::map<ufxclib::EnumMonitoringKey       , std::string>& names);
+    virtual void set_detector_config_file(const std::string& file_name);
+
+    virtual std::string   get_detector_name();
+    virtual std::string   get_detector_type();
+    virtual std::string   get_lib_version();
+    virtual std::string   get_firmware_version();
+    virtual unsigned long get_detector_temp();
+    virtual ufxclib::EnumDetectorStatus get_detector_status();
+
+    virtual void        set_acq_mode(ufxclib::EnumAcquisitionMode mode);
+    virtual void        set_counting_time_ms(double time_ms);
+    virtual double      get_counting_time_ms();
+    virtual void        set_waiting_time_ms(double time_ms);
+    virtual double      get_waiting_time_ms();
+    virtual void        set_images_number(std::size_t images_number);
+    virtual std::size_t get_images_number();
+    virtual void        set_triggers_number(std::size_t triggers_number);
+    virtual std::size_t get_triggers_number();
+    virtual void        set_low_1_threshold (float threshold);
+    virtual double      get_low_1_threshold ();
+    virtual void        set_low_2_threshold (float threshold);
+    virtual double      get_low_2_threshold ();
+    virtual void        set_high_1_threshold(float threshold);
+    virtual double      get_high_1_threshold();
+    virtual void        set_high_2_threshold(float threshold);
+    virtual double      get_high_2_threshold();
+    virtual void        set_pump_probe_frequency_Hz(double frequency);
+    virtual double      get_pump_probe_frequency_Hz();
+    virtual void        set_geometrical_correction(bool enabled);
+    virtual bool        get_geometrical_correction();
+    virtual std::size_t get_current_width ();
+    virtual std::size_t get_current_height();
+    virtual double      get_min_exposure_time_ms();
+    virtual double      get_max_exposure_time_ms();
+    virtual double      get_min_latency_time_ms ();
+    virtual double      get_max_latency_time_ms ();
+
+    virtual void        start_acquisition();
+    virtual void        stop_acquisition ();
+    virtual void        register_acquisition_customer  (const std::string& name);
+    virtual void        unregister_acquisition_customer(const std::string& name);
+    virtual void        waiting_built_images();
+    virtual std::size_t get_built_images_nb();
+    virtual std::size_t get_first_built_image_index();
+    virtual bool        fill_image_buffer    (char * buffer, int buffer_size);
+    virtual bool        fill_raw_image_buffer(char * buffer, int buffer_size);
+    virtual bool        is_raw_images_supported() const;
+    virtual bool        end_of_transfer();
+    virtual bool        failed_acquisition();
+    virtual void        log_acquisition_stats();
+
+private:
+    ufxclib::UFXCInterface m_interface;
+    Mutex                  m_control_mutex; // TCP calls (connection, registers, status, start and stop)
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCDETECTORBACKEND_H_ */
@@ -0,0 +1,190 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcDetectorSimulator.h
+
+#ifndef UFXCDETECTORSIMULATOR_H_
+#define UFXCDETECTORSIMULATOR_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "UfxcDetectorBackend.h"
+#include "UfxcPixelUnpacker.h"
+#include "UfxcGeometryRemap.h"
+#include "lima/ThreadUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class DetectorSimulator
+ * \brief software UFXC detector, used instead of ufxclib
+ *
+ * Selected by the Ufxc_Model label SIMULATOR (two chips of 128 x 128
+ * pixels side by side) or SIMULATOR_<width>x<height> (multiples of the
+ * chip size).
+ *
+ * The frames are built at the rate of the registers: one frame every
+ * counting time + waiting time, images number x triggers number frames
+ * whatever the trigger mode (the external triggers are simulated at
+ * the same rate). In the pump-probe-probe mode, an image lasts the
+ * triggers number periods of the pump-probe frequency.
+ * A frame is built when the acquisition thread asks for it (no frame
+ * generation thread): its content is one of a few synthetic patterns
+ * of sparse counters, the first pixel holding the frame index modulo
+ * the max counter. The raw images are the patterns as bit streams,
+ * the images are decoded and corrected like the SDK ones.
+ * The calls of the control path (registers, informations, start and
+ * stop) are counted as DAQ transactions, each one lasting the
+ * transaction time like a TCP round trip to the DAQ.
+ *******************************************************************/
+class LIBUFXC_API DetectorSimulator : public DetectorBackend
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "DetectorSimulator", "Ufxc");
+
+public:
+    DetectorSimulator();
+    virtual ~DetectorSimulator();
+
+    static bool isSimulatorModel(const std::string& model);
+
+    // the occupancy of the patterns (fraction of the pixels with counts), used at the next start
+    void   setOccupancy(double occupancy);
+    double getOccupancy() const;
+
+    // simulated round trip of a DAQ transaction (0: none)
+    void   setTransactionTime(double time_ms);
+    double getTransactionTime() const;
+    void   getTransactionStats(unsigned long& nb_reads, unsigned long& nb_writes) const;
+    void   resetTransactionStats();
+
+    // start of the last simulated acquisition and period of its images
+    void   getAcquisitionTiming(double& start_time, double& image_period) const;
+
+    virtual void open_connection(const std::string& model,
+                                 const ufxclib::DaqCnxConfig& tcp_cnx , const ufxclib::DaqCnxConfig& sfp1_cnx,
+                                 const ufxclib::DaqCnxConfig& sfp2_cnx, const ufxclib::DaqCnxConfig& sfp3_cnx,
+                                 unsigned long sfp_mtu);
+    virtual void close_connection();
+    virtual void set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& names);
+    virtual void set_detector_registers_names   (const std::map<ufxclib::EnumDetectorConfigKey   , std::string>& names);
+    virtual void set_monitoring_registers_names (const std::map<ufxclib::EnumMonitoringKey       , std::string>& names);
+    virtual void set_detector_config_file(const std::string& file_name);
+
+    virtual std::string   get_detector_name();
+    virtual std::string   get_detector_type();
+    virtual std::string   get_lib_version();
+    virtual std::string   get_firmware_version();
+    virtual unsigned long get_detector_temp();
+    virtual ufxclib::EnumDetectorStatus get_detector_status();
+
+    virtual void        set_acq_mode(ufxclib::EnumAcquisitionMode mode);
+    virtual void        set_counting_time_ms(double time_ms);
+    virtual double      get_counting_time_ms();
+    virtual void        set_waiting_time_ms(double time_ms);
+    virtual double      get_waiting_time_ms();
+    virtual void        set_images_number(std::size_t images_number);
+    virtual std::size_t get_images_number();
+    virtual void        set_triggers_number(std::size_t triggers_number);
+    virtual std::size_t get_triggers_number();
+    virtual void        set_low_1_threshold (float threshold);
+    virtual double      get_low_1_threshold ();
+    virtual void        set_low_2_threshold (float threshold);
+    virtual double      get_low_2_threshold ();
+    virtual void        set_high_1_threshold(float threshold);
+    virtual double      get_high_1_threshold();
+    virtual void        set_high_2_threshold(float threshold);
+    virtual double      get_high_2_threshold();
+    virtual void        set_pump_probe_frequency_Hz(double frequency);
+    virtual double      get_pump_probe_frequency_Hz();
+    virtual void        set_geometrical_correction(bool enabled);
+    virtual bool        get_geometrical_correction();
+    virtual std::size_t get_current_width ();
+    virtual std::size_t get_current_height();
+    virtual double      get_min_exposure_time_ms();
+    virtual double      get_max_exposure_time_ms();
+    virtual double      get_min_latency_time_ms ();
+    virtual double      get_max_latency_time_ms ();
+
+    virtual void        start_acquisition();
+    virtual void        stop_acquisition ();
+    virtual void        register_acquisition_customer  (const std::string& name);
+    virtual void        unregister_acquisition_customer(const std::string& name);
+    virtual void        waiting_built_images();
+    virtual std::size_t get_built_images_nb();
+    virtual std::size_t get_first_built_image_index();
+    virtual bool        fill_image_buffer    (char * buffer, int buffer_size);
+    virtual bool        fill_raw_image_buffer(char * buffer, int buffer_size);
+    virtual bool        is_raw_images_supported() const;
+    virtual bool        end_of_transfer();
+    virtual bool        failed_acquisition();
+    virtual void        log_acquisition_stats();
+
+private:
+    int         getDepth() const; // bits of the counters of the acquisition mode
+    bool        isPumpProbe() const;
+    std::size_t getNbBuiltImages() const; // since the start
+    void        buildPatterns();
+    bool        fillBuffer(const std::vector<char>& patterns, int frame_size, int depth, char * buffer, int buffer_size);
+    void        transaction(bool write); // counts a DAQ transaction and waits for its round trip
+
+    std::string                 m_model             ;
+    int                         m_width             ; // raw image (without the gaps of the geometrical correction)
+    int                         m_height            ;
+    bool                        m_connected         ;
+    ufxclib::EnumAcquisitionMode m_acq_mode         ;
+    double                      m_counting_time_ms  ;
+    double                      m_waiting_time_ms   ;
+    std::size_t                 m_images_number     ;
+    std::size_t                 m_triggers_number   ;
+    double                      m_thresholds[4]     ; // low 1, low 2, high 1, high 2
+    double                      m_pump_probe_frequency;
+    bool                        m_geometrical_correction;
+    double                      m_occupancy         ;
+    std::atomic<double>         m_transaction_time  ; // ms
+    std::atomic<unsigned long>  m_nb_reads          ;
+    std::atomic<unsigned long>  m_nb_writes         ;
+
+    PixelUnpacker               m_unpacker          ;
+    GeometryRemap               m_remap             ; // SDK geometrical correction
+    std::vector<char>           m_raw_patterns      ; // bit streams
+    std::vector<char>           m_patterns          ; // decoded (and corrected) images
+    int                         m_raw_frame_size    ; // bytes
+    int                         m_frame_size        ; // bytes
+
+    // acquisition, the built images are only consumed by the acquisition thread
+    double                      m_start_time        ; // s
+    double                      m_image_period      ; // s
+    std::size_t                 m_nb_images         ; // images of the acquisition
+    std::size_t                 m_nb_filled_images  ;
+    std::atomic<bool>           m_running           ;
+    std::atomic<bool>           m_stopped           ;
+    mutable Mutex               m_mutex             ; // start and stop
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCDETECTORSIMULATOR_H_ */
@@ -0,0 +1,98 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcFrameAccumulator.h
+
+#ifndef UFXCFRAMEACCUMULATOR_H_
+#define UFXCFRAMEACCUMULATOR_H_
+
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "UfxcPixelUnpacker.h"
+#include "lima/Constants.h"
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class FrameAccumulator
+ * \brief sum of consecutive frames of the continuous modes
+ *
+ * The hardware frame k goes in the accumulated frame k / nb_frames.
+ * The 8 bits counters of the SDK frames are added in a 16 or 32 bits
+ * Lima buffer, a lost frame counts for zero. An accumulated frame is
+ * complete when all its frames were added, whatever their order.
+ *
+ * Only used by the acquisition thread, except the configuration.
+ *******************************************************************/
+class LIBUFXC_API FrameAccumulator
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "FrameAccumulator", "Ufxc");
+
+public:
+    FrameAccumulator();
+
+    void setNbFrames(int nb_frames); // 1: no accumulation
+    int  getNbFrames() const;
+    void setImageType(ImageType image_type); // Bpp16 or Bpp32
+    ImageType getImageType() const;
+
+    // max frames number without overflow of the accumulated counters
+    int  getMaxNbFrames(int depth) const;
+
+    // called at prepareAcq: frames of nb_pixels 8 bits counters
+    void prepare(int depth, int nb_pixels, PixelUnpacker::Kernel kernel);
+    // nb_slots: accumulated frames which can be in the pipeline at the same time
+    void start(int nb_slots);
+
+    void * getInputBuffer(); // filled by the SDK
+    int    getInputFrameSize() const;
+
+    // false if the accumulated frame did not receive any frame yet
+    bool isOpen(int acc_frame_nb) const;
+    // frame NULL: lost frame, returns true when the accumulated frame is complete
+    bool add(int acc_frame_nb, void * acc_frame, const void * frame);
+
+    int  getNbOpenFrames() const; // incomplete accumulated frames
+
+private:
+    struct Slot
+    {
+        int acc_frame_nb;
+        int nb_added    ;
+    };
+
+    int                   m_nb_frames  ;
+    ImageType             m_image_type ;
+    int                   m_nb_pixels  ;
+    PixelUnpacker::Kernel m_kernel     ;
+    std::vector<Slot>     m_slots      ; // indexed by accumulated frame number
+    std::vector<char>     m_input_frame;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCFRAMEACCUMULATOR_H_ */
@@ -0,0 +1,81 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcFrameBinRoi.h
+
+#ifndef UFXCFRAMEBINROI_H_
+#define UFXCFRAMEBINROI_H_
+
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+#include "lima/SizeUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class FrameBinRoi
+ * \brief hardware binning and roi applied by the fill workers
+ *
+ * As in Lima, the roi is given in the binned image. Only the binned
+ * pixels of the roi are computed: the sums of bin_x x bin_y pixels,
+ * saturated to the max value of the pixel storage. Without binning,
+ * the roi rows are copied with memcpy.
+ *******************************************************************/
+class LIBUFXC_API FrameBinRoi
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "FrameBinRoi", "Ufxc");
+
+public:
+    FrameBinRoi();
+
+    // roi empty: the whole binned image
+    void configure(const Size& source_size, const Bin& bin, const Roi& roi);
+    bool isIdentity() const; // full frame without binning
+
+    Size getSourceSize() const;
+    Size getOutputSize() const;
+    int  getSourceNbPixels() const;
+
+    static Size getBinnedSize(const Size& source_size, const Bin& bin);
+
+    // pixel_size: 1, 2 or 4 bytes
+    void apply(int pixel_size, const void * source, void * output) const;
+
+private:
+    template<typename T, typename Sum> void applyTyped(const T * source, T * output) const;
+
+    Size m_source_size;
+    int  m_bin_x      ;
+    int  m_bin_y      ;
+    int  m_roi_x      ; // in the binned image
+    int  m_roi_y      ;
+    int  m_roi_width  ;
+    int  m_roi_height ;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCFRAMEBINROI_H_ */
@@ -0,0 +1,103 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcFrameCompressor.h
+
+#ifndef UFXCFRAMECOMPRESSOR_H_
+#define UFXCFRAMECOMPRESSOR_H_
+
+#include <stdint.h>
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class FrameCompressor
+ * \brief lossless compression of the frames in the Lima buffers
+ *
+ * A record starts with a RecordHeader followed by the compressed data.
+ * The BitshuffleLz4 data use the chunk layout of the bitshuffle HDF5
+ * filter (id 32008, LZ4): a HDF5 direct chunk writer stores them as
+ * they are. A frame which does not compress is stored after the header.
+ * A record without the magic number (blank frame) is a zero frame.
+ *
+ * The compression is done in place by the fill workers: the frame is
+ * compressed in a scratch buffer, then copied over the frame.
+ *******************************************************************/
+class LIBUFXC_API FrameCompressor
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "FrameCompressor", "Ufxc");
+
+public:
+    enum Codec
+    {
+        NoCompression,
+        BitshuffleLz4, // needs liblz4 (UFXC_LZ4)
+    };
+
+    struct RecordHeader
+    {
+        uint32_t magic          ;
+        uint32_t codec          ; // NoCompression: frame stored as is
+        uint32_t frame_size     ; // bytes of the uncompressed frame
+        uint32_t compressed_size; // bytes following the header
+    };
+
+    static const uint32_t MAGIC = 0x5a584655; // "UFXZ"
+
+    FrameCompressor();
+
+    void  setCodec(Codec codec); // the codec must be supported
+    Codec getCodec() const;
+
+    // returns false if the frame was stored uncompressed, elem_size: bytes of a pixel,
+    // record_size: bytes of the Lima buffer (frame_size + header rows)
+    bool compress(int elem_size, void * record, int frame_size, int record_size,
+                  std::vector<char>& shuffled, std::vector<char>& compressed) const;
+
+    // returns false if the record is not a frame of frame_size bytes
+    static bool decompress(int elem_size, const void * record, void * frame, int frame_size);
+
+    // data of a compressed record, for the HDF5 direct chunk writes
+    static bool getCompressedData(const void * record, const void *& data, int& size);
+
+    static bool isCodecSupported(Codec codec);
+    static const char * getCodecName(Codec codec);
+
+    // image rows needed for the header in front of the frame
+    static int getHeaderRows(int width, int pixel_size);
+
+private:
+    static int getBlockSize(int elem_size); // elements of a bitshuffle block
+
+    Codec m_codec;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCFRAMECOMPRESSOR_H_ */
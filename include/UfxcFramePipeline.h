@@ -0,0 +1,215 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcFramePipeline.h
+
+#ifndef UFXCFRAMEPIPELINE_H_
+#define UFXCFRAMEPIPELINE_H_
+
+#include <atomic>
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "UfxcBoundedQueue.h"
+#include "UfxcPlacement.h"
+#include "UfxcPixelUnpacker.h"
+#include "UfxcGeometryRemap.h"
+#include "UfxcSparseEncoder.h"
+#include "UfxcFrameCompressor.h"
+#include "UfxcPixelCorrection.h"
+#include "UfxcProbeChannels.h"
+#include "UfxcFrameStatistics.h"
+#include "UfxcFrameBinRoi.h"
+#include "UfxcStatusBlock.h"
+#include "lima/HwBufferMgr.h"
+#include "lima/ThreadUtils.h"
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \struct FrameJob
+ * \brief frame travelling between the pipeline stages
+ *******************************************************************/
+struct FrameJob
+{
+    int    acq_frame_nb; // frame number in the acquisition (gives the Lima buffer)
+    void * frame_ptr   ; // Lima buffer filled by the receiver
+    void * raw_ptr     ; // staging frame converted by the fill worker (NULL: filled by the SDK)
+    bool   lost        ; // blank frame given to Lima in place of a lost image
+};
+
+/*******************************************************************
+ * \class FramePipeline
+ * \brief receive/fill/publish pipeline of the acquisition.
+ *
+ * The acquisition thread (receiver) drains the SDK and pushes the
+ * frames in a lock-free queue. Fill workers take the frames from this
+ * queue and the publisher gives them to Lima (newFrameReady) in the
+ * acquisition order. A slow Lima callback no longer stalls the drain
+ * of the SDK queue as long as Lima buffers are available.
+ * With the plugin decoding or the plugin geometrical correction, the
+ * receiver fills staging frames and the fill workers unpack the raw
+ * counters, correct the geometry, bin and crop the frame (hardware
+ * binning and roi) and/or pack the 2/4 bits counters in
+ * the Lima buffers, or split the two probe counters of the
+ * pump-probe-probe frames in two images. The pixel mask and flat-field correction is done
+ * in place in the Lima buffer, just after its fill, followed by the
+ * frame statistics (computed before the sparse encoding). A raw frame which only needs to be packed is given
+ * as is to Lima. With the sparse output, the converted frame is written
+ * in the Lima buffer as a photon events record. The compression is the
+ * last step of the fill workers, done in place in the Lima buffer.
+ *******************************************************************/
+class LIBUFXC_API FramePipeline
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "FramePipeline", "Ufxc");
+
+public:
+    FramePipeline(StdBufferCbMgr& buffer_mgr, StatusBlock& status_block, const ThreadPlacement& placement = ThreadPlacement());
+    ~FramePipeline();
+
+    // the new number of workers is used at the next acquisition start
+    void setNbFillWorkers(int nb_workers);
+    int  getNbFillWorkers() const;
+
+    // the new placement of the workers and the publisher is used at the next acquisition start
+    void setThreadsPlacement(const ThreadPlacement& placement);
+    std::string getThreadsPlacement() const; // effective placement of the threads
+
+    // called at prepareAcq, after the Lima buffers allocation
+    void cacheFrameBuffers();
+    void * getFrameBuffer(int acq_frame_nb) const;
+    int    getNbFrameBuffers() const;
+    int    getFrameMemSize() const;
+
+    // called at prepareAcq, nb_pixels: pixels of the SDK image, remap NULL: no plugin correction,
+    // packed_output: 2/4 bits counters packed in the Lima buffers, sparse NULL: dense frames,
+    // bin_roi NULL: full frames, probe_split: 32 bits pixels split in two 16 bits probe images
+    void setStagingFrames(bool raw_frames, int depth, int nb_pixels, const PixelUnpacker& unpacker,
+                          const GeometryRemap * remap, bool packed_output, const SparseEncoder * sparse,
+                          const FrameBinRoi * bin_roi, bool probe_split);
+    int  getStagingFrameSize() const; // bytes, 0 if the SDK fills the Lima buffers
+    bool isRawFrames() const;
+    void * getStagingBuffer(int acq_frame_nb);
+
+    // called at prepareAcq, compressor NULL: no compression, frame_size: bytes of the frame before the compression
+    void setCompression(const FrameCompressor * compressor, int elem_size, int frame_size);
+
+    // called at prepareAcq, correction NULL: no mask and flat-field, pixel_size: bytes of a pixel in the Lima buffers
+    void setPixelCorrection(const PixelCorrection * correction, int pixel_size);
+
+    // called at prepareAcq, pixel_size and nb_pixels: pixels of the Lima frames,
+    // probe_counters: the 32 bits pixels are two 16 bits counters
+    void setFrameStatistics(bool enabled, int pixel_size, int nb_pixels, uint32_t saturation, bool probe_counters);
+
+    // called before the acquisition thread receives the first frame
+    void start();
+    int  getMaxInFlight() const; // frames pushed but not yet published
+
+    // receiver side
+    void waitFreeBuffer(int acq_frame_nb); // waits until the Lima buffer of the frame can be reused
+    void push(const FrameJob& job);
+    void finish(); // waits until all the pushed frames are published
+
+    int getNbPublishedFrames() const;
+    void getSparseStats(unsigned long& nb_sparse_frames, unsigned long& nb_dense_frames) const; // last acquisition
+    void getCompressionStats(unsigned long& nb_frames, double& frame_bytes, double& compressed_bytes,
+                             double& compression_time) const; // last acquisition, time in s
+    bool getFrameStatistics(int acq_frame_nb, FrameStats& stats) const; // false if not in the ring
+    int  getNbFrameStatisticsSlots() const;
+
+private:
+    class StageThread;
+
+    void workerLoop   ();
+    void publisherLoop();
+    void startThreads ();
+    void stopThreads  ();
+    void wakeUp       ();
+    void applyPlacement(const std::string& thread_name);
+    void convertStagingFrame(const FrameJob& job, std::vector<char>& unpacked_frame, std::vector<char>& corrected_frame);
+    void computeStatistics(int acq_frame_nb, int pixel_size, const void * frame, int nb_pixels);
+
+    template<typename Predicate> void waitFor(Predicate ready);
+
+    StdBufferCbMgr&             m_buffer_mgr;
+    StatusBlock&                m_status_block; // frames count and time of the last frame
+    int                         m_nb_workers;
+    std::vector<StageThread *>  m_threads   ;
+    bool                        m_threads_changed; // number or placement
+    ThreadPlacement             m_placement;
+    std::vector<std::string>    m_threads_placement; // effective placement of each thread
+
+    std::vector<void *>         m_frame_buffers ; // Lima buffers given to fill_image_buffer
+    int                         m_frame_mem_size;
+
+    PixelUnpacker               m_unpacker      ; // plugin decoding of the raw frames
+    GeometryRemap               m_remap         ; // plugin geometrical correction
+    bool                        m_raw_frames    ;
+    bool                        m_remap_enabled ;
+    bool                        m_packed_output ;
+    FrameBinRoi                 m_bin_roi       ; // hardware binning and roi
+    bool                        m_bin_roi_enabled;
+    bool                        m_probe_split   ; // pump-probe-probe counters in two images
+    SparseEncoder               m_sparse_encoder; // photon events records
+    bool                        m_sparse_output ;
+    FrameCompressor             m_compressor    ; // in place compression of the Lima buffers
+    bool                        m_compression   ;
+    int                         m_compression_elem_size ;
+    int                         m_compression_frame_size;
+    PixelCorrection             m_pixel_correction; // pixel mask and flat-field
+    bool                        m_pixel_correction_enabled;
+    int                         m_pixel_correction_size; // bytes of a pixel
+    FrameStatistics             m_statistics    ; // ring of the frames statistics
+    bool                        m_statistics_enabled;
+    int                         m_statistics_pixel_size;
+    int                         m_statistics_nb_pixels ;
+    uint32_t                    m_statistics_saturation;
+    bool                        m_statistics_probe_counters;
+    int                         m_depth         ;
+    int                         m_nb_pixels     ; // pixels of a staging frame
+    int                         m_staging_frame_size;
+    std::vector<char>           m_staging_buffers; // one staging frame per frame in flight
+
+    BoundedQueue<FrameJob>      m_fill_queue   ; // receiver -> fill workers
+    std::vector<std::atomic<int> > m_filled_frames; // fill workers -> publisher (indexed by frame number)
+    const int                   m_mask         ;
+    int                         m_max_in_flight; // frames pushed but not yet published
+
+    std::atomic<int>            m_nb_pushed   ;
+    std::atomic<int>            m_nb_published;
+    std::atomic<unsigned long>  m_nb_sparse_frames;
+    std::atomic<unsigned long>  m_nb_dense_frames ; // sparse output frames written as dense records
+    std::atomic<unsigned long>  m_nb_compressed_frames;
+    std::atomic<unsigned long long> m_compressed_bytes;    // bytes following the record headers
+    std::atomic<unsigned long long> m_compression_time_ns;
+    std::atomic<int>            m_nb_sleepers ;
+    std::atomic<bool>           m_quit        ;
+    mutable Cond                m_cond        ;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCFRAMEPIPELINE_H_ */
@@ -0,0 +1,112 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcFrameStatistics.h
+
+#ifndef UFXCFRAMESTATISTICS_H_
+#define UFXCFRAMESTATISTICS_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "UfxcPixelUnpacker.h"
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \struct FrameStats
+ * \brief statistics of a Lima frame
+ *******************************************************************/
+struct FrameStats
+{
+    static const int NB_BINS = 16;
+
+    int      acq_frame_nb ;
+    bool     lost         ; // no statistics
+    int      nb_pixels    ;
+    uint64_t sum          ;
+    uint32_t max          ;
+    uint32_t nb_saturated ; // pixels at the saturation level or above
+    uint32_t bin_width    ; // counts of a histogram bin (power of 2)
+    uint32_t histogram[NB_BINS]; // the last bin also counts the values above the histogram
+};
+
+/*******************************************************************
+ * \class FrameStatistics
+ * \brief online statistics of the frames computed by the fill workers
+ *
+ * The sum, the max and the saturated pixels count are computed with
+ * the SSE4.1/AVX2 kernels on blocks of pixels, the histogram of a block
+ * is done while the block is still in the L1 cache: one pass on the
+ * frame. The histogram covers the values up to the saturation level.
+ *
+ * The statistics of the last frames are kept in a ring indexed by the
+ * frame number. A slot is written by one worker at a time (the ring is
+ * larger than the frames in flight) with a sequence lock: the readers
+ * never block a worker and retry if a write was in progress.
+ *******************************************************************/
+class LIBUFXC_API FrameStatistics
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "FrameStatistics", "Ufxc");
+
+public:
+    explicit FrameStatistics(int nb_slots); // power of 2
+
+    // pixel_size: 1, 2 or 4 bytes, saturation is limited to the max value of the pixels
+    static void compute(PixelUnpacker::Kernel kernel, int pixel_size, const void * frame, int nb_pixels,
+                        uint32_t saturation, FrameStats& stats);
+    static uint32_t getBinWidth(uint32_t saturation);
+
+    int  getNbSlots() const;
+    void reset(); // called while no frame is in the pipeline
+    void write(const FrameStats& stats);
+
+    // returns false if the frame was not written or already replaced in the ring
+    bool read(int acq_frame_nb, FrameStats& stats) const;
+
+private:
+    struct Slot
+    {
+        std::atomic<unsigned> sequence    ; // odd while a write is in progress
+        std::atomic<int>      acq_frame_nb;
+        std::atomic<bool>     lost        ;
+        std::atomic<int>      nb_pixels   ;
+        std::atomic<uint64_t> sum         ;
+        std::atomic<uint32_t> max         ;
+        std::atomic<uint32_t> nb_saturated;
+        std::atomic<uint32_t> bin_width   ;
+        std::atomic<uint32_t> histogram[FrameStats::NB_BINS];
+    };
+
+    std::vector<Slot> m_slots;
+    const int         m_mask ;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCFRAMESTATISTICS_H_ */
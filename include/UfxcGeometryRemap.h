@@ -0,0 +1,134 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcGeometryRemap.h
+
+#ifndef UFXCGEOMETRYREMAP_H_
+#define UFXCGEOMETRYREMAP_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+#include "lima/SizeUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \struct ChipLayout
+ * \brief chips of the detector image
+ *
+ * The image is a grid of chips of chip_width x chip_height pixels.
+ * The corrected image has gap_x (gap_y) pixels between two chips, the
+ * counts of the chip border pixels are split on the gap pixels.
+ *******************************************************************/
+struct LIBUFXC_API ChipLayout
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "ChipLayout", "Ufxc");
+
+public:
+    int chip_width ;
+    int chip_height;
+    int gap_x      ;
+    int gap_y      ;
+
+    ChipLayout(); // UFXC chip (128 x 128 pixels) with wide border pixels
+
+    void check() const;
+
+    bool operator==(const ChipLayout& other) const;
+    bool operator!=(const ChipLayout& other) const;
+};
+
+/*******************************************************************
+ * \class GeometryRemap
+ * \brief plugin side geometrical correction
+ *
+ * Precomputed table of the source to corrected pixels: runs of pixels
+ * copied as is, and weighted contributions of the border pixels split
+ * on the gap pixels. The shares of a split pixel are rounded down and
+ * the remainder goes to its last contribution, so the counts of the
+ * corrected image sum to the source ones. Used by the fill workers,
+ * each worker corrects its own frames.
+ *******************************************************************/
+class LIBUFXC_API GeometryRemap
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "GeometryRemap", "Ufxc");
+
+public:
+    GeometryRemap();
+
+    static Size getCorrectedSize(const ChipLayout& layout, const Size& source_size);
+
+    // returns false if the table of this model, layout and size is already built
+    bool build(const std::string& model, const ChipLayout& layout, const Size& source_size);
+    bool isBuilt() const;
+
+    Size getSourceSize   () const;
+    Size getCorrectedSize() const;
+    int  getSourceNbPixels() const;
+
+    // pixel_size: 1, 2 or 4 bytes
+    void apply(int pixel_size, const void * source, void * corrected) const;
+
+private:
+    struct CopyRun
+    {
+        int source   ;
+        int corrected;
+        int length   ;
+    };
+
+    struct Split
+    {
+        int      source   ;
+        int      corrected;
+        uint32_t weight   ; // 16 bits fixed point
+    };
+
+    struct AxisPart
+    {
+        int    corrected;
+        double fraction ;
+    };
+
+    static void buildAxis(int size, int chip_size, int gap, std::vector<std::vector<AxisPart> >& parts);
+
+    template<typename T> void applyTyped(const T * source, T * corrected) const;
+
+    std::string          m_model         ;
+    ChipLayout           m_layout        ;
+    Size                 m_source_size   ;
+    Size                 m_corrected_size;
+    std::vector<CopyRun> m_copy_runs     ;
+    std::vector<Split>   m_splits        ; // the contributions of a source pixel are consecutive
+    std::vector<int>     m_split_targets ; // corrected pixels of the splits, zeroed before the sums
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCGEOMETRYREMAP_H_ */
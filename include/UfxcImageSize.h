@@ -76,6 +76,7 @@ public:
         Size      image_size ;
 
         // specific part from the camera plugin [START]
+        updateGeometryRemap(); // rebuilt only if the SDK image changed
         getDetectorImageSize(image_size);
     	getImageType(image_depth);
         // specific part from the camera plugin [END]
@@ -32,6 +32,8 @@
 #include "UfxcCamera.h"
 #include "UfxcDetInfoCtrlObj.h"
 #include "UfxcSyncCtrlObj.h"
+#include "UfxcRoiCtrlObj.h"
+#include "UfxcBinCtrlObj.h"
 #include "lima/HwInterface.h"
 #include "lima/HwBufferMgr.h"
 #include "lima/HwEventCtrlObj.h"
@@ -80,6 +82,8 @@ private:
     DetInfoCtrlObj m_det_info;
     HwBufferCtrlObj*  m_bufferCtrlObj;
     SyncCtrlObj m_sync;  
+    RoiCtrlObj m_roi;
+    BinCtrlObj m_bin;
 } ;
 
 } // namespace Ufxc
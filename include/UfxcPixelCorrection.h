@@ -0,0 +1,99 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcPixelCorrection.h
+
+#ifndef UFXCPIXELCORRECTION_H_
+#define UFXCPIXELCORRECTION_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "UfxcPixelUnpacker.h"
+#include "lima/Debug.h"
+#include "lima/SizeUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class PixelCorrection
+ * \brief pixel mask and flat-field applied by the fill workers
+ *
+ * The maps of a detector model are read from the files of a directory:
+ *   <model>_<width>x<height>.mask : one byte per pixel, 0 for a masked pixel
+ *   <model>_<width>x<height>.flat : one float (little-endian) per pixel
+ * A missing file means no mask or a flat response.
+ *
+ * The mask and the flat-field are merged in one 14 bits fixed point
+ * factor per pixel (0 for a masked pixel, flat factors below 4). The
+ * corrected count is rounded and saturated to the maximum value of the
+ * counters (the depth of the counting mode), not only to the pixel storage.
+ * The table is rebuilt only when the model, the image, the counting
+ * mode or the roi changes.
+ *******************************************************************/
+class LIBUFXC_API PixelCorrection
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "PixelCorrection", "Ufxc");
+
+public:
+    PixelCorrection();
+
+    // returns false if the table of these parameters is already built,
+    // roi empty: the whole image
+    bool build(const std::string& directory, const std::string& model, const Size& image_size,
+               int counting_mode, const Roi& roi, PixelUnpacker::Kernel kernel);
+    void     setMaxValue(uint32_t max_value); // saturation of the corrected counts
+    uint32_t getMaxValue() const;
+    void clear(); // the files are read again at the next build
+    bool isBuilt() const;
+
+    int  getNbPixels() const; // pixels of the corrected frames
+    int  getNbMaskedPixels() const;
+
+    static std::string getFileName(const std::string& directory, const std::string& model,
+                                   const Size& image_size, const std::string& extension);
+
+    // in place, pixel_size: 1, 2 or 4 bytes
+    void apply(int pixel_size, void * frame) const;
+
+private:
+    static bool readFile(const std::string& file_name, std::vector<char>& data);
+
+    std::string           m_directory    ;
+    std::string           m_model        ;
+    Size                  m_image_size   ;
+    int                   m_counting_mode;
+    Roi                   m_roi          ;
+    PixelUnpacker::Kernel m_kernel       ;
+    uint32_t              m_max_value    ;
+    int                   m_nb_masked_pixels;
+    std::vector<uint16_t> m_factors      ; // 14 bits fixed point, pixels of the roi
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCPIXELCORRECTION_H_ */
@@ -0,0 +1,97 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcPixelUnpacker.h
+
+#ifndef UFXCPIXELUNPACKER_H_
+#define UFXCPIXELUNPACKER_H_
+
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class PixelUnpacker
+ * \brief decoding of the raw counting modes into Lima pixels
+ *
+ * The layout of the raw frames is the plugin one (ufxclib does not
+ * give them): a little-endian bit stream of depth bits counters:
+ * the counter of the pixel k uses the bits [k * depth, (k+1) * depth)
+ * of the stream, the first bit being the lsb of the first byte.
+ * The counters are given in the Lima storage of the image type: one
+ * byte for 2, 4 and 8 bits, two bytes for 14 bits, four bytes for 28
+ * and 32 bits.
+ *
+ * The kernel is chosen at runtime from the cpu features, the scalar
+ * one is the reference. The packing of the 2 and 4 bits counters is
+ * the reverse conversion (the Avx2 kernel uses the Sse41 packing).
+ *******************************************************************/
+class LIBUFXC_API PixelUnpacker
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "PixelUnpacker", "Ufxc");
+
+public:
+    enum Kernel
+    {
+        Auto  , // fastest kernel supported by the cpu
+        Scalar,
+        Sse41 ,
+        Avx2  ,
+    };
+
+    PixelUnpacker();
+
+    void   setKernel(Kernel kernel); // the cpu must support it
+    Kernel getKernel() const;
+    Kernel getEffectiveKernel() const;
+
+    // depth: 2, 4, 8, 14, 28 or 32 bits
+    void unpack(int depth, const void * packed, void * pixels, int nb_pixels) const;
+
+    // reverse conversion, depth: 2 or 4 bits (packed frames given to Lima)
+    void pack(int depth, const void * pixels, void * packed, int nb_pixels) const;
+
+    // mean decoding time (s) of a frame of random counters
+    double benchmark(int depth, int nb_pixels, int nb_frames) const;
+
+    static bool isKernelSupported(Kernel kernel);
+    static const char * getKernelName(Kernel kernel);
+    static bool isDepthSupported(int depth);
+    static bool isPackingSupported(int depth);
+    static int  getPackedSize(int depth, int nb_pixels); // bytes
+    static int  getPixelSize (int depth);                // bytes
+
+private:
+    static Kernel selectKernel();
+
+    Kernel m_kernel;
+    Kernel m_effective_kernel;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCPIXELUNPACKER_H_ */
@@ -0,0 +1,109 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcPlacement.h
+
+#ifndef UFXCPLACEMENT_H_
+#define UFXCPLACEMENT_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class ThreadPlacement
+ * \brief cpu affinity and scheduling of a plugin thread
+ *
+ * The cpu list uses the kernel syntax ("2", "2,3", "4-7,12").
+ * An empty list keeps the thread free, "numa" uses the cpus of the
+ * NUMA node of the SFP network interface.
+ *******************************************************************/
+class LIBUFXC_API ThreadPlacement
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "ThreadPlacement", "Ufxc");
+
+public:
+    enum SchedPolicy
+    {
+        Other     , // SCHED_OTHER (default time sharing)
+        Fifo      , // SCHED_FIFO
+        RoundRobin, // SCHED_RR
+    };
+
+    ThreadPlacement();
+    ThreadPlacement(const std::string& cpus, SchedPolicy policy, int priority);
+
+    const std::string& getCpus    () const { return m_cpus    ; }
+    SchedPolicy        getPolicy  () const { return m_policy  ; }
+    int                getPriority() const { return m_priority; }
+
+    // throws if the cpu list or the priority is incorrect
+    void check() const;
+
+    // "numa" is resolved with the cpus of this node
+    void setNumaNode(int numa_node);
+
+    // applies the placement to the calling thread and returns the effective placement
+    std::string applyToCurrentThread(const std::string& thread_name) const;
+
+    bool operator==(const ThreadPlacement& other) const;
+    bool operator!=(const ThreadPlacement& other) const { return !(*this == other); }
+
+    static std::string getCurrentThreadPlacement();
+
+private:
+    static bool parseCpus(const std::string& cpus, std::vector<int>& cpu_list);
+
+    std::string m_cpus     ;
+    SchedPolicy m_policy   ;
+    int         m_priority ;
+    int         m_numa_node;
+};
+
+/*******************************************************************
+ * \class NumaPlacement
+ * \brief NUMA locality of the SFP network interface and of the Lima buffers
+ *******************************************************************/
+class LIBUFXC_API NumaPlacement
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "NumaPlacement", "Ufxc");
+
+public:
+    // node of the local interface owning this address or on its subnet, -1 if unknown
+    static int         getInterfaceNode(const std::string& ip_address, std::string& interface_name);
+    static std::string getNodeCpus     (int numa_node);
+
+    // moves the pages of the memory area on the node
+    static bool        bindMemory      (void * address, std::size_t size, int numa_node);
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCPLACEMENT_H_ */
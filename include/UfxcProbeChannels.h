@@ -0,0 +1,83 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcProbeChannels.h
+
+#ifndef UFXCPROBECHANNELS_H_
+#define UFXCPROBECHANNELS_H_
+
+#include <stdint.h>
+#include "UfxcCompatibility.h"
+#include "UfxcPixelUnpacker.h"
+#include "lima/Debug.h"
+#include "lima/SizeUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class ProbeChannels
+ * \brief the two probe counters of the PumpProbeProbe_32 frames
+ *
+ * A 32 bits pixel of the pump-probe-probe mode contains the 16 bits
+ * counter of the first probe in its low half and the counter of the
+ * second probe in its high half.
+ * A view gives a probe image without copy, as 16 bits values with a
+ * stride: in a Bpp32 frame, or in a frame of the split output where the
+ * fill workers write the first probe image followed by the second one
+ * (Bpp16 frame of twice the image height).
+ *******************************************************************/
+class LIBUFXC_API ProbeChannels
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "ProbeChannels", "Ufxc");
+
+public:
+    static const int NB_CHANNELS = 2;
+
+    struct View
+    {
+        const uint16_t * data        ; // first pixel of the probe image
+        int              width       ;
+        int              height      ;
+        int              pixel_stride; // uint16_t values between two pixels of a row
+        int              row_stride  ; // uint16_t values between two rows
+
+        uint16_t at(int x, int y) const { return data[static_cast<long>(y) * row_stride + static_cast<long>(x) * pixel_stride]; }
+    };
+
+    // zero copy, channel: 0 or 1
+    static View getInterleavedView(const void * frame, const Size& image_size, int channel);
+    static View getSplitView      (const void * frame, const Size& image_size, int channel);
+
+    // Bpp16 frame of the split output
+    static Size getSplitSize(const Size& image_size);
+
+    // one pass: 32 bits pixels -> first probe pixels followed by the second probe pixels
+    static void split(PixelUnpacker::Kernel kernel, const void * frame, int nb_pixels, void * split_frame);
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCPROBECHANNELS_H_ */
@@ -0,0 +1,100 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcRegisterBatch.h
+
+#ifndef UFXCREGISTERBATCH_H_
+#define UFXCREGISTERBATCH_H_
+
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class RegisterBatch
+ * \brief acquisition registers waiting to be written in the DAQ
+ *
+ * The setters only record the requested values. The camera writes them
+ * in one pass at prepareAcq, in the register order, and skips the values
+ * already known to be in the DAQ. A value is only forgotten once written,
+ * so a failed write is retried at the next commit.
+ *******************************************************************/
+class LIBUFXC_API RegisterBatch
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "RegisterBatch", "Ufxc");
+
+public:
+    // commit order: the acquisition mode changes the valid time ranges
+    enum Register
+    {
+        AcquisitionMode, // FMC.ACQ_MODE
+        CountingTime   , // FMC.ACQ_COUNT_TIME (ms)
+        WaitingTime    , // FMC.ACQ_WAIT_TIME (ms)
+        ImagesNumber   , // FMC.ACQ_NIMG
+        TriggersNumber , // FMC.ACQ_NTRIG
+        NbRegisters    ,
+    };
+
+    struct Write
+    {
+        Register reg  ;
+        double   value;
+    };
+
+    RegisterBatch();
+
+    void mark(Register reg, double value);
+    bool getPending(Register reg, double& value) const;
+    bool isPending(Register reg) const;
+
+    // pending values to write, the ones already in the DAQ are dropped
+    void getWrites(std::vector<Write>& writes);
+    bool getWrite(Register reg, Write& write); // the same for one register
+    void written(Register reg, double value);
+
+    // the DAQ content is unknown (reset, configuration file), next commit writes everything
+    void forgetHardware();
+
+    void getStats(unsigned long& nb_writes, unsigned long& nb_skipped_writes) const;
+
+    static const char * getName(Register reg);
+
+private:
+    double                  m_pending_values [NbRegisters];
+    bool                    m_pending        [NbRegisters];
+    double                  m_hardware_values[NbRegisters]; // last value written
+    bool                    m_hardware_known [NbRegisters];
+    unsigned long           m_nb_writes;
+    unsigned long           m_nb_skipped_writes;
+    mutable Mutex           m_mutex;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCREGISTERBATCH_H_ */
@@ -0,0 +1,103 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcRegisterCache.h
+
+#ifndef UFXCREGISTERCACHE_H_
+#define UFXCREGISTERCACHE_H_
+
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class RegisterCache
+ * \brief shadow copy of the DAQ registers read through ufxclib
+ *
+ * A value is read once from the hardware, then given by the cache
+ * until it is written, invalidated or resynchronized. The setters
+ * store the written value when the DAQ keeps it as is, otherwise they
+ * invalidate it so the next read gets the value used by the DAQ.
+ *******************************************************************/
+class LIBUFXC_API RegisterCache
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "RegisterCache", "Ufxc");
+
+public:
+    enum Key
+    {
+        CountingTime         , // FMC.ACQ_COUNT_TIME (ms)
+        WaitingTime          , // FMC.ACQ_WAIT_TIME (ms)
+        ImagesNumber         , // FMC.ACQ_NIMG
+        TriggersNumber       , // FMC.ACQ_NTRIG
+        ThresholdLow1        , // FMC.DET_THRESHOLD_LOW_1
+        ThresholdLow2        , // FMC.DET_THRESHOLD_LOW_2
+        ThresholdHigh1       , // FMC.DET_THRESHOLD_HIGH_1
+        ThresholdHigh2       , // FMC.DET_THRESHOLD_HIGH_2
+        PumpProbeFrequency   , // Hz
+        GeometricalCorrection, // SDK setting
+        ImageWidth           , // depends on the acquisition mode and the geometrical correction
+        ImageHeight          ,
+        MinExposureTime      , // ms, depends on the acquisition mode
+        MaxExposureTime      ,
+        MinLatencyTime       ,
+        MaxLatencyTime       ,
+        NbKeys               ,
+    };
+
+    RegisterCache();
+
+    // a disabled cache always reads the hardware
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // false if the value must be read from the hardware, then given to fill with the generation
+    bool get (Key key, double& value, unsigned& generation) const;
+    void fill(Key key, double value, unsigned generation); // ignored if the key changed meanwhile
+    void set (Key key, double value);
+    void invalidate(Key key);
+    void invalidateGeometry(); // image size and time ranges
+    void invalidateAll();
+
+    void getStats(unsigned long& nb_hits, unsigned long& nb_misses) const;
+
+    static const char * getName(Key key);
+
+private:
+    bool                    m_enabled;
+    double                  m_values[NbKeys];
+    bool                    m_valid [NbKeys];
+    unsigned                m_generation[NbKeys]; // incremented at each write or invalidation
+    mutable unsigned long   m_nb_hits;
+    mutable unsigned long   m_nb_misses;
+    mutable Mutex           m_mutex;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCREGISTERCACHE_H_ */
@@ -0,0 +1,105 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcReorderWindow.h
+
+#ifndef UFXCREORDERWINDOW_H_
+#define UFXCREORDERWINDOW_H_
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class ReorderWindow
+ * \brief places the received images by their hardware index
+ *
+ * Each image goes in the Lima buffer of its hardware index. A missing
+ * index is declared lost after the reorder timeout, or when a received
+ * index is too far ahead to keep it in the window. The lost frames are
+ * given to Lima as blank frames and their indexes are kept in a list.
+ * Late or duplicated images are dropped.
+ *
+ * Only used by the acquisition thread, except the statistics getters.
+ *******************************************************************/
+class LIBUFXC_API ReorderWindow
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "ReorderWindow", "Ufxc");
+
+public:
+    ReorderWindow();
+
+    void   setSize(int nb_frames);
+    int    getSize() const;
+    void   setTimeout(double timeout_ms);
+    double getTimeout() const;
+
+    // window_limit: frames which can be in the pipeline at the same time
+    void start(int window_limit, int nb_frames);
+
+    // false if the image should be dropped (late, duplicated or out of the acquisition)
+    bool accept(int frame_index);
+
+    // next frame to be declared lost before an image can be accepted (-1: none)
+    int  popLost(int incoming_frame_index);
+    // next lost frame because of the timeout (-1: none)
+    int  popExpired();
+    // at the end of the acquisition: next missing frame before the last received one (-1: none)
+    int  popMissing();
+
+    int  getNbReceivedFrames() const; // highest received index + 1
+    int  getNbLostFrames() const;
+    int  getNbDroppedFrames() const;
+    void getLostFrames(std::vector<int>& lost_frames) const;
+
+private:
+    int  popNext(int force_below, bool check_timeout);
+    void advance();
+
+    static double now_ms();
+
+    std::atomic<int>    m_size         ; // configured window (frames)
+    std::atomic<double> m_timeout_ms   ;
+    int                 m_window       ; // effective window of the acquisition
+    int                 m_nb_frames    ; // 0: continuous acquisition
+    int                 m_next         ; // first unresolved frame (neither received nor lost)
+    std::deque<double>  m_missing_since; // frames [m_next, m_next + size): -1 if received, else time when known missing
+
+    std::atomic<int>    m_nb_received  ;
+    std::atomic<int>    m_nb_lost      ;
+    std::atomic<int>    m_nb_dropped   ;
+    std::vector<int>    m_lost_frames  ; // first lost frames of the acquisition
+    mutable Mutex       m_lost_mutex   ;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCREORDERWINDOW_H_ */
@@ -0,0 +1,180 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcReplayBackend.h
+
+#ifndef UFXCREPLAYBACKEND_H_
+#define UFXCREPLAYBACKEND_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <atomic>
+#include <vector>
+#include "UfxcDetectorBackend.h"
+#include "UfxcCaptureFormat.h"
+#include "lima/ThreadUtils.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class ReplayBackend
+ * \brief plays back a file of the CaptureBackend
+ *
+ * Selected by the Ufxc_Model label REPLAY:<capture file>. Each start
+ * plays the next captured acquisition (the first one after the last):
+ * its frames are given to the camera with their hardware index, at
+ * their captured times divided by the speed (0: as fast as possible).
+ * The missing frames of the capture are missing in the replay.
+ * The registers written by the camera are kept like with the
+ * simulator, a difference with the captured values is reported at
+ * the start. The camera must ask the frames as they were captured
+ * (raw or decoded), with the same size.
+ *******************************************************************/
+class LIBUFXC_API ReplayBackend : public DetectorBackend
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "ReplayBackend", "Ufxc");
+
+public:
+    ReplayBackend();
+    virtual ~ReplayBackend();
+
+    static bool isReplayModel(const std::string& model);
+
+    // used at the next start
+    void   setSpeed(double speed); // 1: captured rate, 0: as fast as possible
+    double getSpeed() const;
+
+    int    getNbAcquisitions() const; // in the file
+
+    virtual void open_connection(const std::string& model,
+                                 const ufxclib::DaqCnxConfig& tcp_cnx , const ufxclib::DaqCnxConfig& sfp1_cnx,
+                                 const ufxclib::DaqCnxConfig& sfp2_cnx, const ufxclib::DaqCnxConfig& sfp3_cnx,
+                                 unsigned long sfp_mtu);
+    virtual void close_connection();
+    virtual void set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& names);
+    virtual void set_detector_registers_names   (const std::map<ufxclib::EnumDetectorConfigKey   , std::string>& names);
+    virtual void set_monitoring_registers_names (const std::map<ufxclib::EnumMonitoringKey       , std::string>& names);
+    virtual void set_detector_config_file(const std::string& file_name);
+
+    virtual std::string   get_detector_name();
+    virtual std::string   get_detector_type();
+    virtual std::string   get_lib_version();
+    virtual std::string   get_firmware_version();
+    virtual unsigned long get_detector_temp();
+    virtual ufxclib::EnumDetectorStatus get_detector_status();
+
+    virtual void        set_acq_mode(ufxclib::EnumAcquisitionMode mode);
+    virtual void        set_counting_time_ms(double time_ms);
+    virtual double      get_counting_time_ms();
+    virtual void        set_waiting_time_ms(double time_ms);
+    virtual double      get_waiting_time_ms();
+    virtual void        set_images_number(std::size_t images_number);
+    virtual std::size_t get_images_number();
+    virtual void        set_triggers_number(std::size_t triggers_number);
+    virtual std::size_t get_triggers_number();
+    virtual void        set_low_1_threshold (float threshold);
+    virtual double      get_low_1_threshold ();
+    virtual void        set_low_2_threshold (float threshold);
+    virtual double      get_low_2_threshold ();
+    virtual void        set_high_1_threshold(float threshold);
+    virtual double      get_high_1_threshold();
+    virtual void        set_high_2_threshold(float threshold);
+    virtual double      get_high_2_threshold();
+    virtual void        set_pump_probe_frequency_Hz(double frequency);
+    virtual double      get_pump_probe_frequency_Hz();
+    virtual void        set_geometrical_correction(bool enabled);
+    virtual bool        get_geometrical_correction();
+    virtual std::size_t get_current_width ();
+    virtual std::size_t get_current_height();
+    virtual double      get_min_exposure_time_ms();
+    virtual double      get_max_exposure_time_ms();
+    virtual double      get_min_latency_time_ms ();
+    virtual double      get_max_latency_time_ms ();
+
+    virtual void        start_acquisition();
+    virtual void        stop_acquisition ();
+    virtual void        register_acquisition_customer  (const std::string& name);
+    virtual void        unregister_acquisition_customer(const std::string& name);
+    virtual void        waiting_built_images();
+    virtual std::size_t get_built_images_nb();
+    virtual std::size_t get_first_built_image_index();
+    virtual bool        fill_image_buffer    (char * buffer, int buffer_size);
+    virtual bool        fill_raw_image_buffer(char * buffer, int buffer_size);
+    virtual bool        is_raw_images_supported() const;
+    virtual bool        end_of_transfer();
+    virtual bool        failed_acquisition();
+    virtual void        log_acquisition_stats();
+
+private:
+    struct FrameEntry
+    {
+        double   time        ; // s since the acquisition start
+        uint64_t index       ; // hardware index
+        bool     raw         ;
+        uint32_t size        ; // bytes
+        uint32_t encoded_size; // bytes
+        off_t    offset      ; // of the encoded frame in the file
+    };
+
+    struct Acquisition
+    {
+        uint32_t                width    ;
+        uint32_t                height   ;
+        bool                    failed   ;
+        double                  registers[CaptureFormat::NbRegisters]; // captured values at the start
+        std::vector<FrameEntry> frames   ;
+    };
+
+    void        loadFile(const std::string& file_name); // index of the acquisitions
+    void        setRegister(CaptureFormat::RegisterId id, double value);
+    double      getRegister(CaptureFormat::RegisterId id) const;
+    const Acquisition * getNextAcquisition() const;
+    std::size_t getNbAvailableFrames() const; // since the start
+    bool        fillBuffer(bool raw, char * buffer, int buffer_size);
+
+    std::string              m_file_name       ;
+    FILE *                   m_file            ;
+    CaptureFormat::Header    m_header          ;
+    std::vector<Acquisition> m_acquisitions    ;
+    std::size_t              m_next_acquisition;
+    double                   m_registers[CaptureFormat::NbRegisters]; // written by the camera
+    double                   m_speed           ;
+    std::vector<char>        m_encoded         ; // frame being read
+
+    // acquisition, the frames are only read by the acquisition thread
+    const Acquisition *      m_acquisition     ;
+    double                   m_acquisition_speed;
+    double                   m_start_time      ; // s
+    std::size_t              m_nb_filled_frames;
+    std::atomic<bool>        m_running         ;
+    std::atomic<bool>        m_stopped         ;
+    mutable Mutex            m_mutex           ; // registers, speed and start
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCREPLAYBACKEND_H_ */
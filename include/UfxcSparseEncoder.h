@@ -0,0 +1,91 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcSparseEncoder.h
+
+#ifndef UFXCSPARSEENCODER_H_
+#define UFXCSPARSEENCODER_H_
+
+#include <stdint.h>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class SparseEncoder
+ * \brief photon events records of the low occupancy frames
+ *
+ * A record starts with a RecordHeader. A sparse record is followed by
+ * the indexes (uint32) of the non zero pixels in increasing order, then
+ * by their counts in the Lima storage of the pixels (1, 2 or 4 bytes).
+ * A frame with more events than the occupancy threshold allows is
+ * written as a dense record: the pixels follow the header.
+ * A record without the magic number (blank frame) has no event.
+ *******************************************************************/
+class LIBUFXC_API SparseEncoder
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "SparseEncoder", "Ufxc");
+
+public:
+    enum Encoding
+    {
+        Dense  = 0,
+        Sparse = 1,
+    };
+
+    struct RecordHeader
+    {
+        uint32_t magic    ;
+        uint32_t encoding ;
+        uint32_t nb_pixels;
+        uint32_t nb_events; // non zero pixels of a sparse record
+    };
+
+    static const uint32_t MAGIC = 0x53584655; // "UFXS"
+
+    SparseEncoder();
+
+    // max fraction of non zero pixels of a sparse record
+    void   setOccupancyThreshold(double threshold);
+    double getOccupancyThreshold() const;
+
+    // returns false if the frame was written as a dense record
+    bool encode(int pixel_size, const void * pixels, int nb_pixels, void * record, int record_size) const;
+
+    // returns false if the record is not a frame of nb_pixels pixels
+    static bool decode(int pixel_size, const void * record, void * pixels, int nb_pixels);
+
+    // image rows needed for the header in front of the pixels
+    static int getHeaderRows(int width, int pixel_size);
+
+private:
+    double m_occupancy_threshold;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCSPARSEENCODER_H_ */
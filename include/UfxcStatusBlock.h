@@ -0,0 +1,101 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcStatusBlock.h
+
+#ifndef UFXCSTATUSBLOCK_H_
+#define UFXCSTATUSBLOCK_H_
+
+#include <atomic>
+#include "UfxcCompatibility.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \struct StatusSnapshot
+ * \brief coherent copy of the acquisition status
+ *******************************************************************/
+struct StatusSnapshot
+{
+    int    status              ; // Camera::Status
+    bool   thread_running      ; // an acquisition is running in the acquisition thread
+    int    nb_received_frames  ; // frames placed by the acquisition thread (highest index + 1)
+    int    nb_acquired_frames  ; // frames given to Lima
+    double last_frame_timestamp; // time (s) when the last frame was given to Lima, 0 if none
+    double status_timestamp    ; // time (s) of the last detector status refresh, 0 if none
+};
+
+/*******************************************************************
+ * \class StatusBlock
+ * \brief acquisition status shared without the camera mutex
+ *
+ * Sequence lock: the writers (acquisition thread, publisher, control
+ * calls) are serialized by a spin lock held for a few stores, the
+ * readers never block a writer and retry if a write was in progress.
+ *******************************************************************/
+class LIBUFXC_API StatusBlock
+{
+public:
+    StatusBlock(int status, int fault_status);
+
+    // the Fault status is only replaced if forced
+    void setStatus(int status, bool force);
+    void setThreadRunning(bool thread_running);
+    void setNbReceivedFrames(int nb_frames);
+    void frameAcquired(int nb_frames, double timestamp);
+    void startAcquisition();
+
+    // the generation is taken before the detector status read, the refresh is
+    // ignored if setStatus or startAcquisition were called meanwhile,
+    // then same rule as setStatus without force
+    unsigned getStatusGeneration() const;
+    bool     statusRefreshed(int status, double timestamp, unsigned generation);
+
+    void read(StatusSnapshot& snapshot) const;
+    int  getStatus() const;
+    bool isThreadRunning() const;
+    int  getNbAcquiredFrames() const;
+
+private:
+    void beginWrite();
+    void endWrite  ();
+
+    std::atomic<unsigned>   m_sequence; // odd while a write is in progress
+    std::atomic_flag        m_write_lock;
+    const int               m_fault_status;
+
+    std::atomic<unsigned>   m_status_generation   ; // incremented by setStatus and startAcquisition
+    std::atomic<int>        m_status              ;
+    std::atomic<bool>       m_thread_running      ;
+    std::atomic<int>        m_nb_received_frames  ;
+    std::atomic<int>        m_nb_acquired_frames  ;
+    std::atomic<double>     m_last_frame_timestamp;
+    std::atomic<double>     m_status_timestamp    ;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCSTATUSBLOCK_H_ */
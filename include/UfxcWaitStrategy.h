@@ -0,0 +1,98 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcWaitStrategy.h
+
+#ifndef UFXCWAITSTRATEGY_H_
+#define UFXCWAITSTRATEGY_H_
+
+#include <atomic>
+#include <cstddef>
+#include "UfxcCompatibility.h"
+#include "lima/Debug.h"
+#include "UfxcDetectorBackend.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \class WaitStrategy
+ * \brief how the acquisition thread waits for the SDK built images
+ *
+ * Blocking      : waiting_built_images() for every batch.
+ * SpinThenBlock : polls the built images during a spin budget, then blocks.
+ * BusyPoll      : never blocks (the thread should have its own core).
+ * Auto          : chosen from the measured frame period.
+ *******************************************************************/
+class LIBUFXC_API WaitStrategy
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "WaitStrategy", "Ufxc");
+
+public:
+    enum Policy
+    {
+        Auto         ,
+        Blocking     ,
+        SpinThenBlock,
+        BusyPoll     ,
+    };
+
+    WaitStrategy();
+
+    void   setPolicy(Policy policy);
+    Policy getPolicy() const;
+
+    void   setSpinBudget(double spin_budget_us);
+    double getSpinBudget() const;
+
+    // called by the acquisition thread before the first frame
+    void start(double frame_time_ms);
+
+    // returns the number of built images, 0 at the end of the transfer
+    std::size_t wait(DetectorBackend& ufxc_interface);
+
+    Policy getEffectivePolicy() const;
+    double getMeasuredFramePeriod() const; // ms
+
+    // slow acquisitions check the end of transfer between the frames of a batch
+    bool checkEndBetweenFrames() const;
+
+private:
+    void   updateMeasure(std::size_t built_images_nb);
+    Policy selectPolicy(double frame_period_ms) const;
+
+    static double now_us();
+    static void   cpuRelax();
+
+    std::atomic<int>    m_policy          ;
+    std::atomic<double> m_spin_budget_us  ;
+    std::atomic<int>    m_effective_policy;
+    std::atomic<double> m_frame_period_ms ; // moving average of the received frames period
+    double              m_last_batch_us   ;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCWAITSTRATEGY_H_ */
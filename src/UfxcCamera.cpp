@@ -25,6 +25,7 @@
 #include <string>
 #include <math.h>
 #include <climits>
+#include <algorithm>
 #include <iomanip>
 #include <signal.h>
 #include <unistd.h>
@@ -42,6 +43,11 @@ using namespace lima::Ufxc;
 using namespace std;
 using namespace ufxclib;
 
+// default refresh period of the detector status by the status monitor (s)
+static const double STATUS_DEFAULT_REFRESH_PERIOD_S = 0.1;
+// max hardware binning factor of an axis
+static const int    HW_BIN_MAX = 16;
+
 //-------------------------------------------------------------------------
 // COUNTING MODES MANAGEMENT
 //-------------------------------------------------------------------------
@@ -174,7 +180,11 @@ Camera::Camera(	const std::string& Ufxc_Model     ,
                 unsigned long      SFP_MTU        ,
                 unsigned long      timeout_ms     ,
                 unsigned long      pixel_depth    ,
-                std::string        counting_mode  )
+                std::string        counting_mode  ,
+                const ThreadPlacement& acq_thread_placement    ,
+                const ThreadPlacement& helper_threads_placement,
+                int                numa_node      ) :
+m_status_block(Camera::Init, Camera::Fault)
 {
 	DEB_CONSTRUCTOR();
 
@@ -192,6 +202,36 @@ Camera::Camera(	const std::string& Ufxc_Model     ,
 	    m_nb_frames = 1;
 	    m_pump_probe_nb_frames = 1;
 	    m_is_geometrical_correction_enabled = false;		
+	    m_buffer_latency_tolerance = 1.0;
+	    m_buffer_memory_budget = 1024.0;
+	    m_acq_thread_placement = acq_thread_placement;
+	    m_acq_thread_placement_changed = false;
+	    m_helper_threads_placement = helper_threads_placement;
+	    m_numa_node_config = numa_node;
+	    m_numa_node = -1;
+	    m_sfp_ip_address = SFP1_ip_address;
+	    m_bound_numa_node = -1;
+	    m_bound_frame_mem_size = 0;
+	    m_deferred_register_writes = true;
+	    m_prepare_time = 0.0;
+	    m_prepare_commit_time = 0.0;
+	    m_prepare_nb_writes = 0;
+	    m_prepare_total_time = 0.0;
+	    m_prepare_max_time = 0.0;
+	    m_nb_prepares = 0;
+	    m_pixel_decoding = SdkDecoding;
+	    m_geometrical_correction_engine = SdkCorrection;
+	    m_packed_pixel_output = false;
+	    m_sparse_output = false;
+	    m_probe_channels_output = false;
+	    m_frame_statistics_enabled = false;
+	    m_frame_statistics_saturation = 0;
+	    m_pixel_correction_enabled = false;
+	    m_pixel_correction_path = ".";
+	    m_ufxc_interface = NULL;
+	    m_capture_backend = NULL;
+	    m_replay_backend = NULL;
+	    m_simulator = NULL;
 
         // determine which counting mode should be used -> if unknown label -> CountingModes::SelectDefault
         std::string error_message;
@@ -223,17 +263,37 @@ Camera::Camera(	const std::string& Ufxc_Model     ,
 		SFP3_cnx.socket_timeout_ms  = timeout_ms;
 		SFP3_cnx.protocol           = ufxclib::EnumProtocol::UDP;
 
+		// wrong placement options are reported before the connection and the threads creation
+		m_acq_thread_placement.check();
+		m_helper_threads_placement.check();
+
+		if(m_numa_node_config < -1)
+			THROW_HW_ERROR(InvalidValue) << "Incorrect NUMA node: " << m_numa_node_config;
+
 		//- prepare the registers
 		SetHardwareRegisters();
 
-		//- create the main ufxc object
-		m_ufxc_interface = new ufxclib::UFXCInterface();
+		//- create the main ufxc object (the simulator for the SIMULATOR models, a capture file for the REPLAY models)
+        if(ReplayBackend::isReplayModel(Ufxc_Model))
+        {
+            m_replay_backend = new ReplayBackend();
+            m_ufxc_interface = m_replay_backend;
+        }
+        else
+        {
+            if(DetectorSimulator::isSimulatorModel(Ufxc_Model))
+            {
+                m_simulator       = new DetectorSimulator();
+                m_capture_backend = new CaptureBackend(m_simulator);
+            }
+            else
+                m_capture_backend = new CaptureBackend(new SdkBackend());
 
-        // convert the Ufxc_Model (label) to the detector type used by the SDK
-        ufxclib::EnumDetectorType sdk_detector_type = m_ufxc_interface->get_detector_type_from_label(Ufxc_Model);
+            m_ufxc_interface = m_capture_backend;
+        }
 
-		//- connect to the DAQ/Detector
-		m_ufxc_interface->open_connection(sdk_detector_type, TCP_cnx, SFP1_cnx, SFP2_cnx, SFP3_cnx, SFP_MTU);
+		//- connect to the DAQ/Detector (the Ufxc_Model label gives the detector type)
+		m_ufxc_interface->open_connection(Ufxc_Model, TCP_cnx, SFP1_cnx, SFP2_cnx, SFP3_cnx, SFP_MTU);
 
 		//- set the registers to the DAQ
 		m_ufxc_interface->set_acquisition_registers_names(m_acquisition_registers);
@@ -259,18 +319,51 @@ Camera::Camera(	const std::string& Ufxc_Model     ,
 		 << "\norigin : " << ue.errors[0].origin
 		 << std::endl;
 		DEB_ERROR() << err_msg;
+		// the destructor is not called
+		releaseBackend();
 		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
 	}
+	catch(Exception& e)
+	{
+		// errors of the simulator or of the plugin checks
+		DEB_ERROR() << "Error in Camera::Camera() : " << e.getErrMsg();
+		releaseBackend();
+		throw;
+	}
 	catch(...)
 	{
 		std::ostringstream err_msg;
 		err_msg << "Error in Camera::Camera() : Unknown error" << std::endl;
 		DEB_ERROR() << err_msg;
+		releaseBackend();
 		THROW_HW_FATAL(ErrorType::Error) << err_msg;
 	}
 
+	// NUMA node of the network interface receiving the SFP links
+	updateNumaNode();
+
+	m_frame_pipeline = new FramePipeline(m_bufferCtrlObj.getBuffer(), m_status_block, m_helper_threads_placement);
+
 	m_acq_thread = new AcqThread(*this);
 	m_acq_thread->start();
+
+	{
+		// the acquisition thread applies its placement before waiting for the first acquisition
+		AutoMutex aLock(m_cond.mutex());
+
+		while(m_acq_thread_effective_placement.empty())
+			m_cond.wait();
+	}
+
+	std::string report;
+	getPlacementReport(report);
+	DEB_ALWAYS() << "Effective placement:\n" << report;
+
+	// first status read before any poll, then refreshed in background
+	refreshDetectorStatus();
+
+	m_status_monitor = new StatusMonitorThread(*this, STATUS_DEFAULT_REFRESH_PERIOD_S);
+	m_status_monitor->start();
 }
 
 //-----------------------------------------------------
@@ -280,24 +373,47 @@ Camera::~Camera()
 {
 	DEB_DESTRUCTOR();
 
+	// no more detector status read
+	delete m_status_monitor;
+
 	//delete the acquisition thread
-	if(m_thread_running == true)
+	if(m_status_block.isThreadRunning())
 	{
 	    m_ufxc_interface->stop_acquisition();
     }
 
 	delete m_acq_thread;
+	delete m_frame_pipeline;
 
 	// releasing the detector control instance
 	DEB_TRACE() << "Camera::Camera - releasing the detector control instance";
+	releaseBackend();
+}
 
-	if(m_ufxc_interface != NULL)
+//-----------------------------------------------------
+// the capture backend owns the backend it records
+//-----------------------------------------------------
+void Camera::releaseBackend()
+{
+	DEB_MEMBER_FUNCT();
+
+	if(m_ufxc_interface == NULL)
+		return;
+
+	try
 	{
 		m_ufxc_interface->close_connection();
-
-		delete m_ufxc_interface;
-		m_ufxc_interface = NULL;
 	}
+	catch(...)
+	{
+		DEB_ERROR() << "Camera::releaseBackend() - the connection could not be closed";
+	}
+
+	delete m_ufxc_interface;
+	m_ufxc_interface  = NULL;
+	m_capture_backend = NULL;
+	m_replay_backend  = NULL;
+	m_simulator       = NULL;
 }
 
 //-----------------------------------------------------
@@ -308,7 +424,10 @@ void Camera::reset()
 	DEB_MEMBER_FUNCT();
 	stopAcq();
 	//@BEGIN : other stuff on Driver/API
-	//...
+	// the registers are read again from the DAQ after a reset
+	// and fully written at the next prepareAcq
+	m_register_cache.invalidateAll();
+	m_register_batch.forgetHardware();
 	//@END
 }
 
@@ -319,9 +438,284 @@ void Camera::prepareAcq()
 {
 	DEB_MEMBER_FUNCT();
 	//@BEGIN : some stuff on Driver/API before start acquisition
+    double prepare_start = Timestamp::now();
 
     if((m_counting_mode == CountingModes::PumpProbeProbe_32)&&(m_nb_frames != 1LL))
 		THROW_HW_ERROR(Error) << "Incorrect number of frames in Pump Probe Probe mode! Should be set to 1.";
+
+    // hardware frames number of the current accumulation factor
+    setNbFrames(m_nb_frames);
+
+    // registers changed since the last acquisition, in one pass
+    int    nb_writes;
+    double commit_time;
+
+    {
+        AutoMutex aLock(m_cond.mutex());
+        double commit_start = Timestamp::now();
+
+        try
+        {
+            nb_writes = commitRegisters();
+        }
+        catch(const ufxclib::Exception& ue)
+        {
+            std::ostringstream err_msg;
+            err_msg << "Error in Camera::prepareAcq() :"
+             << "\nreason : " << ue.errors[0].reason
+             << "\ndesc : "   << ue.errors[0].desc
+             << "\norigin : " << ue.errors[0].origin
+             << std::endl;
+            DEB_ERROR() << err_msg;
+            THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+        }
+
+        commit_time = double(Timestamp::now()) - commit_start;
+    }
+
+    // the Lima buffers are allocated by the control layer, only checked
+    checkBufferPool();
+
+    // pointers of the Lima frame buffers given to fill_image_buffer
+    // (ufxclib has no registration of the caller buffers, the SDK still copies each frame)
+    m_frame_pipeline->cacheFrameBuffers();
+
+    // Lima buffers on the NUMA node of the SFP network interface
+    bindFrameBuffers();
+
+    Size      image_size;
+    ImageType image_type;
+    getDetectorImageSize(image_size);
+    getImageType(image_type);
+
+    // the Lima frames of the hardware binning and roi are smaller
+    {
+        AutoMutex aLock(m_cond.mutex());
+
+        if(useHwBinRoi())
+        {
+            if(!isHwBinRoiSupported())
+                THROW_HW_ERROR(Error) << "Hardware roi and binning need frames of pixels (no packing, sparse records, compression or accumulation)!";
+
+            if((!m_hw_bin.isOne()) && (!isHwBinSupported()))
+                THROW_HW_ERROR(Error) << "Hardware binning does not sum the two probe counters of the pump-probe-probe pixels!";
+
+            m_frame_bin_roi.configure(getPixelImageSize(), m_hw_bin, m_hw_roi);
+            image_size = m_frame_bin_roi.getOutputSize();
+        }
+    }
+
+    FrameDim image_dim(image_size, image_type);
+
+    // better to fail now than at the first received frame
+    if(m_frame_pipeline->getFrameMemSize() < image_dim.getMemSize())
+    {
+		THROW_HW_ERROR(Error) << "Lima frame buffers are too small for the detector images! ("
+                              << m_frame_pipeline->getFrameMemSize() << " < " << image_dim.getMemSize() << " bytes)";
+    }
+
+    // no-op if the image format did not change
+    updateGeometryRemap();
+
+    // raw frames unpacked, geometry corrected, binned and cropped, counters packed and/or sparse frames encoded by the fill workers
+    {
+        AutoMutex aLock(m_cond.mutex());
+        bool plugin_correction = usePluginCorrection();
+        bool packed_output     = usePackedOutput();
+        int  accumulation      = getAccumulationFactor();
+
+        // the raw frames are in the chips order
+        if((m_pixel_decoding == PluginDecoding) && (m_is_geometrical_correction_enabled) && (!plugin_correction))
+            THROW_HW_ERROR(Error) << "Plugin pixel decoding needs the plugin geometrical correction!";
+
+        // the SDK frames are summed by the acquisition thread, without staging frame
+        if((accumulation > 1) && ((m_pixel_decoding == PluginDecoding) || (plugin_correction)))
+            THROW_HW_ERROR(Error) << "Frames accumulation needs the SDK pixel decoding and geometrical correction!";
+
+        if(accumulation > 1)
+        {
+            Size pixel_size = getPixelImageSize();
+
+            m_frame_accumulator.prepare(static_cast<int>(getCountingModePixelDepth(m_counting_mode)),
+                                        pixel_size.getWidth() * pixel_size.getHeight(),
+                                        m_pixel_unpacker.getEffectiveKernel());
+        }
+
+        // Lima sees a Bpp8 image when the counters are packed
+        int  depth       = packed_output ? static_cast<int>(getCountingModePixelDepth(m_counting_mode)) : static_cast<int>(m_depth);
+        Size source_size = getSdkImageSize();
+
+        m_frame_pipeline->setStagingFrames(m_pixel_decoding == PluginDecoding, depth,
+                                           source_size.getWidth() * source_size.getHeight(), m_pixel_unpacker,
+                                           plugin_correction ? &m_geometry_remap : NULL, packed_output,
+                                           useSparseOutput() ? &m_sparse_encoder : NULL,
+                                           (useHwBinRoi() && !m_frame_bin_roi.isIdentity()) ? &m_frame_bin_roi : NULL,
+                                           useProbeChannelsOutput());
+
+        // the compression follows all the conversions
+        Size content_size = getFrameContentSize();
+        int  pixel_size   = getFramePixelSize();
+
+        m_frame_pipeline->setCompression(useCompression() ? &m_frame_compressor : NULL, pixel_size,
+                                         content_size.getWidth() * content_size.getHeight() * pixel_size);
+
+        // the mask and flat-field are applied to the pixels of the Lima frames
+        if(m_pixel_correction_enabled)
+        {
+            if(usePackedOutput() || useSparseOutput() || useProbeChannelsOutput() || (!m_hw_bin.isOne()))
+                THROW_HW_ERROR(Error) << "Pixel mask and flat-field need frames of unbinned pixels (no packing, sparse records or split probes)!";
+
+            // a 32 bits pixel holds the two 16 bits counters of the probes
+            if(m_counting_mode == CountingModes::PumpProbeProbe_32)
+                THROW_HW_ERROR(Error) << "Pixel mask and flat-field do not correct the two probe counters of the pump-probe-probe pixels!";
+
+            if(m_pixel_correction.build(m_pixel_correction_path, m_detector_model, getPixelImageSize(),
+                                        static_cast<int>(m_counting_mode), m_hw_roi, m_pixel_unpacker.getEffectiveKernel()))
+                DEB_TRACE() << "Camera::prepareAcq() - pixel correction table rebuilt";
+
+            // the accumulated frames are summed before the correction
+            unsigned long counter_depth = getCountingModePixelDepth(m_counting_mode);
+            uint64_t      max_value     = ((1ULL << counter_depth) - 1) * static_cast<uint64_t>(accumulation);
+
+            m_pixel_correction.setMaxValue(static_cast<uint32_t>(std::min(max_value, static_cast<uint64_t>(0xFFFFFFFFULL))));
+        }
+
+        m_frame_pipeline->setPixelCorrection(m_pixel_correction_enabled ? &m_pixel_correction : NULL, pixel_size);
+
+        // statistics of the pixels of the Lima frames
+        if((m_frame_statistics_enabled) && (usePackedOutput()))
+            THROW_HW_ERROR(Error) << "Frame statistics need frames of pixels (no packing)!";
+
+        Size statistics_size = useHwBinRoi() ? m_frame_bin_roi.getOutputSize() : content_size;
+
+        m_frame_pipeline->setFrameStatistics(m_frame_statistics_enabled, pixel_size,
+                                             statistics_size.getWidth() * statistics_size.getHeight(),
+                                             getStatisticsSaturationLevel(),
+                                             m_counting_mode == CountingModes::PumpProbeProbe_32);
+    }
+
+    // dead time of a scan point
+    double prepare_time = double(Timestamp::now()) - prepare_start;
+
+    AutoMutex aLock(m_cond.mutex());
+    m_prepare_time        = prepare_time;
+    m_prepare_commit_time = commit_time;
+    m_prepare_nb_writes   = nb_writes;
+    m_prepare_total_time += prepare_time;
+    m_prepare_max_time    = std::max(m_prepare_max_time, prepare_time);
+    m_nb_prepares++;
+
+    DEB_TRACE() << "prepareAcq (ms): " << prepare_time * 1000.0 << " - registers commit (ms): " << commit_time * 1000.0
+                << " - written registers: " << nb_writes;
+}
+
+//-----------------------------------------------------
+// computes the Lima buffers number from the frame rate, the latency
+// tolerance of the consumers and the memory budget, for the Lima
+// frames of the current settings
+//-----------------------------------------------------
+void Camera::computeBufferSizing(int& nb_buffers, double& memory_mb)
+{
+	DEB_MEMBER_FUNCT();
+
+    Size      image_size;
+    ImageType image_type;
+
+    getDetectorImageSize(image_size);
+    getImageType(image_type);
+
+    double frame_mem_size = FrameDim(image_size, image_type).getMemSize();
+
+    // a Lima frame is the sum of the accumulated hardware frames
+    double frame_time_ms = (readRegister(RegisterCache::CountingTime) + readRegister(RegisterCache::WaitingTime)) * getAccumulationFactor();
+    double needed_nb_buffers;
+
+    // frames received during the latency tolerance (+1 for the frame being filled)
+    if(frame_time_ms > 0.0)
+        needed_nb_buffers = ceil(m_buffer_latency_tolerance * 1000.0 / frame_time_ms) + 1.0;
+    else
+        needed_nb_buffers = INT_MAX;
+
+    // no need of more buffers than frames (0 frames means a continuous acquisition)
+    if((m_nb_frames > 0) && (needed_nb_buffers > m_nb_frames))
+        needed_nb_buffers = m_nb_frames;
+
+    // memory budget of the acquisition host
+    double max_nb_buffers = floor(m_buffer_memory_budget * 1024.0 * 1024.0 / frame_mem_size);
+
+    if(needed_nb_buffers > max_nb_buffers)
+    {
+        DEB_TRACE() << "Lima buffers number is limited by the memory budget: " << DEB_VAR2(needed_nb_buffers, m_buffer_memory_budget);
+        needed_nb_buffers = max_nb_buffers;
+    }
+
+    nb_buffers = static_cast<int>(std::max(1.0, std::min(needed_nb_buffers, static_cast<double>(INT_MAX))));
+    memory_mb  = nb_buffers * frame_mem_size / (1024.0 * 1024.0);
+
+    DEB_TRACE() << "Camera::computeBufferSizing() " << DEB_VAR3(frame_time_ms, nb_buffers, memory_mb);
+}
+
+//-----------------------------------------------------
+// the Lima buffers are set up by the control layer before prepareAcq,
+// they are not reallocated here: a smaller pool is only reported
+//-----------------------------------------------------
+void Camera::checkBufferPool()
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+
+    int    nb_buffers;
+    int    recommended_nb_buffers;
+    double recommended_memory;
+
+    m_bufferCtrlObj.getNbBuffers(nb_buffers);
+    computeBufferSizing(recommended_nb_buffers, recommended_memory);
+
+    if(nb_buffers < recommended_nb_buffers)
+    {
+        DEB_WARNING() << "Less Lima buffers than recommended for the latency tolerance: "
+                      << DEB_VAR3(nb_buffers, recommended_nb_buffers, m_buffer_latency_tolerance);
+    }
+}
+
+//-----------------------------------------------------
+// moves the Lima buffers on the NUMA node of the SFP network interface,
+// only after a new allocation
+//-----------------------------------------------------
+void Camera::bindFrameBuffers()
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+
+    if(m_numa_node < 0)
+        return;
+
+    int nb_buffers     = m_frame_pipeline->getNbFrameBuffers();
+    int frame_mem_size = m_frame_pipeline->getFrameMemSize();
+
+    std::vector<void *> frame_buffers(nb_buffers);
+
+    for(int buffer_nb = 0 ; buffer_nb < nb_buffers ; buffer_nb++)
+        frame_buffers[buffer_nb] = m_frame_pipeline->getFrameBuffer(buffer_nb);
+
+    if((frame_buffers  == m_bound_frame_buffers ) &&
+       (m_numa_node    == m_bound_numa_node     ) &&
+       (frame_mem_size == m_bound_frame_mem_size))
+        return;
+
+    int nb_bound_buffers = 0;
+
+    for(int buffer_nb = 0 ; buffer_nb < nb_buffers ; buffer_nb++)
+    {
+        if(NumaPlacement::bindMemory(frame_buffers[buffer_nb], frame_mem_size, m_numa_node))
+            nb_bound_buffers++;
+    }
+
+    m_bound_frame_buffers  = frame_buffers;
+    m_bound_numa_node      = m_numa_node;
+    m_bound_frame_mem_size = frame_mem_size;
+
+    DEB_TRACE() << "Lima buffers on the NUMA node: " << DEB_VAR3(m_numa_node, nb_bound_buffers, nb_buffers);
 }
 
 //-----------------------------------------------------
@@ -331,11 +725,32 @@ void Camera::startAcq()
 {
 	DEB_MEMBER_FUNCT();
 	AutoMutex aLock(m_cond.mutex());
+
+    // a change done after prepareAcq, usually nothing to write
+    try
+    {
+        commitRegisters();
+    }
+    catch(const ufxclib::Exception& ue)
+    {
+        std::ostringstream err_msg;
+        err_msg << "Error in Camera::startAcq() :"
+         << "\nreason : " << ue.errors[0].reason
+         << "\ndesc : "   << ue.errors[0].desc
+         << "\norigin : " << ue.errors[0].origin
+         << std::endl;
+        DEB_ERROR() << err_msg;
+        THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+    }
+
 	m_acq_frame_nb = 0;
+	m_status_block.startAcquisition();
 	StdBufferCbMgr& buffer_mgr = m_bufferCtrlObj.getBuffer();
 	buffer_mgr.setStartTimestamp(Timestamp::now());
 	DEB_TRACE() << "Ensure that Acquisition is Started  ";
 
+    m_frame_pipeline->start();
+
     // we need to force the busy state.
     // if not critical error occured during the previous acquisition
     // we are able to start another acqusition.
@@ -377,7 +792,7 @@ void Camera::stopAcq()
 	AutoMutex aLock(m_cond.mutex());
 
     // Don't do anything if acquisition is idle.
-	if(m_thread_running)
+	if(m_status_block.isThreadRunning())
 	{
         // do not call internalStopAcq in this method because the lock is not a recursive one!
         //@BEGIN : Ensure that Acquisition is Stopped before return ...	
@@ -399,45 +814,91 @@ void Camera::stopAcq()
 void Camera::getStatus(Camera::Status& status)
 {
 	DEB_MEMBER_FUNCT();
-	AutoMutex aLock(m_cond.mutex());
+	double age;
+	getStatus(status, age);
+}
+
+//-----------------------------------------------------
+// reads the cache refreshed by the status monitor, no network access
+// age: time (s) since the last detector status read, -1 if none
+//-----------------------------------------------------
+void Camera::getStatus(Camera::Status& status, double& age)
+{
+	DEB_MEMBER_FUNCT();
+	StatusSnapshot snapshot;
+	m_status_block.read(snapshot);
+
+	status = static_cast<Camera::Status>(snapshot.status);
+	age    = (snapshot.status_timestamp > 0.0) ? (double(Timestamp::now()) - snapshot.status_timestamp) : -1.0;
+
+	DEB_RETURN() << DEB_VAR2(status, age);
+}
+
+//-----------------------------------------------------
+// called by the status monitor, the camera lock is not held during
+// the TCP round trip: the backend serializes its SDK calls
+//-----------------------------------------------------
+void Camera::refreshDetectorStatus()
+{
+	DEB_MEMBER_FUNCT();
+
+	// a status set by the control or the acquisition during the read is newer
+	unsigned       generation = m_status_block.getStatusGeneration();
+	Camera::Status status     = static_cast<Camera::Status>(m_status_block.getStatus());
 
     // managing the error state which could be forced by the acquisition thread
-    if(m_status != Camera::Fault)
+    if(status != Camera::Fault)
     {
     	ufxclib::EnumDetectorStatus det_status;
 
-        // getting the detector status
-	    det_status = m_ufxc_interface->get_detector_status();
+        try
+        {
+            // getting the detector status
+	        det_status = m_ufxc_interface->get_detector_status();
+        }
+	    catch(const ufxclib::Exception& ue)
+	    {
+		    std::ostringstream err_msg;
+		    err_msg << "Error in Camera::refreshDetectorStatus() :"
+		     << "\nreason : " << ue.errors[0].reason
+		     << "\ndesc : " << ue.errors[0].desc
+		     << "\norigin : " << ue.errors[0].origin
+		     << std::endl;
+		    DEB_ERROR() << err_msg;
+
+		    // the cached status gets older
+		    return;
+	    }
 
 	    switch(det_status)
 	    {
 		    case ufxclib::EnumDetectorStatus::E_DET_READY:
-			    m_status = Camera::Ready;
+			    status = Camera::Ready;
 			    //DEB_TRACE() << "E_DET_READY";
 			    break;
 		    case ufxclib::EnumDetectorStatus::E_DET_BUSY:
-			    m_status = Camera::Busy;
+			    status = Camera::Busy;
 			    //DEB_TRACE() << "E_DET_BUSY";
 			    break;
 		    case ufxclib::EnumDetectorStatus::E_DET_DELAY_SCANNING:
 		    case ufxclib::EnumDetectorStatus::E_DET_CONFIGURING:
-			    m_status = Camera::Configuring;
+			    status = Camera::Configuring;
 			    //DEB_TRACE() << "E_DET_CONFIGURING";
 			    break;
 		    case ufxclib::EnumDetectorStatus::E_DET_NOT_CONFIGURED:
-			    m_status = Camera::Ready;
+			    status = Camera::Ready;
 			    //DEB_TRACE() << "E_DET_NOT_CONFIGURED";
 			    break;
 		    case ufxclib::EnumDetectorStatus::E_DET_ERROR:
-			    m_status = Camera::Fault;
+			    status = Camera::Fault;
 			    DEB_TRACE() << "E_DET_ERROR";
 			    break;
 	    }
     }
 
-	status = m_status;
-	aLock.unlock();
-	DEB_RETURN() << DEB_VAR1(status);
+	// the Fault status forced by the acquisition thread is kept
+	if(!m_status_block.statusRefreshed(status, Timestamp::now(), generation))
+		DEB_TRACE() << "detector status changed during the read, refresh ignored";
 }
 
 //-----------------------------------------------------
@@ -446,10 +907,8 @@ void Camera::getStatus(Camera::Status& status)
 void Camera::setStatus(Camera::Status status, bool force)
 {
 	DEB_MEMBER_FUNCT();
-	//AutoMutex aLock(m_cond.mutex());	
-	if(force || m_status != Camera::Fault)
-		m_status = status;
-	//m_cond.broadcast();
+	// no lock: the Fault status is checked in the status block
+	m_status_block.setStatus(status, force);
 }
 
 //-----------------------------------------------------
@@ -460,8 +919,9 @@ bool Camera::readFrames(void)
     DEB_MEMBER_FUNCT();
 	DEB_TRACE() << "Camera::readFrames() ";
 
-    double frame_time = m_ufxc_interface->get_counting_time_ms() + m_ufxc_interface->get_waiting_time_ms();
-    bool fast_acquisition = (frame_time < 100); // if the frame time is inferior of 100 ms, we need te treat the frames faster
+    // the wait policy depends on the frame period
+    double frame_time = readRegister(RegisterCache::CountingTime) + readRegister(RegisterCache::WaitingTime);
+    m_wait_strategy.start(frame_time);
 
     // reading the Lima frame size in bytes
 	StdBufferCbMgr& buffer_mgr     = m_bufferCtrlObj.getBuffer();
@@ -469,8 +929,17 @@ bool Camera::readFrames(void)
     int             frame_mem_size = frame_dim.getMemSize();
     Size            frame_size     = frame_dim.getSize();
     int             frame_depth    = frame_dim.getDepth();
-    bool            incoherent_frame_index = false; // will be set to true if there is at least one incoherent frame received (frame lost)
+    int             staging_frame_size = m_frame_pipeline->getStagingFrameSize(); // 0: the SDK fills the Lima buffers
+    bool            raw_frames     = m_frame_pipeline->isRawFrames();
+    int             accumulation   = getAccumulationFactor(); // hardware frames in a Lima frame
     std::size_t     built_images_nb;
+    int             lost_frame_nb;
+
+    // each image goes in the Lima buffer of its hardware index
+    m_reorder_window.start(m_frame_pipeline->getMaxInFlight(), m_nb_frames * accumulation);
+
+    if(accumulation > 1)
+        m_frame_accumulator.start(m_frame_pipeline->getMaxInFlight());
 
 	DEB_TRACE() << "Camera::readFrames() - starting acquisition - size (" 
                 << frame_size.getWidth () << ", " 
@@ -480,56 +949,140 @@ bool Camera::readFrames(void)
     // register the plugin as an acquisition customer
     m_ufxc_interface->register_acquisition_customer("Lima Ufxc Plugin");
 
+    // the end of the acquisition is done even if a step of the reading throws
+    struct ReadFramesGuard
+    {
+        Camera& cam;
+        bool    active;
+        ~ReadFramesGuard() { if(active) cam.abortReadFrames(); }
+    } guard = { *this, true };
+
     // read all the frames or until there is a stop/error
     while(!m_ufxc_interface->end_of_transfer())
     {
-        // waiting for new images to receive
-        m_ufxc_interface->waiting_built_images();
-
-        // getting the images
-        built_images_nb = m_ufxc_interface->get_built_images_nb();
+        // waiting for new images to receive and getting the images
+        built_images_nb = m_wait_strategy.wait(*m_ufxc_interface);
 
         while(built_images_nb)
         {
-            std::size_t image_index = m_ufxc_interface->get_first_built_image_index();
+            int frame_index = static_cast<int>(m_ufxc_interface->get_first_built_image_index());
+
+            // the missing frames which can not wait anymore are given to Lima as blank frames
+            while((lost_frame_nb = m_reorder_window.popLost(frame_index)) >= 0)
+                pushLostFrame(lost_frame_nb);
+
+            bool   accepted = m_reorder_window.accept(frame_index);
+            void * bptr;
+            void * rptr = NULL;
+
+            if(accepted && (accumulation > 1))
+            {
+                // the SDK frame is added in the Lima buffer once filled
+                bptr = m_frame_accumulator.getInputBuffer();
+            }
+            else
+            if(accepted)
+            {
+                // the Lima buffer of this frame can be used by a frame not yet published
+                m_frame_pipeline->waitFreeBuffer(frame_index);
+
+	            // preparing Lima Frame Ptr (read at prepareAcq)
+	            bptr = m_frame_pipeline->getFrameBuffer(frame_index);
 
-            if((!incoherent_frame_index)&&(image_index != m_acq_frame_nb))
+                // the staging frame is converted in the Lima buffer by a fill worker
+                if(staging_frame_size)
+                    rptr = m_frame_pipeline->getStagingBuffer(frame_index);
+            }
+            else
             {
-    	        DEB_ERROR() << "---- received frame index " << image_index << " is incoherent with the needed frame index " << m_acq_frame_nb;
-                incoherent_frame_index = true;
+                // late or duplicated image: removed from the SDK queue but not given to Lima
+                m_drop_buffer.resize(std::max(frame_mem_size, staging_frame_size));
+                bptr = &m_drop_buffer[0];
+
+                if(staging_frame_size)
+                    rptr = bptr;
             }
 
-	        // preparing Lima Frame Ptr 
-	        void * bptr = buffer_mgr.getFrameBufferPtr(m_acq_frame_nb);
+            char * fill_ptr  = reinterpret_cast<char *>(rptr ? rptr : bptr);
+            int    fill_size = rptr ? staging_frame_size : frame_mem_size;
+            bool   filled;
+
+            // the SDK frame of the accumulation has the counting mode pixels
+            if(accepted && (accumulation > 1))
+                fill_size = m_frame_accumulator.getInputFrameSize();
+
+            if(raw_frames)
+                filled = m_ufxc_interface->fill_raw_image_buffer(fill_ptr, fill_size);
+            else
+                filled = m_ufxc_interface->fill_image_buffer(fill_ptr, fill_size);
 
-            if(!m_ufxc_interface->fill_image_buffer(reinterpret_cast<char *>(bptr), frame_mem_size))
+            if(!filled)
             {
                 // A problem occured, it is safer to stop the acquisition.
                 // We will exit from the loop.
-    	        DEB_ERROR() << "---- Error during fill image buffer of image " << m_acq_frame_nb;
+    	        DEB_ERROR() << "---- Error during fill image buffer of image " << frame_index;
         	    m_ufxc_interface->stop_acquisition();
+
+                // the publisher can not wait for this frame
+                if(accepted)
+                    pushLostFrame(frame_index);
+            }
+            else
+            if(accepted && (accumulation > 1))
+            {
+                pushAccumulatedFrame(frame_index, bptr);
             }
             else
+            if(accepted)
             {
-		        // pushing the image buffer through Lima 
-		        HwFrameInfoType frame_info;
-		        frame_info.acq_frame_nb = m_acq_frame_nb;
-		        buffer_mgr.newFrameReady(frame_info);
-		        m_acq_frame_nb++;
+		        // the fill workers and the publisher take the frame from here
+		        FrameJob job;
+		        job.acq_frame_nb = frame_index;
+		        job.frame_ptr    = bptr;
+		        job.raw_ptr      = rptr;
+		        job.lost         = false;
+		        m_frame_pipeline->push(job);
             }
 
+            m_acq_frame_nb = m_reorder_window.getNbReceivedFrames();
+            m_status_block.setNbReceivedFrames(m_acq_frame_nb);
             built_images_nb--;
 
             // if this is a slow acquisition, we need to check if there is an error/stop
             // for a fast management of acquisition end.
-            if((!fast_acquisition) && (built_images_nb) && (m_ufxc_interface->end_of_transfer()))
+            if((m_wait_strategy.checkEndBetweenFrames()) && (built_images_nb) && (m_ufxc_interface->end_of_transfer()))
             {
                 break;
             }
         }
+
+        // the missing frames are not waited longer than the reorder timeout
+        while((lost_frame_nb = m_reorder_window.popExpired()) >= 0)
+            pushLostFrame(lost_frame_nb);
+    }
+
+    // no more image to wait for, the holes are filled before the end
+    while((lost_frame_nb = m_reorder_window.popMissing()) >= 0)
+        pushLostFrame(lost_frame_nb);
+
+    DEB_TRACE() << "received images number (" << m_acq_frame_nb << ") - measured frame period (" 
+                << m_wait_strategy.getMeasuredFramePeriod() << " ms)";
+
+    if(m_reorder_window.getNbLostFrames() || m_reorder_window.getNbDroppedFrames())
+    {
+        DEB_WARNING() << "lost frames number (" << m_reorder_window.getNbLostFrames() << ") - dropped images number ("
+                      << m_reorder_window.getNbDroppedFrames() << ")";
+    }
+
+    // stopped acquisition: the last Lima frame did not receive all its frames
+    if((accumulation > 1) && (m_frame_accumulator.getNbOpenFrames()))
+    {
+        DEB_WARNING() << "incomplete accumulated frames not given to Lima: " << m_frame_accumulator.getNbOpenFrames();
     }
 
-    DEB_TRACE() << "received images number (" << m_acq_frame_nb << ")";
+    // waiting for the last frames to be given to Lima
+    guard.active = false;
+    m_frame_pipeline->finish();
 
     // unregister the plugin as an acquisition customer
     m_ufxc_interface->unregister_acquisition_customer("Lima Ufxc Plugin");
@@ -541,13 +1094,103 @@ bool Camera::readFrames(void)
     return (!m_ufxc_interface->failed_acquisition());
 }
 
+//-----------------------------------------------------
+// called while readFrames throws: the fill workers must not keep Lima
+// buffers and the plugin must not stay an SDK customer for the next
+// acquisition, the errors of this cleanup are only logged
+//-----------------------------------------------------
+void Camera::abortReadFrames()
+{
+    DEB_MEMBER_FUNCT();
+
+    try
+    {
+        m_ufxc_interface->stop_acquisition();
+
+        // the publisher can not wait for the missing frames
+        int lost_frame_nb;
+
+        while((lost_frame_nb = m_reorder_window.popMissing()) >= 0)
+            pushLostFrame(lost_frame_nb);
+
+        m_frame_pipeline->finish();
+    }
+    catch(...)
+    {
+        DEB_ERROR() << "Camera::abortReadFrames() - the pushed frames could not be published";
+    }
+
+    try
+    {
+        m_ufxc_interface->unregister_acquisition_customer("Lima Ufxc Plugin");
+    }
+    catch(...)
+    {
+        DEB_ERROR() << "Camera::abortReadFrames() - the plugin could not be unregistered";
+    }
+}
+
+//-----------------------------------------------------
+// blank frame in the Lima buffer of a lost image
+//-----------------------------------------------------
+void Camera::pushLostFrame(int frame_index)
+{
+    DEB_MEMBER_FUNCT();
+
+    // a lost frame counts for zero in its Lima frame
+    if(getAccumulationFactor() > 1)
+    {
+        pushAccumulatedFrame(frame_index, NULL);
+        return;
+    }
+
+    m_frame_pipeline->waitFreeBuffer(frame_index);
+
+    // the fill workers clear the Lima buffer
+    FrameJob job;
+    job.acq_frame_nb = frame_index;
+    job.frame_ptr    = m_frame_pipeline->getFrameBuffer(frame_index);
+    job.raw_ptr      = NULL;
+    job.lost         = true;
+    m_frame_pipeline->push(job);
+}
+
+//-----------------------------------------------------
+// hardware frame added in the Lima buffer of its accumulated frame,
+// which is published once complete (frame NULL: lost frame)
+//-----------------------------------------------------
+void Camera::pushAccumulatedFrame(int frame_index, const void * frame)
+{
+    DEB_MEMBER_FUNCT();
+
+    int acc_frame_nb = frame_index / getAccumulationFactor();
+
+    // first frame of the accumulated frame: its Lima buffer can be used by a frame not yet published
+    if(!m_frame_accumulator.isOpen(acc_frame_nb))
+        m_frame_pipeline->waitFreeBuffer(acc_frame_nb);
+
+    void * acc_frame = m_frame_pipeline->getFrameBuffer(acc_frame_nb);
+
+    if(!m_frame_accumulator.add(acc_frame_nb, acc_frame, frame))
+        return;
+
+    // already filled, the fill workers only forward it to the publisher
+    FrameJob job;
+    job.acq_frame_nb = acc_frame_nb;
+    job.frame_ptr    = acc_frame;
+    job.raw_ptr      = NULL;
+    job.lost         = false;
+    m_frame_pipeline->push(job);
+}
+
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
 int Camera::getNbHwAcquiredFrames()
 {
 	DEB_MEMBER_FUNCT();
-	return m_acq_frame_nb;
+	// frames already given to Lima, read without the camera lock
+	return m_status_block.getNbAcquiredFrames();
 }
 
 //-----------------------------------------------------
@@ -558,12 +1201,16 @@ void Camera::AcqThread::threadFunction()
 	DEB_MEMBER_FUNCT();
 	AutoMutex aLock(m_cam.m_cond.mutex());
 
+	// cpus and scheduling of the acquisition thread
+	m_cam.m_acq_thread_effective_placement = m_cam.m_acq_thread_placement.applyToCurrentThread("acquisition thread");
+	m_cam.m_acq_thread_placement_changed = false;
+
 	while(!m_cam.m_quit)
 	{
 		while(m_cam.m_wait_flag && !m_cam.m_quit)
 		{
 			DEB_TRACE() << "Wait for start acquisition";
-			m_cam.m_thread_running = false;
+			m_cam.m_status_block.setThreadRunning(false);
 			m_cam.m_cond.broadcast();
 			m_cam.m_cond.wait();
 		}
@@ -572,7 +1219,15 @@ void Camera::AcqThread::threadFunction()
 			return;
 
 		DEB_TRACE() << "AcqThread Running";
-		m_cam.m_thread_running = true;
+		m_cam.m_status_block.setThreadRunning(true);
+
+		// placement changed since the last acquisition
+		if(m_cam.m_acq_thread_placement_changed)
+		{
+			m_cam.m_acq_thread_effective_placement = m_cam.m_acq_thread_placement.applyToCurrentThread("acquisition thread");
+			m_cam.m_acq_thread_placement_changed = false;
+		}
+
 		m_cam.m_cond.broadcast();
 		aLock.unlock();
 
@@ -629,7 +1284,7 @@ void Camera::AcqThread::threadFunction()
 
 		    DEB_TRACE() << " AcqThread::threadfunction() Setting thread running flag to false";
 		    aLock.lock();
-		    m_cam.m_thread_running = false;
+		    m_cam.m_status_block.setThreadRunning(false);
 		    m_cam.m_wait_flag = true;
 		    aLock.unlock();
 
@@ -642,7 +1297,7 @@ void Camera::AcqThread::threadFunction()
 
 		    DEB_TRACE() << " AcqThread::threadfunction() Setting thread running flag to false";
 		    aLock.lock();
-		    m_cam.m_thread_running = false;
+		    m_cam.m_status_block.setThreadRunning(false);
 		    m_cam.m_wait_flag = true;
 		    aLock.unlock();
         }
@@ -662,6 +1317,73 @@ m_cam(cam)
 	pthread_attr_setscope(&m_thread_attr, PTHREAD_SCOPE_PROCESS);
 }
 
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Camera::StatusMonitorThread::StatusMonitorThread(Camera& cam, double period):
+m_cam(cam),
+m_period(period),
+m_quit(false)
+{
+	pthread_attr_setscope(&m_thread_attr, PTHREAD_SCOPE_PROCESS);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Camera::StatusMonitorThread::~StatusMonitorThread()
+{
+	AutoMutex aLock(m_cond.mutex());
+	m_quit = true;
+	m_cond.broadcast();
+	aLock.unlock();
+	join();
+}
+
+//-----------------------------------------------------
+// refresh period in s
+//-----------------------------------------------------
+void Camera::StatusMonitorThread::setPeriod(double period)
+{
+	AutoMutex aLock(m_cond.mutex());
+	m_period = period;
+	m_cond.broadcast();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double Camera::StatusMonitorThread::getPeriod()
+{
+	AutoMutex aLock(m_cond.mutex());
+	return m_period;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::StatusMonitorThread::threadFunction()
+{
+	DEB_MEMBER_FUNCT();
+
+	// same placement as the pipeline threads
+	ThreadPlacement placement;
+	m_cam.getHelperThreadsPlacement(placement);
+	placement.applyToCurrentThread("status monitor");
+
+	AutoMutex aLock(m_cond.mutex());
+
+	while(!m_quit)
+	{
+		aLock.unlock();
+		m_cam.refreshDetectorStatus();
+		aLock.lock();
+
+		if(!m_quit)
+			m_cond.wait(m_period);
+	}
+}
+
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
@@ -780,8 +1502,7 @@ void Camera::setGeometricalCorrection(bool enabled)
 	DEB_MEMBER_FUNCT();
 	DEB_TRACE() << "Camera::setGeometricalCorrection - " << DEB_VAR1(enabled);
 	AutoMutex aLock(m_cond.mutex());
-    m_ufxc_interface->set_geometrical_correction(enabled);
-    m_is_geometrical_correction_enabled = m_ufxc_interface->get_geometrical_correction();
+    applyGeometricalCorrection(enabled);
 }
 
 //-----------------------------------------------------
@@ -791,374 +1512,1929 @@ void Camera::getGeometricalCorrection(bool& enabled)
 {
 	DEB_MEMBER_FUNCT();
 	AutoMutex aLock(m_cond.mutex());
-    m_is_geometrical_correction_enabled = m_ufxc_interface->get_geometrical_correction();
+
+    // the SDK correction is disabled when the plugin corrects the images
+    if(m_geometrical_correction_engine == SdkCorrection)
+        m_is_geometrical_correction_enabled = (readRegister(RegisterCache::GeometricalCorrection) != 0.0);
+
     enabled = m_is_geometrical_correction_enabled;
 }
 
 //-----------------------------------------------------
-//
+// the image size changes with the engine, updateImageFormat should be called
 //-----------------------------------------------------
-ImageType Camera::getImageTypeOfCountingMode(CountingModes mode)
+void Camera::setGeometricalCorrectionEngine(GeometricalCorrectionEngine engine)
 {
 	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setGeometricalCorrectionEngine - " << DEB_VAR1(engine);
+	AutoMutex aLock(m_cond.mutex());
+    m_geometrical_correction_engine = engine;
+    applyGeometricalCorrection(m_is_geometrical_correction_enabled);
+}
 
-    ImageType type;
-
-    switch(mode)
-    {
-        case CountingModes::Continuous_2     : type = Bpp2 ; break;
-        case CountingModes::Continuous_4     : type = Bpp4 ; break;
-        case CountingModes::Continuous_8     : type = Bpp8 ; break;
-        case CountingModes::Continuous_14    : type = Bpp14; break;
-        case CountingModes::Standard_14      : type = Bpp14; break;
-        case CountingModes::LongCounter_28   : type = Bpp28; break;
-        case CountingModes::PumpProbeProbe_32: type = Bpp32; break;
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getGeometricalCorrectionEngine(GeometricalCorrectionEngine& engine)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    engine = m_geometrical_correction_engine;
+}
 
-	    default:
-		    THROW_HW_ERROR(Error) << "This pixel format of the camera is not managed, only (2, 4, 8, 14, 28, 32) bits cameras are managed!";
-		    break;
-    }
+//-----------------------------------------------------
+// the image size changes with the layout, updateImageFormat should be called
+//-----------------------------------------------------
+void Camera::setChipLayout(const ChipLayout& layout)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setChipLayout - " << DEB_VAR4(layout.chip_width, layout.chip_height, layout.gap_x, layout.gap_y);
+    layout.check();
 
-    return type;
+	AutoMutex aLock(m_cond.mutex());
+    m_chip_layout = layout;
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::getImageType(ImageType& type)
+void Camera::getChipLayout(ChipLayout& layout)
 {
 	DEB_MEMBER_FUNCT();
-
-    type = getImageTypeOfCountingMode(m_counting_mode);
+	AutoMutex aLock(m_cond.mutex());
+    layout = m_chip_layout;
 }
 
 //-----------------------------------------------------
-//
+// called with the camera lock
 //-----------------------------------------------------
-void Camera::setImageType(ImageType type)
+void Camera::applyGeometricalCorrection(bool enabled)
 {
 	DEB_MEMBER_FUNCT();
-	DEB_TRACE() << "Camera::setImageType - " << DEB_VAR1(type);
-	switch(type)
-	{
-		case Bpp2 : m_depth = 2 ; break;
-		case Bpp4 : m_depth = 4 ; break;
-		case Bpp8 : m_depth = 8 ; break;
-		case Bpp14: m_depth = 14; break;
-		case Bpp28: m_depth = 28; break;
-		case Bpp32: m_depth = 32; break;
 
-		default:
-		    THROW_HW_ERROR(Error) << "This pixel format of the camera is not managed, only (2, 4, 8, 14, 28, 32) bits cameras are managed!";
-			break;
-	}
+    // the plugin corrects the images given uncorrected by the SDK
+    m_ufxc_interface->set_geometrical_correction(enabled && (m_geometrical_correction_engine == SdkCorrection));
+    bool sdk_enabled = m_ufxc_interface->get_geometrical_correction();
+
+    m_is_geometrical_correction_enabled = (m_geometrical_correction_engine == SdkCorrection) ? sdk_enabled : enabled;
+
+    // the image size depends on the correction
+    m_register_cache.set(RegisterCache::GeometricalCorrection, sdk_enabled ? 1.0 : 0.0);
+    m_register_cache.invalidateGeometry();
 }
 
 //-----------------------------------------------------
-//
+// called with the camera lock
 //-----------------------------------------------------
-void Camera::getDetectorType(std::string& type)
+bool Camera::usePluginCorrection() const
+{
+    return m_is_geometrical_correction_enabled && (m_geometrical_correction_engine == PluginCorrection);
+}
+
+//-----------------------------------------------------
+// the image format changes, updateImageFormat should be called
+//-----------------------------------------------------
+void Camera::setPackedPixelOutput(bool enabled)
 {
 	DEB_MEMBER_FUNCT();
-	//@BEGIN : Get Detector type from Driver/API
-	type = m_detector_type;
-	//@END	
+	DEB_TRACE() << "Camera::setPackedPixelOutput - " << DEB_VAR1(enabled);
+	AutoMutex aLock(m_cond.mutex());
+    m_packed_pixel_output = enabled;
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::getDetectorModel(std::string& model)
+void Camera::getPackedPixelOutput(bool& enabled)
 {
 	DEB_MEMBER_FUNCT();
-	//@BEGIN : Get Detector model from Driver/API
-	model = m_detector_model;
-	//@END		
+	AutoMutex aLock(m_cond.mutex());
+    enabled = m_packed_pixel_output;
 }
 
 //-----------------------------------------------------
-//
+// for the consumers of the packed frames: one byte per pixel
+// in the image of the counting mode
 //-----------------------------------------------------
-void Camera::getDetectorImageSize(Size& size)
+void Camera::unpackFrame(const void * packed_frame, void * pixels)
 {
 	DEB_MEMBER_FUNCT();
 	AutoMutex aLock(m_cond.mutex());
-	//@BEGIN : Get Detector type from Driver/API	
-    size = Size(m_ufxc_interface->get_current_width(), m_ufxc_interface->get_current_height());
-	//@END
+
+    if(!usePackedOutput())
+        THROW_HW_ERROR(Error) << "The frames are not packed!";
+
+    Size size = getPixelImageSize();
+    m_pixel_unpacker.unpack(static_cast<int>(getCountingModePixelDepth(m_counting_mode)), packed_frame, pixels,
+                            size.getWidth() * size.getHeight());
 }
 
 //-----------------------------------------------------
-//
+// only the 2 and 4 bits counting modes are packed
 //-----------------------------------------------------
-void Camera::getPixelSize(double& sizex, double& sizey)
+bool Camera::usePackedOutput() const
+{
+    return m_packed_pixel_output && (!useSparseOutput()) && (getAccumulationFactor() == 1) &&
+           ((m_counting_mode == CountingModes::Continuous_2) || (m_counting_mode == CountingModes::Continuous_4));
+}
+
+//-----------------------------------------------------
+// the image format and the frames number change, updateImageFormat should be called
+//-----------------------------------------------------
+void Camera::setAccumulationNbFrames(int nb_frames)
 {
 	DEB_MEMBER_FUNCT();
-	//@BEGIN : Get Detector type from Driver/API			
-	sizex = xPixelSize;
-	sizey = yPixelSize;
-	//@END
+	DEB_TRACE() << "Camera::setAccumulationNbFrames - " << DEB_VAR1(nb_frames);
+
+    {
+	    AutoMutex aLock(m_cond.mutex());
+        m_frame_accumulator.setNbFrames(nb_frames);
+    }
+
+    // recursive lock problem - can not be called with a locked mutex
+    setNbFrames(m_nb_frames);
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-HwBufferCtrlObj* Camera::getBufferCtrlObj()
+void Camera::getAccumulationNbFrames(int& nb_frames)
 {
-	return &m_bufferCtrlObj;
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    nb_frames = m_frame_accumulator.getNbFrames();
 }
 
 //-----------------------------------------------------
-//
+// the image format changes, updateImageFormat should be called
 //-----------------------------------------------------
-HwEventCtrlObj* Camera::getEventCtrlObj()
+void Camera::setAccumulationImageType(ImageType type)
 {
-	return &m_event_ctrl_obj;
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setAccumulationImageType - " << DEB_VAR1(type);
+	AutoMutex aLock(m_cond.mutex());
+    m_frame_accumulator.setImageType(type);
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-bool Camera::checkTrigModeOfCountingMode(TrigMode trig_mode, CountingModes counting_mode)
+void Camera::getAccumulationImageType(ImageType& type)
 {
 	DEB_MEMBER_FUNCT();
-	DEB_TRACE() << "Camera::checkTrigModeOfCountingMode() " << DEB_VAR1(trig_mode    ) << ", " 
-                                                            << DEB_VAR1(counting_mode);
-	bool valid_mode = true;
+	AutoMutex aLock(m_cond.mutex());
+    type = m_frame_accumulator.getImageType();
+}
 
-	switch(counting_mode)
-	{
-		case CountingModes::Continuous_2 : 
-		case CountingModes::Continuous_4 : 
-		case CountingModes::Continuous_8 : 
-		case CountingModes::Continuous_14 : 
-		case CountingModes::Standard_14 : 
-		case CountingModes::LongCounter_28 : 
-		if( (trig_mode != IntTrig) && (trig_mode != ExtTrigSingle) )
-		{
-			valid_mode = false;
-		}
-		break;
+//-----------------------------------------------------
+// hardware frames in a Lima frame, only the 2, 4 and 8 bits counting modes are accumulated
+//-----------------------------------------------------
+int Camera::getAccumulationFactor() const
+{
+    if((m_counting_mode == CountingModes::Continuous_2) ||
+       (m_counting_mode == CountingModes::Continuous_4) ||
+       (m_counting_mode == CountingModes::Continuous_8))
+        return m_frame_accumulator.getNbFrames();
 
-		case CountingModes::PumpProbeProbe_32 : 
-		if(trig_mode != ExtTrigMult)
-		{
-			valid_mode = false;
-		}
-		break;
+    return 1;
+}
 
-		default : 
-		DEB_ERROR() << "Camera::checkTrigModeOfCountingMode - counting mode " << counting_mode << "is not managed!";
-		break;
-	}
+//-----------------------------------------------------
+// the image format changes, updateImageFormat should be called
+//-----------------------------------------------------
+void Camera::setSparseOutput(bool enabled)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setSparseOutput - " << DEB_VAR1(enabled);
+	AutoMutex aLock(m_cond.mutex());
+    m_sparse_output = enabled;
+}
 
-	return valid_mode;
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSparseOutput(bool& enabled)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    enabled = m_sparse_output;
+}
+
+//-----------------------------------------------------
+// used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setSparseOccupancyThreshold(double threshold)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setSparseOccupancyThreshold - " << DEB_VAR1(threshold);
+	AutoMutex aLock(m_cond.mutex());
+    m_sparse_encoder.setOccupancyThreshold(threshold);
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-bool Camera::checkTrigMode(TrigMode mode)
+void Camera::getSparseOccupancyThreshold(double& threshold)
 {
 	DEB_MEMBER_FUNCT();
-    return ((mode == IntTrig      ) || 
-            (mode == ExtTrigSingle) ||
-            (mode == ExtTrigMult  ));
+	AutoMutex aLock(m_cond.mutex());
+    threshold = m_sparse_encoder.getOccupancyThreshold();
 }
 
 //-----------------------------------------------------
-// get default trigger mode for the counting mode
+// frames of the current or last acquisition, read without the camera lock
 //-----------------------------------------------------
-TrigMode Camera::getDefaultTrigModeOfCountingMode(CountingModes counting_mode) const
+void Camera::getSparseOutputStats(unsigned long& nb_sparse_frames, unsigned long& nb_dense_frames)
 {
 	DEB_MEMBER_FUNCT();
+    m_frame_pipeline->getSparseStats(nb_sparse_frames, nb_dense_frames);
+}
 
-    TrigMode result;
+//-----------------------------------------------------
+// for the consumers of the records: the frame in the Lima storage of the pixels
+//-----------------------------------------------------
+void Camera::decodeSparseFrame(const void * record, void * pixels)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
 
-    if((counting_mode == CountingModes::Continuous_2  ) ||
-       (counting_mode == CountingModes::Continuous_4  ) ||
-       (counting_mode == CountingModes::Continuous_8  ) ||
-       (counting_mode == CountingModes::Continuous_14 ) ||
-       (counting_mode == CountingModes::Standard_14   ) ||
-       (counting_mode == CountingModes::LongCounter_28))
-    {
-        result = IntTrig;
-    }
-    else
-    if(counting_mode == CountingModes::PumpProbeProbe_32)
-    {
-        result = ExtTrigMult;
-    }
-    else
-    {
-        DEB_ERROR() << "Camera::getDefaultTrigModeOfCountingMode - counting mode " << counting_mode << "is not managed!";
-    }
+    if(!useSparseOutput())
+        THROW_HW_ERROR(Error) << "The frames are not sparse records!";
 
-	return result;
+    Size size       = getPixelImageSize();
+    int  pixel_size = PixelUnpacker::getPixelSize(static_cast<int>(getCountingModePixelDepth(m_counting_mode)));
+
+    if(!SparseEncoder::decode(pixel_size, record, pixels, size.getWidth() * size.getHeight()))
+        THROW_HW_ERROR(Error) << "The record is not a frame of the current image!";
 }
 
 //-----------------------------------------------------
-// get default trigger mode for the current counting mode
+// the image format changes, updateImageFormat should be called
 //-----------------------------------------------------
-TrigMode Camera::getDefaultTrigMode() const
+void Camera::setCompressionCodec(FrameCompressor::Codec codec)
 {
-    DEB_MEMBER_FUNCT();
-    return getDefaultTrigModeOfCountingMode(m_counting_mode);
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setCompressionCodec - " << FrameCompressor::getCodecName(codec);
+	AutoMutex aLock(m_cond.mutex());
+    m_frame_compressor.setCodec(codec);
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::setTrigMode(TrigMode mode)
+void Camera::getCompressionCodec(FrameCompressor::Codec& codec)
 {
 	DEB_MEMBER_FUNCT();
-	DEB_TRACE() << "Camera::setTrigMode() " << DEB_VAR1(mode)    << ", " 
-                                            << DEB_VAR1(m_depth) << ", " 
-                                            << DEB_VAR1(m_counting_mode);
-	DEB_PARAM() << DEB_VAR1(mode);
-
-    bool incoherence = false;
-    ufxclib::EnumAcquisitionMode acq_mode;
+	AutoMutex aLock(m_cond.mutex());
+    codec = m_frame_compressor.getCodec();
+}
 
-	try
+//-----------------------------------------------------
+// frames of the current or last acquisition, read without the camera lock
+//-----------------------------------------------------
+void Camera::getCompressionStats(double& ratio, double& mean_frame_time, unsigned long& nb_frames)
+{
+	DEB_MEMBER_FUNCT();
+    double frame_bytes;
+    double compressed_bytes;
+    double compression_time;
+
+    m_frame_pipeline->getCompressionStats(nb_frames, frame_bytes, compressed_bytes, compression_time);
+
+    ratio           = (compressed_bytes > 0.0) ? frame_bytes / compressed_bytes : 0.0;
+    mean_frame_time = (nb_frames) ? compression_time / nb_frames : 0.0;
+}
+
+//-----------------------------------------------------
+// for the consumers of the records
+//-----------------------------------------------------
+void Camera::decompressFrame(const void * record, void * frame)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+
+    if(!useCompression())
+        THROW_HW_ERROR(Error) << "The frames are not compressed!";
+
+    Size size       = getFrameContentSize();
+    int  pixel_size = getFramePixelSize();
+
+    if(!FrameCompressor::decompress(pixel_size, record, frame, size.getWidth() * size.getHeight() * pixel_size))
+        THROW_HW_ERROR(Error) << "The record is not a compressed frame of the current image!";
+}
+
+//-----------------------------------------------------
+// used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setPixelCorrectionEnabled(bool enabled)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setPixelCorrectionEnabled - " << DEB_VAR1(enabled);
+	AutoMutex aLock(m_cond.mutex());
+    m_pixel_correction_enabled = enabled;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPixelCorrectionEnabled(bool& enabled)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    enabled = m_pixel_correction_enabled;
+}
+
+//-----------------------------------------------------
+// used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setPixelCorrectionPath(const std::string& directory)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setPixelCorrectionPath - " << DEB_VAR1(directory);
+	AutoMutex aLock(m_cond.mutex());
+    m_pixel_correction_path = directory;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPixelCorrectionPath(std::string& directory)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    directory = m_pixel_correction_path;
+}
+
+//-----------------------------------------------------
+// new files with the same names (calibration done again)
+//-----------------------------------------------------
+void Camera::reloadPixelCorrection()
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    m_pixel_correction.clear();
+}
+
+//-----------------------------------------------------
+// pixels of the last prepared table
+//-----------------------------------------------------
+void Camera::getPixelCorrectionNbMaskedPixels(int& nb_pixels)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    nb_pixels = m_pixel_correction.getNbMaskedPixels();
+}
+
+//-----------------------------------------------------
+// the image format changes, updateImageFormat should be called
+//-----------------------------------------------------
+void Camera::setProbeChannelsOutput(bool enabled)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setProbeChannelsOutput - " << DEB_VAR1(enabled);
+	AutoMutex aLock(m_cond.mutex());
+    m_probe_channels_output = enabled;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getProbeChannelsOutput(bool& enabled)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    enabled = m_probe_channels_output;
+}
+
+//-----------------------------------------------------
+// frame: a Lima frame of the current image (Bpp32 or split probes)
+//-----------------------------------------------------
+void Camera::getProbeChannelView(const void * frame, int channel, ProbeChannels::View& view)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+
+    if(m_counting_mode != CountingModes::PumpProbeProbe_32)
+        THROW_HW_ERROR(Error) << "The frames are not pump-probe-probe frames!";
+
+    if(useSparseOutput() || useCompression() || useHwBinRoi())
+        THROW_HW_ERROR(Error) << "The probe counters of the records or binned frames can not be viewed!";
+
+    Size size = getPixelImageSize();
+
+    if(useProbeChannelsOutput())
+        view = ProbeChannels::getSplitView(frame, size, channel);
+    else
+        view = ProbeChannels::getInterleavedView(frame, size, channel);
+}
+
+//-----------------------------------------------------
+// used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setFrameStatisticsEnabled(bool enabled)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setFrameStatisticsEnabled - " << DEB_VAR1(enabled);
+	AutoMutex aLock(m_cond.mutex());
+    m_frame_statistics_enabled = enabled;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameStatisticsEnabled(bool& enabled)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    enabled = m_frame_statistics_enabled;
+}
+
+//-----------------------------------------------------
+// used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setFrameStatisticsSaturation(uint32_t level)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setFrameStatisticsSaturation - " << DEB_VAR1(level);
+	AutoMutex aLock(m_cond.mutex());
+    m_frame_statistics_saturation = level;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameStatisticsSaturation(uint32_t& level)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    level = m_frame_statistics_saturation;
+}
+
+//-----------------------------------------------------
+// read without the camera lock, during or after the acquisition
+//-----------------------------------------------------
+void Camera::getFrameStatistics(int acq_frame_nb, FrameStats& stats)
+{
+	DEB_MEMBER_FUNCT();
+
+    if(!m_frame_pipeline->getFrameStatistics(acq_frame_nb, stats))
+    {
+        THROW_HW_ERROR(Error) << "No statistics of the frame " << acq_frame_nb << " (not yet filled or older than the last "
+                              << m_frame_pipeline->getNbFrameStatisticsSlots() << " frames)!";
+    }
+}
+
+//-----------------------------------------------------
+// stream of the statistics: the client gives the frame following the last read one
+//-----------------------------------------------------
+void Camera::readFrameStatistics(int first_frame_nb, int max_nb_frames, std::vector<FrameStats>& stats)
+{
+	DEB_MEMBER_FUNCT();
+    FrameStats frame_stats;
+
+    stats.clear();
+
+    for(int acq_frame_nb = first_frame_nb ; acq_frame_nb < first_frame_nb + max_nb_frames ; acq_frame_nb++)
+    {
+        if(!m_frame_pipeline->getFrameStatistics(acq_frame_nb, frame_stats))
+            break;
+
+        stats.push_back(frame_stats);
+    }
+}
+
+//-----------------------------------------------------
+// the sums of the accumulated or binned frames saturate later, the camera lock must be held
+//-----------------------------------------------------
+uint32_t Camera::getStatisticsSaturationLevel()
+{
+    if(m_frame_statistics_saturation)
+        return m_frame_statistics_saturation;
+
+    // 16 bits counter of each probe
+    unsigned long depth = (m_counting_mode == CountingModes::PumpProbeProbe_32) ? 16 : getCountingModePixelDepth(m_counting_mode);
+    uint64_t      level = (depth >= 32) ? 0xFFFFFFFFULL : ((1ULL << depth) - 1);
+
+    level *= static_cast<uint64_t>(getAccumulationFactor());
+
+    if(useHwBinRoi())
+        level *= static_cast<uint64_t>(m_hw_bin.getX()) * m_hw_bin.getY();
+
+    return static_cast<uint32_t>(std::min(level, static_cast<uint64_t>(0xFFFFFFFFULL)));
+}
+
+//-----------------------------------------------------
+// the file starts with the next acquisition, not during one
+//-----------------------------------------------------
+void Camera::setCaptureFile(const std::string& file_name)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setCaptureFile - " << DEB_VAR1(file_name);
+	AutoMutex aLock(m_cond.mutex());
+
+    if(m_capture_backend == NULL)
+        THROW_HW_ERROR(NotSupported) << "No capture of a replayed acquisition!";
+
+    if(m_status_block.isThreadRunning())
+        THROW_HW_ERROR(Error) << "The capture file can not be changed during an acquisition!";
+
+    m_capture_backend->setCaptureFile(file_name);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getCaptureFile(std::string& file_name)
+{
+	DEB_MEMBER_FUNCT();
+    file_name = (m_capture_backend != NULL) ? m_capture_backend->getCaptureFile() : std::string();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getCaptureStats(unsigned long& nb_frames, unsigned long& nb_dropped, double& size_mb)
+{
+	DEB_MEMBER_FUNCT();
+    nb_frames  = 0;
+    nb_dropped = 0;
+    size_mb    = 0.0;
+
+    if(m_capture_backend != NULL)
+        m_capture_backend->getCaptureStats(nb_frames, nb_dropped, size_mb);
+}
+
+//-----------------------------------------------------
+// used at the next acquisition
+//-----------------------------------------------------
+void Camera::setReplaySpeed(double speed)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setReplaySpeed - " << DEB_VAR1(speed);
+
+    if(m_replay_backend == NULL)
+        THROW_HW_ERROR(NotSupported) << "The replay speed needs a REPLAY:<capture file> model!";
+
+    m_replay_backend->setSpeed(speed);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getReplaySpeed(double& speed)
+{
+	DEB_MEMBER_FUNCT();
+
+    if(m_replay_backend == NULL)
+        THROW_HW_ERROR(NotSupported) << "The replay speed needs a REPLAY:<capture file> model!";
+
+    speed = m_replay_backend->getSpeed();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setSimulatorTransactionTime(double time_ms)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setSimulatorTransactionTime - " << DEB_VAR1(time_ms);
+
+    if(m_simulator == NULL)
+        THROW_HW_ERROR(NotSupported) << "The transaction time needs a SIMULATOR model!";
+
+    m_simulator->setTransactionTime(time_ms);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSimulatorTransactionTime(double& time_ms)
+{
+	DEB_MEMBER_FUNCT();
+
+    if(m_simulator == NULL)
+        THROW_HW_ERROR(NotSupported) << "The transaction time needs a SIMULATOR model!";
+
+    time_ms = m_simulator->getTransactionTime();
+}
+
+//-----------------------------------------------------
+// calls of the control path received by the simulator
+//-----------------------------------------------------
+void Camera::getSimulatorTransactionStats(unsigned long& nb_reads, unsigned long& nb_writes)
+{
+	DEB_MEMBER_FUNCT();
+
+    if(m_simulator == NULL)
+        THROW_HW_ERROR(NotSupported) << "The transactions are only counted by the SIMULATOR models!";
+
+    m_simulator->getTransactionStats(nb_reads, nb_writes);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::resetSimulatorTransactionStats()
+{
+	DEB_MEMBER_FUNCT();
+
+    if(m_simulator == NULL)
+        THROW_HW_ERROR(NotSupported) << "The transactions are only counted by the SIMULATOR models!";
+
+    m_simulator->resetTransactionStats();
+}
+
+//-----------------------------------------------------
+// start of the simulated acquisition (s), reference of the frames latency
+//-----------------------------------------------------
+void Camera::getSimulatorAcquisitionTiming(double& start_time, double& image_period)
+{
+	DEB_MEMBER_FUNCT();
+
+    if(m_simulator == NULL)
+        THROW_HW_ERROR(NotSupported) << "The acquisition timing is only given by the SIMULATOR models!";
+
+    m_simulator->getAcquisitionTiming(start_time, image_period);
+}
+
+//-----------------------------------------------------
+// the sparse records keep the 32 bits pixels
+//-----------------------------------------------------
+bool Camera::useProbeChannelsOutput() const
+{
+    return m_probe_channels_output && (m_counting_mode == CountingModes::PumpProbeProbe_32) && (!useSparseOutput());
+}
+
+//-----------------------------------------------------
+// the sparse records are already compact
+//-----------------------------------------------------
+bool Camera::useCompression() const
+{
+    return (m_frame_compressor.getCodec() != FrameCompressor::NoCompression) && (!useSparseOutput());
+}
+
+//-----------------------------------------------------
+// the accumulated frames are dense
+//-----------------------------------------------------
+bool Camera::useSparseOutput() const
+{
+    return m_sparse_output && (getAccumulationFactor() == 1);
+}
+
+//-----------------------------------------------------
+// the table is built once per detector model, chip layout and image size
+//-----------------------------------------------------
+void Camera::updateGeometryRemap()
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+
+    if(!usePluginCorrection())
+        return;
+
+    if(m_geometry_remap.build(m_detector_model, m_chip_layout, getSdkImageSize()))
+        DEB_TRACE() << "Camera::updateGeometryRemap() - remap table rebuilt";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ImageType Camera::getImageTypeOfCountingMode(CountingModes mode)
+{
+	DEB_MEMBER_FUNCT();
+
+    ImageType type;
+
+    switch(mode)
+    {
+        case CountingModes::Continuous_2     : type = Bpp2 ; break;
+        case CountingModes::Continuous_4     : type = Bpp4 ; break;
+        case CountingModes::Continuous_8     : type = Bpp8 ; break;
+        case CountingModes::Continuous_14    : type = Bpp14; break;
+        case CountingModes::Standard_14      : type = Bpp14; break;
+        case CountingModes::LongCounter_28   : type = Bpp28; break;
+        case CountingModes::PumpProbeProbe_32: type = Bpp32; break;
+
+	    default:
+		    THROW_HW_ERROR(Error) << "This pixel format of the camera is not managed, only (2, 4, 8, 14, 28, 32) bits cameras are managed!";
+		    break;
+    }
+
+    return type;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getImageType(ImageType& type)
+{
+	DEB_MEMBER_FUNCT();
+
+    type = getImageTypeOfCountingMode(m_counting_mode);
+
+    // the packed counters are seen as bytes
+    if(usePackedOutput())
+        type = Bpp8;
+
+    // the sums of the counters
+    if(getAccumulationFactor() > 1)
+        type = m_frame_accumulator.getImageType();
+
+    // the 16 bits counters of each probe
+    if(useProbeChannelsOutput())
+        type = Bpp16;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setImageType(ImageType type)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setImageType - " << DEB_VAR1(type);
+
+    // the type of the packed, accumulated or split frames is not a counters depth
+    if(usePackedOutput() || (getAccumulationFactor() > 1) || useProbeChannelsOutput())
+    {
+        ImageType frame_type;
+        getImageType(frame_type);
+
+        if(type == frame_type)
+            return;
+    }
+
+	switch(type)
+	{
+		case Bpp2 : m_depth = 2 ; break;
+		case Bpp4 : m_depth = 4 ; break;
+		case Bpp8 : m_depth = 8 ; break;
+		case Bpp14: m_depth = 14; break;
+		case Bpp28: m_depth = 28; break;
+		case Bpp32: m_depth = 32; break;
+
+		default:
+		    THROW_HW_ERROR(Error) << "This pixel format of the camera is not managed, only (2, 4, 8, 14, 28, 32) bits cameras are managed!";
+			break;
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getDetectorType(std::string& type)
+{
+	DEB_MEMBER_FUNCT();
+	//@BEGIN : Get Detector type from Driver/API
+	type = m_detector_type;
+	//@END	
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getDetectorModel(std::string& model)
+{
+	DEB_MEMBER_FUNCT();
+	//@BEGIN : Get Detector model from Driver/API
+	model = m_detector_model;
+	//@END		
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getDetectorImageSize(Size& size)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	//@BEGIN : Get Detector type from Driver/API	
+    size = getFrameContentSize();
+
+    // rows of the record header in front of a dense frame
+    if(useSparseOutput())
+        size = Size(size.getWidth(), size.getHeight() + SparseEncoder::getHeaderRows(size.getWidth(), getFramePixelSize()));
+
+    // rows of the record header in front of a frame which does not compress
+    if(useCompression())
+        size = Size(size.getWidth(), size.getHeight() + FrameCompressor::getHeaderRows(size.getWidth(), getFramePixelSize()));
+	//@END
+}
+
+//-----------------------------------------------------
+// image of the Lima frames before the records, called with the camera lock
+//-----------------------------------------------------
+Size Camera::getFrameContentSize() const
+{
+    Size size = getPixelImageSize();
+
+    // bytes of the packed counters in a Bpp8 image
+    if(usePackedOutput())
+        size = Size(PixelUnpacker::getPackedSize(static_cast<int>(getCountingModePixelDepth(m_counting_mode)), size.getWidth()), size.getHeight());
+
+    // the second probe image follows the first one
+    if(useProbeChannelsOutput())
+        size = ProbeChannels::getSplitSize(size);
+
+    return size;
+}
+
+//-----------------------------------------------------
+// bytes of a Lima pixel, called with the camera lock
+//-----------------------------------------------------
+int Camera::getFramePixelSize() const
+{
+    if(usePackedOutput())
+        return 1;
+
+    if(getAccumulationFactor() > 1)
+        return (m_frame_accumulator.getImageType() == Bpp16) ? 2 : 4;
+
+    if(useProbeChannelsOutput())
+        return 2;
+
+    return PixelUnpacker::getPixelSize(static_cast<int>(getCountingModePixelDepth(m_counting_mode)));
+}
+
+//-----------------------------------------------------
+// image given by the SDK, called with the camera lock
+//-----------------------------------------------------
+Size Camera::getSdkImageSize() const
+{
+    return Size(static_cast<int>(readRegister(RegisterCache::ImageWidth )),
+                static_cast<int>(readRegister(RegisterCache::ImageHeight)));
+}
+
+//-----------------------------------------------------
+// image in pixels (before the packing), called with the camera lock
+//-----------------------------------------------------
+Size Camera::getPixelImageSize() const
+{
+    Size size = getSdkImageSize();
+
+    // the plugin correction inserts the gaps between the chips
+    if(usePluginCorrection())
+        size = GeometryRemap::getCorrectedSize(m_chip_layout, size);
+
+    return size;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPixelSize(double& sizex, double& sizey)
+{
+	DEB_MEMBER_FUNCT();
+	//@BEGIN : Get Detector type from Driver/API			
+	sizex = xPixelSize;
+	sizey = yPixelSize;
+	//@END
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+HwBufferCtrlObj* Camera::getBufferCtrlObj()
+{
+	return &m_bufferCtrlObj;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+HwEventCtrlObj* Camera::getEventCtrlObj()
+{
+	return &m_event_ctrl_obj;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool Camera::checkTrigModeOfCountingMode(TrigMode trig_mode, CountingModes counting_mode)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::checkTrigModeOfCountingMode() " << DEB_VAR1(trig_mode    ) << ", " 
+                                                            << DEB_VAR1(counting_mode);
+	bool valid_mode = true;
+
+	switch(counting_mode)
+	{
+		case CountingModes::Continuous_2 : 
+		case CountingModes::Continuous_4 : 
+		case CountingModes::Continuous_8 : 
+		case CountingModes::Continuous_14 : 
+		case CountingModes::Standard_14 : 
+		case CountingModes::LongCounter_28 : 
+		if( (trig_mode != IntTrig) && (trig_mode != ExtTrigSingle) )
+		{
+			valid_mode = false;
+		}
+		break;
+
+		case CountingModes::PumpProbeProbe_32 : 
+		if(trig_mode != ExtTrigMult)
+		{
+			valid_mode = false;
+		}
+		break;
+
+		default : 
+		DEB_ERROR() << "Camera::checkTrigModeOfCountingMode - counting mode " << counting_mode << "is not managed!";
+		break;
+	}
+
+	return valid_mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool Camera::checkTrigMode(TrigMode mode)
+{
+	DEB_MEMBER_FUNCT();
+    return ((mode == IntTrig      ) || 
+            (mode == ExtTrigSingle) ||
+            (mode == ExtTrigMult  ));
+}
+
+//-----------------------------------------------------
+// get default trigger mode for the counting mode
+//-----------------------------------------------------
+TrigMode Camera::getDefaultTrigModeOfCountingMode(CountingModes counting_mode) const
+{
+	DEB_MEMBER_FUNCT();
+
+    TrigMode result;
+
+    if((counting_mode == CountingModes::Continuous_2  ) ||
+       (counting_mode == CountingModes::Continuous_4  ) ||
+       (counting_mode == CountingModes::Continuous_8  ) ||
+       (counting_mode == CountingModes::Continuous_14 ) ||
+       (counting_mode == CountingModes::Standard_14   ) ||
+       (counting_mode == CountingModes::LongCounter_28))
+    {
+        result = IntTrig;
+    }
+    else
+    if(counting_mode == CountingModes::PumpProbeProbe_32)
+    {
+        result = ExtTrigMult;
+    }
+    else
+    {
+        DEB_ERROR() << "Camera::getDefaultTrigModeOfCountingMode - counting mode " << counting_mode << "is not managed!";
+    }
+
+	return result;
+}
+
+//-----------------------------------------------------
+// get default trigger mode for the current counting mode
+//-----------------------------------------------------
+TrigMode Camera::getDefaultTrigMode() const
+{
+    DEB_MEMBER_FUNCT();
+    return getDefaultTrigModeOfCountingMode(m_counting_mode);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setTrigMode(TrigMode mode)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setTrigMode() " << DEB_VAR1(mode)    << ", " 
+                                            << DEB_VAR1(m_depth) << ", " 
+                                            << DEB_VAR1(m_counting_mode);
+	DEB_PARAM() << DEB_VAR1(mode);
+
+    bool incoherence = false;
+    ufxclib::EnumAcquisitionMode acq_mode;
+
+	try
+	{
+        // beware, it is not a recursive mutex
+        {
+            AutoMutex aLock(m_cond.mutex());
+
+            if(m_counting_mode == CountingModes::Continuous_2)
+            {
+                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_continuous_2_raw; else
+                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_continuous_2_raw; else
+                    incoherence = true;
+            }
+            else
+            if(m_counting_mode == CountingModes::Continuous_4)
+            {
+                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_continuous_4_raw; else
+                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_continuous_4_raw; else
+                    incoherence = true;
+            }
+            else
+            if(m_counting_mode == CountingModes::Continuous_8)
+            {
+                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_continuous_8_raw; else
+                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_continuous_8_raw; else
+                    incoherence = true;
+            }
+            else
+            if(m_counting_mode == CountingModes::Continuous_14)
+            {
+                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_continuous_14_raw; else
+                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_continuous_14_raw; else
+                    incoherence = true;
+            }
+            else
+            if(m_counting_mode == CountingModes::Standard_14)
+            {
+                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_14_raw; else
+                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_14_raw; else
+                if(mode == ExtTrigMult  ) acq_mode = EnumAcquisitionMode::external_14_raw; else
+                    incoherence = true;
+            }
+            else
+            if(m_counting_mode == CountingModes::LongCounter_28)
+            {
+                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_long_counter_14_raw; else
+                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_long_counter_14_raw; else
+                if(mode == ExtTrigMult  ) acq_mode = EnumAcquisitionMode::external_long_counter_14_raw; else
+                    incoherence = true;
+            }
+            else
+            if(m_counting_mode == CountingModes::PumpProbeProbe_32)
+            {
+                if(mode == ExtTrigMult  ) acq_mode = EnumAcquisitionMode::pump_and_probe_2_raw; else
+                    incoherence = true;
+            }
+
+            if(incoherence)
+            {
+		        THROW_HW_ERROR(NotSupported) << DEB_VAR1(mode);
+            }
+
+    	    m_trigger_mode = mode;
+            setRegister(RegisterBatch::AcquisitionMode, static_cast<double>(acq_mode));
+        }
+
+		// DET-407
+		// setTrigMode is called before setExpTime so the previous m_exp_time used value (to compute nb frames) can be false.
+		if(m_counting_mode == lima::Ufxc::Camera::CountingModes::PumpProbeProbe_32)
+		{
+        	computePumpProbeNbFrames(m_exp_time);
+		}
+        // recursive lock problem - can not be called with a locked mutex
+        setNbFrames(m_nb_frames);
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::setTrigMode() :"
+		 << "\nreason : " << ue.errors[0].reason
+		 << "\ndesc : " << ue.errors[0].desc
+		 << "\norigin : " << ue.errors[0].origin
+		 << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+// NEVER USED.
+//-----------------------------------------------------
+void Camera::getTrigMode(TrigMode& mode)
+{
+	DEB_MEMBER_FUNCT();
+	mode = m_trigger_mode;
+	DEB_RETURN() << DEB_VAR1(mode);
+}
+
+//-----------------------------------------------------
+// 
+//-----------------------------------------------------
+std::string Camera::getTrigLabel(TrigMode& mode) const
+{
+	DEB_MEMBER_FUNCT();
+
+    std::string triggerName = "";
+
+    switch(mode)
+    {
+        case IntTrig: triggerName        = "INTERNAL_SINGLE"     ; break;
+        case ExtTrigSingle: triggerName  = "EXTERNAL_SINGLE"     ; break;
+        case ExtTrigMult: triggerName    = "EXTERNAL_MULTI"      ; break;
+        case ExtGate: triggerName        = "EXTERNAL_GATE"       ; break;
+        case IntTrigMult: triggerName    = "INTERNAL_MULTI"      ; break;
+        case ExtStartStop: triggerName   = "EXTERNAL_START_STOP" ; break;
+        case ExtTrigReadout: triggerName = "EXTERNAL_READOUT"    ; break;
+        default: triggerName = "ERROR"; break;
+    }
+    
+    return triggerName;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getExpTime(double& exp_time)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	try
+	{
+		//UFXCLib use (ms), but lima use (second) as unit
+		exp_time   = readRegister(RegisterCache::CountingTime);
+		exp_time   = exp_time / 1000;
+		m_exp_time = exp_time;
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::getExpTime() :"
+		 << "\nreason : " << ue.errors[0].reason
+		 << "\ndesc : "   << ue.errors[0].desc
+		 << "\norigin : " << ue.errors[0].origin
+		 << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+	DEB_RETURN() << DEB_VAR1(exp_time);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setExpTime(double exp_time)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setExpTime() " << DEB_VAR1(exp_time);
+    {
+        AutoMutex aLock(m_cond.mutex());
+	    try
+	    {
+		    if(exp_time < 0.0)
+		    {
+			    THROW_HW_ERROR(Error) << "Incorrect exposure time!";
+		    }
+            
+            //UFXCLib use (ms), but lima use (second) as unit
+		    setRegister(RegisterBatch::CountingTime, exp_time * 1000);
+		    m_exp_time = exp_time;
+	    }
+	    catch(const ufxclib::Exception& ue)
+	    {
+		    std::ostringstream err_msg;
+		    err_msg << "Error in Camera::setExpTime() :"
+		     << "\nreason : " << ue.errors[0].reason
+		     << "\ndesc : "   << ue.errors[0].desc
+		     << "\norigin : " << ue.errors[0].origin
+		     << std::endl;
+		    DEB_ERROR() << err_msg;
+		    THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	    }
+    }
+
+	//only in mode pump & probe
+    // recursive lock problem - can not be called with a locked mutex
+	if(m_counting_mode == lima::Ufxc::Camera::CountingModes::PumpProbeProbe_32)
 	{
-        // beware, it is not a recursive mutex
-        {
-            AutoMutex aLock(m_cond.mutex());
+        computePumpProbeNbFrames(m_exp_time);
 
-            if(m_counting_mode == CountingModes::Continuous_2)
-            {
-                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_continuous_2_raw; else
-                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_continuous_2_raw; else
-                    incoherence = true;
-            }
-            else
-            if(m_counting_mode == CountingModes::Continuous_4)
-            {
-                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_continuous_4_raw; else
-                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_continuous_4_raw; else
-                    incoherence = true;
-            }
-            else
-            if(m_counting_mode == CountingModes::Continuous_8)
-            {
-                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_continuous_8_raw; else
-                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_continuous_8_raw; else
-                    incoherence = true;
-            }
-            else
-            if(m_counting_mode == CountingModes::Continuous_14)
-            {
-                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_continuous_14_raw; else
-                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_continuous_14_raw; else
-                    incoherence = true;
-            }
-            else
-            if(m_counting_mode == CountingModes::Standard_14)
-            {
-                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_14_raw; else
-                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_14_raw; else
-                if(mode == ExtTrigMult  ) acq_mode = EnumAcquisitionMode::external_14_raw; else
-                    incoherence = true;
-            }
-            else
-            if(m_counting_mode == CountingModes::LongCounter_28)
+        // updating again the frames number.
+        // In Lima, setExpTime is called after setTrigMode and setNbFrames,
+        // so the previous set value can be false.
+        setNbFrames(m_nb_frames); 
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setLatTime(double lat_time)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setLatTime() " << DEB_VAR1(lat_time);
+	AutoMutex aLock(m_cond.mutex());
+	try
+	{
+		//UFXCLib use (ms), but lima use (second) as unit
+		setRegister(RegisterBatch::WaitingTime, lat_time * 1000);
+		m_lat_time = lat_time;
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::setLatTime() :"
+                << "\nreason : " << ue.errors[0].reason
+                << "\ndesc : "   << ue.errors[0].desc
+                << "\norigin : " << ue.errors[0].origin
+                << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getLatTime(double& lat_time)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	try
+	{
+		//UFXCLib use (ms), but lima use (second) as unit 
+		lat_time   = readRegister(RegisterCache::WaitingTime) / 1000.0;
+		m_lat_time = lat_time;
+		DEB_RETURN() << DEB_VAR1(lat_time);
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::getLatTime() :"
+                << "\nreason : " << ue.errors[0].reason
+                << "\ndesc : "   << ue.errors[0].desc
+                << "\norigin : " << ue.errors[0].origin
+                << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getExposureTimeRange(double& min_expo, double& max_expo) const
+{
+	DEB_MEMBER_FUNCT();
+	try
+	{
+		//UFXCLib uses (ms), but lima uses (second) as unit 
+		min_expo = readRegister(RegisterCache::MinExposureTime) / 1000.0;
+        max_expo = readRegister(RegisterCache::MaxExposureTime) / 1000.0;
+	    DEB_RETURN() << DEB_VAR2(min_expo, max_expo);
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::getExposureTimeRange() :"
+                << "\nreason : " << ue.errors[0].reason
+                << "\ndesc : "   << ue.errors[0].desc
+                << "\norigin : " << ue.errors[0].origin
+                << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getLatTimeRange(double& min_lat, double& max_lat) const
+{
+	DEB_MEMBER_FUNCT();
+
+	try
+	{
+		//UFXCLib uses (ms), but lima uses (second) as unit 
+		min_lat = readRegister(RegisterCache::MinLatencyTime) / 1000.0;
+        max_lat = readRegister(RegisterCache::MaxLatencyTime) / 1000.0;
+	    DEB_RETURN() << DEB_VAR2(min_lat, max_lat);
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::getLatTimeRange() :"
+                << "\nreason : " << ue.errors[0].reason
+                << "\ndesc : "   << ue.errors[0].desc
+                << "\norigin : " << ue.errors[0].origin
+                << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getCorrectLatTime(double& lat_time) const
+{
+	DEB_MEMBER_FUNCT();
+
+	try
+	{
+		//UFXCLib uses (ms), but lima uses (second) as unit 
+        double min_lat = readRegister(RegisterCache::MinLatencyTime) / 1000.0;
+        double max_lat = readRegister(RegisterCache::MaxLatencyTime) / 1000.0;
+
+        if(lat_time < min_lat) lat_time = min_lat;
+        if(lat_time > max_lat) lat_time = max_lat;
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::getCorrectLatTime() :"
+                << "\nreason : " << ue.errors[0].reason
+                << "\ndesc : "   << ue.errors[0].desc
+                << "\norigin : " << ue.errors[0].origin
+                << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getCorrectExposureTime(double& exp_time) const
+{
+	DEB_MEMBER_FUNCT();
+	try
+	{
+		//UFXCLib uses (ms), but lima uses (second) as unit 
+		double min_expo = readRegister(RegisterCache::MinExposureTime) / 1000.0;
+        double max_expo = readRegister(RegisterCache::MaxExposureTime) / 1000.0;
+
+        if(exp_time < min_expo) exp_time = min_expo;
+        if(exp_time > max_expo) exp_time = max_expo;
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::getCorrectExposureTime() :"
+                << "\nreason : " << ue.errors[0].reason
+                << "\ndesc : "   << ue.errors[0].desc
+                << "\norigin : " << ue.errors[0].origin
+                << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setNbFrames(int nb_frames)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setNbFrames() " << DEB_VAR1(nb_frames);
+	AutoMutex aLock(m_cond.mutex());
+	try
+	{
+		if(nb_frames < 0)
+		{
+			THROW_HW_ERROR(Error) << "Number of frames to acquire has not been set";
+		}
+
+        std::size_t images_number   = 0;
+        std::size_t triggers_number = 0;
+        std::size_t accumulation    = static_cast<std::size_t>(getAccumulationFactor()); // hardware frames in a Lima frame
+
+		TrigMode trigger_mode;
+		getTrigMode(trigger_mode);
+
+        if((trigger_mode == IntTrig) || (trigger_mode == ExtTrigSingle))
+        {
+	        images_number   = nb_frames * accumulation;
+	        triggers_number = 1;
+	        m_nb_frames     = nb_frames;
+        }
+        else
+        if(trigger_mode == ExtTrigMult)
+        {
+	        if(m_counting_mode == CountingModes::PumpProbeProbe_32)
             {
-                if(mode == IntTrig      ) acq_mode = EnumAcquisitionMode::software_long_counter_14_raw; else
-                if(mode == ExtTrigSingle) acq_mode = EnumAcquisitionMode::external_long_counter_14_raw; else
-                if(mode == ExtTrigMult  ) acq_mode = EnumAcquisitionMode::external_long_counter_14_raw; else
-                    incoherence = true;
+                images_number   = 1;
+	            triggers_number = m_pump_probe_nb_frames;
+	            m_nb_frames     = 1;
             }
             else
-            if(m_counting_mode == CountingModes::PumpProbeProbe_32)
             {
-                if(mode == ExtTrigMult  ) acq_mode = EnumAcquisitionMode::pump_and_probe_2_raw; else
-                    incoherence = true;
+                images_number   = 1;
+	            triggers_number = nb_frames * accumulation;
+	            m_nb_frames     = nb_frames;
             }
+        }
 
-            if(incoherence)
-            {
-		        THROW_HW_ERROR(NotSupported) << DEB_VAR1(mode);
-            }
+        setRegister(RegisterBatch::ImagesNumber  , static_cast<double>(images_number  ));
+        setRegister(RegisterBatch::TriggersNumber, static_cast<double>(triggers_number));
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::setNbFrames() :"
+		 << "\nreason : " << ue.errors[0].reason
+		 << "\ndesc : " << ue.errors[0].desc
+		 << "\norigin : " << ue.errors[0].origin
+		 << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbFrames(int& nb_frames)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	try
+	{
+        if(m_counting_mode == CountingModes::PumpProbeProbe_32)
+        {
+		    m_nb_frames = 1;
+        }
+        else
+        {
+            std::size_t images_number   = static_cast<std::size_t>(readRegister(RegisterCache::ImagesNumber  ));
+            std::size_t triggers_number = static_cast<std::size_t>(readRegister(RegisterCache::TriggersNumber));
+            m_nb_frames = (images_number * triggers_number) / getAccumulationFactor();
+        }
+
+        nb_frames = m_nb_frames;
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::getNbFrames() :"
+		 << "\nreason : " << ue.errors[0].reason
+		 << "\ndesc : "   << ue.errors[0].desc
+		 << "\norigin : " << ue.errors[0].origin
+		 << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+// for the pollers: never takes the camera lock
+//-----------------------------------------------------
+void Camera::getStatusSnapshot(StatusSnapshot& snapshot)
+{
+	m_status_block.read(snapshot);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool Camera::is_thread_running()
+{
+	return m_status_block.isThreadRunning();
+}
+
+//-----------------------------------------------------
+// used at the next acquisition start
+//-----------------------------------------------------
+void Camera::setNbFillWorkers(int nb_workers)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setNbFillWorkers() " << DEB_VAR1(nb_workers);
+	AutoMutex aLock(m_cond.mutex());
+	m_frame_pipeline->setNbFillWorkers(nb_workers);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbFillWorkers(int& nb_workers)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	nb_workers = m_frame_pipeline->getNbFillWorkers();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setBufferLatencyTolerance(double latency)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setBufferLatencyTolerance() " << DEB_VAR1(latency);
+
+	if(latency < 0.0)
+	{
+		THROW_HW_ERROR(InvalidValue) << "Incorrect latency tolerance!";
+	}
+
+	AutoMutex aLock(m_cond.mutex());
+	m_buffer_latency_tolerance = latency;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBufferLatencyTolerance(double& latency)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	latency = m_buffer_latency_tolerance;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setBufferMemoryBudget(double memory_mb)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setBufferMemoryBudget() " << DEB_VAR1(memory_mb);
+
+	if(memory_mb <= 0.0)
+	{
+		THROW_HW_ERROR(InvalidValue) << "Incorrect memory budget!";
+	}
+
+	AutoMutex aLock(m_cond.mutex());
+	m_buffer_memory_budget = memory_mb;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBufferMemoryBudget(double& memory_mb)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	memory_mb = m_buffer_memory_budget;
+}
+
+//-----------------------------------------------------
+// to be applied by the control layer (CtBuffer or the Tango device)
+// before prepareAcq
+//-----------------------------------------------------
+void Camera::getRecommendedBufferSizing(int& nb_buffers, double& memory_mb)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	computeBufferSizing(nb_buffers, memory_mb);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setWaitPolicy(WaitStrategy::Policy policy)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setWaitPolicy() " << DEB_VAR1(policy);
+	m_wait_strategy.setPolicy(policy);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getWaitPolicy(WaitStrategy::Policy& policy)
+{
+	DEB_MEMBER_FUNCT();
+	policy = m_wait_strategy.getPolicy();
+}
+
+//-----------------------------------------------------
+// policy used by the acquisition thread (resolved if Auto)
+//-----------------------------------------------------
+void Camera::getEffectiveWaitPolicy(WaitStrategy::Policy& policy)
+{
+	DEB_MEMBER_FUNCT();
+	policy = m_wait_strategy.getEffectivePolicy();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setWaitSpinBudget(double spin_budget_us)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setWaitSpinBudget() " << DEB_VAR1(spin_budget_us);
+	m_wait_strategy.setSpinBudget(spin_budget_us);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getWaitSpinBudget(double& spin_budget_us)
+{
+	DEB_MEMBER_FUNCT();
+	spin_budget_us = m_wait_strategy.getSpinBudget();
+}
+
+//-----------------------------------------------------
+// measured during the last/current acquisition
+//-----------------------------------------------------
+void Camera::getMeasuredFramePeriod(double& frame_period_ms)
+{
+	DEB_MEMBER_FUNCT();
+	frame_period_ms = m_wait_strategy.getMeasuredFramePeriod();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setAcqThreadPlacement(const ThreadPlacement& placement)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setAcqThreadPlacement() " << placement.getCpus() << " " << placement.getPolicy() << " " << placement.getPriority();
+	placement.check();
+
+	AutoMutex aLock(m_cond.mutex());
+	ThreadPlacement new_placement(placement);
+	new_placement.setNumaNode(m_numa_node);
+
+	// applied by the acquisition thread at the next acquisition start
+	if(new_placement != m_acq_thread_placement)
+	{
+		m_acq_thread_placement = new_placement;
+		m_acq_thread_placement_changed = true;
+	}
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAcqThreadPlacement(ThreadPlacement& placement)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	placement = m_acq_thread_placement;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setHelperThreadsPlacement(const ThreadPlacement& placement)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setHelperThreadsPlacement() " << placement.getCpus() << " " << placement.getPolicy() << " " << placement.getPriority();
+	placement.check();
+
+	AutoMutex aLock(m_cond.mutex());
+	m_helper_threads_placement = placement;
+	m_helper_threads_placement.setNumaNode(m_numa_node);
+
+	// the pipeline threads are restarted at the next acquisition start
+	m_frame_pipeline->setThreadsPlacement(m_helper_threads_placement);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getHelperThreadsPlacement(ThreadPlacement& placement)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	placement = m_helper_threads_placement;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setNumaNode(int numa_node)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setNumaNode() " << DEB_VAR1(numa_node);
+
+	if(numa_node < -1)
+	{
+		THROW_HW_ERROR(InvalidValue) << "Incorrect NUMA node: " << numa_node << " (-1 for the node of the SFP interface)";
+	}
+
+	AutoMutex aLock(m_cond.mutex());
+	m_numa_node_config = numa_node;
+	updateNumaNode();
+	m_frame_pipeline->setThreadsPlacement(m_helper_threads_placement);
+}
+
+//-----------------------------------------------------
+// effective node, -1 if unknown
+//-----------------------------------------------------
+void Camera::getNumaNode(int& numa_node)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	numa_node = m_numa_node;
+}
+
+//-----------------------------------------------------
+// effective cpus and scheduling of the plugin threads
+//-----------------------------------------------------
+void Camera::getPlacementReport(std::string& report)
+{
+	DEB_MEMBER_FUNCT();
+	std::ostringstream out;
+
+	{
+		AutoMutex aLock(m_cond.mutex());
+		out << "SFP interface: " << (m_sfp_interface_name.empty() ? "unknown" : m_sfp_interface_name)
+		    << " (" << m_sfp_ip_address << ") - NUMA node: " << m_numa_node << "\n"
+		    << m_acq_thread_effective_placement << "\n";
+	}
+
+	out << m_frame_pipeline->getThreadsPlacement();
+	report = out.str();
+}
+
+//-----------------------------------------------------
+// called with the lock taken
+//-----------------------------------------------------
+void Camera::updateNumaNode()
+{
+	DEB_MEMBER_FUNCT();
+
+	if(m_numa_node_config >= 0)
+	{
+		m_numa_node = m_numa_node_config;
+		NumaPlacement::getInterfaceNode(m_sfp_ip_address, m_sfp_interface_name);
+	}
+	else
+	{
+		m_numa_node = NumaPlacement::getInterfaceNode(m_sfp_ip_address, m_sfp_interface_name);
+	}
+
+	DEB_TRACE() << "NUMA node of the Lima buffers: " << m_numa_node;
 
-    	    m_trigger_mode = mode;
-            m_ufxc_interface->set_acq_mode(acq_mode);
-        }
+	// the "numa" cpu lists depend on the node
+	ThreadPlacement acq_thread_placement(m_acq_thread_placement);
+	acq_thread_placement.setNumaNode(m_numa_node);
 
-		// DET-407
-		// setTrigMode is called before setExpTime so the previous m_exp_time used value (to compute nb frames) can be false.
-		if(m_counting_mode == lima::Ufxc::Camera::CountingModes::PumpProbeProbe_32)
-		{
-        	computePumpProbeNbFrames(m_exp_time);
-		}
-        // recursive lock problem - can not be called with a locked mutex
-        setNbFrames(m_nb_frames);
-	}
-	catch(const ufxclib::Exception& ue)
+	if(acq_thread_placement != m_acq_thread_placement)
 	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::setTrigMode() :"
-		 << "\nreason : " << ue.errors[0].reason
-		 << "\ndesc : " << ue.errors[0].desc
-		 << "\norigin : " << ue.errors[0].origin
-		 << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+		m_acq_thread_placement = acq_thread_placement;
+		m_acq_thread_placement_changed = true;
 	}
+
+	m_helper_threads_placement.setNumaNode(m_numa_node);
 }
 
 //-----------------------------------------------------
-// NEVER USED.
+//
 //-----------------------------------------------------
-void Camera::getTrigMode(TrigMode& mode)
+void Camera::setReorderWindowSize(int nb_frames)
 {
 	DEB_MEMBER_FUNCT();
-	mode = m_trigger_mode;
-	DEB_RETURN() << DEB_VAR1(mode);
+	DEB_TRACE() << "Camera::setReorderWindowSize() " << DEB_VAR1(nb_frames);
+	m_reorder_window.setSize(nb_frames);
 }
 
 //-----------------------------------------------------
-// 
+//
 //-----------------------------------------------------
-std::string Camera::getTrigLabel(TrigMode& mode) const
+void Camera::getReorderWindowSize(int& nb_frames)
 {
 	DEB_MEMBER_FUNCT();
+	nb_frames = m_reorder_window.getSize();
+}
 
-    std::string triggerName = "";
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setReorderTimeout(double timeout_ms)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setReorderTimeout() " << DEB_VAR1(timeout_ms);
+	m_reorder_window.setTimeout(timeout_ms);
+}
 
-    switch(mode)
-    {
-        case IntTrig: triggerName        = "INTERNAL_SINGLE"     ; break;
-        case ExtTrigSingle: triggerName  = "EXTERNAL_SINGLE"     ; break;
-        case ExtTrigMult: triggerName    = "EXTERNAL_MULTI"      ; break;
-        case ExtGate: triggerName        = "EXTERNAL_GATE"       ; break;
-        case IntTrigMult: triggerName    = "INTERNAL_MULTI"      ; break;
-        case ExtStartStop: triggerName   = "EXTERNAL_START_STOP" ; break;
-        case ExtTrigReadout: triggerName = "EXTERNAL_READOUT"    ; break;
-        default: triggerName = "ERROR"; break;
-    }
-    
-    return triggerName;
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getReorderTimeout(double& timeout_ms)
+{
+	DEB_MEMBER_FUNCT();
+	timeout_ms = m_reorder_window.getTimeout();
+}
+
+//-----------------------------------------------------
+// frames replaced by blank frames during the last/current acquisition
+//-----------------------------------------------------
+void Camera::getNbLostFrames(int& nb_frames)
+{
+	DEB_MEMBER_FUNCT();
+	nb_frames = m_reorder_window.getNbLostFrames();
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::getExpTime(double& exp_time)
+void Camera::getLostFrames(std::vector<int>& lost_frames)
+{
+	DEB_MEMBER_FUNCT();
+	m_reorder_window.getLostFrames(lost_frames);
+}
+
+//-----------------------------------------------------
+// late or duplicated images during the last/current acquisition
+//-----------------------------------------------------
+void Camera::getNbDroppedFrames(int& nb_frames)
+{
+	DEB_MEMBER_FUNCT();
+	nb_frames = m_reorder_window.getNbDroppedFrames();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setStatusRefreshPeriod(double period_ms)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setStatusRefreshPeriod() " << DEB_VAR1(period_ms);
+
+	if(period_ms <= 0.0)
+	{
+		THROW_HW_ERROR(InvalidValue) << "Incorrect status refresh period!";
+	}
+
+	m_status_monitor->setPeriod(period_ms / 1000.0);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getStatusRefreshPeriod(double& period_ms)
+{
+	DEB_MEMBER_FUNCT();
+	period_ms = m_status_monitor->getPeriod() * 1000.0;
+}
+
+//-----------------------------------------------------
+// disabled: every getter reads the DAQ
+//-----------------------------------------------------
+void Camera::setRegisterCacheEnabled(bool enabled)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setRegisterCacheEnabled() " << DEB_VAR1(enabled);
+	m_register_cache.setEnabled(enabled);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getRegisterCacheEnabled(bool& enabled)
+{
+	DEB_MEMBER_FUNCT();
+	enabled = m_register_cache.isEnabled();
+}
+
+//-----------------------------------------------------
+// reads the hits (no DAQ access) and misses of the register cache
+//-----------------------------------------------------
+void Camera::getRegisterCacheStats(unsigned long& nb_hits, unsigned long& nb_misses)
+{
+	DEB_MEMBER_FUNCT();
+	m_register_cache.getStats(nb_hits, nb_misses);
+}
+
+//-----------------------------------------------------
+// reloads all the cached registers from the DAQ,
+// for a change done outside of the plugin
+//-----------------------------------------------------
+void Camera::resyncFromHardware()
 {
 	DEB_MEMBER_FUNCT();
 	AutoMutex aLock(m_cond.mutex());
+
 	try
 	{
-		//UFXCLib use (ms), but lima use (second) as unit
-		exp_time   = m_ufxc_interface->get_counting_time_ms();
-		exp_time   = exp_time / 1000;
-		m_exp_time = exp_time;
+		m_register_cache.invalidateAll();
+		m_register_batch.forgetHardware();
+
+		for(int key = 0 ; key < RegisterCache::NbKeys ; key++)
+		{
+			double value = readRegister(static_cast<RegisterCache::Key>(key));
+			DEB_TRACE() << RegisterCache::getName(static_cast<RegisterCache::Key>(key)) << " = " << value;
+		}
+
+		if(m_geometrical_correction_engine == SdkCorrection)
+			m_is_geometrical_correction_enabled = (readRegister(RegisterCache::GeometricalCorrection) != 0.0);
 	}
 	catch(const ufxclib::Exception& ue)
 	{
 		std::ostringstream err_msg;
-		err_msg << "Error in Camera::getExpTime() :"
+		err_msg << "Error in Camera::resyncFromHardware() :"
+		 << "\nreason : " << ue.errors[0].reason
+		 << "\ndesc : "   << ue.errors[0].desc
+		 << "\norigin : " << ue.errors[0].origin
+		 << std::endl;
+		DEB_ERROR() << err_msg;
+		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+	}
+}
+
+//-----------------------------------------------------
+// disabled: every setter writes the DAQ immediately
+//-----------------------------------------------------
+void Camera::setDeferredRegisterWrites(bool enabled)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setDeferredRegisterWrites() " << DEB_VAR1(enabled);
+	AutoMutex aLock(m_cond.mutex());
+
+	try
+	{
+		m_deferred_register_writes = enabled;
+
+		if(!enabled)
+			commitRegisters();
+	}
+	catch(const ufxclib::Exception& ue)
+	{
+		std::ostringstream err_msg;
+		err_msg << "Error in Camera::setDeferredRegisterWrites() :"
 		 << "\nreason : " << ue.errors[0].reason
 		 << "\ndesc : "   << ue.errors[0].desc
 		 << "\norigin : " << ue.errors[0].origin
@@ -1166,320 +3442,450 @@ void Camera::getExpTime(double& exp_time)
 		DEB_ERROR() << err_msg;
 		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
 	}
-	DEB_RETURN() << DEB_VAR1(exp_time);
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::setExpTime(double exp_time)
+void Camera::getDeferredRegisterWrites(bool& enabled)
 {
 	DEB_MEMBER_FUNCT();
-	DEB_TRACE() << "Camera::setExpTime() " << DEB_VAR1(exp_time);
+	AutoMutex aLock(m_cond.mutex());
+	enabled = m_deferred_register_writes;
+}
+
+//-----------------------------------------------------
+// times (s) of the last prepareAcq and of its registers commit
+//-----------------------------------------------------
+void Camera::getLastPrepareTime(double& prepare_time, double& commit_time, int& nb_writes)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	prepare_time = m_prepare_time;
+	commit_time  = m_prepare_commit_time;
+	nb_writes    = m_prepare_nb_writes;
+}
+
+//-----------------------------------------------------
+// since the start or the last reset of the statistics
+//-----------------------------------------------------
+void Camera::getPrepareTimeStats(double& mean_time, double& max_time, unsigned long& nb_prepares)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	mean_time   = (m_nb_prepares > 0) ? (m_prepare_total_time / m_nb_prepares) : 0.0;
+	max_time    = m_prepare_max_time;
+	nb_prepares = m_nb_prepares;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::resetPrepareTimeStats()
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	m_prepare_total_time = 0.0;
+	m_prepare_max_time   = 0.0;
+	m_nb_prepares        = 0;
+}
+
+//-----------------------------------------------------
+// used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setPixelDecoding(PixelDecoding decoding)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setPixelDecoding() " << DEB_VAR1(decoding);
+
+	// ufxclib only gives the images decoded, the raw frames come from the simulator
+	if((decoding == PluginDecoding) && (!m_ufxc_interface->is_raw_images_supported()))
+		THROW_HW_ERROR(NotSupported) << "Plugin pixel decoding needs the raw images, only given by the simulator!";
+
+	AutoMutex aLock(m_cond.mutex());
+	m_pixel_decoding = decoding;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPixelDecoding(PixelDecoding& decoding)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	decoding = m_pixel_decoding;
+}
+
+//-----------------------------------------------------
+// used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setPixelUnpackerKernel(PixelUnpacker::Kernel kernel)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setPixelUnpackerKernel() " << PixelUnpacker::getKernelName(kernel);
+	AutoMutex aLock(m_cond.mutex());
+	m_pixel_unpacker.setKernel(kernel);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPixelUnpackerKernel(PixelUnpacker::Kernel& kernel)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	kernel = m_pixel_unpacker.getKernel();
+}
+
+//-----------------------------------------------------
+// kernel chosen from the cpu features (resolved if Auto)
+//-----------------------------------------------------
+void Camera::getEffectivePixelUnpackerKernel(PixelUnpacker::Kernel& kernel)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+	kernel = m_pixel_unpacker.getEffectiveKernel();
+}
+
+//-----------------------------------------------------
+// decoding time of a detector image on one core, for each counting mode
+// and each kernel supported by the cpu. The packed rate can be compared
+// with the SFP links rate.
+//-----------------------------------------------------
+void Camera::runPixelUnpackerBenchmark(int nb_frames, std::string& report)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::runPixelUnpackerBenchmark() " << DEB_VAR1(nb_frames);
+
+    Size image_size;
+    getDetectorImageSize(image_size);
+
+    int nb_pixels = image_size.getWidth() * image_size.getHeight();
+    const PixelUnpacker::Kernel kernels[] = { PixelUnpacker::Scalar, PixelUnpacker::Sse41, PixelUnpacker::Avx2 };
+    std::ostringstream out;
+
+    out << "image size (" << image_size.getWidth() << ", " << image_size.getHeight() << ")" << std::endl;
+
+    for(int mode = Continuous_2 ; mode < SelectDefault ; mode++)
     {
-        AutoMutex aLock(m_cond.mutex());
-	    try
-	    {
-		    if(exp_time < 0.0)
-		    {
-			    THROW_HW_ERROR(Error) << "Incorrect exposure time!";
-		    }
-            
-            //UFXCLib use (ms), but lima use (second) as unit
-		    m_ufxc_interface->set_counting_time_ms(exp_time * 1000);
-		    m_exp_time = exp_time;
-	    }
-	    catch(const ufxclib::Exception& ue)
-	    {
-		    std::ostringstream err_msg;
-		    err_msg << "Error in Camera::setExpTime() :"
-		     << "\nreason : " << ue.errors[0].reason
-		     << "\ndesc : "   << ue.errors[0].desc
-		     << "\norigin : " << ue.errors[0].origin
-		     << std::endl;
-		    DEB_ERROR() << err_msg;
-		    THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
-	    }
+        CountingModes counting_mode = static_cast<CountingModes>(mode);
+        std::string   mode_label;
+        std::string   error_message;
+        int           depth = static_cast<int>(getCountingModePixelDepth(counting_mode));
+
+        convertCountingModeEnum(counting_mode, mode_label, error_message);
+
+        for(std::size_t index = 0 ; index < sizeof(kernels) / sizeof(kernels[0]) ; index++)
+        {
+            if(!PixelUnpacker::isKernelSupported(kernels[index]))
+                continue;
+
+            PixelUnpacker unpacker;
+            unpacker.setKernel(kernels[index]);
+
+            double frame_time  = unpacker.benchmark(depth, nb_pixels, nb_frames);
+            double packed_rate = PixelUnpacker::getPackedSize(depth, nb_pixels) * 8.0 / frame_time / 1e9;
+
+            out << std::left << std::setw(24) << mode_label << " " << std::setw(7) << PixelUnpacker::getKernelName(kernels[index])
+                << std::right << std::fixed << std::setprecision(1)
+                << " - frame (us): " << std::setw(8) << frame_time * 1e6
+                << " - frames/s: "   << std::setw(9) << 1.0 / frame_time
+                << " - packed (Gbit/s): " << std::setprecision(2) << packed_rate << std::endl;
+        }
     }
 
-	//only in mode pump & probe
-    // recursive lock problem - can not be called with a locked mutex
-	if(m_counting_mode == lima::Ufxc::Camera::CountingModes::PumpProbeProbe_32)
-	{
-        computePumpProbeNbFrames(m_exp_time);
+    report = out.str();
+    DEB_TRACE() << report;
+}
+
+//-----------------------------------------------------
+// without hardware support, Lima does the roi on the full binned image
+//-----------------------------------------------------
+void Camera::checkRoi(const Roi& set_roi, Roi& hw_roi)
+{
+	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+
+    if((!isHwBinRoiSupported()) || (set_roi.isEmpty()))
+        hw_roi = getFullBinnedRoi();
+    else
+        hw_roi = set_roi;
+}
+
+//-----------------------------------------------------
+// used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setRoi(const Roi& set_roi)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "Camera::setRoi - " << DEB_VAR1(set_roi);
+	AutoMutex aLock(m_cond.mutex());
 
-        // updating again the frames number.
-        // In Lima, setExpTime is called after setTrigMode and setNbFrames,
-        // so the previous set value can be false.
-        setNbFrames(m_nb_frames); 
-    }
+    // the full image is not a roi
+    if((set_roi.isEmpty()) || (set_roi == getFullBinnedRoi()))
+        m_hw_roi = Roi();
+    else
+        m_hw_roi = set_roi;
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::setLatTime(double lat_time)
+void Camera::getRoi(Roi& hw_roi)
 {
 	DEB_MEMBER_FUNCT();
-	DEB_TRACE() << "Camera::setLatTime() " << DEB_VAR1(lat_time);
 	AutoMutex aLock(m_cond.mutex());
-	try
-	{
-		//UFXCLib use (ms), but lima use (second) as unit
-		m_ufxc_interface->set_waiting_time_ms(lat_time * 1000);
-		m_lat_time = lat_time;
-	}
-	catch(const ufxclib::Exception& ue)
-	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::setLatTime() :"
-                << "\nreason : " << ue.errors[0].reason
-                << "\ndesc : "   << ue.errors[0].desc
-                << "\norigin : " << ue.errors[0].origin
-                << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
-	}
+
+    hw_roi = (m_hw_roi.isEmpty()) ? getFullBinnedRoi() : m_hw_roi;
 }
 
 //-----------------------------------------------------
-//
+// without hardware support, Lima does the binning
 //-----------------------------------------------------
-void Camera::getLatTime(double& lat_time)
+void Camera::checkBin(Bin& bin)
 {
 	DEB_MEMBER_FUNCT();
 	AutoMutex aLock(m_cond.mutex());
-	try
-	{
-		//UFXCLib use (ms), but lima use (second) as unit 
-		lat_time   = m_ufxc_interface->get_waiting_time_ms() / 1000.0;
-		m_lat_time = lat_time;
-		DEB_RETURN() << DEB_VAR1(lat_time);
-	}
-	catch(const ufxclib::Exception& ue)
-	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::getLatTime() :"
-                << "\nreason : " << ue.errors[0].reason
-                << "\ndesc : "   << ue.errors[0].desc
-                << "\norigin : " << ue.errors[0].origin
-                << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
-	}
+
+    if(!isHwBinSupported())
+        bin = Bin(1, 1);
+    else
+        bin = Bin(std::max(1, std::min(bin.getX(), HW_BIN_MAX)), std::max(1, std::min(bin.getY(), HW_BIN_MAX)));
 }
 
 //-----------------------------------------------------
-//
+// used at the next prepareAcq, Lima sets the roi after the binning
 //-----------------------------------------------------
-void Camera::getExposureTimeRange(double& min_expo, double& max_expo) const
+void Camera::setBin(const Bin& bin)
 {
 	DEB_MEMBER_FUNCT();
-	try
-	{
-		//UFXCLib uses (ms), but lima uses (second) as unit 
-		min_expo = m_ufxc_interface->get_min_exposure_time_ms() / 1000.0;
-        max_expo = m_ufxc_interface->get_max_exposure_time_ms() / 1000.0;
-	    DEB_RETURN() << DEB_VAR2(min_expo, max_expo);
-	}
-	catch(const ufxclib::Exception& ue)
-	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::getExposureTimeRange() :"
-                << "\nreason : " << ue.errors[0].reason
-                << "\ndesc : "   << ue.errors[0].desc
-                << "\norigin : " << ue.errors[0].origin
-                << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
-	}
+	DEB_TRACE() << "Camera::setBin - " << DEB_VAR1(bin);
+	AutoMutex aLock(m_cond.mutex());
+
+    m_hw_bin = bin;
+    m_hw_roi = Roi();
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::getLatTimeRange(double& min_lat, double& max_lat) const
+void Camera::getBin(Bin& bin)
 {
 	DEB_MEMBER_FUNCT();
+	AutoMutex aLock(m_cond.mutex());
+    bin = m_hw_bin;
+}
 
-	try
-	{
-		//UFXCLib uses (ms), but lima uses (second) as unit 
-		min_lat = m_ufxc_interface->get_min_latency_time_ms() / 1000.0;
-        max_lat = m_ufxc_interface->get_max_latency_time_ms() / 1000.0;
-	    DEB_RETURN() << DEB_VAR2(min_lat, max_lat);
-	}
-	catch(const ufxclib::Exception& ue)
-	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::getLatTimeRange() :"
-                << "\nreason : " << ue.errors[0].reason
-                << "\ndesc : "   << ue.errors[0].desc
-                << "\norigin : " << ue.errors[0].origin
-                << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
-	}
+//-----------------------------------------------------
+// the camera lock must be held
+//-----------------------------------------------------
+bool Camera::useHwBinRoi() const
+{
+    return (!m_hw_bin.isOne()) || (!m_hw_roi.isEmpty());
 }
 
 //-----------------------------------------------------
-//
+// only frames of pixels are binned and cropped, the camera lock must be held
 //-----------------------------------------------------
-void Camera::getCorrectLatTime(double& lat_time) const
+bool Camera::isHwBinRoiSupported() const
+{
+    return (!usePackedOutput()) && (!useSparseOutput()) && (!useCompression()) && (getAccumulationFactor() == 1) &&
+           (!useProbeChannelsOutput());
+}
+
+//-----------------------------------------------------
+// a pump-probe-probe pixel holds two 16 bits probe counters, their sum
+// would overflow from the low probe into the high one: only cropped,
+// the camera lock must be held
+//-----------------------------------------------------
+bool Camera::isHwBinSupported() const
+{
+    return isHwBinRoiSupported() && (m_counting_mode != CountingModes::PumpProbeProbe_32);
+}
+
+//-----------------------------------------------------
+// the camera lock must be held
+//-----------------------------------------------------
+Roi Camera::getFullBinnedRoi() const
+{
+    return Roi(Point(0, 0), FrameBinRoi::getBinnedSize(getPixelImageSize(), m_hw_bin));
+}
+
+//-----------------------------------------------------
+// written registers since the start, and unchanged ones not written again
+//-----------------------------------------------------
+void Camera::getRegisterWritesStats(unsigned long& nb_writes, unsigned long& nb_skipped_writes)
 {
 	DEB_MEMBER_FUNCT();
+	m_register_batch.getStats(nb_writes, nb_skipped_writes);
+}
 
-	try
-	{
-		//UFXCLib uses (ms), but lima uses (second) as unit 
-        double min_lat = m_ufxc_interface->get_min_latency_time_ms() / 1000.0;
-        double max_lat = m_ufxc_interface->get_max_latency_time_ms() / 1000.0;
+//-----------------------------------------------------
+// the camera lock must be held
+//-----------------------------------------------------
+void Camera::setRegister(RegisterBatch::Register reg, double value)
+{
+	m_register_batch.mark(reg, value);
 
-        if(lat_time < min_lat) lat_time = min_lat;
-        if(lat_time > max_lat) lat_time = max_lat;
-	}
-	catch(const ufxclib::Exception& ue)
-	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::getCorrectLatTime() :"
-                << "\nreason : " << ue.errors[0].reason
-                << "\ndesc : "   << ue.errors[0].desc
-                << "\norigin : " << ue.errors[0].origin
-                << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
-	}
+	if(!m_deferred_register_writes)
+		commitRegisters();
 }
 
 //-----------------------------------------------------
-//
+// writes the pending registers, the camera lock must be held
 //-----------------------------------------------------
-void Camera::getCorrectExposureTime(double& exp_time) const
+int Camera::commitRegisters() const
 {
 	DEB_MEMBER_FUNCT();
-	try
-	{
-		//UFXCLib uses (ms), but lima uses (second) as unit 
-		double min_expo = m_ufxc_interface->get_min_exposure_time_ms() / 1000.0;
-        double max_expo = m_ufxc_interface->get_max_exposure_time_ms() / 1000.0;
 
-        if(exp_time < min_expo) exp_time = min_expo;
-        if(exp_time > max_expo) exp_time = max_expo;
-	}
-	catch(const ufxclib::Exception& ue)
+	std::vector<RegisterBatch::Write> writes;
+	m_register_batch.getWrites(writes);
+
+	for(std::size_t write_nb = 0 ; write_nb < writes.size() ; write_nb++)
 	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::getCorrectExposureTime() :"
-                << "\nreason : " << ue.errors[0].reason
-                << "\ndesc : "   << ue.errors[0].desc
-                << "\norigin : " << ue.errors[0].origin
-                << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+		writeHardwareRegister(writes[write_nb].reg, writes[write_nb].value);
+		m_register_batch.written(writes[write_nb].reg, writes[write_nb].value);
 	}
+
+	return static_cast<int>(writes.size());
 }
 
 //-----------------------------------------------------
-//
+// writes one pending register, the others stay in the batch,
+// takes the camera lock (the range getters are called by Lima without it)
 //-----------------------------------------------------
-void Camera::setNbFrames(int nb_frames)
+bool Camera::commitRegister(RegisterBatch::Register reg) const
 {
 	DEB_MEMBER_FUNCT();
-	DEB_TRACE() << "Camera::setNbFrames() " << DEB_VAR1(nb_frames);
+
+	RegisterBatch::Write write;
+	double               value;
+
+	// most reads have nothing to write, without waiting for the lock
+	if(!m_register_batch.getPending(reg, value))
+		return false;
+
+	// serialized with the commits of prepareAcq and startAcq
 	AutoMutex aLock(m_cond.mutex());
-	try
-	{
-		if(nb_frames < 0)
-		{
-			THROW_HW_ERROR(Error) << "Number of frames to acquire has not been set";
-		}
 
-        std::size_t images_number   = 0;
-        std::size_t triggers_number = 0;
+	if(!m_register_batch.getWrite(reg, write))
+		return false;
 
-		TrigMode trigger_mode;
-		getTrigMode(trigger_mode);
+	writeHardwareRegister(write.reg, write.value);
+	m_register_batch.written(write.reg, write.value);
+	return true;
+}
 
-        if((trigger_mode == IntTrig) || (trigger_mode == ExtTrigSingle))
-        {
-	        images_number   = nb_frames;
-	        triggers_number = 1;
-	        m_nb_frames     = nb_frames;
-        }
-        else
-        if(trigger_mode == ExtTrigMult)
-        {
-	        if(m_counting_mode == CountingModes::PumpProbeProbe_32)
-            {
-                images_number   = 1;
-	            triggers_number = m_pump_probe_nb_frames;
-	            m_nb_frames     = 1;
-            }
-            else
-            {
-                images_number   = 1;
-	            triggers_number = nb_frames;
-	            m_nb_frames     = nb_frames;
-            }
-        }
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::writeHardwareRegister(RegisterBatch::Register reg, double value) const
+{
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "writing " << RegisterBatch::getName(reg) << " = " << value;
 
-        m_ufxc_interface->set_images_number  (images_number  );
-        m_ufxc_interface->set_triggers_number(triggers_number);
-	}
-	catch(const ufxclib::Exception& ue)
+	switch(reg)
 	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::setNbFrames() :"
-		 << "\nreason : " << ue.errors[0].reason
-		 << "\ndesc : " << ue.errors[0].desc
-		 << "\norigin : " << ue.errors[0].origin
-		 << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+		case RegisterBatch::AcquisitionMode:
+			m_ufxc_interface->set_acq_mode(static_cast<ufxclib::EnumAcquisitionMode>(static_cast<int>(value)));
+			// image size and time ranges of the new acquisition mode
+			m_register_cache.invalidateGeometry();
+			break;
+
+		case RegisterBatch::CountingTime:
+			m_ufxc_interface->set_counting_time_ms(value);
+			// the DAQ can round the value
+			m_register_cache.invalidate(RegisterCache::CountingTime);
+			break;
+
+		case RegisterBatch::WaitingTime:
+			m_ufxc_interface->set_waiting_time_ms(value);
+			m_register_cache.invalidate(RegisterCache::WaitingTime);
+			break;
+
+		case RegisterBatch::ImagesNumber:
+			m_ufxc_interface->set_images_number(static_cast<std::size_t>(value));
+			m_register_cache.set(RegisterCache::ImagesNumber, value);
+			break;
+
+		case RegisterBatch::TriggersNumber:
+			m_ufxc_interface->set_triggers_number(static_cast<std::size_t>(value));
+			m_register_cache.set(RegisterCache::TriggersNumber, value);
+			break;
+
+		default:
+			THROW_HW_ERROR(InvalidValue) << "Unknown register: " << static_cast<int>(reg);
 	}
 }
 
 //-----------------------------------------------------
-//
+// value from the register cache, read from the DAQ if needed
 //-----------------------------------------------------
-void Camera::getNbFrames(int& nb_frames)
+double Camera::readRegister(RegisterCache::Key key) const
 {
-	DEB_MEMBER_FUNCT();
-	AutoMutex aLock(m_cond.mutex());
-	try
+	double   value;
+	unsigned generation;
+
+	// a value not yet written is given as requested
+	switch(key)
 	{
-        if(m_counting_mode == CountingModes::PumpProbeProbe_32)
-        {
-		    m_nb_frames = 1;
-        }
-        else
-        {
-            std::size_t images_number   = m_ufxc_interface->get_images_number  ();
-            std::size_t triggers_number = m_ufxc_interface->get_triggers_number();
-            m_nb_frames = images_number * triggers_number;
-        }
+		case RegisterCache::CountingTime  : if(m_register_batch.getPending(RegisterBatch::CountingTime  , value)) return value; break;
+		case RegisterCache::WaitingTime   : if(m_register_batch.getPending(RegisterBatch::WaitingTime   , value)) return value; break;
+		case RegisterCache::ImagesNumber  : if(m_register_batch.getPending(RegisterBatch::ImagesNumber  , value)) return value; break;
+		case RegisterCache::TriggersNumber: if(m_register_batch.getPending(RegisterBatch::TriggersNumber, value)) return value; break;
+
+		// computed by the SDK from the acquisition mode, only this one is written first
+		case RegisterCache::ImageWidth     :
+		case RegisterCache::ImageHeight    :
+		case RegisterCache::MinExposureTime:
+		case RegisterCache::MaxExposureTime:
+		case RegisterCache::MinLatencyTime :
+		case RegisterCache::MaxLatencyTime :
+			commitRegister(RegisterBatch::AcquisitionMode);
+			break;
 
-        nb_frames = m_nb_frames;
+		default: break;
 	}
-	catch(const ufxclib::Exception& ue)
+
+	if(!m_register_cache.get(key, value, generation))
 	{
-		std::ostringstream err_msg;
-		err_msg << "Error in Camera::getNbFrames() :"
-		 << "\nreason : " << ue.errors[0].reason
-		 << "\ndesc : "   << ue.errors[0].desc
-		 << "\norigin : " << ue.errors[0].origin
-		 << std::endl;
-		DEB_ERROR() << err_msg;
-		THROW_HW_FATAL(ErrorType::Error) << err_msg.str();
+		value = readHardwareRegister(key);
+		m_register_cache.fill(key, value, generation);
 	}
+
+	return value;
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-bool Camera::is_thread_running()
+double Camera::readHardwareRegister(RegisterCache::Key key) const
 {
-	return m_thread_running;
+	DEB_MEMBER_FUNCT();
+	DEB_TRACE() << "reading " << RegisterCache::getName(key);
+
+	switch(key)
+	{
+		case RegisterCache::CountingTime         : return m_ufxc_interface->get_counting_time_ms();
+		case RegisterCache::WaitingTime          : return m_ufxc_interface->get_waiting_time_ms();
+		case RegisterCache::ImagesNumber         : return static_cast<double>(m_ufxc_interface->get_images_number());
+		case RegisterCache::TriggersNumber       : return static_cast<double>(m_ufxc_interface->get_triggers_number());
+		case RegisterCache::ThresholdLow1        : return static_cast<double>(m_ufxc_interface->get_low_1_threshold());
+		case RegisterCache::ThresholdLow2        : return static_cast<double>(m_ufxc_interface->get_low_2_threshold());
+		case RegisterCache::ThresholdHigh1       : return static_cast<double>(m_ufxc_interface->get_high_1_threshold());
+		case RegisterCache::ThresholdHigh2       : return static_cast<double>(m_ufxc_interface->get_high_2_threshold());
+		case RegisterCache::PumpProbeFrequency   : return m_ufxc_interface->get_pump_probe_frequency_Hz();
+		case RegisterCache::GeometricalCorrection: return m_ufxc_interface->get_geometrical_correction() ? 1.0 : 0.0;
+		case RegisterCache::ImageWidth           : return static_cast<double>(m_ufxc_interface->get_current_width());
+		case RegisterCache::ImageHeight          : return static_cast<double>(m_ufxc_interface->get_current_height());
+		case RegisterCache::MinExposureTime      : return m_ufxc_interface->get_min_exposure_time_ms();
+		case RegisterCache::MaxExposureTime      : return m_ufxc_interface->get_max_exposure_time_ms();
+		case RegisterCache::MinLatencyTime       : return m_ufxc_interface->get_min_latency_time_ms();
+		case RegisterCache::MaxLatencyTime       : return m_ufxc_interface->get_max_latency_time_ms();
+		default                                  : break;
+	}
+
+	THROW_HW_ERROR(InvalidValue) << "Unknown register cache key: " << static_cast<int>(key);
 }
 
 ///////////////////////////////////////////////////
@@ -1564,6 +3970,9 @@ void Camera::set_threshold_Low1(float thr)
 	try
 	{
 		m_ufxc_interface->set_low_1_threshold(thr);
+
+		// the DAQ converts the value
+		m_register_cache.invalidate(RegisterCache::ThresholdLow1);
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1587,7 +3996,7 @@ void Camera::get_threshold_Low1(unsigned long& thr)
 	AutoMutex aLock(m_cond.mutex());
 	try
 	{
-		thr = m_ufxc_interface->get_low_1_threshold();
+		thr = static_cast<unsigned long>(readRegister(RegisterCache::ThresholdLow1));
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1612,6 +4021,9 @@ void Camera::set_threshold_Low2(float thr)
 	try
 	{
 		m_ufxc_interface->set_low_2_threshold(thr);
+
+		// the DAQ converts the value
+		m_register_cache.invalidate(RegisterCache::ThresholdLow2);
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1635,7 +4047,7 @@ void Camera::get_threshold_Low2(unsigned long& thr)
 	AutoMutex aLock(m_cond.mutex());
 	try
 	{
-		thr = m_ufxc_interface->get_low_2_threshold();
+		thr = static_cast<unsigned long>(readRegister(RegisterCache::ThresholdLow2));
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1660,6 +4072,9 @@ void Camera::set_threshold_High1(float thr)
 	try
 	{
 		m_ufxc_interface->set_high_1_threshold(thr);
+
+		// the DAQ converts the value
+		m_register_cache.invalidate(RegisterCache::ThresholdHigh1);
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1683,7 +4098,7 @@ void Camera::get_threshold_High1(unsigned long& thr)
 	AutoMutex aLock(m_cond.mutex());
 	try
 	{
-		thr = m_ufxc_interface->get_high_1_threshold();
+		thr = static_cast<unsigned long>(readRegister(RegisterCache::ThresholdHigh1));
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1708,6 +4123,9 @@ void Camera::set_threshold_High2(float thr)
 	try
 	{
 		m_ufxc_interface->set_high_2_threshold(thr);
+
+		// the DAQ converts the value
+		m_register_cache.invalidate(RegisterCache::ThresholdHigh2);
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1732,6 +4150,10 @@ void Camera::set_detector_config_file(const std::string& file_name)
 	try
 	{
 		m_ufxc_interface->set_detector_config_file(file_name);
+
+		// the configuration file can change any register
+		m_register_cache.invalidateAll();
+		m_register_batch.forgetHardware();
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1755,7 +4177,7 @@ void Camera::get_threshold_High2(unsigned long& thr)
 	AutoMutex aLock(m_cond.mutex());
 	try
 	{
-		thr = m_ufxc_interface->get_high_2_threshold();
+		thr = static_cast<unsigned long>(readRegister(RegisterCache::ThresholdHigh2));
 	}
 	catch(const ufxclib::Exception& ue)
 	{
@@ -1836,6 +4258,7 @@ void Camera::set_pump_probe_trigger_acquisition_frequency(float frequency)
 {
 	AutoMutex aLock(m_cond.mutex());
     m_ufxc_interface->set_pump_probe_frequency_Hz(static_cast<double>(frequency));
+    m_register_cache.invalidate(RegisterCache::PumpProbeFrequency);
 }
 /*******************************************************
  * \brief get trigger acquisition frequency for the pump and probe mode (2bits & ext triggger multi)
@@ -1843,7 +4266,7 @@ void Camera::set_pump_probe_trigger_acquisition_frequency(float frequency)
 void Camera::get_pump_probe_trigger_acquisition_frequency(float& frequency)
 {
 	AutoMutex aLock(m_cond.mutex());
-	frequency = static_cast<float>(m_ufxc_interface->get_pump_probe_frequency_Hz());
+	frequency = static_cast<float>(readRegister(RegisterCache::PumpProbeFrequency));
 }
 /*******************************************************
  * \brief set nb frames for the pump and probe mode (2bits & ext triggger multi)
@@ -1877,7 +4300,7 @@ void Camera::computePumpProbeNbFrames(double in_exposure)
         {
             AutoMutex aLock(m_cond.mutex());
 
-            double acquisition_frequency = m_ufxc_interface->get_pump_probe_frequency_Hz();
+            double acquisition_frequency = readRegister(RegisterCache::PumpProbeFrequency);
 
             nb_frames_pump_probe = static_cast<int> (round(in_exposure * acquisition_frequency / 2)*2);
 
@@ -0,0 +1,752 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <errno.h>
+#include "lima/Exceptions.h"
+#include "lima/Timestamp.h"
+#include "UfxcCaptureBackend.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// stdio buffer of the capture file (bytes)
+static const std::size_t CAPTURE_FILE_BUFFER = 8 * 1024 * 1024;
+// bytes of a record start (type, time)
+static const uint64_t    CAPTURE_RECORD_START= sizeof(uint8_t) + sizeof(double);
+
+// frames copied by the acquisition thread and not written yet
+static const int         CAPTURE_QUEUE_FRAMES = 16;
+
+// wait of the writer thread without frame (s)
+static const double      CAPTURE_WRITER_TIMEOUT_S = 0.1;
+
+/*******************************************************************
+ * \class CaptureBackend::WriterThread
+ * \brief thread encoding and writing the queued frames
+ *******************************************************************/
+class CaptureBackend::WriterThread : public Thread
+{
+public:
+    explicit WriterThread(CaptureBackend& backend) : m_backend(backend)
+    {
+        pthread_attr_setscope(&m_thread_attr, PTHREAD_SCOPE_PROCESS);
+    }
+
+    virtual ~WriterThread()
+    {
+        join();
+    }
+
+protected:
+    virtual void threadFunction()
+    {
+        m_backend.writerLoop();
+    }
+
+private:
+    CaptureBackend& m_backend;
+};
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+CaptureBackend::CaptureBackend(DetectorBackend * backend) :
+m_backend(backend),
+m_file(NULL),
+m_capturing(false),
+m_capture_start(0.0),
+m_frame_index(0),
+m_nb_frames(0),
+m_nb_bytes(0),
+m_frames(CAPTURE_QUEUE_FRAMES),
+m_free_frames(CAPTURE_QUEUE_FRAMES),
+m_queued_frames(CAPTURE_QUEUE_FRAMES),
+m_nb_queued_frames(0),
+m_nb_dropped(0),
+m_writer(NULL),
+m_writer_quit(false)
+{
+    DEB_CONSTRUCTOR();
+
+    for(int slot = 0 ; slot < CAPTURE_QUEUE_FRAMES ; slot++)
+        m_free_frames.push(slot);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+CaptureBackend::~CaptureBackend()
+{
+    DEB_DESTRUCTOR();
+
+    // the queued frames are written before the thread quits
+    if(m_writer != NULL)
+    {
+        {
+            AutoMutex aLock(m_writer_cond.mutex());
+            m_writer_quit = true;
+            m_writer_cond.broadcast();
+        }
+
+        delete m_writer; // joins the thread
+    }
+
+    {
+        AutoMutex aLock(m_mutex);
+        closeFile();
+    }
+
+    delete m_backend;
+}
+
+//-----------------------------------------------------
+// the informations of the detector are in the file header
+//-----------------------------------------------------
+void CaptureBackend::setCaptureFile(const std::string& file_name)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(file_name);
+
+    CaptureFormat::Header header;
+
+    if(!file_name.empty())
+    {
+        header.detector_name    = m_backend->get_detector_name   ();
+        header.detector_type    = m_backend->get_detector_type   ();
+        header.lib_version      = m_backend->get_lib_version     ();
+        header.firmware_version = m_backend->get_firmware_version();
+    }
+
+    // the frames of the previous file
+    drainFrames();
+
+    AutoMutex aLock(m_mutex);
+    closeFile();
+
+    if(file_name.empty())
+        return;
+
+    if(m_writer == NULL)
+    {
+        m_writer = new WriterThread(*this);
+        m_writer->start();
+    }
+
+    m_file = fopen(file_name.c_str(), "wb");
+
+    if(m_file == NULL)
+        THROW_HW_ERROR(Error) << "Can not create the capture file " << file_name << ": " << strerror(errno);
+
+    m_file_buffer.resize(CAPTURE_FILE_BUFFER);
+    setvbuf(m_file, &m_file_buffer[0], _IOFBF, m_file_buffer.size());
+
+    try
+    {
+        CaptureFormat::writeHeader(m_file, header);
+    }
+    catch(...)
+    {
+        closeFile();
+        throw;
+    }
+
+    m_file_name     = file_name;
+    m_capture_start = Timestamp::now();
+    m_nb_frames     = 0;
+    m_nb_bytes      = 0;
+    m_nb_dropped.store(0, std::memory_order_relaxed);
+    m_capturing.store(true, std::memory_order_release);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::string CaptureBackend::getCaptureFile() const
+{
+    AutoMutex aLock(m_mutex);
+    return m_file_name;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureBackend::getCaptureStats(unsigned long& nb_frames, unsigned long& nb_dropped, double& size_mb) const
+{
+    AutoMutex aLock(m_mutex);
+    nb_frames  = m_nb_frames;
+    nb_dropped = m_nb_dropped.load(std::memory_order_relaxed);
+    size_mb    = m_nb_bytes / (1024.0 * 1024.0);
+}
+
+//-----------------------------------------------------
+// connection and informations, not recorded
+//-----------------------------------------------------
+void CaptureBackend::open_connection(const std::string& model,
+                                     const ufxclib::DaqCnxConfig& tcp_cnx , const ufxclib::DaqCnxConfig& sfp1_cnx,
+                                     const ufxclib::DaqCnxConfig& sfp2_cnx, const ufxclib::DaqCnxConfig& sfp3_cnx,
+                                     unsigned long sfp_mtu)
+{
+    m_backend->open_connection(model, tcp_cnx, sfp1_cnx, sfp2_cnx, sfp3_cnx, sfp_mtu);
+}
+
+void CaptureBackend::close_connection()
+{
+    m_backend->close_connection();
+}
+
+void CaptureBackend::set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& names)
+{
+    m_backend->set_acquisition_registers_names(names);
+}
+
+void CaptureBackend::set_detector_registers_names(const std::map<ufxclib::EnumDetectorConfigKey, std::string>& names)
+{
+    m_backend->set_detector_registers_names(names);
+}
+
+void CaptureBackend::set_monitoring_registers_names(const std::map<ufxclib::EnumMonitoringKey, std::string>& names)
+{
+    m_backend->set_monitoring_registers_names(names);
+}
+
+void CaptureBackend::set_detector_config_file(const std::string& file_name)
+{
+    DEB_MEMBER_FUNCT();
+    m_backend->set_detector_config_file(file_name);
+
+    if(m_capturing.load(std::memory_order_acquire))
+    {
+        drainFrames();
+        AutoMutex aLock(m_mutex);
+
+        if(m_file != NULL)
+        {
+            try
+            {
+                CaptureFormat::writeRecordStart(m_file, CaptureFormat::ConfigFile, getTime());
+                CaptureFormat::writeString(m_file, file_name);
+                m_nb_bytes += CAPTURE_RECORD_START + sizeof(uint32_t) + file_name.size();
+            }
+            catch(Exception& e)
+            {
+                DEB_ERROR() << "capture stopped: " << e.getErrMsg();
+                closeFile();
+            }
+        }
+    }
+}
+
+std::string CaptureBackend::get_detector_name()
+{
+    return m_backend->get_detector_name();
+}
+
+std::string CaptureBackend::get_detector_type()
+{
+    return m_backend->get_detector_type();
+}
+
+std::string CaptureBackend::get_lib_version()
+{
+    return m_backend->get_lib_version();
+}
+
+std::string CaptureBackend::get_firmware_version()
+{
+    return m_backend->get_firmware_version();
+}
+
+unsigned long CaptureBackend::get_detector_temp()
+{
+    return m_backend->get_detector_temp();
+}
+
+ufxclib::EnumDetectorStatus CaptureBackend::get_detector_status()
+{
+    return m_backend->get_detector_status();
+}
+
+//-----------------------------------------------------
+// registers, the writes are recorded
+//-----------------------------------------------------
+void CaptureBackend::set_acq_mode(ufxclib::EnumAcquisitionMode mode)
+{
+    m_backend->set_acq_mode(mode);
+    writeRegister(CaptureFormat::AcqMode, static_cast<double>(static_cast<int>(mode)));
+}
+
+void CaptureBackend::set_counting_time_ms(double time_ms)
+{
+    m_backend->set_counting_time_ms(time_ms);
+    writeRegister(CaptureFormat::CountingTime, time_ms);
+}
+
+double CaptureBackend::get_counting_time_ms()
+{
+    return m_backend->get_counting_time_ms();
+}
+
+void CaptureBackend::set_waiting_time_ms(double time_ms)
+{
+    m_backend->set_waiting_time_ms(time_ms);
+    writeRegister(CaptureFormat::WaitingTime, time_ms);
+}
+
+double CaptureBackend::get_waiting_time_ms()
+{
+    return m_backend->get_waiting_time_ms();
+}
+
+void CaptureBackend::set_images_number(std::size_t images_number)
+{
+    m_backend->set_images_number(images_number);
+    writeRegister(CaptureFormat::ImagesNumber, static_cast<double>(images_number));
+}
+
+std::size_t CaptureBackend::get_images_number()
+{
+    return m_backend->get_images_number();
+}
+
+void CaptureBackend::set_triggers_number(std::size_t triggers_number)
+{
+    m_backend->set_triggers_number(triggers_number);
+    writeRegister(CaptureFormat::TriggersNumber, static_cast<double>(triggers_number));
+}
+
+std::size_t CaptureBackend::get_triggers_number()
+{
+    return m_backend->get_triggers_number();
+}
+
+void CaptureBackend::set_low_1_threshold(float threshold)
+{
+    m_backend->set_low_1_threshold(threshold);
+    writeRegister(CaptureFormat::Low1Threshold, threshold);
+}
+
+double CaptureBackend::get_low_1_threshold()
+{
+    return m_backend->get_low_1_threshold();
+}
+
+void CaptureBackend::set_low_2_threshold(float threshold)
+{
+    m_backend->set_low_2_threshold(threshold);
+    writeRegister(CaptureFormat::Low2Threshold, threshold);
+}
+
+double CaptureBackend::get_low_2_threshold()
+{
+    return m_backend->get_low_2_threshold();
+}
+
+void CaptureBackend::set_high_1_threshold(float threshold)
+{
+    m_backend->set_high_1_threshold(threshold);
+    writeRegister(CaptureFormat::High1Threshold, threshold);
+}
+
+double CaptureBackend::get_high_1_threshold()
+{
+    return m_backend->get_high_1_threshold();
+}
+
+void CaptureBackend::set_high_2_threshold(float threshold)
+{
+    m_backend->set_high_2_threshold(threshold);
+    writeRegister(CaptureFormat::High2Threshold, threshold);
+}
+
+double CaptureBackend::get_high_2_threshold()
+{
+    return m_backend->get_high_2_threshold();
+}
+
+void CaptureBackend::set_pump_probe_frequency_Hz(double frequency)
+{
+    m_backend->set_pump_probe_frequency_Hz(frequency);
+    writeRegister(CaptureFormat::PumpProbeFrequency, frequency);
+}
+
+double CaptureBackend::get_pump_probe_frequency_Hz()
+{
+    return m_backend->get_pump_probe_frequency_Hz();
+}
+
+void CaptureBackend::set_geometrical_correction(bool enabled)
+{
+    m_backend->set_geometrical_correction(enabled);
+    writeRegister(CaptureFormat::GeometricalCorrection, enabled ? 1.0 : 0.0);
+}
+
+bool CaptureBackend::get_geometrical_correction()
+{
+    return m_backend->get_geometrical_correction();
+}
+
+std::size_t CaptureBackend::get_current_width()
+{
+    return m_backend->get_current_width();
+}
+
+std::size_t CaptureBackend::get_current_height()
+{
+    return m_backend->get_current_height();
+}
+
+double CaptureBackend::get_min_exposure_time_ms()
+{
+    return m_backend->get_min_exposure_time_ms();
+}
+
+double CaptureBackend::get_max_exposure_time_ms()
+{
+    return m_backend->get_max_exposure_time_ms();
+}
+
+double CaptureBackend::get_min_latency_time_ms()
+{
+    return m_backend->get_min_latency_time_ms();
+}
+
+double CaptureBackend::get_max_latency_time_ms()
+{
+    return m_backend->get_max_latency_time_ms();
+}
+
+//-----------------------------------------------------
+// the start record gives the image size of the acquisition frames
+//-----------------------------------------------------
+void CaptureBackend::start_acquisition()
+{
+    DEB_MEMBER_FUNCT();
+
+    if(m_capturing.load(std::memory_order_acquire))
+    {
+        uint32_t width  = static_cast<uint32_t>(m_backend->get_current_width ());
+        uint32_t height = static_cast<uint32_t>(m_backend->get_current_height());
+
+        drainFrames();
+        AutoMutex aLock(m_mutex);
+
+        if(m_file != NULL)
+        {
+            try
+            {
+                CaptureFormat::writeRecordStart(m_file, CaptureFormat::Start, getTime());
+                CaptureFormat::writeValue(m_file, width );
+                CaptureFormat::writeValue(m_file, height);
+                m_nb_bytes += CAPTURE_RECORD_START + 2 * sizeof(uint32_t);
+            }
+            catch(Exception& e)
+            {
+                DEB_ERROR() << "capture stopped: " << e.getErrMsg();
+                closeFile();
+            }
+        }
+    }
+
+    m_backend->start_acquisition();
+}
+
+void CaptureBackend::stop_acquisition()
+{
+    m_backend->stop_acquisition();
+    writeEvent(CaptureFormat::Stop, 0);
+}
+
+void CaptureBackend::register_acquisition_customer(const std::string& name)
+{
+    m_backend->register_acquisition_customer(name);
+}
+
+void CaptureBackend::unregister_acquisition_customer(const std::string& name)
+{
+    m_backend->unregister_acquisition_customer(name);
+}
+
+void CaptureBackend::waiting_built_images()
+{
+    m_backend->waiting_built_images();
+}
+
+std::size_t CaptureBackend::get_built_images_nb()
+{
+    return m_backend->get_built_images_nb();
+}
+
+//-----------------------------------------------------
+// the camera reads the index before filling the frame
+//-----------------------------------------------------
+std::size_t CaptureBackend::get_first_built_image_index()
+{
+    std::size_t index = m_backend->get_first_built_image_index();
+    m_frame_index = index;
+    return index;
+}
+
+bool CaptureBackend::fill_image_buffer(char * buffer, int buffer_size)
+{
+    bool filled = m_backend->fill_image_buffer(buffer, buffer_size);
+
+    if(filled && m_capturing.load(std::memory_order_acquire))
+        queueFrame(false, buffer, buffer_size);
+
+    return filled;
+}
+
+bool CaptureBackend::fill_raw_image_buffer(char * buffer, int buffer_size)
+{
+    bool filled = m_backend->fill_raw_image_buffer(buffer, buffer_size);
+
+    if(filled && m_capturing.load(std::memory_order_acquire))
+        queueFrame(true, buffer, buffer_size);
+
+    return filled;
+}
+
+bool CaptureBackend::is_raw_images_supported() const
+{
+    return m_backend->is_raw_images_supported();
+}
+
+bool CaptureBackend::end_of_transfer()
+{
+    return m_backend->end_of_transfer();
+}
+
+bool CaptureBackend::failed_acquisition()
+{
+    bool failed = m_backend->failed_acquisition();
+    writeEvent(CaptureFormat::Failed, failed ? 1 : 0);
+    return failed;
+}
+
+void CaptureBackend::log_acquisition_stats()
+{
+    m_backend->log_acquisition_stats();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureBackend::writeRegister(CaptureFormat::RegisterId id, double value)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(!m_capturing.load(std::memory_order_acquire))
+        return;
+
+    drainFrames();
+    AutoMutex aLock(m_mutex);
+
+    if(m_file == NULL)
+        return;
+
+    try
+    {
+        CaptureFormat::writeRecordStart(m_file, CaptureFormat::Register, getTime());
+        CaptureFormat::writeValue(m_file, static_cast<uint8_t>(id));
+        CaptureFormat::writeValue(m_file, value);
+        m_nb_bytes += CAPTURE_RECORD_START + sizeof(uint8_t) + sizeof(double);
+    }
+    catch(Exception& e)
+    {
+        DEB_ERROR() << "capture stopped: " << e.getErrMsg();
+        closeFile();
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureBackend::writeEvent(CaptureFormat::RecordType type, uint8_t value)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(!m_capturing.load(std::memory_order_acquire))
+        return;
+
+    drainFrames();
+    AutoMutex aLock(m_mutex);
+
+    if(m_file == NULL)
+        return;
+
+    try
+    {
+        CaptureFormat::writeRecordStart(m_file, type, getTime());
+        m_nb_bytes += CAPTURE_RECORD_START;
+
+        if(type == CaptureFormat::Failed)
+        {
+            CaptureFormat::writeValue(m_file, value);
+            m_nb_bytes += sizeof(uint8_t);
+        }
+
+        // the end of an acquisition is readable at once
+        fflush(m_file);
+    }
+    catch(Exception& e)
+    {
+        DEB_ERROR() << "capture stopped: " << e.getErrMsg();
+        closeFile();
+    }
+}
+
+//-----------------------------------------------------
+// called by the acquisition thread, the frame is dropped if the queue is full
+//-----------------------------------------------------
+void CaptureBackend::queueFrame(bool raw, const char * buffer, int size)
+{
+    int slot;
+
+    if(!m_free_frames.pop(slot))
+    {
+        m_nb_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    QueuedFrame& frame = m_frames[slot];
+
+    frame.data.assign(buffer, buffer + size); // the capacity is kept
+    frame.index = m_frame_index;
+    frame.time  = getTime();
+    frame.raw   = raw;
+
+    m_nb_queued_frames.fetch_add(1, std::memory_order_acq_rel);
+
+    // cannot be full, the queue can contain all the slots
+    m_queued_frames.push(slot);
+
+    AutoMutex aLock(m_writer_cond.mutex());
+    m_writer_cond.broadcast();
+}
+
+//-----------------------------------------------------
+// writer thread: the queued frames are written before it quits
+//-----------------------------------------------------
+void CaptureBackend::writerLoop()
+{
+    AutoMutex aLock(m_writer_cond.mutex());
+
+    for(;;)
+    {
+        int slot;
+
+        if(!m_queued_frames.pop(slot))
+        {
+            if(m_writer_quit)
+                break;
+
+            m_writer_cond.wait(CAPTURE_WRITER_TIMEOUT_S);
+            continue;
+        }
+
+        aLock.unlock();
+        writeFrame(m_frames[slot]);
+        m_free_frames.push(slot);
+        aLock.lock();
+
+        m_nb_queued_frames.fetch_sub(1, std::memory_order_acq_rel);
+        m_writer_cond.broadcast();
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureBackend::drainFrames()
+{
+    AutoMutex aLock(m_writer_cond.mutex());
+
+    while(m_nb_queued_frames.load(std::memory_order_acquire) > 0)
+        m_writer_cond.wait(CAPTURE_WRITER_TIMEOUT_S);
+}
+
+//-----------------------------------------------------
+// called by the writer thread
+//-----------------------------------------------------
+void CaptureBackend::writeFrame(const QueuedFrame& frame)
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_mutex);
+
+    // the capture was stopped by an error
+    if(m_file == NULL)
+        return;
+
+    int size = static_cast<int>(frame.data.size());
+
+    try
+    {
+        CaptureFormat::encode(&frame.data[0], size, m_encoded);
+
+        CaptureFormat::writeRecordStart(m_file, CaptureFormat::Frame, frame.time);
+        CaptureFormat::writeValue(m_file, frame.index);
+        CaptureFormat::writeValue(m_file, static_cast<uint8_t >(frame.raw ? 1 : 0));
+        CaptureFormat::writeValue(m_file, static_cast<uint32_t>(size));
+        CaptureFormat::writeValue(m_file, static_cast<uint32_t>(m_encoded.size()));
+
+        if(!m_encoded.empty())
+            CaptureFormat::writeBytes(m_file, &m_encoded[0], m_encoded.size());
+
+        m_nb_frames++;
+        m_nb_bytes += CAPTURE_RECORD_START + sizeof(uint64_t) + sizeof(uint8_t) + 2 * sizeof(uint32_t) + m_encoded.size();
+    }
+    catch(Exception& e)
+    {
+        DEB_ERROR() << "capture stopped: " << e.getErrMsg();
+        closeFile();
+    }
+}
+
+//-----------------------------------------------------
+// called with the lock
+//-----------------------------------------------------
+void CaptureBackend::closeFile()
+{
+    DEB_MEMBER_FUNCT();
+    m_capturing.store(false, std::memory_order_release);
+
+    if(m_file != NULL)
+    {
+        if(fclose(m_file) != 0)
+            DEB_ERROR() << "Can not close the capture file " << m_file_name << ": " << strerror(errno);
+
+        DEB_TRACE() << "capture file closed: " << m_file_name << " - frames: " << m_nb_frames
+                    << " - dropped: " << m_nb_dropped.load(std::memory_order_relaxed);
+        m_file = NULL;
+    }
+
+    m_file_name.clear();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double CaptureBackend::getTime() const
+{
+    return double(Timestamp::now()) - m_capture_start;
+}
@@ -0,0 +1,249 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+#include "lima/Exceptions.h"
+#include "UfxcCaptureFormat.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+static const char     CAPTURE_MAGIC[8]    = { 'U', 'F', 'X', 'C', 'C', 'A', 'P', '\0' };
+static const uint32_t CAPTURE_VERSION     = 1;
+// longest string of the file (bytes)
+static const uint32_t CAPTURE_MAX_STRING  = 4096;
+
+static const char * CAPTURE_REGISTER_NAMES[CaptureFormat::NbRegisters] =
+{
+    "acq_mode"                ,
+    "counting_time_ms"        ,
+    "waiting_time_ms"         ,
+    "images_number"           ,
+    "triggers_number"         ,
+    "low_1_threshold"         ,
+    "low_2_threshold"         ,
+    "high_1_threshold"        ,
+    "high_2_threshold"        ,
+    "pump_probe_frequency_Hz" ,
+    "geometrical_correction"  ,
+};
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+const char * CaptureFormat::getRegisterName(int id)
+{
+    return ((id >= 0) && (id < NbRegisters)) ? CAPTURE_REGISTER_NAMES[id] : "unknown";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureFormat::writeHeader(FILE * file, const Header& header)
+{
+    writeBytes(file, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    writeValue(file, CAPTURE_VERSION);
+    writeString(file, header.detector_name   );
+    writeString(file, header.detector_type   );
+    writeString(file, header.lib_version     );
+    writeString(file, header.firmware_version);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureFormat::readHeader(FILE * file, Header& header)
+{
+    DEB_STATIC_FUNCT();
+
+    char     magic[sizeof(CAPTURE_MAGIC)];
+    uint32_t version;
+
+    readBytes(file, magic, sizeof(magic));
+
+    if(memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0)
+        THROW_HW_ERROR(Error) << "Not a UFXC capture file!";
+
+    readValue(file, version);
+
+    if(version != CAPTURE_VERSION)
+        THROW_HW_ERROR(Error) << "Unsupported capture file version: " << version << " (expected " << CAPTURE_VERSION << ")";
+
+    readString(file, header.detector_name   );
+    readString(file, header.detector_type   );
+    readString(file, header.lib_version     );
+    readString(file, header.firmware_version);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureFormat::writeRecordStart(FILE * file, RecordType type, double time)
+{
+    writeValue(file, static_cast<uint8_t>(type));
+    writeValue(file, time);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureFormat::writeString(FILE * file, const std::string& text)
+{
+    uint32_t size = static_cast<uint32_t>(std::min<std::size_t>(text.size(), CAPTURE_MAX_STRING));
+
+    writeValue(file, size);
+    writeBytes(file, text.data(), size);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool CaptureFormat::readRecordStart(FILE * file, RecordType& type, double& time)
+{
+    int value = fgetc(file);
+
+    if(value == EOF)
+        return false;
+
+    type = static_cast<RecordType>(value);
+    readValue(file, time);
+    return true;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureFormat::readString(FILE * file, std::string& text)
+{
+    DEB_STATIC_FUNCT();
+    uint32_t size;
+
+    readValue(file, size);
+
+    if(size > CAPTURE_MAX_STRING)
+        THROW_HW_ERROR(Error) << "Corrupted capture file: string of " << size << " bytes!";
+
+    text.resize(size);
+
+    if(size)
+        readBytes(file, &text[0], size);
+}
+
+//-----------------------------------------------------
+// runs of (zeros number, literals number, literals), the numbers are uint32
+//-----------------------------------------------------
+void CaptureFormat::encode(const char * data, int size, std::vector<char>& encoded)
+{
+    encoded.clear();
+    encoded.reserve(size / 4 + 16);
+
+    int position = 0;
+
+    while(position < size)
+    {
+        int zeros_start = position;
+
+        // zeros: 8 bytes at a time
+        while((position + 8 <= size) && (!memcmp(data + position, "\0\0\0\0\0\0\0\0", 8)))
+            position += 8;
+
+        while((position < size) && (data[position] == 0))
+            position++;
+
+        int literals_start = position;
+
+        // a literal run ends at 8 zero bytes, shorter zero runs cost more than they save
+        while(position < size)
+        {
+            if((position + 8 <= size) && (!memcmp(data + position, "\0\0\0\0\0\0\0\0", 8)))
+                break;
+
+            position++;
+        }
+
+        uint32_t run[2] = { static_cast<uint32_t>(literals_start - zeros_start), static_cast<uint32_t>(position - literals_start) };
+        std::size_t offset = encoded.size();
+
+        encoded.resize(offset + sizeof(run) + run[1]);
+        memcpy(&encoded[offset], run, sizeof(run));
+
+        if(run[1])
+            memcpy(&encoded[offset + sizeof(run)], data + literals_start, run[1]);
+    }
+}
+
+//-----------------------------------------------------
+// false if the encoded frame does not give size bytes
+//-----------------------------------------------------
+bool CaptureFormat::decode(const char * encoded, int encoded_size, char * data, int size)
+{
+    int input  = 0;
+    int output = 0;
+
+    while(input < encoded_size)
+    {
+        uint32_t run[2];
+
+        if(input + static_cast<int>(sizeof(run)) > encoded_size)
+            return false;
+
+        memcpy(run, encoded + input, sizeof(run));
+        input += sizeof(run);
+
+        if((run[0] > static_cast<uint32_t>(size - output)) || (run[1] > static_cast<uint32_t>(size - output) - run[0]) ||
+           (run[1] > static_cast<uint32_t>(encoded_size - input)))
+            return false;
+
+        memset(data + output, 0, run[0]);
+        output += run[0];
+
+        memcpy(data + output, encoded + input, run[1]);
+        output += run[1];
+        input  += run[1];
+    }
+
+    return output == size;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureFormat::writeBytes(FILE * file, const void * data, std::size_t size)
+{
+    DEB_STATIC_FUNCT();
+
+    if(fwrite(data, 1, size, file) != size)
+        THROW_HW_ERROR(Error) << "Can not write the capture file: " << strerror(errno);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CaptureFormat::readBytes(FILE * file, void * data, std::size_t size)
+{
+    DEB_STATIC_FUNCT();
+
+    if(fread(data, 1, size, file) != size)
+        THROW_HW_ERROR(Error) << "Truncated capture file!";
+}
@@ -0,0 +1,367 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include "lima/Exceptions.h"
+#include "UfxcDetectorBackend.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+SdkBackend::SdkBackend()
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+SdkBackend::~SdkBackend()
+{
+    DEB_DESTRUCTOR();
+}
+
+//-----------------------------------------------------
+// the SDK converts the Ufxc_Model label to its detector type
+//-----------------------------------------------------
+void SdkBackend::open_connection(const std::string& model,
+                                 const ufxclib::DaqCnxConfig& tcp_cnx , const ufxclib::DaqCnxConfig& sfp1_cnx,
+                                 const ufxclib::DaqCnxConfig& sfp2_cnx, const ufxclib::DaqCnxConfig& sfp3_cnx,
+                                 unsigned long sfp_mtu)
+{
+    AutoMutex aLock(m_control_mutex);
+    ufxclib::EnumDetectorType sdk_detector_type = m_interface.get_detector_type_from_label(model);
+    m_interface.open_connection(sdk_detector_type, tcp_cnx, sfp1_cnx, sfp2_cnx, sfp3_cnx, sfp_mtu);
+}
+
+void SdkBackend::close_connection()
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.close_connection();
+}
+
+void SdkBackend::set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& names)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_acquisition_registers_names(names);
+}
+
+void SdkBackend::set_detector_registers_names(const std::map<ufxclib::EnumDetectorConfigKey, std::string>& names)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_detector_registers_names(names);
+}
+
+void SdkBackend::set_monitoring_registers_names(const std::map<ufxclib::EnumMonitoringKey, std::string>& names)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_monitoring_registers_names(names);
+}
+
+void SdkBackend::set_detector_config_file(const std::string& file_name)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_detector_config_file(file_name);
+}
+
+//-----------------------------------------------------
+// informations
+//-----------------------------------------------------
+std::string SdkBackend::get_detector_name()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_detector_name();
+}
+
+std::string SdkBackend::get_detector_type()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_detector_type();
+}
+
+std::string SdkBackend::get_lib_version()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_lib_version();
+}
+
+std::string SdkBackend::get_firmware_version()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_firmware_version();
+}
+
+unsigned long SdkBackend::get_detector_temp()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_detector_temp();
+}
+
+ufxclib::EnumDetectorStatus SdkBackend::get_detector_status()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_detector_status();
+}
+
+//-----------------------------------------------------
+// registers
+//-----------------------------------------------------
+void SdkBackend::set_acq_mode(ufxclib::EnumAcquisitionMode mode)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_acq_mode(mode);
+}
+
+void SdkBackend::set_counting_time_ms(double time_ms)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_counting_time_ms(time_ms);
+}
+
+double SdkBackend::get_counting_time_ms()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_counting_time_ms();
+}
+
+void SdkBackend::set_waiting_time_ms(double time_ms)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_waiting_time_ms(time_ms);
+}
+
+double SdkBackend::get_waiting_time_ms()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_waiting_time_ms();
+}
+
+void SdkBackend::set_images_number(std::size_t images_number)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_images_number(images_number);
+}
+
+std::size_t SdkBackend::get_images_number()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_images_number();
+}
+
+void SdkBackend::set_triggers_number(std::size_t triggers_number)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_triggers_number(triggers_number);
+}
+
+std::size_t SdkBackend::get_triggers_number()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_triggers_number();
+}
+
+void SdkBackend::set_low_1_threshold(float threshold)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_low_1_threshold(threshold);
+}
+
+double SdkBackend::get_low_1_threshold()
+{
+    AutoMutex aLock(m_control_mutex);
+    return static_cast<double>(m_interface.get_low_1_threshold());
+}
+
+void SdkBackend::set_low_2_threshold(float threshold)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_low_2_threshold(threshold);
+}
+
+double SdkBackend::get_low_2_threshold()
+{
+    AutoMutex aLock(m_control_mutex);
+    return static_cast<double>(m_interface.get_low_2_threshold());
+}
+
+void SdkBackend::set_high_1_threshold(float threshold)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_high_1_threshold(threshold);
+}
+
+double SdkBackend::get_high_1_threshold()
+{
+    AutoMutex aLock(m_control_mutex);
+    return static_cast<double>(m_interface.get_high_1_threshold());
+}
+
+void SdkBackend::set_high_2_threshold(float threshold)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_high_2_threshold(threshold);
+}
+
+double SdkBackend::get_high_2_threshold()
+{
+    AutoMutex aLock(m_control_mutex);
+    return static_cast<double>(m_interface.get_high_2_threshold());
+}
+
+void SdkBackend::set_pump_probe_frequency_Hz(double frequency)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_pump_probe_frequency_Hz(frequency);
+}
+
+double SdkBackend::get_pump_probe_frequency_Hz()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_pump_probe_frequency_Hz();
+}
+
+void SdkBackend::set_geometrical_correction(bool enabled)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.set_geometrical_correction(enabled);
+}
+
+bool SdkBackend::get_geometrical_correction()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_geometrical_correction();
+}
+
+std::size_t SdkBackend::get_current_width()
+{
+    AutoMutex aLock(m_control_mutex);
+    return static_cast<std::size_t>(m_interface.get_current_width());
+}
+
+std::size_t SdkBackend::get_current_height()
+{
+    AutoMutex aLock(m_control_mutex);
+    return static_cast<std::size_t>(m_interface.get_current_height());
+}
+
+double SdkBackend::get_min_exposure_time_ms()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_min_exposure_time_ms();
+}
+
+double SdkBackend::get_max_exposure_time_ms()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_max_exposure_time_ms();
+}
+
+double SdkBackend::get_min_latency_time_ms()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_min_latency_time_ms();
+}
+
+double SdkBackend::get_max_latency_time_ms()
+{
+    AutoMutex aLock(m_control_mutex);
+    return m_interface.get_max_latency_time_ms();
+}
+
+//-----------------------------------------------------
+// acquisition
+//-----------------------------------------------------
+void SdkBackend::start_acquisition()
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.start_acquisition();
+}
+
+void SdkBackend::stop_acquisition()
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.stop_acquisition();
+}
+
+void SdkBackend::register_acquisition_customer(const std::string& name)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.register_acquisition_customer(name);
+}
+
+void SdkBackend::unregister_acquisition_customer(const std::string& name)
+{
+    AutoMutex aLock(m_control_mutex);
+    m_interface.unregister_acquisition_customer(name);
+}
+
+void SdkBackend::waiting_built_images()
+{
+    m_interface.waiting_built_images();
+}
+
+std::size_t SdkBackend::get_built_images_nb()
+{
+    return static_cast<std::size_t>(m_interface.get_built_images_nb());
+}
+
+std::size_t SdkBackend::get_first_built_image_index()
+{
+    return static_cast<std::size_t>(m_interface.get_first_built_image_index());
+}
+
+bool SdkBackend::fill_image_buffer(char * buffer, int buffer_size)
+{
+    return m_interface.fill_image_buffer(buffer, buffer_size);
+}
+
+//-----------------------------------------------------
+// blocked on the SDK: ufxclib has no call giving the raw bit streams,
+// and their layout in the DAQ is not documented
+//-----------------------------------------------------
+bool SdkBackend::fill_raw_image_buffer(char * /*buffer*/, int /*buffer_size*/)
+{
+    DEB_MEMBER_FUNCT();
+    THROW_HW_ERROR(NotSupported) << "ufxclib does not give the raw images!";
+}
+
+bool SdkBackend::is_raw_images_supported() const
+{
+    return false;
+}
+
+bool SdkBackend::end_of_transfer()
+{
+    return m_interface.end_of_transfer();
+}
+
+bool SdkBackend::failed_acquisition()
+{
+    return m_interface.failed_acquisition();
+}
+
+void SdkBackend::log_acquisition_stats()
+{
+    m_interface.log_acquisition_stats();
+}
@@ -0,0 +1,747 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <algorithm>
+#include "lima/Exceptions.h"
+#include "lima/Timestamp.h"
+#include "UfxcDetectorSimulator.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+using namespace ufxclib;
+
+static const char * SIMULATOR_MODEL          = "SIMULATOR";
+// pixels of an UFXC chip side
+static const int    SIMULATOR_CHIP_SIZE      = 128;
+// different frames contents, the frames repeat them
+static const int    SIMULATOR_NB_PATTERNS    = 8;
+// max counts of a pixel of the patterns
+static const uint32_t SIMULATOR_MAX_COUNTS   = 255;
+// longest sleep of waiting_built_images (in s), the stop is seen after it
+static const double SIMULATOR_MAX_SLEEP_S    = 0.001;
+// limits of the registers
+static const double SIMULATOR_MIN_EXPOSURE_MS= 0.001;
+static const double SIMULATOR_MAX_EXPOSURE_MS= 1e6;
+static const double SIMULATOR_MIN_LATENCY_MS = 0.0;
+static const double SIMULATOR_MAX_LATENCY_MS = 1e6;
+
+//-----------------------------------------------------
+// writes a counter in a little-endian bit stream
+//-----------------------------------------------------
+static void writeCounter(uint8_t * stream, int pixel, int depth, uint32_t value)
+{
+    uint64_t first_bit = static_cast<uint64_t>(pixel) * depth;
+
+    for(int bit = 0 ; bit < depth ; bit++)
+    {
+        uint64_t position = first_bit + bit;
+        uint8_t  mask     = static_cast<uint8_t>(1U << (position & 7));
+
+        if((value >> bit) & 1U)
+            stream[position >> 3] |=  mask;
+        else
+            stream[position >> 3] &= ~mask;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static uint32_t nextRandom(uint32_t& seed)
+{
+    seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+    return seed;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+DetectorSimulator::DetectorSimulator() :
+m_width(2 * SIMULATOR_CHIP_SIZE),
+m_height(SIMULATOR_CHIP_SIZE),
+m_connected(false),
+m_acq_mode(EnumAcquisitionMode::software_14_raw),
+m_counting_time_ms(1.0),
+m_waiting_time_ms(0.0),
+m_images_number(1),
+m_triggers_number(1),
+m_pump_probe_frequency(1000.0),
+m_geometrical_correction(false),
+m_occupancy(0.02),
+m_transaction_time(0.0),
+m_nb_reads(0),
+m_nb_writes(0),
+m_raw_frame_size(0),
+m_frame_size(0),
+m_start_time(0.0),
+m_image_period(0.0),
+m_nb_images(0),
+m_nb_filled_images(0),
+m_running(false),
+m_stopped(false)
+{
+    DEB_CONSTRUCTOR();
+
+    for(int index = 0 ; index < 4 ; index++)
+        m_thresholds[index] = 0.0;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+DetectorSimulator::~DetectorSimulator()
+{
+    DEB_DESTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool DetectorSimulator::isSimulatorModel(const std::string& model)
+{
+    return model.compare(0, strlen(SIMULATOR_MODEL), SIMULATOR_MODEL) == 0;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void DetectorSimulator::setOccupancy(double occupancy)
+{
+    DEB_MEMBER_FUNCT();
+
+    if((occupancy < 0.0) || (occupancy > 1.0))
+        THROW_HW_ERROR(InvalidValue) << "Incorrect simulator occupancy: " << DEB_VAR1(occupancy);
+
+    AutoMutex aLock(m_mutex);
+    m_occupancy = occupancy;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double DetectorSimulator::getOccupancy() const
+{
+    AutoMutex aLock(m_mutex);
+    return m_occupancy;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void DetectorSimulator::setTransactionTime(double time_ms)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(time_ms < 0.0)
+        THROW_HW_ERROR(InvalidValue) << "Incorrect simulator transaction time: " << DEB_VAR1(time_ms);
+
+    m_transaction_time.store(time_ms, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double DetectorSimulator::getTransactionTime() const
+{
+    return m_transaction_time.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void DetectorSimulator::getTransactionStats(unsigned long& nb_reads, unsigned long& nb_writes) const
+{
+    nb_reads  = m_nb_reads .load(std::memory_order_relaxed);
+    nb_writes = m_nb_writes.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void DetectorSimulator::resetTransactionStats()
+{
+    m_nb_reads .store(0, std::memory_order_relaxed);
+    m_nb_writes.store(0, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------
+// the image n ends at start_time + (n + 1) x image_period
+//-----------------------------------------------------
+void DetectorSimulator::getAcquisitionTiming(double& start_time, double& image_period) const
+{
+    AutoMutex aLock(m_mutex);
+
+    start_time   = m_start_time  ;
+    image_period = m_image_period;
+}
+
+//-----------------------------------------------------
+// SIMULATOR or SIMULATOR_<width>x<height>
+//-----------------------------------------------------
+void DetectorSimulator::open_connection(const std::string& model,
+                                        const ufxclib::DaqCnxConfig& /*tcp_cnx*/ , const ufxclib::DaqCnxConfig& /*sfp1_cnx*/,
+                                        const ufxclib::DaqCnxConfig& /*sfp2_cnx*/, const ufxclib::DaqCnxConfig& /*sfp3_cnx*/,
+                                        unsigned long /*sfp_mtu*/)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(model);
+
+    int width  = 2 * SIMULATOR_CHIP_SIZE;
+    int height = SIMULATOR_CHIP_SIZE;
+
+    if(!isSimulatorModel(model))
+        THROW_HW_ERROR(InvalidValue) << "Not a simulator model: " << model;
+
+    if(model.size() > strlen(SIMULATOR_MODEL))
+    {
+        char end;
+
+        if((sscanf(model.c_str() + strlen(SIMULATOR_MODEL), "_%dx%d%c", &width, &height, &end) != 2) ||
+           (width <= 0) || (height <= 0) || (width % SIMULATOR_CHIP_SIZE) || (height % SIMULATOR_CHIP_SIZE))
+        {
+            THROW_HW_ERROR(InvalidValue) << "Incorrect simulator model " << model << ", should be " << SIMULATOR_MODEL
+                                         << " or " << SIMULATOR_MODEL << "_<width>x<height> (multiples of "
+                                         << SIMULATOR_CHIP_SIZE << " pixels)";
+        }
+    }
+
+    AutoMutex aLock(m_mutex);
+    m_model     = model;
+    m_width     = width;
+    m_height    = height;
+    m_connected = true;
+}
+
+void DetectorSimulator::close_connection()
+{
+    stop_acquisition();
+
+    AutoMutex aLock(m_mutex);
+    m_connected = false;
+}
+
+void DetectorSimulator::set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& /*names*/)
+{
+}
+
+void DetectorSimulator::set_detector_registers_names(const std::map<ufxclib::EnumDetectorConfigKey, std::string>& /*names*/)
+{
+}
+
+void DetectorSimulator::set_monitoring_registers_names(const std::map<ufxclib::EnumMonitoringKey, std::string>& /*names*/)
+{
+}
+
+void DetectorSimulator::set_detector_config_file(const std::string& file_name)
+{
+    DEB_MEMBER_FUNCT();
+    transaction(true);
+    DEB_TRACE() << "configuration file ignored by the simulator: " << file_name;
+}
+
+//-----------------------------------------------------
+// informations
+//-----------------------------------------------------
+std::string DetectorSimulator::get_detector_name()
+{
+    transaction(false);
+    return "UFXC simulator";
+}
+
+std::string DetectorSimulator::get_detector_type()
+{
+    transaction(false);
+    AutoMutex aLock(m_mutex);
+    return m_model;
+}
+
+std::string DetectorSimulator::get_lib_version()
+{
+    transaction(false);
+    return "simulator";
+}
+
+std::string DetectorSimulator::get_firmware_version()
+{
+    transaction(false);
+    return "simulator";
+}
+
+unsigned long DetectorSimulator::get_detector_temp()
+{
+    transaction(false);
+    return 30;
+}
+
+ufxclib::EnumDetectorStatus DetectorSimulator::get_detector_status()
+{
+    transaction(false);
+    AutoMutex aLock(m_mutex);
+    return (m_running && !end_of_transfer()) ? EnumDetectorStatus::E_DET_BUSY : EnumDetectorStatus::E_DET_READY;
+}
+
+//-----------------------------------------------------
+// registers, written and read with the camera lock
+//-----------------------------------------------------
+void DetectorSimulator::set_acq_mode(ufxclib::EnumAcquisitionMode mode)
+{
+    transaction(true);
+    m_acq_mode = mode;
+}
+
+void DetectorSimulator::set_counting_time_ms(double time_ms)
+{
+    transaction(true);
+    m_counting_time_ms = std::max(SIMULATOR_MIN_EXPOSURE_MS, std::min(time_ms, SIMULATOR_MAX_EXPOSURE_MS));
+}
+
+double DetectorSimulator::get_counting_time_ms()
+{
+    transaction(false);
+    return m_counting_time_ms;
+}
+
+void DetectorSimulator::set_waiting_time_ms(double time_ms)
+{
+    transaction(true);
+    m_waiting_time_ms = std::max(SIMULATOR_MIN_LATENCY_MS, std::min(time_ms, SIMULATOR_MAX_LATENCY_MS));
+}
+
+double DetectorSimulator::get_waiting_time_ms()
+{
+    transaction(false);
+    return m_waiting_time_ms;
+}
+
+void DetectorSimulator::set_images_number(std::size_t images_number)
+{
+    transaction(true);
+    m_images_number = images_number;
+}
+
+std::size_t DetectorSimulator::get_images_number()
+{
+    transaction(false);
+    return m_images_number;
+}
+
+void DetectorSimulator::set_triggers_number(std::size_t triggers_number)
+{
+    transaction(true);
+    m_triggers_number = triggers_number;
+}
+
+std::size_t DetectorSimulator::get_triggers_number()
+{
+    transaction(false);
+    return m_triggers_number;
+}
+
+void DetectorSimulator::set_low_1_threshold(float threshold)
+{
+    transaction(true);
+    m_thresholds[0] = threshold;
+}
+
+double DetectorSimulator::get_low_1_threshold()
+{
+    transaction(false);
+    return m_thresholds[0];
+}
+
+void DetectorSimulator::set_low_2_threshold(float threshold)
+{
+    transaction(true);
+    m_thresholds[1] = threshold;
+}
+
+double DetectorSimulator::get_low_2_threshold()
+{
+    transaction(false);
+    return m_thresholds[1];
+}
+
+void DetectorSimulator::set_high_1_threshold(float threshold)
+{
+    transaction(true);
+    m_thresholds[2] = threshold;
+}
+
+double DetectorSimulator::get_high_1_threshold()
+{
+    transaction(false);
+    return m_thresholds[2];
+}
+
+void DetectorSimulator::set_high_2_threshold(float threshold)
+{
+    transaction(true);
+    m_thresholds[3] = threshold;
+}
+
+double DetectorSimulator::get_high_2_threshold()
+{
+    transaction(false);
+    return m_thresholds[3];
+}
+
+void DetectorSimulator::set_pump_probe_frequency_Hz(double frequency)
+{
+    transaction(true);
+    m_pump_probe_frequency = frequency;
+}
+
+double DetectorSimulator::get_pump_probe_frequency_Hz()
+{
+    transaction(false);
+    return m_pump_probe_frequency;
+}
+
+void DetectorSimulator::set_geometrical_correction(bool enabled)
+{
+    m_geometrical_correction = enabled;
+}
+
+bool DetectorSimulator::get_geometrical_correction()
+{
+    return m_geometrical_correction;
+}
+
+//-----------------------------------------------------
+// the SDK correction inserts the gaps between the chips
+//-----------------------------------------------------
+std::size_t DetectorSimulator::get_current_width()
+{
+    transaction(false);
+    Size size(m_width, m_height);
+
+    if(m_geometrical_correction)
+        size = GeometryRemap::getCorrectedSize(ChipLayout(), size);
+
+    return static_cast<std::size_t>(size.getWidth());
+}
+
+std::size_t DetectorSimulator::get_current_height()
+{
+    transaction(false);
+    Size size(m_width, m_height);
+
+    if(m_geometrical_correction)
+        size = GeometryRemap::getCorrectedSize(ChipLayout(), size);
+
+    return static_cast<std::size_t>(size.getHeight());
+}
+
+double DetectorSimulator::get_min_exposure_time_ms()
+{
+    transaction(false);
+    return SIMULATOR_MIN_EXPOSURE_MS;
+}
+
+double DetectorSimulator::get_max_exposure_time_ms()
+{
+    transaction(false);
+    return SIMULATOR_MAX_EXPOSURE_MS;
+}
+
+double DetectorSimulator::get_min_latency_time_ms()
+{
+    transaction(false);
+    return SIMULATOR_MIN_LATENCY_MS;
+}
+
+double DetectorSimulator::get_max_latency_time_ms()
+{
+    transaction(false);
+    return SIMULATOR_MAX_LATENCY_MS;
+}
+
+//-----------------------------------------------------
+// the patterns are rebuilt for each acquisition (mode or size change)
+//-----------------------------------------------------
+void DetectorSimulator::start_acquisition()
+{
+    DEB_MEMBER_FUNCT();
+    transaction(true);
+    AutoMutex aLock(m_mutex);
+
+    if(!m_connected)
+        THROW_HW_ERROR(Error) << "The simulator is not connected!";
+
+    buildPatterns();
+
+    if(isPumpProbe())
+    {
+        // the triggers of an image at the pump-probe frequency
+        m_nb_images    = m_images_number;
+        m_image_period = (m_pump_probe_frequency > 0.0) ? m_triggers_number / m_pump_probe_frequency : m_counting_time_ms * 1e-3;
+    }
+    else
+    {
+        m_nb_images    = m_images_number * m_triggers_number;
+        m_image_period = (m_counting_time_ms + m_waiting_time_ms) * 1e-3;
+    }
+
+    m_nb_filled_images = 0;
+    m_start_time       = Timestamp::now();
+    m_stopped.store(false, std::memory_order_relaxed);
+    m_running.store(true , std::memory_order_release);
+
+    DEB_TRACE() << "simulated acquisition: " << m_nb_images << " images - period " << m_image_period << " s";
+}
+
+void DetectorSimulator::stop_acquisition()
+{
+    transaction(true);
+    m_stopped.store(true, std::memory_order_release);
+}
+
+void DetectorSimulator::register_acquisition_customer(const std::string& /*name*/)
+{
+}
+
+void DetectorSimulator::unregister_acquisition_customer(const std::string& /*name*/)
+{
+}
+
+//-----------------------------------------------------
+// sleeps until the next image is built
+//-----------------------------------------------------
+void DetectorSimulator::waiting_built_images()
+{
+    while((!get_built_images_nb()) && (!end_of_transfer()))
+    {
+        double next_image = m_start_time + (m_nb_filled_images + 1) * m_image_period;
+        double sleep_time = std::min(SIMULATOR_MAX_SLEEP_S, next_image - double(Timestamp::now()));
+
+        if(sleep_time > 0.0)
+            usleep(static_cast<useconds_t>(ceil(sleep_time * 1e6)));
+    }
+}
+
+std::size_t DetectorSimulator::get_built_images_nb()
+{
+    if((!m_running.load(std::memory_order_acquire)) || (m_stopped.load(std::memory_order_acquire)))
+        return 0;
+
+    return getNbBuiltImages() - m_nb_filled_images;
+}
+
+std::size_t DetectorSimulator::get_first_built_image_index()
+{
+    return m_nb_filled_images;
+}
+
+bool DetectorSimulator::fill_image_buffer(char * buffer, int buffer_size)
+{
+    return fillBuffer(m_patterns, m_frame_size, getDepth(), buffer, buffer_size);
+}
+
+bool DetectorSimulator::fill_raw_image_buffer(char * buffer, int buffer_size)
+{
+    return fillBuffer(m_raw_patterns, m_raw_frame_size, getDepth(), buffer, buffer_size);
+}
+
+bool DetectorSimulator::is_raw_images_supported() const
+{
+    return true;
+}
+
+bool DetectorSimulator::end_of_transfer()
+{
+    if((!m_running.load(std::memory_order_acquire)) || (m_stopped.load(std::memory_order_acquire)))
+        return true;
+
+    return m_nb_filled_images >= m_nb_images;
+}
+
+//-----------------------------------------------------
+// a stop is not a failure
+//-----------------------------------------------------
+bool DetectorSimulator::failed_acquisition()
+{
+    return false;
+}
+
+void DetectorSimulator::log_acquisition_stats()
+{
+    DEB_MEMBER_FUNCT();
+    double elapsed = double(Timestamp::now()) - m_start_time;
+
+    DEB_TRACE() << "simulated images: " << m_nb_filled_images << " / " << m_nb_images << " in " << elapsed << " s";
+}
+
+//-----------------------------------------------------
+// same counters as the counting modes of the camera
+//-----------------------------------------------------
+int DetectorSimulator::getDepth() const
+{
+    switch(m_acq_mode)
+    {
+        case EnumAcquisitionMode::software_continuous_2_raw   :
+        case EnumAcquisitionMode::external_continuous_2_raw   : return 2 ;
+        case EnumAcquisitionMode::software_continuous_4_raw   :
+        case EnumAcquisitionMode::external_continuous_4_raw   : return 4 ;
+        case EnumAcquisitionMode::software_continuous_8_raw   :
+        case EnumAcquisitionMode::external_continuous_8_raw   : return 8 ;
+        case EnumAcquisitionMode::software_long_counter_14_raw:
+        case EnumAcquisitionMode::external_long_counter_14_raw: return 28;
+        case EnumAcquisitionMode::pump_and_probe_2_raw        : return 32;
+        default                                               : return 14;
+    }
+}
+
+bool DetectorSimulator::isPumpProbe() const
+{
+    return m_acq_mode == EnumAcquisitionMode::pump_and_probe_2_raw;
+}
+
+//-----------------------------------------------------
+// an image is built at the end of its period
+//-----------------------------------------------------
+std::size_t DetectorSimulator::getNbBuiltImages() const
+{
+    if(m_image_period <= 0.0)
+        return m_nb_images;
+
+    double elapsed = double(Timestamp::now()) - m_start_time;
+    return std::min(m_nb_images, static_cast<std::size_t>(std::max(0.0, floor(elapsed / m_image_period))));
+}
+
+//-----------------------------------------------------
+// sparse counters, the two 16 bits probes of the pump-probe-probe pixels
+//-----------------------------------------------------
+void DetectorSimulator::buildPatterns()
+{
+    int      depth     = getDepth();
+    int      nb_pixels = m_width * m_height;
+    uint32_t max_value = (depth >= 32) ? 0xFFFFFFFFU : ((1U << depth) - 1);
+    uint32_t max_counts= std::min(SIMULATOR_MAX_COUNTS, max_value);
+    uint32_t threshold = static_cast<uint32_t>(m_occupancy * 4294967295.0);
+    uint32_t seed      = 0x2545f491;
+    Size     size(m_width, m_height);
+
+    m_raw_frame_size = PixelUnpacker::getPackedSize(depth, nb_pixels);
+    m_raw_patterns.assign(static_cast<std::size_t>(SIMULATOR_NB_PATTERNS) * m_raw_frame_size, 0);
+
+    for(int pattern = 0 ; pattern < SIMULATOR_NB_PATTERNS ; pattern++)
+    {
+        uint8_t * stream = reinterpret_cast<uint8_t *>(&m_raw_patterns[static_cast<std::size_t>(pattern) * m_raw_frame_size]);
+
+        for(int pixel = 0 ; pixel < nb_pixels ; pixel++)
+        {
+            if(nextRandom(seed) > threshold)
+                continue;
+
+            uint32_t value = 1 + nextRandom(seed) % max_counts;
+
+            if(isPumpProbe())
+                value |= (1 + nextRandom(seed) % max_counts) << 16;
+
+            writeCounter(stream, pixel, depth, value);
+        }
+    }
+
+    // images of the SDK: decoded, with the gaps of the geometrical correction
+    int                pixel_size = PixelUnpacker::getPixelSize(depth);
+    std::vector<char>  decoded(static_cast<std::size_t>(pixel_size) * nb_pixels);
+    Size               image_size = size;
+
+    if(m_geometrical_correction)
+    {
+        m_remap.build(m_model, ChipLayout(), size);
+        image_size = m_remap.getCorrectedSize();
+    }
+
+    m_frame_size = pixel_size * image_size.getWidth() * image_size.getHeight();
+    m_patterns.assign(static_cast<std::size_t>(SIMULATOR_NB_PATTERNS) * m_frame_size, 0);
+
+    for(int pattern = 0 ; pattern < SIMULATOR_NB_PATTERNS ; pattern++)
+    {
+        char * image = &m_patterns[static_cast<std::size_t>(pattern) * m_frame_size];
+
+        if(m_geometrical_correction)
+        {
+            m_unpacker.unpack(depth, &m_raw_patterns[static_cast<std::size_t>(pattern) * m_raw_frame_size], &decoded[0], nb_pixels);
+            m_remap.apply(pixel_size, &decoded[0], image);
+        }
+        else
+            m_unpacker.unpack(depth, &m_raw_patterns[static_cast<std::size_t>(pattern) * m_raw_frame_size], image, nb_pixels);
+    }
+}
+
+//-----------------------------------------------------
+// the first counter is the frame index (the pixel 0 is the same in the raw and the corrected images)
+//-----------------------------------------------------
+bool DetectorSimulator::fillBuffer(const std::vector<char>& patterns, int frame_size, int depth, char * buffer, int buffer_size)
+{
+    if((!get_built_images_nb()) || (buffer_size < frame_size))
+        return false;
+
+    std::size_t index      = m_nb_filled_images;
+    int         pattern    = static_cast<int>(index % SIMULATOR_NB_PATTERNS);
+    uint32_t    max_value  = (depth >= 32) ? 0xFFFFFFFFU : ((1U << depth) - 1);
+    uint32_t    stamp      = static_cast<uint32_t>(index) & max_value;
+
+    memcpy(buffer, &patterns[static_cast<std::size_t>(pattern) * frame_size], frame_size);
+
+    if(&patterns == &m_raw_patterns)
+        writeCounter(reinterpret_cast<uint8_t *>(buffer), 0, depth, stamp);
+    else
+    {
+        int pixel_size = PixelUnpacker::getPixelSize(depth);
+
+        if(pixel_size == 1)
+            *reinterpret_cast<uint8_t *>(buffer) = static_cast<uint8_t>(stamp);
+        else
+        if(pixel_size == 2)
+        {
+            uint16_t value = static_cast<uint16_t>(stamp);
+            memcpy(buffer, &value, sizeof(value));
+        }
+        else
+            memcpy(buffer, &stamp, sizeof(stamp));
+    }
+
+    m_nb_filled_images++;
+    return true;
+}
+
+//-----------------------------------------------------
+// the round trip is slept, like the wait of the TCP reply
+//-----------------------------------------------------
+void DetectorSimulator::transaction(bool write)
+{
+    if(write)
+        m_nb_writes.fetch_add(1, std::memory_order_relaxed);
+    else
+        m_nb_reads.fetch_add(1, std::memory_order_relaxed);
+
+    double time_ms = m_transaction_time.load(std::memory_order_relaxed);
+
+    if(time_ms > 0.0)
+        usleep(static_cast<useconds_t>(ceil(time_ms * 1e3)));
+}
@@ -0,0 +1,340 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UFXC_ACCUMULATOR_X86
+#endif
+#include "lima/Exceptions.h"
+#include "UfxcFrameAccumulator.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+//-----------------------------------------------------
+// reference kernel, first: the accumulated frame is initialized
+//-----------------------------------------------------
+template<typename T>
+static void accumulateScalar(T * acc, const uint8_t * frame, int first_pixel, int nb_pixels, bool first)
+{
+    if(first)
+    {
+        for(int k = first_pixel ; k < nb_pixels ; k++)
+            acc[k] = frame[k];
+    }
+    else
+    {
+        for(int k = first_pixel ; k < nb_pixels ; k++)
+            acc[k] += frame[k];
+    }
+}
+
+#ifdef UFXC_ACCUMULATOR_X86
+
+//-----------------------------------------------------
+// returns the number of accumulated pixels, the scalar kernel does the tail
+//-----------------------------------------------------
+__attribute__((target("sse4.1")))
+static int accumulateSse41(uint16_t * acc, const uint8_t * frame, int nb_pixels, bool first)
+{
+    int k = 0;
+
+    for( ; k + 8 <= nb_pixels ; k += 8)
+    {
+        __m128i x = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(frame + k)));
+        __m128i * p = reinterpret_cast<__m128i *>(acc + k);
+
+        if(!first)
+            x = _mm_add_epi16(x, _mm_loadu_si128(p));
+
+        _mm_storeu_si128(p, x);
+    }
+
+    return k;
+}
+
+__attribute__((target("sse4.1")))
+static int accumulateSse41(uint32_t * acc, const uint8_t * frame, int nb_pixels, bool first)
+{
+    int k = 0;
+
+    for( ; k + 4 <= nb_pixels ; k += 4)
+    {
+        __m128i x = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(*reinterpret_cast<const int *>(frame + k)));
+        __m128i * p = reinterpret_cast<__m128i *>(acc + k);
+
+        if(!first)
+            x = _mm_add_epi32(x, _mm_loadu_si128(p));
+
+        _mm_storeu_si128(p, x);
+    }
+
+    return k;
+}
+
+__attribute__((target("avx2")))
+static int accumulateAvx2(uint16_t * acc, const uint8_t * frame, int nb_pixels, bool first)
+{
+    int k = 0;
+
+    for( ; k + 16 <= nb_pixels ; k += 16)
+    {
+        __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + k)));
+        __m256i * p = reinterpret_cast<__m256i *>(acc + k);
+
+        if(!first)
+            x = _mm256_add_epi16(x, _mm256_loadu_si256(p));
+
+        _mm256_storeu_si256(p, x);
+    }
+
+    return k;
+}
+
+__attribute__((target("avx2")))
+static int accumulateAvx2(uint32_t * acc, const uint8_t * frame, int nb_pixels, bool first)
+{
+    int k = 0;
+
+    for( ; k + 8 <= nb_pixels ; k += 8)
+    {
+        __m256i x = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(frame + k)));
+        __m256i * p = reinterpret_cast<__m256i *>(acc + k);
+
+        if(!first)
+            x = _mm256_add_epi32(x, _mm256_loadu_si256(p));
+
+        _mm256_storeu_si256(p, x);
+    }
+
+    return k;
+}
+
+#endif // UFXC_ACCUMULATOR_X86
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+template<typename T>
+static void accumulate(PixelUnpacker::Kernel kernel, T * acc, const uint8_t * frame, int nb_pixels, bool first)
+{
+    int first_pixel = 0;
+
+#ifdef UFXC_ACCUMULATOR_X86
+    if(kernel == PixelUnpacker::Avx2)
+        first_pixel = accumulateAvx2(acc, frame, nb_pixels, first);
+    else
+    if(kernel == PixelUnpacker::Sse41)
+        first_pixel = accumulateSse41(acc, frame, nb_pixels, first);
+#endif
+
+    accumulateScalar(acc, frame, first_pixel, nb_pixels, first);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+FrameAccumulator::FrameAccumulator() :
+m_nb_frames(1),
+m_image_type(Bpp16),
+m_nb_pixels(0),
+m_kernel(PixelUnpacker::Scalar)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameAccumulator::setNbFrames(int nb_frames)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_frames);
+
+    if(nb_frames < 1)
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect number of accumulated frames: " << nb_frames;
+    }
+
+    m_nb_frames = nb_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FrameAccumulator::getNbFrames() const
+{
+    return m_nb_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameAccumulator::setImageType(ImageType image_type)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(image_type);
+
+    if((image_type != Bpp16) && (image_type != Bpp32))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Accumulated frames are only Bpp16 or Bpp32!";
+    }
+
+    m_image_type = image_type;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ImageType FrameAccumulator::getImageType() const
+{
+    return m_image_type;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FrameAccumulator::getMaxNbFrames(int depth) const
+{
+    long long max_value = (m_image_type == Bpp16) ? 0xffffLL : 0xffffffffLL;
+    long long max_count = (1LL << depth) - 1;
+
+    return static_cast<int>(std::min(max_value / max_count, 0x7fffffffLL));
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameAccumulator::prepare(int depth, int nb_pixels, PixelUnpacker::Kernel kernel)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR2(depth, nb_pixels);
+
+    if(depth > 8)
+    {
+        THROW_HW_ERROR(Error) << "Only the 2, 4 and 8 bits counters can be accumulated!";
+    }
+
+    if(m_nb_frames > getMaxNbFrames(depth))
+    {
+        THROW_HW_ERROR(Error) << "Too many accumulated frames for the image type: " << m_nb_frames
+                              << " (max " << getMaxNbFrames(depth) << ")";
+    }
+
+    m_nb_pixels = nb_pixels;
+    m_kernel    = kernel;
+    m_input_frame.resize(nb_pixels);
+}
+
+//-----------------------------------------------------
+// called before the first frame
+//-----------------------------------------------------
+void FrameAccumulator::start(int nb_slots)
+{
+    m_slots.resize(std::max(1, nb_slots));
+
+    for(std::size_t index = 0 ; index < m_slots.size() ; index++)
+    {
+        m_slots[index].acc_frame_nb = -1;
+        m_slots[index].nb_added     = 0;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void * FrameAccumulator::getInputBuffer()
+{
+    return &m_input_frame[0];
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FrameAccumulator::getInputFrameSize() const
+{
+    return static_cast<int>(m_input_frame.size());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool FrameAccumulator::isOpen(int acc_frame_nb) const
+{
+    return (m_slots[acc_frame_nb % m_slots.size()].acc_frame_nb == acc_frame_nb);
+}
+
+//-----------------------------------------------------
+// the slot of a complete frame is reused by a next accumulated frame
+//-----------------------------------------------------
+bool FrameAccumulator::add(int acc_frame_nb, void * acc_frame, const void * frame)
+{
+    Slot& slot  = m_slots[acc_frame_nb % m_slots.size()];
+    bool  first = (slot.acc_frame_nb != acc_frame_nb);
+
+    if(first)
+    {
+        slot.acc_frame_nb = acc_frame_nb;
+        slot.nb_added     = 0;
+    }
+
+    if(frame)
+    {
+        const uint8_t * input = static_cast<const uint8_t *>(frame);
+
+        if(m_image_type == Bpp16)
+            accumulate(m_kernel, static_cast<uint16_t *>(acc_frame), input, m_nb_pixels, first);
+        else
+            accumulate(m_kernel, static_cast<uint32_t *>(acc_frame), input, m_nb_pixels, first);
+    }
+    else
+    if(first)
+    {
+        // the lost frame counts for zero
+        memset(acc_frame, 0, static_cast<std::size_t>(m_nb_pixels) * ((m_image_type == Bpp16) ? 2 : 4));
+    }
+
+    if(++slot.nb_added < m_nb_frames)
+        return false;
+
+    slot.acc_frame_nb = -1;
+    return true;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FrameAccumulator::getNbOpenFrames() const
+{
+    int nb_open_frames = 0;
+
+    for(std::size_t index = 0 ; index < m_slots.size() ; index++)
+    {
+        if(m_slots[index].acc_frame_nb >= 0)
+            nb_open_frames++;
+    }
+
+    return nb_open_frames;
+}
@@ -0,0 +1,190 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include "lima/Exceptions.h"
+#include "UfxcFrameBinRoi.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+FrameBinRoi::FrameBinRoi() :
+m_bin_x(1),
+m_bin_y(1),
+m_roi_x(0),
+m_roi_y(0),
+m_roi_width(0),
+m_roi_height(0)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+// the last pixels which do not fill a bin are ignored
+//-----------------------------------------------------
+Size FrameBinRoi::getBinnedSize(const Size& source_size, const Bin& bin)
+{
+    return Size(source_size.getWidth () / std::max(1, bin.getX()),
+                source_size.getHeight() / std::max(1, bin.getY()));
+}
+
+//-----------------------------------------------------
+// called at prepareAcq
+//-----------------------------------------------------
+void FrameBinRoi::configure(const Size& source_size, const Bin& bin, const Roi& roi)
+{
+    DEB_MEMBER_FUNCT();
+
+    if((bin.getX() < 1) || (bin.getY() < 1))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect binning: " << bin;
+    }
+
+    Size binned_size = getBinnedSize(source_size, bin);
+    int  roi_x       = 0;
+    int  roi_y       = 0;
+    int  roi_width   = binned_size.getWidth ();
+    int  roi_height  = binned_size.getHeight();
+
+    if(!roi.isEmpty())
+    {
+        roi_x      = roi.getTopLeft().x;
+        roi_y      = roi.getTopLeft().y;
+        roi_width  = roi.getSize().getWidth ();
+        roi_height = roi.getSize().getHeight();
+    }
+
+    if((roi_x < 0) || (roi_y < 0) || (roi_width <= 0) || (roi_height <= 0) ||
+       (roi_x + roi_width  > binned_size.getWidth ()) ||
+       (roi_y + roi_height > binned_size.getHeight()))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Roi " << roi << " is not in the binned image (" << binned_size.getWidth()
+                                     << ", " << binned_size.getHeight() << ")!";
+    }
+
+    m_source_size = source_size;
+    m_bin_x       = bin.getX();
+    m_bin_y       = bin.getY();
+    m_roi_x       = roi_x;
+    m_roi_y       = roi_y;
+    m_roi_width   = roi_width;
+    m_roi_height  = roi_height;
+
+    DEB_TRACE() << "hardware binning (" << m_bin_x << ", " << m_bin_y << ") - roi (" << m_roi_x << ", " << m_roi_y
+                << ", " << m_roi_width << ", " << m_roi_height << ")";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool FrameBinRoi::isIdentity() const
+{
+    return (m_bin_x == 1) && (m_bin_y == 1) && (m_roi_x == 0) && (m_roi_y == 0) &&
+           (m_roi_width == m_source_size.getWidth()) && (m_roi_height == m_source_size.getHeight());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Size FrameBinRoi::getSourceSize() const
+{
+    return m_source_size;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Size FrameBinRoi::getOutputSize() const
+{
+    return Size(m_roi_width, m_roi_height);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FrameBinRoi::getSourceNbPixels() const
+{
+    return m_source_size.getWidth() * m_source_size.getHeight();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameBinRoi::apply(int pixel_size, const void * source, void * output) const
+{
+    switch(pixel_size)
+    {
+        case 1 : applyTyped<uint8_t , uint32_t>(static_cast<const uint8_t  *>(source), static_cast<uint8_t  *>(output)); break;
+        case 2 : applyTyped<uint16_t, uint32_t>(static_cast<const uint16_t *>(source), static_cast<uint16_t *>(output)); break;
+        default: applyTyped<uint32_t, uint64_t>(static_cast<const uint32_t *>(source), static_cast<uint32_t *>(output)); break;
+    }
+}
+
+//-----------------------------------------------------
+// the source rows of a binned row are read sequentially
+//-----------------------------------------------------
+template<typename T, typename Sum>
+void FrameBinRoi::applyTyped(const T * source, T * output) const
+{
+    int source_width = m_source_size.getWidth();
+
+    if((m_bin_x == 1) && (m_bin_y == 1))
+    {
+        for(int y = 0 ; y < m_roi_height ; y++)
+        {
+            memcpy(output + static_cast<std::size_t>(y) * m_roi_width,
+                   source + static_cast<std::size_t>(m_roi_y + y) * source_width + m_roi_x,
+                   m_roi_width * sizeof(T));
+        }
+        return;
+    }
+
+    const Sum max_value = std::numeric_limits<T>::max();
+
+    for(int y = 0 ; y < m_roi_height ; y++)
+    {
+        T * out_row = output + static_cast<std::size_t>(y) * m_roi_width;
+
+        for(int x = 0 ; x < m_roi_width ; x++)
+        {
+            const T * first = source + static_cast<std::size_t>(m_roi_y + y) * m_bin_y * source_width +
+                              static_cast<std::size_t>(m_roi_x + x) * m_bin_x;
+            Sum       sum   = 0;
+
+            for(int sy = 0 ; sy < m_bin_y ; sy++)
+            {
+                const T * row = first + static_cast<std::size_t>(sy) * source_width;
+
+                for(int sx = 0 ; sx < m_bin_x ; sx++)
+                    sum += row[sx];
+            }
+
+            out_row[x] = static_cast<T>(std::min(sum, max_value));
+        }
+    }
+}
@@ -0,0 +1,377 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <algorithm>
+#ifdef UFXC_LZ4
+#include <lz4.h>
+#endif
+#include "lima/Exceptions.h"
+#include "UfxcFrameCompressor.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// bytes of a bitshuffle block (default of the bitshuffle library)
+static const int COMPRESSOR_BLOCK_BYTES = 8192;
+// the bitshuffle blocks are multiples of 8 elements
+static const int COMPRESSOR_BLOCK_MULT  = 8;
+// bitshuffle chunk header: uncompressed size (64 bits) and block size (32 bits)
+static const int COMPRESSOR_CHUNK_HEADER= 12;
+
+#ifdef UFXC_LZ4
+
+//-----------------------------------------------------
+// transposes a 8x8 bits matrix: byte j bit i <-> byte i bit j
+//-----------------------------------------------------
+static inline uint64_t transposeBits(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >> 7 )) & 0x00AA00AA00AA00AAULL; x = x ^ t ^ (t << 7 );
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x = x ^ t ^ (t << 28);
+    return x;
+}
+
+//-----------------------------------------------------
+// bit i of the byte b of the n elements, in the row b * 8 + i of n / 8 bytes
+//-----------------------------------------------------
+static void bitshuffle(const uint8_t * in, uint8_t * out, int nb_elements, int elem_size)
+{
+    int row_size = nb_elements / COMPRESSOR_BLOCK_MULT;
+
+    for(int b = 0 ; b < elem_size ; b++)
+    {
+        for(int m = 0 ; m < row_size ; m++)
+        {
+            const uint8_t * group = in + static_cast<std::size_t>(m) * 8 * elem_size + b;
+            uint64_t        x     = 0;
+
+            for(int j = 0 ; j < 8 ; j++)
+                x |= static_cast<uint64_t>(group[j * elem_size]) << (8 * j);
+
+            x = transposeBits(x);
+
+            for(int i = 0 ; i < 8 ; i++)
+                out[static_cast<std::size_t>(b * 8 + i) * row_size + m] = static_cast<uint8_t>(x >> (8 * i));
+        }
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void bitunshuffle(const uint8_t * in, uint8_t * out, int nb_elements, int elem_size)
+{
+    int row_size = nb_elements / COMPRESSOR_BLOCK_MULT;
+
+    for(int b = 0 ; b < elem_size ; b++)
+    {
+        for(int m = 0 ; m < row_size ; m++)
+        {
+            uint8_t * group = out + static_cast<std::size_t>(m) * 8 * elem_size + b;
+            uint64_t  x     = 0;
+
+            for(int i = 0 ; i < 8 ; i++)
+                x |= static_cast<uint64_t>(in[static_cast<std::size_t>(b * 8 + i) * row_size + m]) << (8 * i);
+
+            x = transposeBits(x);
+
+            for(int j = 0 ; j < 8 ; j++)
+                group[j * elem_size] = static_cast<uint8_t>(x >> (8 * j));
+        }
+    }
+}
+
+//-----------------------------------------------------
+// the bitshuffle chunk sizes are big-endian
+//-----------------------------------------------------
+static void writeBigEndian(uint8_t * out, uint64_t value, int nb_bytes)
+{
+    for(int k = 0 ; k < nb_bytes ; k++)
+        out[k] = static_cast<uint8_t>(value >> (8 * (nb_bytes - 1 - k)));
+}
+
+static uint64_t readBigEndian(const uint8_t * in, int nb_bytes)
+{
+    uint64_t value = 0;
+
+    for(int k = 0 ; k < nb_bytes ; k++)
+        value = (value << 8) | in[k];
+
+    return value;
+}
+
+#endif // UFXC_LZ4
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+FrameCompressor::FrameCompressor() :
+m_codec(NoCompression)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameCompressor::setCodec(Codec codec)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(codec);
+
+    if(!isCodecSupported(codec))
+    {
+        THROW_HW_ERROR(NotSupported) << "Compression codec " << getCodecName(codec) << " is not available in this build!";
+    }
+
+    m_codec = codec;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+FrameCompressor::Codec FrameCompressor::getCodec() const
+{
+    return m_codec;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool FrameCompressor::isCodecSupported(Codec codec)
+{
+#ifdef UFXC_LZ4
+    return (codec == NoCompression) || (codec == BitshuffleLz4);
+#else
+    return (codec == NoCompression);
+#endif
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+const char * FrameCompressor::getCodecName(Codec codec)
+{
+    switch(codec)
+    {
+        case NoCompression: return "NoCompression";
+        case BitshuffleLz4: return "BitshuffleLz4";
+        default           : return "Unknown";
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FrameCompressor::getBlockSize(int elem_size)
+{
+    int block_size = COMPRESSOR_BLOCK_BYTES / elem_size;
+    return std::max(COMPRESSOR_BLOCK_MULT, block_size - (block_size % COMPRESSOR_BLOCK_MULT));
+}
+
+//-----------------------------------------------------
+// called by the fill workers with the frame at the start of the Lima buffer
+//-----------------------------------------------------
+bool FrameCompressor::compress(int elem_size, void * record, int frame_size, int record_size,
+                               std::vector<char>& shuffled, std::vector<char>& compressed) const
+{
+    RecordHeader * header       = static_cast<RecordHeader *>(record);
+    uint8_t *      frame        = static_cast<uint8_t *>(record);
+    int            header_size  = static_cast<int>(sizeof(RecordHeader));
+    int            payload_size = -1;
+
+#ifdef UFXC_LZ4
+    if(m_codec == BitshuffleLz4)
+    {
+        int nb_elements = frame_size / elem_size;
+        int block_size  = getBlockSize(elem_size);
+        int max_blocks  = (nb_elements + block_size - 1) / block_size;
+        int max_size    = header_size + COMPRESSOR_CHUNK_HEADER + frame_size +
+                          max_blocks * (4 + LZ4_compressBound(block_size * elem_size) - block_size * elem_size);
+
+        shuffled.resize(static_cast<std::size_t>(block_size) * elem_size);
+        compressed.resize(max_size);
+
+        uint8_t * out = reinterpret_cast<uint8_t *>(&compressed[header_size]);
+        int       pos = COMPRESSOR_CHUNK_HEADER;
+
+        writeBigEndian(out    , static_cast<uint64_t>(frame_size)             , 8);
+        writeBigEndian(out + 8, static_cast<uint64_t>(block_size * elem_size) , 4);
+
+        int first = 0;
+
+        // full blocks, then the last block rounded to 8 elements
+        while(nb_elements - first >= COMPRESSOR_BLOCK_MULT)
+        {
+            int nb_block_elements = std::min(block_size, nb_elements - first);
+            nb_block_elements -= nb_block_elements % COMPRESSOR_BLOCK_MULT;
+
+            int block_bytes = nb_block_elements * elem_size;
+
+            bitshuffle(frame + static_cast<std::size_t>(first) * elem_size, reinterpret_cast<uint8_t *>(&shuffled[0]),
+                       nb_block_elements, elem_size);
+
+            int size = LZ4_compress_default(&shuffled[0], reinterpret_cast<char *>(out + pos + 4), block_bytes,
+                                            max_size - header_size - pos - 4);
+            if(size <= 0)
+            {
+                pos = -1;
+                break;
+            }
+
+            writeBigEndian(out + pos, static_cast<uint64_t>(size), 4);
+            pos   += 4 + size;
+            first += nb_block_elements;
+        }
+
+        // the last elements are not shuffled
+        if(pos >= 0)
+        {
+            int leftover = (nb_elements - first) * elem_size;
+            memcpy(out + pos, frame + static_cast<std::size_t>(first) * elem_size, leftover);
+            payload_size = pos + leftover;
+        }
+    }
+#endif
+
+    // compressed data over the frame
+    if((payload_size >= 0) && (payload_size < frame_size) && (header_size + payload_size <= record_size))
+    {
+        RecordHeader * compressed_header = reinterpret_cast<RecordHeader *>(&compressed[0]);
+        compressed_header->magic           = MAGIC;
+        compressed_header->codec           = m_codec;
+        compressed_header->frame_size      = static_cast<uint32_t>(frame_size);
+        compressed_header->compressed_size = static_cast<uint32_t>(payload_size);
+
+        memcpy(record, &compressed[0], header_size + payload_size);
+        return true;
+    }
+
+    // the header rows give room for the stored frame
+    memmove(frame + header_size, frame, frame_size);
+    header->magic           = MAGIC;
+    header->codec           = NoCompression;
+    header->frame_size      = static_cast<uint32_t>(frame_size);
+    header->compressed_size = static_cast<uint32_t>(frame_size);
+    return false;
+}
+
+//-----------------------------------------------------
+// for the consumers of the records
+//-----------------------------------------------------
+bool FrameCompressor::decompress(int elem_size, const void * record, void * frame, int frame_size)
+{
+    const RecordHeader * header  = static_cast<const RecordHeader *>(record);
+    const uint8_t *      payload = static_cast<const uint8_t *>(record) + sizeof(RecordHeader);
+
+    // blank frame
+    if(header->magic != MAGIC)
+    {
+        memset(frame, 0, frame_size);
+        return true;
+    }
+
+    if(header->frame_size != static_cast<uint32_t>(frame_size))
+        return false;
+
+    if(header->codec == NoCompression)
+    {
+        memcpy(frame, payload, frame_size);
+        return true;
+    }
+
+#ifdef UFXC_LZ4
+    if(header->codec == BitshuffleLz4)
+    {
+        int             nb_elements = frame_size / elem_size;
+        int             block_bytes = static_cast<int>(readBigEndian(payload + 8, 4));
+        int             block_size  = block_bytes / elem_size;
+        const uint8_t * in          = payload + COMPRESSOR_CHUNK_HEADER;
+        const uint8_t * in_end      = payload + header->compressed_size;
+        uint8_t *       out         = static_cast<uint8_t *>(frame);
+        std::vector<char> shuffled(block_bytes);
+        int             first       = 0;
+
+        if((static_cast<int>(readBigEndian(payload, 8)) != frame_size) || (block_size < COMPRESSOR_BLOCK_MULT))
+            return false;
+
+        while(nb_elements - first >= COMPRESSOR_BLOCK_MULT)
+        {
+            int nb_block_elements = std::min(block_size, nb_elements - first);
+            nb_block_elements -= nb_block_elements % COMPRESSOR_BLOCK_MULT;
+
+            if(in + 4 > in_end)
+                return false;
+
+            int size = static_cast<int>(readBigEndian(in, 4));
+
+            if((in + 4 + size > in_end) ||
+               (LZ4_decompress_safe(reinterpret_cast<const char *>(in + 4), &shuffled[0], size, block_bytes) != nb_block_elements * elem_size))
+                return false;
+
+            bitunshuffle(reinterpret_cast<const uint8_t *>(&shuffled[0]), out + static_cast<std::size_t>(first) * elem_size,
+                         nb_block_elements, elem_size);
+            in    += 4 + size;
+            first += nb_block_elements;
+        }
+
+        int leftover = (nb_elements - first) * elem_size;
+
+        if(in + leftover > in_end)
+            return false;
+
+        memcpy(out + static_cast<std::size_t>(first) * elem_size, in, leftover);
+        return true;
+    }
+#else
+    (void)elem_size;
+#endif
+
+    return false;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool FrameCompressor::getCompressedData(const void * record, const void *& data, int& size)
+{
+    const RecordHeader * header = static_cast<const RecordHeader *>(record);
+
+    if((header->magic != MAGIC) || (header->codec == NoCompression))
+        return false;
+
+    data = static_cast<const char *>(record) + sizeof(RecordHeader);
+    size = static_cast<int>(header->compressed_size);
+    return true;
+}
+
+//-----------------------------------------------------
+// the stored frame is the image shifted by the header
+//-----------------------------------------------------
+int FrameCompressor::getHeaderRows(int width, int pixel_size)
+{
+    int row_size = std::max(1, width * pixel_size);
+    return (static_cast<int>(sizeof(RecordHeader)) + row_size - 1) / row_size;
+}
@@ -0,0 +1,795 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <sched.h>
+#include <string.h>
+#include <algorithm>
+#include <sstream>
+#include "lima/Exceptions.h"
+#include "lima/Timestamp.h"
+#include "UfxcFramePipeline.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// max number of frames in the pipeline at the same time (also limited by the Lima buffers number)
+static const int    PIPELINE_MAX_IN_FLIGHT   = 1024;
+static const int    PIPELINE_MAX_FILL_WORKERS= 16  ;
+// statistics of the last frames kept for the clients (multiple of the frames in flight)
+static const int    PIPELINE_STATISTICS_SLOTS= 4096;
+// number of polls before going to sleep when a stage has nothing to do
+static const int    PIPELINE_SPIN_LOOPS      = 200 ;
+// security timeout of a sleeping stage (in s)
+static const double PIPELINE_SLEEP_TIMEOUT_S = 0.01;
+
+/*******************************************************************
+ * \class FramePipeline::StageThread
+ * \brief thread running a fill worker or the publisher
+ *******************************************************************/
+class FramePipeline::StageThread : public Thread
+{
+public:
+    enum Role { Worker, Publisher };
+
+    StageThread(FramePipeline& pipeline, Role role, int index) : m_pipeline(pipeline), m_role(role), m_index(index)
+    {
+        pthread_attr_setscope(&m_thread_attr, PTHREAD_SCOPE_PROCESS);
+    }
+
+    virtual ~StageThread()
+    {
+        join();
+    }
+
+protected:
+    virtual void threadFunction()
+    {
+        if(m_role == Worker)
+        {
+            std::ostringstream thread_name;
+            thread_name << "fill worker " << m_index;
+            m_pipeline.applyPlacement(thread_name.str());
+            m_pipeline.workerLoop();
+        }
+        else
+        {
+            m_pipeline.applyPlacement("publisher");
+            m_pipeline.publisherLoop();
+        }
+    }
+
+private:
+    FramePipeline& m_pipeline;
+    Role           m_role    ;
+    int            m_index   ;
+};
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+FramePipeline::FramePipeline(StdBufferCbMgr& buffer_mgr, StatusBlock& status_block, const ThreadPlacement& placement) :
+m_buffer_mgr(buffer_mgr),
+m_status_block(status_block),
+m_nb_workers(1),
+m_threads_changed(false),
+m_placement(placement),
+m_frame_mem_size(0),
+m_raw_frames(false),
+m_remap_enabled(false),
+m_packed_output(false),
+m_bin_roi_enabled(false),
+m_probe_split(false),
+m_sparse_output(false),
+m_compression(false),
+m_compression_elem_size(1),
+m_compression_frame_size(0),
+m_pixel_correction_enabled(false),
+m_pixel_correction_size(1),
+m_statistics(PIPELINE_STATISTICS_SLOTS),
+m_statistics_enabled(false),
+m_statistics_pixel_size(1),
+m_statistics_nb_pixels(0),
+m_statistics_saturation(0),
+m_statistics_probe_counters(false),
+m_depth(0),
+m_nb_pixels(0),
+m_staging_frame_size(0),
+m_fill_queue(PIPELINE_MAX_IN_FLIGHT),
+m_filled_frames(m_fill_queue.capacity()),
+m_mask(static_cast<int>(m_fill_queue.capacity()) - 1),
+m_max_in_flight(1),
+m_nb_pushed(0),
+m_nb_published(0),
+m_nb_sparse_frames(0),
+m_nb_dense_frames(0),
+m_nb_compressed_frames(0),
+m_compressed_bytes(0),
+m_compression_time_ns(0),
+m_nb_sleepers(0),
+m_quit(false)
+{
+    DEB_CONSTRUCTOR();
+
+    // no frame filled
+    for(std::size_t index = 0 ; index < m_filled_frames.size() ; index++)
+        m_filled_frames[index].store(-1, std::memory_order_relaxed);
+
+    startThreads();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+FramePipeline::~FramePipeline()
+{
+    DEB_DESTRUCTOR();
+    stopThreads();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FramePipeline::setNbFillWorkers(int nb_workers)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_workers);
+
+    if((nb_workers < 1) || (nb_workers > PIPELINE_MAX_FILL_WORKERS))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect number of fill workers: " << nb_workers
+                                     << " (1 to " << PIPELINE_MAX_FILL_WORKERS << ")";
+    }
+
+    if(nb_workers != m_nb_workers)
+    {
+        m_nb_workers      = nb_workers;
+        m_threads_changed = true;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FramePipeline::getNbFillWorkers() const
+{
+    return m_nb_workers;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FramePipeline::setThreadsPlacement(const ThreadPlacement& placement)
+{
+    DEB_MEMBER_FUNCT();
+    placement.check();
+
+    if(placement != m_placement)
+    {
+        m_placement       = placement;
+        m_threads_changed = true;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::string FramePipeline::getThreadsPlacement() const
+{
+    AutoMutex aLock(m_cond.mutex());
+    std::string placement;
+
+    for(std::size_t index = 0 ; index < m_threads_placement.size() ; index++)
+        placement += m_threads_placement[index] + "\n";
+
+    return placement;
+}
+
+//-----------------------------------------------------
+// the Lima buffers pointers are read once instead of at each frame,
+// the receiver gives them to fill_image_buffer like before
+//-----------------------------------------------------
+void FramePipeline::cacheFrameBuffers()
+{
+    DEB_MEMBER_FUNCT();
+
+    int nb_buffers;
+    m_buffer_mgr.getNbBuffers(nb_buffers);
+
+    m_frame_buffers.resize(nb_buffers);
+
+    for(int buffer_nb = 0 ; buffer_nb < nb_buffers ; buffer_nb++)
+        m_frame_buffers[buffer_nb] = m_buffer_mgr.getFrameBufferPtr(buffer_nb);
+
+    m_frame_mem_size = m_buffer_mgr.getFrameDim().getMemSize();
+
+    DEB_TRACE() << "Lima frame buffers: " << DEB_VAR2(nb_buffers, m_frame_mem_size);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void * FramePipeline::getFrameBuffer(int acq_frame_nb) const
+{
+    return m_frame_buffers[acq_frame_nb % m_frame_buffers.size()];
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FramePipeline::getNbFrameBuffers() const
+{
+    return static_cast<int>(m_frame_buffers.size());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FramePipeline::getFrameMemSize() const
+{
+    return m_frame_mem_size;
+}
+
+//-----------------------------------------------------
+// the staging buffers are allocated at the next start,
+// the remap table is copied (it can be rebuilt during the acquisition)
+//-----------------------------------------------------
+void FramePipeline::setStagingFrames(bool raw_frames, int depth, int nb_pixels, const PixelUnpacker& unpacker,
+                                     const GeometryRemap * remap, bool packed_output, const SparseEncoder * sparse,
+                                     const FrameBinRoi * bin_roi, bool probe_split)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR4(raw_frames, depth, nb_pixels, packed_output);
+
+    // pixels given to the binning
+    Size corrected_size     = remap ? remap->getCorrectedSize() : Size();
+    int  corrected_nb_pixels= remap ? corrected_size.getWidth() * corrected_size.getHeight() : nb_pixels;
+
+    if((!PixelUnpacker::isDepthSupported(depth)) || ((remap) && (remap->getSourceNbPixels() != nb_pixels)) ||
+       ((packed_output) && ((!PixelUnpacker::isPackingSupported(depth)) || (sparse))) ||
+       ((bin_roi) && ((packed_output) || (sparse) || (bin_roi->getSourceNbPixels() != corrected_nb_pixels))) ||
+       ((probe_split) && ((PixelUnpacker::getPixelSize(depth) != 4) || (packed_output) || (sparse) || (bin_roi))))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect staging frames: " << DEB_VAR2(depth, nb_pixels);
+    }
+
+    m_unpacker      = unpacker;
+    m_raw_frames    = raw_frames;
+    m_remap_enabled = (remap != NULL);
+    m_packed_output = packed_output;
+    m_sparse_output = (sparse != NULL);
+    m_bin_roi_enabled = (bin_roi != NULL);
+    m_probe_split   = probe_split;
+    m_depth         = depth;
+    m_nb_pixels     = nb_pixels;
+
+    if(m_remap_enabled)
+        m_remap = *remap;
+
+    if(m_sparse_output)
+        m_sparse_encoder = *sparse;
+
+    if(m_bin_roi_enabled)
+        m_bin_roi = *bin_roi;
+
+    // a raw frame is already packed
+    if((m_raw_frames) && (m_packed_output) && (!m_remap_enabled))
+        m_staging_frame_size = 0;
+    else
+    if(m_raw_frames)
+        m_staging_frame_size = PixelUnpacker::getPackedSize(depth, nb_pixels);
+    else
+    if((m_remap_enabled) || (m_packed_output) || (m_sparse_output) || (m_bin_roi_enabled) || (m_probe_split))
+        m_staging_frame_size = PixelUnpacker::getPixelSize(depth) * nb_pixels;
+    else
+        m_staging_frame_size = 0;
+
+    if(!m_staging_frame_size)
+        std::vector<char>().swap(m_staging_buffers);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FramePipeline::getStagingFrameSize() const
+{
+    return m_staging_frame_size;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool FramePipeline::isRawFrames() const
+{
+    return m_raw_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FramePipeline::setCompression(const FrameCompressor * compressor, int elem_size, int frame_size)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR2(elem_size, frame_size);
+
+    m_compression = (compressor != NULL) && (compressor->getCodec() != FrameCompressor::NoCompression);
+
+    if(!m_compression)
+        return;
+
+    // the frame is stored after the record header if it does not compress
+    if((elem_size <= 0) || (frame_size % elem_size) ||
+       (frame_size + static_cast<int>(sizeof(FrameCompressor::RecordHeader)) > m_frame_mem_size))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect compressed frames: " << DEB_VAR3(elem_size, frame_size, m_frame_mem_size);
+    }
+
+    m_compressor             = *compressor;
+    m_compression_elem_size  = elem_size;
+    m_compression_frame_size = frame_size;
+}
+
+//-----------------------------------------------------
+// the correction table is copied (it can be rebuilt during the acquisition)
+//-----------------------------------------------------
+void FramePipeline::setPixelCorrection(const PixelCorrection * correction, int pixel_size)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(pixel_size);
+
+    m_pixel_correction_enabled = (correction != NULL) && correction->isBuilt();
+
+    if(!m_pixel_correction_enabled)
+        return;
+
+    int nb_pixels = correction->getNbPixels();
+
+    if(((pixel_size != 1) && (pixel_size != 2) && (pixel_size != 4)) ||
+       (static_cast<long long>(nb_pixels) * pixel_size > m_frame_mem_size))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect corrected frames: " << DEB_VAR3(pixel_size, nb_pixels, m_frame_mem_size);
+    }
+
+    m_pixel_correction      = *correction;
+    m_pixel_correction_size = pixel_size;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FramePipeline::setFrameStatistics(bool enabled, int pixel_size, int nb_pixels, uint32_t saturation, bool probe_counters)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR4(enabled, pixel_size, nb_pixels, saturation);
+
+    m_statistics_enabled = enabled;
+
+    if(!m_statistics_enabled)
+        return;
+
+    if(((pixel_size != 1) && (pixel_size != 2) && (pixel_size != 4)) ||
+       (static_cast<long long>(nb_pixels) * pixel_size > m_frame_mem_size))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect frames statistics: " << DEB_VAR3(pixel_size, nb_pixels, m_frame_mem_size);
+    }
+
+    m_statistics_pixel_size     = pixel_size;
+    m_statistics_nb_pixels      = nb_pixels;
+    m_statistics_saturation     = saturation;
+    m_statistics_probe_counters = probe_counters;
+}
+
+//-----------------------------------------------------
+// the staging frame can not be reused before the frame is published
+//-----------------------------------------------------
+void * FramePipeline::getStagingBuffer(int acq_frame_nb)
+{
+    return &m_staging_buffers[static_cast<std::size_t>(acq_frame_nb % m_max_in_flight) * m_staging_frame_size];
+}
+
+//-----------------------------------------------------
+// called while no frame is in the pipeline
+//-----------------------------------------------------
+void FramePipeline::start()
+{
+    DEB_MEMBER_FUNCT();
+
+    // no prepareAcq since the last allocation
+    if(m_frame_buffers.empty())
+        cacheFrameBuffers();
+
+    int nb_buffers = static_cast<int>(m_frame_buffers.size());
+
+    if(m_threads_changed)
+    {
+        stopThreads ();
+        startThreads();
+        m_threads_changed = false;
+    }
+
+    // a frame can not be filled before its Lima buffer was published
+    m_max_in_flight = std::max(1, std::min(nb_buffers, PIPELINE_MAX_IN_FLIGHT));
+
+    // kept between the acquisitions with the same size
+    if(m_staging_frame_size)
+        m_staging_buffers.resize(static_cast<std::size_t>(m_max_in_flight) * m_staging_frame_size);
+
+    for(std::size_t index = 0 ; index < m_filled_frames.size() ; index++)
+        m_filled_frames[index].store(-1, std::memory_order_relaxed);
+
+    // no statistics of the previous acquisition
+    m_statistics.reset();
+
+    m_nb_sparse_frames.store(0, std::memory_order_relaxed);
+    m_nb_dense_frames.store (0, std::memory_order_relaxed);
+    m_nb_compressed_frames.store(0, std::memory_order_relaxed);
+    m_compressed_bytes.store    (0, std::memory_order_relaxed);
+    m_compression_time_ns.store (0, std::memory_order_relaxed);
+    m_nb_pushed.store   (0, std::memory_order_relaxed);
+    m_nb_published.store(0, std::memory_order_release);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FramePipeline::getMaxInFlight() const
+{
+    return m_max_in_flight;
+}
+
+//-----------------------------------------------------
+// back pressure on the receiver
+//-----------------------------------------------------
+void FramePipeline::waitFreeBuffer(int acq_frame_nb)
+{
+    waitFor([&]() { return (acq_frame_nb - m_nb_published.load(std::memory_order_acquire) < m_max_in_flight) || m_quit; });
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FramePipeline::push(const FrameJob& job)
+{
+    // cannot be full after waitFreeBuffer, the queue can contain all the frames in flight
+    while(!m_fill_queue.push(job))
+        sched_yield();
+
+    m_nb_pushed.fetch_add(1, std::memory_order_release);
+    wakeUp();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FramePipeline::finish()
+{
+    DEB_MEMBER_FUNCT();
+    waitFor([&]() { return (m_nb_published.load(std::memory_order_acquire) == m_nb_pushed.load(std::memory_order_acquire)) || m_quit; });
+    DEB_TRACE() << "published frames number (" << m_nb_published.load() << ")";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FramePipeline::getNbPublishedFrames() const
+{
+    return m_nb_published.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------
+// read without lock by the clients
+//-----------------------------------------------------
+bool FramePipeline::getFrameStatistics(int acq_frame_nb, FrameStats& stats) const
+{
+    return m_statistics.read(acq_frame_nb, stats);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FramePipeline::getNbFrameStatisticsSlots() const
+{
+    return m_statistics.getNbSlots();
+}
+
+//-----------------------------------------------------
+// read without lock by the pollers
+//-----------------------------------------------------
+void FramePipeline::getSparseStats(unsigned long& nb_sparse_frames, unsigned long& nb_dense_frames) const
+{
+    nb_sparse_frames = m_nb_sparse_frames.load(std::memory_order_relaxed);
+    nb_dense_frames  = m_nb_dense_frames.load (std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------
+// read without lock by the pollers
+//-----------------------------------------------------
+void FramePipeline::getCompressionStats(unsigned long& nb_frames, double& frame_bytes, double& compressed_bytes,
+                                        double& compression_time) const
+{
+    nb_frames        = m_nb_compressed_frames.load(std::memory_order_relaxed);
+    frame_bytes      = static_cast<double>(nb_frames) * m_compression_frame_size;
+    compressed_bytes = static_cast<double>(m_compressed_bytes.load(std::memory_order_relaxed));
+    compression_time = static_cast<double>(m_compression_time_ns.load(std::memory_order_relaxed)) * 1e-9;
+}
+
+//-----------------------------------------------------
+// fill worker: takes the frames from the receiver
+//-----------------------------------------------------
+void FramePipeline::workerLoop()
+{
+    DEB_MEMBER_FUNCT();
+    FrameJob          job;
+    std::vector<char> unpacked_frame ; // raw frame unpacked before the geometrical correction
+    std::vector<char> corrected_frame; // corrected frame before the packing or the sparse encoding
+    std::vector<char> shuffled_block  ; // block of the frame before the compression
+    std::vector<char> compressed_frame; // record copied over the frame
+
+    while(!m_quit)
+    {
+        if(!m_fill_queue.pop(job))
+        {
+            waitFor([&]() { return (!m_fill_queue.empty()) || m_quit; });
+            continue;
+        }
+
+        // the Lima buffer can contain an old frame
+        if(job.lost)
+            memset(job.frame_ptr, 0, m_frame_mem_size);
+        else
+        if(job.raw_ptr)
+            convertStagingFrame(job, unpacked_frame, corrected_frame);
+
+        // the frame is still in the cache of the worker
+        if((m_pixel_correction_enabled) && (!job.lost))
+            m_pixel_correction.apply(m_pixel_correction_size, job.frame_ptr);
+
+        // the sparse frames statistics are done before the encoding
+        if(m_statistics_enabled)
+        {
+            if(job.lost)
+            {
+                FrameStats stats = FrameStats();
+                stats.acq_frame_nb = job.acq_frame_nb;
+                stats.lost         = true;
+                m_statistics.write(stats);
+            }
+            else
+            if(!m_sparse_output)
+                computeStatistics(job.acq_frame_nb, m_statistics_pixel_size, job.frame_ptr, m_statistics_nb_pixels);
+        }
+
+        if(m_compression)
+        {
+            double start = Timestamp::now();
+
+            m_compressor.compress(m_compression_elem_size, job.frame_ptr, m_compression_frame_size, m_frame_mem_size,
+                                  shuffled_block, compressed_frame);
+
+            const FrameCompressor::RecordHeader * header = static_cast<const FrameCompressor::RecordHeader *>(job.frame_ptr);
+            m_compressed_bytes.fetch_add(header->compressed_size, std::memory_order_relaxed);
+            m_compression_time_ns.fetch_add(static_cast<unsigned long long>((double(Timestamp::now()) - start) * 1e9), std::memory_order_relaxed);
+            m_nb_compressed_frames.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // the frame is ready to be published
+        m_filled_frames[job.acq_frame_nb & m_mask].store(job.acq_frame_nb, std::memory_order_release);
+        wakeUp();
+    }
+}
+
+//-----------------------------------------------------
+// publisher: gives the filled frames to Lima in the acquisition order
+//-----------------------------------------------------
+void FramePipeline::publisherLoop()
+{
+    DEB_MEMBER_FUNCT();
+
+    while(!m_quit)
+    {
+        int acq_frame_nb = m_nb_published.load(std::memory_order_acquire);
+
+        if(m_filled_frames[acq_frame_nb & m_mask].load(std::memory_order_acquire) != acq_frame_nb)
+        {
+            waitFor([&]() { int next = m_nb_published.load(std::memory_order_acquire);
+                            return m_quit || (m_filled_frames[next & m_mask].load(std::memory_order_acquire) == next); });
+            continue;
+        }
+
+        // pushing the image buffer through Lima
+        HwFrameInfoType frame_info;
+        frame_info.acq_frame_nb = acq_frame_nb;
+        m_buffer_mgr.newFrameReady(frame_info);
+
+        m_nb_published.store(acq_frame_nb + 1, std::memory_order_release);
+        m_status_block.frameAcquired(acq_frame_nb + 1, Timestamp::now());
+        wakeUp();
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FramePipeline::startThreads()
+{
+    DEB_MEMBER_FUNCT();
+    m_quit = false;
+
+    {
+        AutoMutex aLock(m_cond.mutex());
+        m_threads_placement.clear();
+    }
+
+    for(int index = 0 ; index < m_nb_workers ; index++)
+        m_threads.push_back(new StageThread(*this, StageThread::Worker, index));
+
+    m_threads.push_back(new StageThread(*this, StageThread::Publisher, 0));
+
+    for(std::size_t index = 0 ; index < m_threads.size() ; index++)
+        m_threads[index]->start();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FramePipeline::stopThreads()
+{
+    DEB_MEMBER_FUNCT();
+    m_quit = true;
+    wakeUp();
+
+    for(std::size_t index = 0 ; index < m_threads.size() ; index++)
+        delete m_threads[index]; // joins the thread
+
+    m_threads.clear();
+}
+
+//-----------------------------------------------------
+// wakes up the sleeping stages after a state change
+//-----------------------------------------------------
+void FramePipeline::wakeUp()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(m_nb_sleepers.load(std::memory_order_seq_cst) > 0)
+    {
+        AutoMutex aLock(m_cond.mutex());
+        m_cond.broadcast();
+    }
+}
+
+//-----------------------------------------------------
+// called by each stage thread before its loop
+//-----------------------------------------------------
+void FramePipeline::applyPlacement(const std::string& thread_name)
+{
+    std::string placement = m_placement.applyToCurrentThread(thread_name);
+
+    AutoMutex aLock(m_cond.mutex());
+    m_threads_placement.push_back(placement);
+}
+
+//-----------------------------------------------------
+// staging frame -> Lima buffer
+//-----------------------------------------------------
+void FramePipeline::convertStagingFrame(const FrameJob& job, std::vector<char>& unpacked_frame, std::vector<char>& corrected_frame)
+{
+    const void * source     = job.raw_ptr;
+    int          pixel_size = PixelUnpacker::getPixelSize(m_depth);
+
+    if(m_raw_frames)
+    {
+        void * target = job.frame_ptr;
+
+        if((m_remap_enabled) || (m_packed_output) || (m_sparse_output) || (m_bin_roi_enabled) || (m_probe_split))
+        {
+            unpacked_frame.resize(static_cast<std::size_t>(pixel_size) * m_nb_pixels);
+            target = &unpacked_frame[0];
+        }
+
+        m_unpacker.unpack(m_depth, job.raw_ptr, target, m_nb_pixels);
+        source = target;
+    }
+
+    int nb_pixels = m_nb_pixels;
+
+    if(m_remap_enabled)
+    {
+        void * target = job.frame_ptr;
+        Size   size   = m_remap.getCorrectedSize();
+
+        nb_pixels = size.getWidth() * size.getHeight();
+
+        if((m_packed_output) || (m_sparse_output) || (m_bin_roi_enabled) || (m_probe_split))
+        {
+            corrected_frame.resize(static_cast<std::size_t>(pixel_size) * nb_pixels);
+            target = &corrected_frame[0];
+        }
+
+        m_remap.apply(pixel_size, source, target);
+        source = target;
+    }
+
+    // only the pixels of the Lima frame
+    if(m_bin_roi_enabled)
+        m_bin_roi.apply(pixel_size, source, job.frame_ptr);
+
+    if(m_packed_output)
+        m_unpacker.pack(m_depth, source, job.frame_ptr, nb_pixels);
+
+    if(m_probe_split)
+        ProbeChannels::split(m_unpacker.getEffectiveKernel(), source, nb_pixels, job.frame_ptr);
+
+    if(m_sparse_output)
+    {
+        if(m_statistics_enabled)
+            computeStatistics(job.acq_frame_nb, pixel_size, source, nb_pixels);
+
+        if(m_sparse_encoder.encode(pixel_size, source, nb_pixels, job.frame_ptr, m_frame_mem_size))
+            m_nb_sparse_frames.fetch_add(1, std::memory_order_relaxed);
+        else
+            m_nb_dense_frames.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+//-----------------------------------------------------
+// the frame is still in the cache of the worker
+//-----------------------------------------------------
+void FramePipeline::computeStatistics(int acq_frame_nb, int pixel_size, const void * frame, int nb_pixels)
+{
+    FrameStats stats;
+    stats.acq_frame_nb = acq_frame_nb;
+
+    // counts of the two probes
+    if((m_statistics_probe_counters) && (pixel_size == 4))
+    {
+        pixel_size = 2;
+        nb_pixels *= 2;
+    }
+
+    FrameStatistics::compute(m_unpacker.getEffectiveKernel(), pixel_size, frame, nb_pixels, m_statistics_saturation, stats);
+    m_statistics.write(stats);
+}
+
+//-----------------------------------------------------
+// polls a little then sleeps until the predicate is true
+//-----------------------------------------------------
+template<typename Predicate>
+void FramePipeline::waitFor(Predicate ready)
+{
+    for(int spin = 0 ; spin < PIPELINE_SPIN_LOOPS ; spin++)
+    {
+        if(ready())
+            return;
+
+        sched_yield();
+    }
+
+    AutoMutex aLock(m_cond.mutex());
+    m_nb_sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+    while(!ready())
+        m_cond.wait(PIPELINE_SLEEP_TIMEOUT_S);
+
+    m_nb_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+//-----------------------------------------------------
@@ -0,0 +1,456 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UFXC_STATISTICS_X86
+#endif
+#include "lima/Exceptions.h"
+#include "UfxcFrameStatistics.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// pixels of a block: the vector counters of a block can not overflow
+static const int STATISTICS_BLOCK_SIZE = 256;
+
+//-----------------------------------------------------
+// sum, max and saturated pixels of a block, from the pixel first_pixel
+//-----------------------------------------------------
+template<typename T>
+static void accumulateScalar(const T * pixels, int first_pixel, int nb_pixels, uint32_t saturation,
+                             uint64_t& sum, uint32_t& max, uint32_t& nb_saturated)
+{
+    for(int k = first_pixel ; k < nb_pixels ; k++)
+    {
+        uint32_t value = pixels[k];
+
+        sum += value;
+        max  = std::max(max, value);
+
+        if(value >= saturation)
+            nb_saturated++;
+    }
+}
+
+#ifdef UFXC_STATISTICS_X86
+
+//-----------------------------------------------------
+// the accumulate kernels return the number of done pixels of the block
+//-----------------------------------------------------
+template<typename T, int N>
+static inline void reduceLanes(const T (&lanes)[N], uint64_t& sum)
+{
+    for(int lane = 0 ; lane < N ; lane++)
+        sum += lanes[lane];
+}
+
+template<typename T, int N>
+static inline void maxLanes(const T (&lanes)[N], uint32_t& max)
+{
+    for(int lane = 0 ; lane < N ; lane++)
+        max = std::max(max, static_cast<uint32_t>(lanes[lane]));
+}
+
+__attribute__((target("sse4.1")))
+static int accumulateSse41(const uint8_t * pixels, int nb_pixels, uint32_t saturation,
+                           uint64_t& sum, uint32_t& max, uint32_t& nb_saturated)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i level = _mm_set1_epi8(static_cast<char>(saturation));
+    __m128i       vsum  = zero;
+    __m128i       vmax  = zero;
+    __m128i       vsat  = zero;
+    int           k     = 0;
+
+    for( ; k + 16 <= nb_pixels ; k += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + k));
+
+        vsum = _mm_add_epi64(vsum, _mm_sad_epu8(x, zero));
+        vmax = _mm_max_epu8 (vmax, x);
+        vsat = _mm_sub_epi8 (vsat, _mm_cmpeq_epi8(_mm_max_epu8(x, level), x));
+    }
+
+    uint64_t sums[2];
+    uint64_t sats[2];
+    uint8_t  maxs[16];
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums), vsum);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sats), _mm_sad_epu8(vsat, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maxs), vmax);
+
+    uint64_t block_saturated = 0;
+    reduceLanes(sums, sum);
+    reduceLanes(sats, block_saturated);
+    maxLanes   (maxs, max);
+    nb_saturated += static_cast<uint32_t>(block_saturated);
+    return k;
+}
+
+__attribute__((target("sse4.1")))
+static int accumulateSse41(const uint16_t * pixels, int nb_pixels, uint32_t saturation,
+                           uint64_t& sum, uint32_t& max, uint32_t& nb_saturated)
+{
+    const __m128i level = _mm_set1_epi16(static_cast<short>(saturation));
+    __m128i       vsum  = _mm_setzero_si128();
+    __m128i       vmax  = _mm_setzero_si128();
+    __m128i       vsat  = _mm_setzero_si128();
+    int           k     = 0;
+
+    for( ; k + 8 <= nb_pixels ; k += 8)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + k));
+
+        vsum = _mm_add_epi32(vsum, _mm_add_epi32(_mm_cvtepu16_epi32(x), _mm_cvtepu16_epi32(_mm_srli_si128(x, 8))));
+        vmax = _mm_max_epu16(vmax, x);
+        vsat = _mm_sub_epi16(vsat, _mm_cmpeq_epi16(_mm_max_epu16(x, level), x));
+    }
+
+    uint32_t sums[4];
+    uint16_t sats[8];
+    uint16_t maxs[8];
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums), vsum);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sats), vsat);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maxs), vmax);
+
+    uint64_t block_saturated = 0;
+    reduceLanes(sums, sum);
+    reduceLanes(sats, block_saturated);
+    maxLanes   (maxs, max);
+    nb_saturated += static_cast<uint32_t>(block_saturated);
+    return k;
+}
+
+__attribute__((target("sse4.1")))
+static int accumulateSse41(const uint32_t * pixels, int nb_pixels, uint32_t saturation,
+                           uint64_t& sum, uint32_t& max, uint32_t& nb_saturated)
+{
+    const __m128i level = _mm_set1_epi32(static_cast<int>(saturation));
+    __m128i       vsum  = _mm_setzero_si128();
+    __m128i       vmax  = _mm_setzero_si128();
+    __m128i       vsat  = _mm_setzero_si128();
+    int           k     = 0;
+
+    for( ; k + 4 <= nb_pixels ; k += 4)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + k));
+
+        vsum = _mm_add_epi64(vsum, _mm_add_epi64(_mm_cvtepu32_epi64(x), _mm_cvtepu32_epi64(_mm_srli_si128(x, 8))));
+        vmax = _mm_max_epu32(vmax, x);
+        vsat = _mm_sub_epi32(vsat, _mm_cmpeq_epi32(_mm_max_epu32(x, level), x));
+    }
+
+    uint64_t sums[2];
+    uint32_t sats[4];
+    uint32_t maxs[4];
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums), vsum);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sats), vsat);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maxs), vmax);
+
+    uint64_t block_saturated = 0;
+    reduceLanes(sums, sum);
+    reduceLanes(sats, block_saturated);
+    maxLanes   (maxs, max);
+    nb_saturated += static_cast<uint32_t>(block_saturated);
+    return k;
+}
+
+__attribute__((target("avx2")))
+static int accumulateAvx2(const uint8_t * pixels, int nb_pixels, uint32_t saturation,
+                          uint64_t& sum, uint32_t& max, uint32_t& nb_saturated)
+{
+    const __m256i zero  = _mm256_setzero_si256();
+    const __m256i level = _mm256_set1_epi8(static_cast<char>(saturation));
+    __m256i       vsum  = zero;
+    __m256i       vmax  = zero;
+    __m256i       vsat  = zero;
+    int           k     = 0;
+
+    for( ; k + 32 <= nb_pixels ; k += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + k));
+
+        vsum = _mm256_add_epi64(vsum, _mm256_sad_epu8(x, zero));
+        vmax = _mm256_max_epu8 (vmax, x);
+        vsat = _mm256_sub_epi8 (vsat, _mm256_cmpeq_epi8(_mm256_max_epu8(x, level), x));
+    }
+
+    uint64_t sums[4];
+    uint64_t sats[4];
+    uint8_t  maxs[32];
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums), vsum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sats), _mm256_sad_epu8(vsat, zero));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(maxs), vmax);
+
+    uint64_t block_saturated = 0;
+    reduceLanes(sums, sum);
+    reduceLanes(sats, block_saturated);
+    maxLanes   (maxs, max);
+    nb_saturated += static_cast<uint32_t>(block_saturated);
+    return k;
+}
+
+__attribute__((target("avx2")))
+static int accumulateAvx2(const uint16_t * pixels, int nb_pixels, uint32_t saturation,
+                          uint64_t& sum, uint32_t& max, uint32_t& nb_saturated)
+{
+    const __m256i level = _mm256_set1_epi16(static_cast<short>(saturation));
+    __m256i       vsum  = _mm256_setzero_si256();
+    __m256i       vmax  = _mm256_setzero_si256();
+    __m256i       vsat  = _mm256_setzero_si256();
+    int           k     = 0;
+
+    for( ; k + 16 <= nb_pixels ; k += 16)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + k));
+
+        vsum = _mm256_add_epi32(vsum, _mm256_add_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(x)),
+                                                       _mm256_cvtepu16_epi32(_mm256_extracti128_si256(x, 1))));
+        vmax = _mm256_max_epu16(vmax, x);
+        vsat = _mm256_sub_epi16(vsat, _mm256_cmpeq_epi16(_mm256_max_epu16(x, level), x));
+    }
+
+    uint32_t sums[8];
+    uint16_t sats[16];
+    uint16_t maxs[16];
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums), vsum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sats), vsat);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(maxs), vmax);
+
+    uint64_t block_saturated = 0;
+    reduceLanes(sums, sum);
+    reduceLanes(sats, block_saturated);
+    maxLanes   (maxs, max);
+    nb_saturated += static_cast<uint32_t>(block_saturated);
+    return k;
+}
+
+__attribute__((target("avx2")))
+static int accumulateAvx2(const uint32_t * pixels, int nb_pixels, uint32_t saturation,
+                          uint64_t& sum, uint32_t& max, uint32_t& nb_saturated)
+{
+    const __m256i level = _mm256_set1_epi32(static_cast<int>(saturation));
+    __m256i       vsum  = _mm256_setzero_si256();
+    __m256i       vmax  = _mm256_setzero_si256();
+    __m256i       vsat  = _mm256_setzero_si256();
+    int           k     = 0;
+
+    for( ; k + 8 <= nb_pixels ; k += 8)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + k));
+
+        vsum = _mm256_add_epi64(vsum, _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(x)),
+                                                       _mm256_cvtepu32_epi64(_mm256_extracti128_si256(x, 1))));
+        vmax = _mm256_max_epu32(vmax, x);
+        vsat = _mm256_sub_epi32(vsat, _mm256_cmpeq_epi32(_mm256_max_epu32(x, level), x));
+    }
+
+    uint64_t sums[4];
+    uint32_t sats[8];
+    uint32_t maxs[8];
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums), vsum);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sats), vsat);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(maxs), vmax);
+
+    uint64_t block_saturated = 0;
+    reduceLanes(sums, sum);
+    reduceLanes(sats, block_saturated);
+    maxLanes   (maxs, max);
+    nb_saturated += static_cast<uint32_t>(block_saturated);
+    return k;
+}
+
+#endif // UFXC_STATISTICS_X86
+
+//-----------------------------------------------------
+// block by block: the histogram reads the block from the L1 cache
+//-----------------------------------------------------
+template<typename T>
+static void computeTyped(PixelUnpacker::Kernel kernel, const T * pixels, int nb_pixels, uint32_t saturation,
+                         FrameStats& stats)
+{
+    int      shift    = 0;
+    uint32_t last_bin = FrameStats::NB_BINS - 1;
+
+    while((stats.bin_width >> shift) > 1)
+        shift++;
+
+    for(int block = 0 ; block < nb_pixels ; block += STATISTICS_BLOCK_SIZE)
+    {
+        const T * block_pixels = pixels + block;
+        int       block_size   = std::min(STATISTICS_BLOCK_SIZE, nb_pixels - block);
+        int       first_pixel  = 0;
+
+#ifdef UFXC_STATISTICS_X86
+        if(kernel == PixelUnpacker::Avx2)
+            first_pixel = accumulateAvx2(block_pixels, block_size, saturation, stats.sum, stats.max, stats.nb_saturated);
+        else
+        if(kernel == PixelUnpacker::Sse41)
+            first_pixel = accumulateSse41(block_pixels, block_size, saturation, stats.sum, stats.max, stats.nb_saturated);
+#endif
+
+        accumulateScalar(block_pixels, first_pixel, block_size, saturation, stats.sum, stats.max, stats.nb_saturated);
+
+        for(int k = 0 ; k < block_size ; k++)
+            stats.histogram[std::min(static_cast<uint32_t>(block_pixels[k]) >> shift, last_bin)]++;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+FrameStatistics::FrameStatistics(int nb_slots) :
+m_slots(nb_slots),
+m_mask(nb_slots - 1)
+{
+    DEB_CONSTRUCTOR();
+    reset();
+}
+
+//-----------------------------------------------------
+// the bins cover the values up to the saturation level
+//-----------------------------------------------------
+uint32_t FrameStatistics::getBinWidth(uint32_t saturation)
+{
+    uint32_t bin_width = 1;
+
+    while((bin_width < (1U << 31)) && (static_cast<uint64_t>(bin_width) * FrameStats::NB_BINS <= saturation))
+        bin_width <<= 1;
+
+    return bin_width;
+}
+
+//-----------------------------------------------------
+// called by the fill workers
+//-----------------------------------------------------
+void FrameStatistics::compute(PixelUnpacker::Kernel kernel, int pixel_size, const void * frame, int nb_pixels,
+                              uint32_t saturation, FrameStats& stats)
+{
+    uint32_t max_value = (pixel_size == 1) ? std::numeric_limits<uint8_t >::max() :
+                         (pixel_size == 2) ? std::numeric_limits<uint16_t>::max() :
+                                             std::numeric_limits<uint32_t>::max();
+
+    saturation = std::max(1U, std::min(saturation, max_value));
+
+    stats.lost         = false;
+    stats.nb_pixels    = nb_pixels;
+    stats.sum          = 0;
+    stats.max          = 0;
+    stats.nb_saturated = 0;
+    stats.bin_width    = getBinWidth(saturation);
+    memset(stats.histogram, 0, sizeof(stats.histogram));
+
+    switch(pixel_size)
+    {
+        case 1 : computeTyped(kernel, static_cast<const uint8_t  *>(frame), nb_pixels, saturation, stats); break;
+        case 2 : computeTyped(kernel, static_cast<const uint16_t *>(frame), nb_pixels, saturation, stats); break;
+        default: computeTyped(kernel, static_cast<const uint32_t *>(frame), nb_pixels, saturation, stats); break;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int FrameStatistics::getNbSlots() const
+{
+    return static_cast<int>(m_slots.size());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameStatistics::reset()
+{
+    for(std::size_t index = 0 ; index < m_slots.size() ; index++)
+    {
+        m_slots[index].sequence.store    (0 , std::memory_order_relaxed);
+        m_slots[index].acq_frame_nb.store(-1, std::memory_order_release);
+    }
+}
+
+//-----------------------------------------------------
+// only one writer per slot
+//-----------------------------------------------------
+void FrameStatistics::write(const FrameStats& stats)
+{
+    Slot& slot = m_slots[stats.acq_frame_nb & m_mask];
+
+    slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.acq_frame_nb.store(stats.acq_frame_nb, std::memory_order_relaxed);
+    slot.lost.store        (stats.lost        , std::memory_order_relaxed);
+    slot.nb_pixels.store   (stats.nb_pixels   , std::memory_order_relaxed);
+    slot.sum.store         (stats.sum         , std::memory_order_relaxed);
+    slot.max.store         (stats.max         , std::memory_order_relaxed);
+    slot.nb_saturated.store(stats.nb_saturated, std::memory_order_relaxed);
+    slot.bin_width.store   (stats.bin_width   , std::memory_order_relaxed);
+
+    for(int bin = 0 ; bin < FrameStats::NB_BINS ; bin++)
+        slot.histogram[bin].store(stats.histogram[bin], std::memory_order_relaxed);
+
+    slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+//-----------------------------------------------------
+// retries while a worker is changing the slot
+//-----------------------------------------------------
+bool FrameStatistics::read(int acq_frame_nb, FrameStats& stats) const
+{
+    if(acq_frame_nb < 0)
+        return false;
+
+    const Slot& slot = m_slots[acq_frame_nb & m_mask];
+    unsigned    begin_sequence;
+    unsigned    end_sequence;
+
+    do
+    {
+        begin_sequence = slot.sequence.load(std::memory_order_acquire);
+
+        stats.acq_frame_nb = slot.acq_frame_nb.load(std::memory_order_relaxed);
+        stats.lost         = slot.lost.load        (std::memory_order_relaxed);
+        stats.nb_pixels    = slot.nb_pixels.load   (std::memory_order_relaxed);
+        stats.sum          = slot.sum.load         (std::memory_order_relaxed);
+        stats.max          = slot.max.load         (std::memory_order_relaxed);
+        stats.nb_saturated = slot.nb_saturated.load(std::memory_order_relaxed);
+        stats.bin_width    = slot.bin_width.load   (std::memory_order_relaxed);
+
+        for(int bin = 0 ; bin < FrameStats::NB_BINS ; bin++)
+            stats.histogram[bin] = slot.histogram[bin].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        end_sequence = slot.sequence.load(std::memory_order_relaxed);
+    }
+    while((begin_sequence & 1) || (begin_sequence != end_sequence));
+
+    return (stats.acq_frame_nb == acq_frame_nb);
+}
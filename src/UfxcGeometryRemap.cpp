@@ -0,0 +1,310 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include "lima/Exceptions.h"
+#include "UfxcGeometryRemap.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// pixels of an UFXC chip side
+static const int    REMAP_CHIP_SIZE   = 128;
+// default gap between two chips in the corrected image (pixels)
+static const int    REMAP_DEFAULT_GAP = 2  ;
+// fixed point of the split weights
+static const int    REMAP_WEIGHT_BITS = 16 ;
+static const double REMAP_WEIGHT_ONE  = double(1 << REMAP_WEIGHT_BITS);
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ChipLayout::ChipLayout() :
+chip_width (REMAP_CHIP_SIZE  ),
+chip_height(REMAP_CHIP_SIZE  ),
+gap_x      (REMAP_DEFAULT_GAP),
+gap_y      (REMAP_DEFAULT_GAP)
+{
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ChipLayout::check() const
+{
+    DEB_MEMBER_FUNCT();
+
+    if((chip_width <= 0) || (chip_height <= 0) || (gap_x < 0) || (gap_y < 0))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect chip layout: " << DEB_VAR4(chip_width, chip_height, gap_x, gap_y);
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool ChipLayout::operator==(const ChipLayout& other) const
+{
+    return (chip_width  == other.chip_width ) && (chip_height == other.chip_height) &&
+           (gap_x       == other.gap_x      ) && (gap_y       == other.gap_y      );
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool ChipLayout::operator!=(const ChipLayout& other) const
+{
+    return !(*this == other);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+GeometryRemap::GeometryRemap()
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+// a partial chip is not corrected
+//-----------------------------------------------------
+Size GeometryRemap::getCorrectedSize(const ChipLayout& layout, const Size& source_size)
+{
+    int nb_chips_x = source_size.getWidth () / layout.chip_width ;
+    int nb_chips_y = source_size.getHeight() / layout.chip_height;
+
+    return Size(source_size.getWidth () + std::max(0, nb_chips_x - 1) * layout.gap_x,
+                source_size.getHeight() + std::max(0, nb_chips_y - 1) * layout.gap_y);
+}
+
+//-----------------------------------------------------
+// called when the image format changes, not for each acquisition
+//-----------------------------------------------------
+bool GeometryRemap::build(const std::string& model, const ChipLayout& layout, const Size& source_size)
+{
+    DEB_MEMBER_FUNCT();
+    layout.check();
+
+    if(isBuilt() && (model == m_model) && (layout == m_layout) &&
+       (source_size.getWidth () == m_source_size.getWidth ()) &&
+       (source_size.getHeight() == m_source_size.getHeight()))
+        return false;
+
+    if((source_size.getWidth () % layout.chip_width ) || (source_size.getHeight() % layout.chip_height))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Image size (" << source_size.getWidth() << ", " << source_size.getHeight()
+                                     << ") is not a multiple of the chip size (" << layout.chip_width << ", "
+                                     << layout.chip_height << ")!";
+    }
+
+    std::vector<std::vector<AxisPart> > x_parts;
+    std::vector<std::vector<AxisPart> > y_parts;
+
+    buildAxis(source_size.getWidth (), layout.chip_width , layout.gap_x, x_parts);
+    buildAxis(source_size.getHeight(), layout.chip_height, layout.gap_y, y_parts);
+
+    Size corrected_size = getCorrectedSize(layout, source_size);
+    int  source_width   = source_size.getWidth();
+    int  corrected_width= corrected_size.getWidth();
+
+    m_copy_runs.clear();
+    m_splits.clear();
+    m_split_targets.clear();
+
+    for(int sy = 0 ; sy < source_size.getHeight() ; sy++)
+    {
+        for(int sx = 0 ; sx < source_width ; sx++)
+        {
+            int source = sy * source_width + sx;
+
+            for(std::size_t iy = 0 ; iy < y_parts[sy].size() ; iy++)
+            {
+                for(std::size_t ix = 0 ; ix < x_parts[sx].size() ; ix++)
+                {
+                    const AxisPart& py = y_parts[sy][iy];
+                    const AxisPart& px = x_parts[sx][ix];
+                    int corrected = py.corrected * corrected_width + px.corrected;
+
+                    // inner pixel: extends the current run if contiguous
+                    if((py.fraction == 1.0) && (px.fraction == 1.0))
+                    {
+                        if((!m_copy_runs.empty()) &&
+                           (m_copy_runs.back().source    + m_copy_runs.back().length == source   ) &&
+                           (m_copy_runs.back().corrected + m_copy_runs.back().length == corrected))
+                        {
+                            m_copy_runs.back().length++;
+                        }
+                        else
+                        {
+                            CopyRun run = { source, corrected, 1 };
+                            m_copy_runs.push_back(run);
+                        }
+                    }
+                    else
+                    {
+                        Split split = { source, corrected, static_cast<uint32_t>(lround(py.fraction * px.fraction * REMAP_WEIGHT_ONE)) };
+                        m_splits.push_back(split);
+                    }
+                }
+            }
+        }
+    }
+
+    // a gap pixel can receive the contributions of several source pixels
+    for(std::size_t index = 0 ; index < m_splits.size() ; index++)
+        m_split_targets.push_back(m_splits[index].corrected);
+
+    std::sort(m_split_targets.begin(), m_split_targets.end());
+    m_split_targets.erase(std::unique(m_split_targets.begin(), m_split_targets.end()), m_split_targets.end());
+
+    m_model          = model;
+    m_layout         = layout;
+    m_source_size    = source_size;
+    m_corrected_size = corrected_size;
+
+    DEB_TRACE() << "geometrical correction table: (" << source_size.getWidth() << ", " << source_size.getHeight()
+                << ") -> (" << corrected_size.getWidth() << ", " << corrected_size.getHeight() << ") - copy runs: "
+                << m_copy_runs.size() << " - split contributions: " << m_splits.size();
+    return true;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool GeometryRemap::isBuilt() const
+{
+    return (m_corrected_size.getWidth() > 0) && (m_corrected_size.getHeight() > 0);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Size GeometryRemap::getSourceSize() const
+{
+    return m_source_size;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Size GeometryRemap::getCorrectedSize() const
+{
+    return m_corrected_size;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int GeometryRemap::getSourceNbPixels() const
+{
+    return m_source_size.getWidth() * m_source_size.getHeight();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void GeometryRemap::apply(int pixel_size, const void * source, void * corrected) const
+{
+    switch(pixel_size)
+    {
+        case 1 : applyTyped(static_cast<const uint8_t  *>(source), static_cast<uint8_t  *>(corrected)); break;
+        case 2 : applyTyped(static_cast<const uint16_t *>(source), static_cast<uint16_t *>(corrected)); break;
+        default: applyTyped(static_cast<const uint32_t *>(source), static_cast<uint32_t *>(corrected)); break;
+    }
+}
+
+//-----------------------------------------------------
+// the runs are rows segments, copied with memcpy
+//-----------------------------------------------------
+template<typename T>
+void GeometryRemap::applyTyped(const T * source, T * corrected) const
+{
+    const CopyRun * run      = m_copy_runs.empty() ? NULL : &m_copy_runs[0];
+    const CopyRun * run_end  = run + m_copy_runs.size();
+
+    for( ; run < run_end ; run++)
+        memcpy(corrected + run->corrected, source + run->source, run->length * sizeof(T));
+
+    for(std::size_t index = 0 ; index < m_split_targets.size() ; index++)
+        corrected[m_split_targets[index]] = 0;
+
+    const Split * split     = m_splits.empty() ? NULL : &m_splits[0];
+    const Split * split_end = split + m_splits.size();
+    const uint64_t max_value= std::numeric_limits<T>::max();
+
+    while(split < split_end)
+    {
+        int      pixel     = split->source;
+        uint64_t count     = source[pixel];
+        uint64_t remaining = count;
+
+        for( ; (split < split_end) && (split->source == pixel) ; split++)
+        {
+            bool     last  = (split + 1 == split_end) || (split[1].source != pixel);
+            uint64_t share = last ? remaining : std::min(remaining, (count * split->weight) >> REMAP_WEIGHT_BITS);
+            uint64_t sum   = static_cast<uint64_t>(corrected[split->corrected]) + share;
+
+            remaining -= share;
+            corrected[split->corrected] = static_cast<T>(std::min(sum, max_value));
+        }
+    }
+}
+
+//-----------------------------------------------------
+// the chip border pixels facing a gap are wider: they cover
+// half of the gap, the fractions give their share of each corrected pixel
+//-----------------------------------------------------
+void GeometryRemap::buildAxis(int size, int chip_size, int gap, std::vector<std::vector<AxisPart> >& parts)
+{
+    int nb_chips = size / chip_size;
+    parts.assign(size, std::vector<AxisPart>());
+
+    for(int source = 0 ; source < size ; source++)
+    {
+        int    chip  = source / chip_size;
+        int    index = source % chip_size;
+        double start = chip * (chip_size + gap) + index;
+        double end   = start + 1.0;
+
+        if((index == 0) && (chip > 0))
+            start -= gap / 2.0;
+
+        if((index == chip_size - 1) && (chip < nb_chips - 1))
+            end += gap / 2.0;
+
+        double width = end - start;
+
+        for(int corrected = static_cast<int>(floor(start)) ; corrected < end ; corrected++)
+        {
+            double overlap = std::min(end, corrected + 1.0) - std::max(start, double(corrected));
+
+            if(overlap <= 0.0)
+                continue;
+
+            AxisPart part = { corrected, (overlap == width) ? 1.0 : overlap / width };
+            parts[source].push_back(part);
+        }
+    }
+}
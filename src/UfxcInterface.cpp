@@ -31,7 +31,9 @@ using namespace lima::Ufxc;
 Interface::Interface(Camera& cam):
 m_cam(cam),
 m_det_info(cam),
-m_sync(cam)
+m_sync(cam),
+m_roi(cam),
+m_bin(cam)
 {
 	DEB_CONSTRUCTOR();
 	HwDetInfoCtrlObj *det_info = &m_det_info;
@@ -42,6 +44,13 @@ m_sync(cam)
 
 	HwBufferCtrlObj *buffer = cam.getBufferCtrlObj();
 	m_cap_list.push_back(HwCap(buffer));
+
+	//roi and binning done by the fill workers
+	HwRoiCtrlObj *roi = &m_roi;
+	m_cap_list.push_back(HwCap(roi));
+
+	HwBinCtrlObj *bin = &m_bin;
+	m_cap_list.push_back(HwCap(bin));
 	
 	//event capability
 	m_cap_list.push_back(HwCap(m_cam.getEventCtrlObj()));		
@@ -53,8 +62,6 @@ m_sync(cam)
 Interface::~Interface()
 {
 	DEB_DESTRUCTOR();
-	delete &m_det_info;
-	delete &m_sync;
 }
 
 //-----------------------------------------------------
@@ -123,13 +130,18 @@ void Interface::stopAcq()
 void Interface::getStatus(StatusType& status)
 {
 	DEB_MEMBER_FUNCT();
-	Camera::Status camera_status = Camera::Ready;
-	m_cam.getStatus(camera_status);
+	// status and acquisition thread state from the same snapshot,
+	// the detector status is refreshed by the status monitor of the camera
+	StatusSnapshot snapshot;
+	m_cam.getStatusSnapshot(snapshot);
+	Camera::Status camera_status = static_cast<Camera::Status>(snapshot.status);
+
+	DEB_TRACE() << "detector status age (s): " << ((snapshot.status_timestamp > 0.0) ? (double(Timestamp::now()) - snapshot.status_timestamp) : -1.0);
 
 	switch(camera_status)
 	{
 		case Camera::Ready:
-			if(!m_cam.is_thread_running())
+			if(!snapshot.thread_running)
 				status.set(HwInterface::StatusType::Ready);
 			else
 				status.set(HwInterface::StatusType::Exposure);
@@ -0,0 +1,396 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UFXC_CORRECTION_X86
+#endif
+#include "lima/Exceptions.h"
+#include "UfxcPixelCorrection.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// fixed point of the correction factors
+static const int      CORRECTION_FACTOR_BITS  = 14;
+static const uint32_t CORRECTION_FACTOR_ROUND = 1U << (CORRECTION_FACTOR_BITS - 1);
+static const double   CORRECTION_FACTOR_ONE   = double(1 << CORRECTION_FACTOR_BITS);
+
+//-----------------------------------------------------
+// reference kernel, from the pixel first_pixel, saturated to max_value
+//-----------------------------------------------------
+template<typename T>
+static void correctScalar(T * frame, const uint16_t * factors, int first_pixel, int nb_pixels, T max_value)
+{
+    for(int k = first_pixel ; k < nb_pixels ; k++)
+    {
+        uint64_t value = (static_cast<uint64_t>(frame[k]) * factors[k] + CORRECTION_FACTOR_ROUND) >> CORRECTION_FACTOR_BITS;
+        frame[k] = static_cast<T>(std::min(value, static_cast<uint64_t>(max_value)));
+    }
+}
+
+#ifdef UFXC_CORRECTION_X86
+
+//-----------------------------------------------------
+// products of 16 bits values fit in 32 bits, returns the number of corrected pixels
+//-----------------------------------------------------
+__attribute__((target("sse4.1")))
+static inline __m128i correctLanesSse41(__m128i pixels, __m128i factors)
+{
+    __m128i value = _mm_add_epi32(_mm_mullo_epi32(pixels, factors), _mm_set1_epi32(CORRECTION_FACTOR_ROUND));
+    return _mm_srli_epi32(value, CORRECTION_FACTOR_BITS);
+}
+
+__attribute__((target("sse4.1")))
+static int correctSse41(uint8_t * frame, const uint16_t * factors, int nb_pixels, uint8_t max_value)
+{
+    const __m128i max_pixels = _mm_set1_epi8(static_cast<char>(max_value));
+    int k = 0;
+
+    for( ; k + 8 <= nb_pixels ; k += 8)
+    {
+        __m128i x  = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(frame + k));
+        __m128i f  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(factors + k));
+        __m128i lo = correctLanesSse41(_mm_cvtepu8_epi32(x)                    , _mm_cvtepu16_epi32(f));
+        __m128i hi = correctLanesSse41(_mm_cvtepu8_epi32(_mm_srli_si128(x, 4)), _mm_cvtepu16_epi32(_mm_srli_si128(f, 8)));
+        __m128i p  = _mm_packus_epi32(lo, hi);
+
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(frame + k), _mm_min_epu8(_mm_packus_epi16(p, p), max_pixels));
+    }
+
+    return k;
+}
+
+__attribute__((target("sse4.1")))
+static int correctSse41(uint16_t * frame, const uint16_t * factors, int nb_pixels, uint16_t max_value)
+{
+    const __m128i max_pixels = _mm_set1_epi16(static_cast<short>(max_value));
+    int k = 0;
+
+    for( ; k + 8 <= nb_pixels ; k += 8)
+    {
+        __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + k));
+        __m128i f  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(factors + k));
+        __m128i lo = correctLanesSse41(_mm_cvtepu16_epi32(x)                    , _mm_cvtepu16_epi32(f));
+        __m128i hi = correctLanesSse41(_mm_cvtepu16_epi32(_mm_srli_si128(x, 8)), _mm_cvtepu16_epi32(_mm_srli_si128(f, 8)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(frame + k), _mm_min_epu16(_mm_packus_epi32(lo, hi), max_pixels));
+    }
+
+    return k;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i correctLanesAvx2(__m256i pixels, __m256i factors)
+{
+    __m256i value = _mm256_add_epi32(_mm256_mullo_epi32(pixels, factors), _mm256_set1_epi32(CORRECTION_FACTOR_ROUND));
+    return _mm256_srli_epi32(value, CORRECTION_FACTOR_BITS);
+}
+
+//-----------------------------------------------------
+// 16 corrected pixels saturated to 16 bits, in the pixels order
+//-----------------------------------------------------
+__attribute__((target("avx2")))
+static inline __m256i correct16Avx2(__m128i pixels_lo, __m128i pixels_hi, const uint16_t * factors)
+{
+    __m256i f  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(factors));
+    __m256i lo = correctLanesAvx2(_mm256_cvtepu16_epi32(pixels_lo), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(f)));
+    __m256i hi = correctLanesAvx2(_mm256_cvtepu16_epi32(pixels_hi), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(f, 1)));
+
+    // the pack works in each 128 bits lane
+    return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+}
+
+__attribute__((target("avx2")))
+static int correctAvx2(uint8_t * frame, const uint16_t * factors, int nb_pixels, uint8_t max_value)
+{
+    const __m128i max_pixels = _mm_set1_epi8(static_cast<char>(max_value));
+    int k = 0;
+
+    for( ; k + 16 <= nb_pixels ; k += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + k));
+        __m256i p = correct16Avx2(_mm_cvtepu8_epi16(x), _mm_cvtepu8_epi16(_mm_srli_si128(x, 8)), factors + k);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(frame + k),
+                         _mm_min_epu8(_mm_packus_epi16(_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1)), max_pixels));
+    }
+
+    return k;
+}
+
+__attribute__((target("avx2")))
+static int correctAvx2(uint16_t * frame, const uint16_t * factors, int nb_pixels, uint16_t max_value)
+{
+    const __m256i max_pixels = _mm256_set1_epi16(static_cast<short>(max_value));
+    int k = 0;
+
+    for( ; k + 16 <= nb_pixels ; k += 16)
+    {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + k));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + k + 8));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(frame + k), _mm256_min_epu16(correct16Avx2(lo, hi, factors + k), max_pixels));
+    }
+
+    return k;
+}
+
+#endif // UFXC_CORRECTION_X86
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+template<typename T>
+static void correct(PixelUnpacker::Kernel kernel, T * frame, const uint16_t * factors, int nb_pixels, uint32_t max_value)
+{
+    T   max_pixel   = static_cast<T>(std::min(max_value, static_cast<uint32_t>(std::numeric_limits<T>::max())));
+    int first_pixel = 0;
+
+#ifdef UFXC_CORRECTION_X86
+    if(kernel == PixelUnpacker::Avx2)
+        first_pixel = correctAvx2(frame, factors, nb_pixels, max_pixel);
+    else
+    if(kernel == PixelUnpacker::Sse41)
+        first_pixel = correctSse41(frame, factors, nb_pixels, max_pixel);
+#endif
+
+    correctScalar(frame, factors, first_pixel, nb_pixels, max_pixel);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PixelCorrection::PixelCorrection() :
+m_counting_mode(-1),
+m_kernel(PixelUnpacker::Scalar),
+m_max_value(std::numeric_limits<uint32_t>::max()),
+m_nb_masked_pixels(0)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::string PixelCorrection::getFileName(const std::string& directory, const std::string& model,
+                                         const Size& image_size, const std::string& extension)
+{
+    std::ostringstream name;
+    name << directory << "/" << model << "_" << image_size.getWidth() << "x" << image_size.getHeight() << "." << extension;
+    return name.str();
+}
+
+//-----------------------------------------------------
+// returns false if the file does not exist
+//-----------------------------------------------------
+bool PixelCorrection::readFile(const std::string& file_name, std::vector<char>& data)
+{
+    std::ifstream file(file_name.c_str(), std::ios::binary);
+
+    if(!file)
+        return false;
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+//-----------------------------------------------------
+// called at prepareAcq
+//-----------------------------------------------------
+bool PixelCorrection::build(const std::string& directory, const std::string& model, const Size& image_size,
+                            int counting_mode, const Roi& roi, PixelUnpacker::Kernel kernel)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(isBuilt() && (directory == m_directory) && (model == m_model) && (counting_mode == m_counting_mode) &&
+       (image_size.getWidth () == m_image_size.getWidth ()) && (image_size.getHeight() == m_image_size.getHeight()) &&
+       (roi == m_roi))
+    {
+        m_kernel = kernel;
+        return false;
+    }
+
+    int width     = image_size.getWidth ();
+    int height    = image_size.getHeight();
+    int nb_pixels = width * height;
+
+    std::string       mask_file_name = getFileName(directory, model, image_size, "mask");
+    std::string       flat_file_name = getFileName(directory, model, image_size, "flat");
+    std::vector<char> mask;
+    std::vector<char> flat;
+    bool              has_mask       = readFile(mask_file_name, mask);
+    bool              has_flat       = readFile(flat_file_name, flat);
+
+    if((!has_mask) && (!has_flat))
+    {
+        THROW_HW_ERROR(Error) << "No pixel correction file for this detector image: " << mask_file_name
+                              << " or " << flat_file_name;
+    }
+
+    if((has_mask) && (mask.size() != static_cast<std::size_t>(nb_pixels)))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect size of the mask file " << mask_file_name << ": " << mask.size()
+                              << " bytes for " << nb_pixels << " pixels";
+    }
+
+    if((has_flat) && (flat.size() != static_cast<std::size_t>(nb_pixels) * sizeof(float)))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect size of the flat-field file " << flat_file_name << ": " << flat.size()
+                              << " bytes for " << nb_pixels << " pixels";
+    }
+
+    int roi_x      = 0;
+    int roi_y      = 0;
+    int roi_width  = width;
+    int roi_height = height;
+
+    if(!roi.isEmpty())
+    {
+        roi_x      = roi.getTopLeft().x;
+        roi_y      = roi.getTopLeft().y;
+        roi_width  = roi.getSize().getWidth ();
+        roi_height = roi.getSize().getHeight();
+
+        if((roi_x < 0) || (roi_y < 0) || (roi_x + roi_width > width) || (roi_y + roi_height > height))
+        {
+            THROW_HW_ERROR(InvalidValue) << "Roi " << roi << " is not in the image (" << width << ", " << height << ")!";
+        }
+    }
+
+    const double max_factor = std::numeric_limits<uint16_t>::max() / CORRECTION_FACTOR_ONE;
+
+    m_factors.resize(static_cast<std::size_t>(roi_width) * roi_height);
+    m_nb_masked_pixels = 0;
+
+    for(int y = 0 ; y < roi_height ; y++)
+    {
+        for(int x = 0 ; x < roi_width ; x++)
+        {
+            std::size_t source = static_cast<std::size_t>(roi_y + y) * width + roi_x + x;
+            double      factor = 1.0;
+
+            if(has_flat)
+            {
+                float value;
+                memcpy(&value, &flat[source * sizeof(float)], sizeof(float));
+                factor = (isfinite(value) && (value > 0.0f)) ? std::min(static_cast<double>(value), max_factor) : 0.0;
+            }
+
+            if((has_mask) && (!mask[source]))
+                factor = 0.0;
+
+            uint16_t fixed_factor = static_cast<uint16_t>(lround(factor * CORRECTION_FACTOR_ONE));
+
+            if(!fixed_factor)
+                m_nb_masked_pixels++;
+
+            m_factors[static_cast<std::size_t>(y) * roi_width + x] = fixed_factor;
+        }
+    }
+
+    m_directory     = directory;
+    m_model         = model;
+    m_image_size    = image_size;
+    m_counting_mode = counting_mode;
+    m_roi           = roi;
+    m_kernel        = kernel;
+
+    DEB_TRACE() << "pixel correction table: mask (" << (has_mask ? mask_file_name : "none") << ") - flat-field ("
+                << (has_flat ? flat_file_name : "none") << ") - masked pixels: " << m_nb_masked_pixels;
+    return true;
+}
+
+//-----------------------------------------------------
+// called at prepareAcq, the counters saturate below the pixel storage
+//-----------------------------------------------------
+void PixelCorrection::setMaxValue(uint32_t max_value)
+{
+    m_max_value = max_value;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+uint32_t PixelCorrection::getMaxValue() const
+{
+    return m_max_value;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void PixelCorrection::clear()
+{
+    std::vector<uint16_t>().swap(m_factors);
+    m_nb_masked_pixels = 0;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool PixelCorrection::isBuilt() const
+{
+    return !m_factors.empty();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int PixelCorrection::getNbPixels() const
+{
+    return static_cast<int>(m_factors.size());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int PixelCorrection::getNbMaskedPixels() const
+{
+    return m_nb_masked_pixels;
+}
+
+//-----------------------------------------------------
+// called by the fill workers
+//-----------------------------------------------------
+void PixelCorrection::apply(int pixel_size, void * frame) const
+{
+    int nb_pixels = getNbPixels();
+
+    if(!nb_pixels)
+        return;
+
+    switch(pixel_size)
+    {
+        case 1 : correct(m_kernel, static_cast<uint8_t  *>(frame), &m_factors[0], nb_pixels, m_max_value); break;
+        case 2 : correct(m_kernel, static_cast<uint16_t *>(frame), &m_factors[0], nb_pixels, m_max_value); break;
+        // no vector kernel for the 32 bits counters
+        default: correctScalar(static_cast<uint32_t *>(frame), &m_factors[0], 0, nb_pixels, m_max_value); break;
+    }
+}
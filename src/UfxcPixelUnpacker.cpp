@@ -0,0 +1,600 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UFXC_UNPACKER_X86
+#endif
+#include "lima/Exceptions.h"
+#include "lima/Timestamp.h"
+#include "UfxcPixelUnpacker.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+//-----------------------------------------------------
+// counter of the pixel k, reads only the bytes of this counter
+//-----------------------------------------------------
+static inline uint32_t readCounter(const uint8_t * packed, int depth, int k)
+{
+    uint64_t bit      = static_cast<uint64_t>(k) * depth;
+    const uint8_t * p = packed + (bit >> 3);
+    int      shift    = static_cast<int>(bit & 7);
+    int      nb_bytes = (shift + depth + 7) >> 3;
+    uint64_t value    = 0;
+
+    for(int index = 0 ; index < nb_bytes ; index++)
+        value |= static_cast<uint64_t>(p[index]) << (index * 8);
+
+    return static_cast<uint32_t>((value >> shift) & ((1ULL << depth) - 1));
+}
+
+//-----------------------------------------------------
+// reference kernel, decodes the pixels [first, nb_pixels)
+//-----------------------------------------------------
+static void unpackScalar(int depth, const uint8_t * packed, void * pixels, int first, int nb_pixels)
+{
+    switch(depth)
+    {
+        case 2:
+        {
+            uint8_t * out = static_cast<uint8_t *>(pixels);
+            for(int k = first ; k < nb_pixels ; k++)
+                out[k] = (packed[k >> 2] >> ((k & 3) * 2)) & 0x03;
+            break;
+        }
+
+        case 4:
+        {
+            uint8_t * out = static_cast<uint8_t *>(pixels);
+            for(int k = first ; k < nb_pixels ; k++)
+                out[k] = (packed[k >> 1] >> ((k & 1) * 4)) & 0x0f;
+            break;
+        }
+
+        case 8:
+            memcpy(static_cast<uint8_t *>(pixels) + first, packed + first, nb_pixels - first);
+            break;
+
+        case 14:
+        {
+            // 4 counters in 7 bytes
+            uint16_t * out = static_cast<uint16_t *>(pixels);
+            int k = first;
+
+            for( ; (k & 3) && (k < nb_pixels) ; k++)
+                out[k] = static_cast<uint16_t>(readCounter(packed, 14, k));
+
+            for( ; k + 4 <= nb_pixels ; k += 4)
+            {
+                const uint8_t * p = packed + (k / 4) * 7;
+                uint64_t group = 0;
+                memcpy(&group, p, 7); // little-endian host
+                out[k    ] = static_cast<uint16_t>( group        & 0x3fff);
+                out[k + 1] = static_cast<uint16_t>((group >> 14) & 0x3fff);
+                out[k + 2] = static_cast<uint16_t>((group >> 28) & 0x3fff);
+                out[k + 3] = static_cast<uint16_t>((group >> 42) & 0x3fff);
+            }
+
+            for( ; k < nb_pixels ; k++)
+                out[k] = static_cast<uint16_t>(readCounter(packed, 14, k));
+            break;
+        }
+
+        case 28:
+        {
+            // 2 counters in 7 bytes
+            uint32_t * out = static_cast<uint32_t *>(pixels);
+            int k = first;
+
+            if((k & 1) && (k < nb_pixels))
+            {
+                out[k] = readCounter(packed, 28, k);
+                k++;
+            }
+
+            for( ; k + 2 <= nb_pixels ; k += 2)
+            {
+                const uint8_t * p = packed + (k / 2) * 7;
+                uint64_t group = 0;
+                memcpy(&group, p, 7);
+                out[k    ] = static_cast<uint32_t>( group        & 0x0fffffff);
+                out[k + 1] = static_cast<uint32_t>((group >> 28) & 0x0fffffff);
+            }
+
+            if(k < nb_pixels)
+                out[k] = readCounter(packed, 28, k);
+            break;
+        }
+
+        case 32:
+            memcpy(static_cast<uint32_t *>(pixels) + first, packed + first * 4, (nb_pixels - first) * 4);
+            break;
+    }
+}
+
+//-----------------------------------------------------
+// reference packing of the pixels [first, nb_pixels), first is a multiple of 4
+//-----------------------------------------------------
+static void packScalar(int depth, const uint8_t * pixels, uint8_t * packed, int first, int nb_pixels)
+{
+    int per_byte = 8 / depth;
+    int mask     = (1 << depth) - 1;
+
+    for(int k = first ; k < nb_pixels ; k += per_byte)
+    {
+        uint8_t value = 0;
+
+        for(int index = 0 ; (index < per_byte) && (k + index < nb_pixels) ; index++)
+            value |= (pixels[k + index] & mask) << (index * depth);
+
+        packed[k / per_byte] = value;
+    }
+}
+
+#ifdef UFXC_UNPACKER_X86
+
+//-----------------------------------------------------
+// returns the number of packed pixels, the scalar kernel does the tail
+//-----------------------------------------------------
+__attribute__((target("sse4.1")))
+static int packSse41(int depth, const uint8_t * pixels, uint8_t * packed, int nb_pixels)
+{
+    int k = 0;
+
+    if(depth == 4)
+    {
+        // 32 pixels -> 16 bytes: p0 + 16 * p1 in each 16 bits lane
+        const __m128i mask  = _mm_set1_epi8(0x0f);
+        const __m128i merge = _mm_set1_epi16(0x1001);
+
+        for( ; k + 32 <= nb_pixels ; k += 32)
+        {
+            __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + k     )), mask);
+            __m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + k + 16)), mask);
+            a = _mm_maddubs_epi16(a, merge);
+            b = _mm_maddubs_epi16(b, merge);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(packed + k / 2), _mm_packus_epi16(a, b));
+        }
+    }
+    else
+    if(depth == 2)
+    {
+        // 64 pixels -> 16 bytes: p0 + 4 * p1 in 16 bits, then q0 + 16 * q1 in 32 bits
+        const __m128i mask    = _mm_set1_epi8(0x03);
+        const __m128i merge_8 = _mm_set1_epi16(0x0401);
+        const __m128i merge_16= _mm_set1_epi32(0x00100001);
+        __m128i       words[4];
+
+        for( ; k + 64 <= nb_pixels ; k += 64)
+        {
+            for(int index = 0 ; index < 4 ; index++)
+            {
+                __m128i x = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + k + index * 16)), mask);
+                words[index] = _mm_madd_epi16(_mm_maddubs_epi16(x, merge_8), merge_16);
+            }
+
+            __m128i lo = _mm_packs_epi32(words[0], words[1]);
+            __m128i hi = _mm_packs_epi32(words[2], words[3]);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(packed + k / 4), _mm_packus_epi16(lo, hi));
+        }
+    }
+
+    return k;
+}
+
+//-----------------------------------------------------
+// returns the number of decoded pixels, the scalar kernel does the tail
+//-----------------------------------------------------
+__attribute__((target("sse4.1")))
+static int unpackSse41(int depth, const uint8_t * packed, int packed_size, void * pixels, int nb_pixels)
+{
+    int k = 0;
+
+    switch(depth)
+    {
+        case 2:
+        {
+            // 16 bytes -> 64 pixels
+            const __m128i mask = _mm_set1_epi8(0x03);
+            uint8_t * out = static_cast<uint8_t *>(pixels);
+
+            for( ; k + 64 <= nb_pixels ; k += 64)
+            {
+                __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + k / 4));
+                __m128i v0 = _mm_and_si128(x                    , mask);
+                __m128i v1 = _mm_and_si128(_mm_srli_epi16(x, 2), mask);
+                __m128i v2 = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+                __m128i v3 = _mm_and_si128(_mm_srli_epi16(x, 6), mask);
+                __m128i a  = _mm_unpacklo_epi8(v0, v1);
+                __m128i b  = _mm_unpackhi_epi8(v0, v1);
+                __m128i c  = _mm_unpacklo_epi8(v2, v3);
+                __m128i d  = _mm_unpackhi_epi8(v2, v3);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k     ), _mm_unpacklo_epi16(a, c));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k + 16), _mm_unpackhi_epi16(a, c));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k + 32), _mm_unpacklo_epi16(b, d));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k + 48), _mm_unpackhi_epi16(b, d));
+            }
+            break;
+        }
+
+        case 4:
+        {
+            // 16 bytes -> 32 pixels
+            const __m128i mask = _mm_set1_epi8(0x0f);
+            uint8_t * out = static_cast<uint8_t *>(pixels);
+
+            for( ; k + 32 <= nb_pixels ; k += 32)
+            {
+                __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + k / 2));
+                __m128i lo = _mm_and_si128(x                    , mask);
+                __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k     ), _mm_unpacklo_epi8(lo, hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k + 16), _mm_unpackhi_epi8(lo, hi));
+            }
+            break;
+        }
+
+        case 14:
+        {
+            // 14 bytes -> 8 pixels, 3 bytes per 32 bits lane then alignment on a shift of 6 bits
+            const __m128i shuffle_lo = _mm_setr_epi8(0, 1, 2, -1, 1, 2,  3, -1,  3,  4,  5, -1,  5,  6,  7, -1);
+            const __m128i shuffle_hi = _mm_setr_epi8(7, 8, 9, -1, 8, 9, 10, -1, 10, 11, 12, -1, 12, 13, 14, -1);
+            const __m128i align      = _mm_setr_epi32(64, 1, 4, 16);
+            const __m128i mask       = _mm_set1_epi32(0x3fff);
+            uint16_t * out = static_cast<uint16_t *>(pixels);
+
+            // the load reads 16 bytes
+            for( ; (k + 8 <= nb_pixels) && ((k / 8) * 14 + 16 <= packed_size) ; k += 8)
+            {
+                __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + (k / 8) * 14));
+                __m128i lo = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(_mm_shuffle_epi8(x, shuffle_lo), align), 6), mask);
+                __m128i hi = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(_mm_shuffle_epi8(x, shuffle_hi), align), 6), mask);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k), _mm_packus_epi32(lo, hi));
+            }
+            break;
+        }
+
+        case 28:
+        {
+            // 14 bytes -> 4 pixels, the bits of the next counter leave the lane with the alignment
+            const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 3, 3, 4, 5, 6, 7, 8, 9, 10, 10, 11, 12, 13);
+            const __m128i align   = _mm_setr_epi32(16, 1, 16, 1);
+            uint32_t * out = static_cast<uint32_t *>(pixels);
+
+            for( ; (k + 4 <= nb_pixels) && ((k / 4) * 14 + 16 <= packed_size) ; k += 4)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + (k / 4) * 14));
+                x = _mm_srli_epi32(_mm_mullo_epi32(_mm_shuffle_epi8(x, shuffle), align), 4);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k), x);
+            }
+            break;
+        }
+    }
+
+    return k;
+}
+
+//-----------------------------------------------------
+// returns the number of decoded pixels, the scalar kernel does the tail
+//-----------------------------------------------------
+__attribute__((target("avx2")))
+static int unpackAvx2(int depth, const uint8_t * packed, int packed_size, void * pixels, int nb_pixels)
+{
+    int k = 0;
+
+    switch(depth)
+    {
+        case 2:
+        {
+            // 32 bytes -> 128 pixels, the unpacks work in each 128 bits lane
+            const __m256i mask = _mm256_set1_epi8(0x03);
+            uint8_t * out = static_cast<uint8_t *>(pixels);
+
+            for( ; k + 128 <= nb_pixels ; k += 128)
+            {
+                __m256i x  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(packed + k / 4));
+                __m256i v0 = _mm256_and_si256(x                       , mask);
+                __m256i v1 = _mm256_and_si256(_mm256_srli_epi16(x, 2), mask);
+                __m256i v2 = _mm256_and_si256(_mm256_srli_epi16(x, 4), mask);
+                __m256i v3 = _mm256_and_si256(_mm256_srli_epi16(x, 6), mask);
+                __m256i a  = _mm256_unpacklo_epi8(v0, v1);
+                __m256i b  = _mm256_unpackhi_epi8(v0, v1);
+                __m256i c  = _mm256_unpacklo_epi8(v2, v3);
+                __m256i d  = _mm256_unpackhi_epi8(v2, v3);
+                __m256i e0 = _mm256_unpacklo_epi16(a, c); // bytes 0-3 , 16-19
+                __m256i e1 = _mm256_unpackhi_epi16(a, c); // bytes 4-7 , 20-23
+                __m256i e2 = _mm256_unpacklo_epi16(b, d); // bytes 8-11, 24-27
+                __m256i e3 = _mm256_unpackhi_epi16(b, d); // bytes 12-15, 28-31
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k     ), _mm256_permute2x128_si256(e0, e1, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k + 32), _mm256_permute2x128_si256(e2, e3, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k + 64), _mm256_permute2x128_si256(e0, e1, 0x31));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k + 96), _mm256_permute2x128_si256(e2, e3, 0x31));
+            }
+            break;
+        }
+
+        case 4:
+        {
+            // 32 bytes -> 64 pixels
+            const __m256i mask = _mm256_set1_epi8(0x0f);
+            uint8_t * out = static_cast<uint8_t *>(pixels);
+
+            for( ; k + 64 <= nb_pixels ; k += 64)
+            {
+                __m256i x  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(packed + k / 2));
+                __m256i lo = _mm256_and_si256(x                       , mask);
+                __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), mask);
+                __m256i a  = _mm256_unpacklo_epi8(lo, hi); // bytes 0-7 , 16-23
+                __m256i b  = _mm256_unpackhi_epi8(lo, hi); // bytes 8-15, 24-31
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k     ), _mm256_permute2x128_si256(a, b, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k + 32), _mm256_permute2x128_si256(a, b, 0x31));
+            }
+            break;
+        }
+
+        case 14:
+        {
+            // 28 bytes -> 16 pixels, 14 bytes in each 128 bits lane
+            const __m256i shuffle_lo = _mm256_setr_epi8(0, 1, 2, -1, 1, 2,  3, -1,  3,  4,  5, -1,  5,  6,  7, -1,
+                                                        0, 1, 2, -1, 1, 2,  3, -1,  3,  4,  5, -1,  5,  6,  7, -1);
+            const __m256i shuffle_hi = _mm256_setr_epi8(7, 8, 9, -1, 8, 9, 10, -1, 10, 11, 12, -1, 12, 13, 14, -1,
+                                                        7, 8, 9, -1, 8, 9, 10, -1, 10, 11, 12, -1, 12, 13, 14, -1);
+            const __m256i shift      = _mm256_setr_epi32(0, 6, 4, 2, 0, 6, 4, 2);
+            const __m256i mask       = _mm256_set1_epi32(0x3fff);
+            uint16_t * out = static_cast<uint16_t *>(pixels);
+
+            // the loads read 30 bytes
+            for( ; (k + 16 <= nb_pixels) && ((k / 16) * 28 + 30 <= packed_size) ; k += 16)
+            {
+                const uint8_t * p = packed + (k / 16) * 28;
+                __m256i x  = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))),
+                                                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 14)), 1);
+                __m256i lo = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(x, shuffle_lo), shift), mask);
+                __m256i hi = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(x, shuffle_hi), shift), mask);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k), _mm256_packus_epi32(lo, hi));
+            }
+            break;
+        }
+
+        case 28:
+        {
+            // 28 bytes -> 8 pixels
+            const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, 3, 3, 4, 5, 6, 7, 8, 9, 10, 10, 11, 12, 13,
+                                                     0, 1, 2, 3, 3, 4, 5, 6, 7, 8, 9, 10, 10, 11, 12, 13);
+            const __m256i shift   = _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4);
+            const __m256i mask    = _mm256_set1_epi32(0x0fffffff);
+            uint32_t * out = static_cast<uint32_t *>(pixels);
+
+            for( ; (k + 8 <= nb_pixels) && ((k / 8) * 28 + 30 <= packed_size) ; k += 8)
+            {
+                const uint8_t * p = packed + (k / 8) * 28;
+                __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))),
+                                                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 14)), 1);
+                x = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(x, shuffle), shift), mask);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k), x);
+            }
+            break;
+        }
+    }
+
+    return k;
+}
+
+#endif // UFXC_UNPACKER_X86
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PixelUnpacker::PixelUnpacker() :
+m_kernel(Auto),
+m_effective_kernel(selectKernel())
+{
+    DEB_CONSTRUCTOR();
+    DEB_TRACE() << "pixel unpacking kernel: " << getKernelName(m_effective_kernel);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void PixelUnpacker::setKernel(Kernel kernel)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(kernel);
+
+    if(!isKernelSupported(kernel))
+    {
+        THROW_HW_ERROR(NotSupported) << "Pixel unpacking kernel " << getKernelName(kernel) << " is not supported by the cpu!";
+    }
+
+    m_kernel           = kernel;
+    m_effective_kernel = (kernel == Auto) ? selectKernel() : kernel;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PixelUnpacker::Kernel PixelUnpacker::getKernel() const
+{
+    return m_kernel;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PixelUnpacker::Kernel PixelUnpacker::getEffectiveKernel() const
+{
+    return m_effective_kernel;
+}
+
+//-----------------------------------------------------
+// the buffers do not need any alignment
+//-----------------------------------------------------
+void PixelUnpacker::unpack(int depth, const void * packed, void * pixels, int nb_pixels) const
+{
+    const uint8_t * in          = static_cast<const uint8_t *>(packed);
+    int             packed_size = getPackedSize(depth, nb_pixels);
+    int             first       = 0;
+
+#ifdef UFXC_UNPACKER_X86
+    if(m_effective_kernel == Avx2)
+        first = unpackAvx2(depth, in, packed_size, pixels, nb_pixels);
+    else
+    if(m_effective_kernel == Sse41)
+        first = unpackSse41(depth, in, packed_size, pixels, nb_pixels);
+#endif
+
+    unpackScalar(depth, in, pixels, first, nb_pixels);
+}
+
+//-----------------------------------------------------
+// the buffers do not need any alignment
+//-----------------------------------------------------
+void PixelUnpacker::pack(int depth, const void * pixels, void * packed, int nb_pixels) const
+{
+    const uint8_t * in    = static_cast<const uint8_t *>(pixels);
+    uint8_t *       out   = static_cast<uint8_t *>(packed);
+    int             first = 0;
+
+#ifdef UFXC_UNPACKER_X86
+    if(m_effective_kernel != Scalar)
+        first = packSse41(depth, in, out, nb_pixels);
+#endif
+
+    packScalar(depth, in, out, first, nb_pixels);
+}
+
+//-----------------------------------------------------
+// the first frame warms up the caches and is not measured
+//-----------------------------------------------------
+double PixelUnpacker::benchmark(int depth, int nb_pixels, int nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+
+    if(!isDepthSupported(depth) || (nb_pixels <= 0) || (nb_frames <= 0))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect pixel unpacking benchmark: " << DEB_VAR3(depth, nb_pixels, nb_frames);
+    }
+
+    std::vector<uint8_t> packed(getPackedSize(depth, nb_pixels));
+    std::vector<uint8_t> pixels(static_cast<std::size_t>(getPixelSize(depth)) * nb_pixels);
+    uint32_t             seed = 0x2545f491;
+
+    for(std::size_t index = 0 ; index < packed.size() ; index++)
+    {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        packed[index] = static_cast<uint8_t>(seed);
+    }
+
+    unpack(depth, &packed[0], &pixels[0], nb_pixels);
+
+    double start = Timestamp::now();
+
+    for(int frame = 0 ; frame < nb_frames ; frame++)
+        unpack(depth, &packed[0], &pixels[0], nb_pixels);
+
+    return (double(Timestamp::now()) - start) / nb_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool PixelUnpacker::isKernelSupported(Kernel kernel)
+{
+    switch(kernel)
+    {
+        case Auto  :
+        case Scalar: return true;
+#ifdef UFXC_UNPACKER_X86
+        case Sse41 : return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3");
+        case Avx2  : return __builtin_cpu_supports("avx2");
+#endif
+        default    : return false;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+const char * PixelUnpacker::getKernelName(Kernel kernel)
+{
+    switch(kernel)
+    {
+        case Auto  : return "Auto"  ;
+        case Scalar: return "Scalar";
+        case Sse41 : return "Sse41" ;
+        case Avx2  : return "Avx2"  ;
+        default    : return "Unknown";
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool PixelUnpacker::isDepthSupported(int depth)
+{
+    return (depth == 2) || (depth == 4) || (depth == 8) || (depth == 14) || (depth == 28) || (depth == 32);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool PixelUnpacker::isPackingSupported(int depth)
+{
+    return (depth == 2) || (depth == 4);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int PixelUnpacker::getPackedSize(int depth, int nb_pixels)
+{
+    return static_cast<int>((static_cast<long long>(nb_pixels) * depth + 7) / 8);
+}
+
+//-----------------------------------------------------
+// Lima storage of the counters
+//-----------------------------------------------------
+int PixelUnpacker::getPixelSize(int depth)
+{
+    if(depth <= 8)
+        return 1;
+
+    return (depth <= 16) ? 2 : 4;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PixelUnpacker::Kernel PixelUnpacker::selectKernel()
+{
+    if(isKernelSupported(Avx2))
+        return Avx2;
+
+    if(isKernelSupported(Sse41))
+        return Sse41;
+
+    return Scalar;
+}
@@ -0,0 +1,379 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/syscall.h>
+#include <fstream>
+#include <sstream>
+#include "lima/Exceptions.h"
+#include "UfxcPlacement.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// cpu list keyword for the cpus of the SFP network interface node
+static const char * const PLACEMENT_NUMA_CPUS  = "numa";
+// mbind parameters (linux/mempolicy.h is not always installed)
+static const int          PLACEMENT_MPOL_BIND   = 2;
+static const unsigned     PLACEMENT_MPOL_MF_MOVE= (1 << 1);
+static const int          PLACEMENT_MAX_NODES   = 1024;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ThreadPlacement::ThreadPlacement() :
+m_policy(Other),
+m_priority(0),
+m_numa_node(-1)
+{
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ThreadPlacement::ThreadPlacement(const std::string& cpus, SchedPolicy policy, int priority) :
+m_cpus(cpus),
+m_policy(policy),
+m_priority(priority),
+m_numa_node(-1)
+{
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ThreadPlacement::check() const
+{
+    DEB_MEMBER_FUNCT();
+    std::vector<int> cpu_list;
+
+    if((m_cpus != PLACEMENT_NUMA_CPUS) && (!parseCpus(m_cpus, cpu_list)))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect cpu list: " << m_cpus << " (example: 2,4-7 or numa)";
+    }
+
+    if(m_policy == Other)
+    {
+        if(m_priority != 0)
+            THROW_HW_ERROR(InvalidValue) << "Incorrect priority: " << m_priority << " (only 0 for the default scheduling)";
+    }
+    else
+    if((m_policy == Fifo) || (m_policy == RoundRobin))
+    {
+        int sched_policy = (m_policy == Fifo) ? SCHED_FIFO : SCHED_RR;
+        int min_priority = sched_get_priority_min(sched_policy);
+        int max_priority = sched_get_priority_max(sched_policy);
+
+        if((m_priority < min_priority) || (m_priority > max_priority))
+        {
+            THROW_HW_ERROR(InvalidValue) << "Incorrect real-time priority: " << m_priority
+                                         << " (" << min_priority << " to " << max_priority << ")";
+        }
+    }
+    else
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect scheduling policy: " << static_cast<int>(m_policy);
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ThreadPlacement::setNumaNode(int numa_node)
+{
+    m_numa_node = numa_node;
+}
+
+//-----------------------------------------------------
+// failures are not fatal: the thread keeps running with the system placement
+//-----------------------------------------------------
+std::string ThreadPlacement::applyToCurrentThread(const std::string& thread_name) const
+{
+    DEB_MEMBER_FUNCT();
+
+    std::string cpus = m_cpus;
+
+    // the cpus of the network interface node, no pinning if the node is unknown
+    if(cpus == PLACEMENT_NUMA_CPUS)
+        cpus = (m_numa_node >= 0) ? NumaPlacement::getNodeCpus(m_numa_node) : "";
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    std::vector<int> cpu_list;
+
+    if(cpus.empty())
+    {
+        // back to the affinity of the process
+        sched_getaffinity(getpid(), sizeof(cpu_set), &cpu_set);
+    }
+    else
+    if(parseCpus(cpus, cpu_list))
+    {
+        for(std::size_t index = 0 ; index < cpu_list.size() ; index++)
+            CPU_SET(cpu_list[index], &cpu_set);
+    }
+
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+
+    if(error)
+        DEB_WARNING() << thread_name << ": cannot set the cpu affinity " << cpus << " (" << strerror(error) << ")";
+
+    struct sched_param param;
+    param.sched_priority = m_priority;
+
+    int sched_policy = (m_policy == Fifo) ? SCHED_FIFO : ((m_policy == RoundRobin) ? SCHED_RR : SCHED_OTHER);
+
+    error = pthread_setschedparam(pthread_self(), sched_policy, &param);
+
+    // real-time scheduling needs CAP_SYS_NICE or a rtprio limit
+    if(error)
+        DEB_WARNING() << thread_name << ": cannot set the scheduling " << DEB_VAR2(sched_policy, m_priority)
+                      << " (" << strerror(error) << ")";
+
+    std::string placement = thread_name + ": " + getCurrentThreadPlacement();
+    DEB_TRACE() << placement;
+    return placement;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool ThreadPlacement::operator==(const ThreadPlacement& other) const
+{
+    return (m_cpus      == other.m_cpus     ) &&
+           (m_policy    == other.m_policy   ) &&
+           (m_priority  == other.m_priority ) &&
+           (m_numa_node == other.m_numa_node);
+}
+
+//-----------------------------------------------------
+// effective cpus and scheduling of the calling thread
+//-----------------------------------------------------
+std::string ThreadPlacement::getCurrentThreadPlacement()
+{
+    std::ostringstream placement;
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    placement << "cpus ";
+
+    if(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0)
+    {
+        // compact form of the cpu list (0-3,8)
+        int  first = -1;
+        bool comma = false;
+
+        for(int cpu = 0 ; cpu <= CPU_SETSIZE ; cpu++)
+        {
+            bool is_set = (cpu < CPU_SETSIZE) && CPU_ISSET(cpu, &cpu_set);
+
+            if(is_set && (first < 0))
+                first = cpu;
+            else
+            if((!is_set) && (first >= 0))
+            {
+                placement << (comma ? "," : "") << first;
+
+                if(cpu - 1 > first)
+                    placement << "-" << (cpu - 1);
+
+                first = -1;
+                comma = true;
+            }
+        }
+    }
+    else
+    {
+        placement << "unknown";
+    }
+
+    int sched_policy;
+    struct sched_param param;
+
+    if(pthread_getschedparam(pthread_self(), &sched_policy, &param) == 0)
+    {
+        if(sched_policy == SCHED_FIFO)
+            placement << " - SCHED_FIFO " << param.sched_priority;
+        else
+        if(sched_policy == SCHED_RR)
+            placement << " - SCHED_RR " << param.sched_priority;
+        else
+            placement << " - SCHED_OTHER";
+    }
+
+    return placement.str();
+}
+
+//-----------------------------------------------------
+// kernel cpu list syntax: 2,4-7
+//-----------------------------------------------------
+bool ThreadPlacement::parseCpus(const std::string& cpus, std::vector<int>& cpu_list)
+{
+    std::istringstream stream(cpus);
+    std::string        range;
+
+    cpu_list.clear();
+
+    while(std::getline(stream, range, ','))
+    {
+        int  first, last;
+        char dash, extra;
+        std::istringstream range_stream(range);
+
+        if(!(range_stream >> first))
+            return false;
+
+        last = first;
+
+        if(range_stream >> dash)
+        {
+            if((dash != '-') || !(range_stream >> last))
+                return false;
+        }
+
+        if((range_stream >> extra) || (first < 0) || (last < first) || (last >= CPU_SETSIZE))
+            return false;
+
+        for(int cpu = first ; cpu <= last ; cpu++)
+            cpu_list.push_back(cpu);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------
+// the SFP addresses can be the local addresses or the DAQ addresses on the same subnet
+//-----------------------------------------------------
+int NumaPlacement::getInterfaceNode(const std::string& ip_address, std::string& interface_name)
+{
+    DEB_STATIC_FUNCT();
+
+    struct in_addr address;
+    interface_name.clear();
+
+    if(inet_pton(AF_INET, ip_address.c_str(), &address) != 1)
+        return -1;
+
+    struct ifaddrs * interfaces = NULL;
+
+    if(getifaddrs(&interfaces) != 0)
+        return -1;
+
+    for(struct ifaddrs * iface = interfaces ; iface != NULL ; iface = iface->ifa_next)
+    {
+        if((iface->ifa_addr == NULL) || (iface->ifa_netmask == NULL) || (iface->ifa_addr->sa_family != AF_INET))
+            continue;
+
+        uint32_t local   = reinterpret_cast<struct sockaddr_in *>(iface->ifa_addr   )->sin_addr.s_addr;
+        uint32_t netmask = reinterpret_cast<struct sockaddr_in *>(iface->ifa_netmask)->sin_addr.s_addr;
+
+        // an exact match wins over a subnet match
+        if(local == address.s_addr)
+        {
+            interface_name = iface->ifa_name;
+            break;
+        }
+
+        if(interface_name.empty() && ((local & netmask) == (address.s_addr & netmask)))
+            interface_name = iface->ifa_name;
+    }
+
+    freeifaddrs(interfaces);
+
+    if(interface_name.empty())
+        return -1;
+
+    // -1 on the single node systems or for a virtual interface
+    int numa_node = -1;
+    std::ifstream file(("/sys/class/net/" + interface_name + "/device/numa_node").c_str());
+
+    if(!(file >> numa_node))
+        numa_node = -1;
+
+    DEB_TRACE() << "SFP interface: " << DEB_VAR3(ip_address, interface_name, numa_node);
+    return numa_node;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::string NumaPlacement::getNodeCpus(int numa_node)
+{
+    std::ostringstream path;
+    path << "/sys/devices/system/node/node" << numa_node << "/cpulist";
+
+    std::string   cpus;
+    std::ifstream file(path.str().c_str());
+    std::getline(file, cpus);
+
+    return cpus;
+}
+
+//-----------------------------------------------------
+// the pages already touched by the Lima allocation are moved, only the
+// pages inside the buffer: the first and last ones can be shared with
+// other allocations
+//-----------------------------------------------------
+bool NumaPlacement::bindMemory(void * address, std::size_t size, int numa_node)
+{
+    DEB_STATIC_FUNCT();
+
+    if((numa_node < 0) || (numa_node >= PLACEMENT_MAX_NODES) || (size == 0))
+        return false;
+
+    const std::size_t bits_per_long = sizeof(unsigned long) * 8;
+    unsigned long     node_mask[PLACEMENT_MAX_NODES / (sizeof(unsigned long) * 8)] = { 0 };
+
+    node_mask[numa_node / bits_per_long] = 1UL << (numa_node % bits_per_long);
+
+    // mbind works on whole pages
+    uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start     = (reinterpret_cast<uintptr_t>(address) + page_size - 1) & ~(page_size - 1);
+    uintptr_t end       = (reinterpret_cast<uintptr_t>(address) + size) & ~(page_size - 1);
+
+    // buffer smaller than a page
+    if(end <= start)
+        return false;
+
+    long result = syscall(SYS_mbind, start, end - start, PLACEMENT_MPOL_BIND, node_mask,
+                          PLACEMENT_MAX_NODES + 1, PLACEMENT_MPOL_MF_MOVE);
+
+    if(result != 0)
+    {
+        DEB_WARNING() << "cannot bind the memory on the NUMA node " << numa_node << " (" << strerror(errno) << ")";
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------
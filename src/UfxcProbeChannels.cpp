@@ -0,0 +1,157 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UFXC_PROBE_CHANNELS_X86
+#endif
+#include "lima/Exceptions.h"
+#include "UfxcProbeChannels.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+//-----------------------------------------------------
+// reference kernel, from the pixel first_pixel
+//-----------------------------------------------------
+static void splitScalar(const uint32_t * frame, int first_pixel, int nb_pixels, uint16_t * first, uint16_t * second)
+{
+    for(int k = first_pixel ; k < nb_pixels ; k++)
+    {
+        first [k] = static_cast<uint16_t>(frame[k]      );
+        second[k] = static_cast<uint16_t>(frame[k] >> 16);
+    }
+}
+
+#ifdef UFXC_PROBE_CHANNELS_X86
+
+//-----------------------------------------------------
+// returns the number of split pixels
+//-----------------------------------------------------
+__attribute__((target("sse4.1")))
+static int splitSse41(const uint32_t * frame, int nb_pixels, uint16_t * first, uint16_t * second)
+{
+    // low halves in the low 64 bits, high halves in the high 64 bits
+    const __m128i halves = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+    int k = 0;
+
+    for( ; k + 8 <= nb_pixels ; k += 8)
+    {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + k    )), halves);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + k + 4)), halves);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(first  + k), _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(second + k), _mm_unpackhi_epi64(a, b));
+    }
+
+    return k;
+}
+
+__attribute__((target("avx2")))
+static int splitAvx2(const uint32_t * frame, int nb_pixels, uint16_t * first, uint16_t * second)
+{
+    const __m256i halves = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                                            0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+    int k = 0;
+
+    for( ; k + 16 <= nb_pixels ; k += 16)
+    {
+        // the shuffle works in each 128 bits lane: low and high halves of the two lanes gathered
+        __m256i a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(frame + k    )), halves), 0xD8);
+        __m256i b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(frame + k + 8)), halves), 0xD8);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(first  + k), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(second + k), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+
+    return k;
+}
+
+#endif // UFXC_PROBE_CHANNELS_X86
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ProbeChannels::View ProbeChannels::getInterleavedView(const void * frame, const Size& image_size, int channel)
+{
+    DEB_STATIC_FUNCT();
+
+    if((channel < 0) || (channel >= NB_CHANNELS))
+        THROW_HW_ERROR(InvalidValue) << "Incorrect probe channel: " << DEB_VAR1(channel);
+
+    View view;
+    view.data         = static_cast<const uint16_t *>(frame) + channel;
+    view.width        = image_size.getWidth ();
+    view.height       = image_size.getHeight();
+    view.pixel_stride = NB_CHANNELS;
+    view.row_stride   = NB_CHANNELS * view.width;
+    return view;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ProbeChannels::View ProbeChannels::getSplitView(const void * frame, const Size& image_size, int channel)
+{
+    DEB_STATIC_FUNCT();
+
+    if((channel < 0) || (channel >= NB_CHANNELS))
+        THROW_HW_ERROR(InvalidValue) << "Incorrect probe channel: " << DEB_VAR1(channel);
+
+    View view;
+    view.width        = image_size.getWidth ();
+    view.height       = image_size.getHeight();
+    view.data         = static_cast<const uint16_t *>(frame) + static_cast<long>(channel) * view.width * view.height;
+    view.pixel_stride = 1;
+    view.row_stride   = view.width;
+    return view;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Size ProbeChannels::getSplitSize(const Size& image_size)
+{
+    return Size(image_size.getWidth(), NB_CHANNELS * image_size.getHeight());
+}
+
+//-----------------------------------------------------
+// called by the fill workers, the frames can not overlap
+//-----------------------------------------------------
+void ProbeChannels::split(PixelUnpacker::Kernel kernel, const void * frame, int nb_pixels, void * split_frame)
+{
+    const uint32_t * pixels      = static_cast<const uint32_t *>(frame);
+    uint16_t       * first       = static_cast<uint16_t *>(split_frame);
+    uint16_t       * second      = first + nb_pixels;
+    int              first_pixel = 0;
+
+#ifdef UFXC_PROBE_CHANNELS_X86
+    if(kernel == PixelUnpacker::Avx2)
+        first_pixel = splitAvx2(pixels, nb_pixels, first, second);
+    else
+    if(kernel == PixelUnpacker::Sse41)
+        first_pixel = splitSse41(pixels, nb_pixels, first, second);
+#endif
+
+    splitScalar(pixels, first_pixel, nb_pixels, first, second);
+}
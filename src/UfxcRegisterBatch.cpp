@@ -0,0 +1,184 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include "UfxcRegisterBatch.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+static const char * const REGISTER_BATCH_NAMES[RegisterBatch::NbRegisters] =
+{
+    "FMC.ACQ_MODE"       ,
+    "FMC.ACQ_COUNT_TIME" ,
+    "FMC.ACQ_WAIT_TIME"  ,
+    "FMC.ACQ_NIMG"       ,
+    "FMC.ACQ_NTRIG"      ,
+};
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+RegisterBatch::RegisterBatch() :
+m_nb_writes(0),
+m_nb_skipped_writes(0)
+{
+    DEB_CONSTRUCTOR();
+
+    for(int reg = 0 ; reg < NbRegisters ; reg++)
+    {
+        m_pending_values [reg] = 0.0;
+        m_pending        [reg] = false;
+        m_hardware_values[reg] = 0.0;
+        m_hardware_known [reg] = false;
+    }
+}
+
+//-----------------------------------------------------
+// a new value replaces the previous pending one
+//-----------------------------------------------------
+void RegisterBatch::mark(Register reg, double value)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_TRACE() << getName(reg) << " pending: " << value;
+
+    AutoMutex aLock(m_mutex);
+    m_pending_values[reg] = value;
+    m_pending       [reg] = true;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool RegisterBatch::getPending(Register reg, double& value) const
+{
+    AutoMutex aLock(m_mutex);
+
+    if(!m_pending[reg])
+        return false;
+
+    value = m_pending_values[reg];
+    return true;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool RegisterBatch::isPending(Register reg) const
+{
+    AutoMutex aLock(m_mutex);
+    return m_pending[reg];
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterBatch::getWrites(std::vector<Write>& writes)
+{
+    AutoMutex aLock(m_mutex);
+    writes.clear();
+
+    for(int reg = 0 ; reg < NbRegisters ; reg++)
+    {
+        if(!m_pending[reg])
+            continue;
+
+        if(m_hardware_known[reg] && (m_hardware_values[reg] == m_pending_values[reg]))
+        {
+            m_pending[reg] = false;
+            m_nb_skipped_writes++;
+            continue;
+        }
+
+        Write write;
+        write.reg   = static_cast<Register>(reg);
+        write.value = m_pending_values[reg];
+        writes.push_back(write);
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool RegisterBatch::getWrite(Register reg, Write& write)
+{
+    AutoMutex aLock(m_mutex);
+
+    if(!m_pending[reg])
+        return false;
+
+    if(m_hardware_known[reg] && (m_hardware_values[reg] == m_pending_values[reg]))
+    {
+        m_pending[reg] = false;
+        m_nb_skipped_writes++;
+        return false;
+    }
+
+    write.reg   = reg;
+    write.value = m_pending_values[reg];
+    return true;
+}
+
+//-----------------------------------------------------
+// the pending value is kept if it was changed during the write
+//-----------------------------------------------------
+void RegisterBatch::written(Register reg, double value)
+{
+    AutoMutex aLock(m_mutex);
+    m_hardware_values[reg] = value;
+    m_hardware_known [reg] = true;
+    m_nb_writes++;
+
+    if(m_pending[reg] && (m_pending_values[reg] == value))
+        m_pending[reg] = false;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterBatch::forgetHardware()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_mutex);
+
+    for(int reg = 0 ; reg < NbRegisters ; reg++)
+        m_hardware_known[reg] = false;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterBatch::getStats(unsigned long& nb_writes, unsigned long& nb_skipped_writes) const
+{
+    AutoMutex aLock(m_mutex);
+    nb_writes         = m_nb_writes;
+    nb_skipped_writes = m_nb_skipped_writes;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+const char * RegisterBatch::getName(Register reg)
+{
+    return ((reg >= 0) && (reg < NbRegisters)) ? REGISTER_BATCH_NAMES[reg] : "unknown";
+}
+
+//-----------------------------------------------------
@@ -0,0 +1,187 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include "UfxcRegisterCache.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+static const char * const REGISTER_CACHE_NAMES[RegisterCache::NbKeys] =
+{
+    "FMC.ACQ_COUNT_TIME"       ,
+    "FMC.ACQ_WAIT_TIME"        ,
+    "FMC.ACQ_NIMG"             ,
+    "FMC.ACQ_NTRIG"            ,
+    "FMC.DET_THRESHOLD_LOW_1"  ,
+    "FMC.DET_THRESHOLD_LOW_2"  ,
+    "FMC.DET_THRESHOLD_HIGH_1" ,
+    "FMC.DET_THRESHOLD_HIGH_2" ,
+    "pump probe frequency"     ,
+    "geometrical correction"   ,
+    "image width"              ,
+    "image height"             ,
+    "min exposure time"        ,
+    "max exposure time"        ,
+    "min latency time"         ,
+    "max latency time"         ,
+};
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+RegisterCache::RegisterCache() :
+m_enabled(true),
+m_nb_hits(0),
+m_nb_misses(0)
+{
+    DEB_CONSTRUCTOR();
+
+    for(int key = 0 ; key < NbKeys ; key++)
+    {
+        m_values    [key] = 0.0;
+        m_valid     [key] = false;
+        m_generation[key] = 0;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterCache::setEnabled(bool enabled)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(enabled);
+
+    AutoMutex aLock(m_mutex);
+    m_enabled = enabled;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool RegisterCache::isEnabled() const
+{
+    AutoMutex aLock(m_mutex);
+    return m_enabled;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool RegisterCache::get(Key key, double& value, unsigned& generation) const
+{
+    AutoMutex aLock(m_mutex);
+    generation = m_generation[key];
+
+    if(!m_enabled || !m_valid[key])
+    {
+        m_nb_misses++;
+        return false;
+    }
+
+    m_nb_hits++;
+    value = m_values[key];
+    return true;
+}
+
+//-----------------------------------------------------
+// a write or an invalidation during the hardware read makes the read value obsolete
+//-----------------------------------------------------
+void RegisterCache::fill(Key key, double value, unsigned generation)
+{
+    AutoMutex aLock(m_mutex);
+
+    if(generation == m_generation[key])
+    {
+        m_values[key] = value;
+        m_valid [key] = true;
+    }
+}
+
+//-----------------------------------------------------
+// write-through of a value kept as is by the DAQ
+//-----------------------------------------------------
+void RegisterCache::set(Key key, double value)
+{
+    AutoMutex aLock(m_mutex);
+    m_values    [key] = value;
+    m_valid     [key] = true;
+    m_generation[key]++;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterCache::invalidate(Key key)
+{
+    AutoMutex aLock(m_mutex);
+    m_valid     [key] = false;
+    m_generation[key]++;
+}
+
+//-----------------------------------------------------
+// values computed by the SDK from the acquisition mode
+//-----------------------------------------------------
+void RegisterCache::invalidateGeometry()
+{
+    invalidate(ImageWidth     );
+    invalidate(ImageHeight    );
+    invalidate(MinExposureTime);
+    invalidate(MaxExposureTime);
+    invalidate(MinLatencyTime );
+    invalidate(MaxLatencyTime );
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterCache::invalidateAll()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_mutex);
+
+    for(int key = 0 ; key < NbKeys ; key++)
+    {
+        m_valid     [key] = false;
+        m_generation[key]++;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterCache::getStats(unsigned long& nb_hits, unsigned long& nb_misses) const
+{
+    AutoMutex aLock(m_mutex);
+    nb_hits   = m_nb_hits;
+    nb_misses = m_nb_misses;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+const char * RegisterCache::getName(Key key)
+{
+    return ((key >= 0) && (key < NbKeys)) ? REGISTER_CACHE_NAMES[key] : "unknown";
+}
+
+//-----------------------------------------------------
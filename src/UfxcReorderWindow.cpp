@@ -0,0 +1,286 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <time.h>
+#include <algorithm>
+#include "lima/Exceptions.h"
+#include "UfxcReorderWindow.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+static const int    REORDER_DEFAULT_SIZE      = 256 ; // frames
+static const double REORDER_DEFAULT_TIMEOUT_MS= 50.0;
+// only the first lost frames of an acquisition are listed
+static const int    REORDER_MAX_LOST_LIST     = 1024;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ReorderWindow::ReorderWindow() :
+m_size(REORDER_DEFAULT_SIZE),
+m_timeout_ms(REORDER_DEFAULT_TIMEOUT_MS),
+m_window(1),
+m_nb_frames(0),
+m_next(0),
+m_nb_received(0),
+m_nb_lost(0),
+m_nb_dropped(0)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ReorderWindow::setSize(int nb_frames)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_frames);
+
+    if(nb_frames < 1)
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect reorder window size: " << nb_frames;
+    }
+
+    m_size = nb_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int ReorderWindow::getSize() const
+{
+    return m_size;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ReorderWindow::setTimeout(double timeout_ms)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(timeout_ms);
+
+    if(timeout_ms < 0.0)
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect reorder timeout: " << timeout_ms;
+    }
+
+    m_timeout_ms = timeout_ms;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double ReorderWindow::getTimeout() const
+{
+    return m_timeout_ms;
+}
+
+//-----------------------------------------------------
+// a frame can not wait for a Lima buffer still used by a previous frame
+//-----------------------------------------------------
+void ReorderWindow::start(int window_limit, int nb_frames)
+{
+    DEB_MEMBER_FUNCT();
+
+    m_window    = std::max(1, std::min(m_size.load(), window_limit));
+    m_nb_frames = nb_frames;
+    m_next      = 0;
+    m_missing_since.clear();
+
+    m_nb_received = 0;
+    m_nb_lost     = 0;
+    m_nb_dropped  = 0;
+
+    AutoMutex aLock(m_lost_mutex);
+    m_lost_frames.clear();
+
+    DEB_TRACE() << "reorder window: " << m_window << " frames - timeout: " << m_timeout_ms.load() << " ms";
+}
+
+//-----------------------------------------------------
+// popLost() was called before, the frame is in the window
+//-----------------------------------------------------
+bool ReorderWindow::accept(int frame_index)
+{
+    DEB_MEMBER_FUNCT();
+
+    // too late (already received or declared lost) or not in the acquisition
+    if((frame_index < m_next) || ((m_nb_frames > 0) && (frame_index >= m_nb_frames)))
+    {
+        DEB_WARNING() << "dropped frame index " << frame_index << " (next expected frame " << m_next << ")";
+        m_nb_dropped++;
+        return false;
+    }
+
+    std::size_t offset = frame_index - m_next;
+
+    if(offset < m_missing_since.size())
+    {
+        if(m_missing_since[offset] < 0.0)
+        {
+            DEB_WARNING() << "dropped duplicated frame index " << frame_index;
+            m_nb_dropped++;
+            return false;
+        }
+
+        // a missing frame arrives late but in the window
+        m_missing_since[offset] = -1.0;
+    }
+    else
+    {
+        // the frames before this one are now known missing
+        double now = now_ms();
+
+        while(m_missing_since.size() < offset)
+            m_missing_since.push_back(now);
+
+        m_missing_since.push_back(-1.0);
+    }
+
+    if(frame_index + 1 > m_nb_received)
+        m_nb_received = frame_index + 1;
+
+    advance();
+    return true;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int ReorderWindow::popLost(int incoming_frame_index)
+{
+    // an image out of the acquisition will be dropped, it forces nothing
+    if((m_nb_frames > 0) && (incoming_frame_index >= m_nb_frames))
+        return popNext(0, true);
+
+    return popNext(incoming_frame_index - m_window + 1, true);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int ReorderWindow::popExpired()
+{
+    return popNext(0, true);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int ReorderWindow::popMissing()
+{
+    return popNext(m_next + static_cast<int>(m_missing_since.size()), false);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int ReorderWindow::getNbReceivedFrames() const
+{
+    return m_nb_received;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int ReorderWindow::getNbLostFrames() const
+{
+    return m_nb_lost;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int ReorderWindow::getNbDroppedFrames() const
+{
+    return m_nb_dropped;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ReorderWindow::getLostFrames(std::vector<int>& lost_frames) const
+{
+    AutoMutex aLock(m_lost_mutex);
+    lost_frames = m_lost_frames;
+}
+
+//-----------------------------------------------------
+// the first unresolved frame is declared lost if it is forced or expired
+//-----------------------------------------------------
+int ReorderWindow::popNext(int force_below, bool check_timeout)
+{
+    DEB_MEMBER_FUNCT();
+
+    // the first unresolved frame is always missing (see advance)
+    bool forced  = (m_next < force_below);
+    bool expired = check_timeout && (!m_missing_since.empty()) && (now_ms() - m_missing_since.front() >= m_timeout_ms);
+
+    if(!forced && !expired)
+        return -1;
+
+    // a frame not yet known missing (after the last received one) is only forced
+    if(!m_missing_since.empty())
+        m_missing_since.pop_front();
+
+    int lost_frame = m_next++;
+    advance();
+
+    m_nb_lost++;
+
+    {
+        AutoMutex aLock(m_lost_mutex);
+
+        if(m_lost_frames.size() < static_cast<std::size_t>(REORDER_MAX_LOST_LIST))
+            m_lost_frames.push_back(lost_frame);
+    }
+
+    DEB_TRACE() << "lost frame " << lost_frame << (forced ? " (window full)" : " (timeout)");
+    return lost_frame;
+}
+
+//-----------------------------------------------------
+// skips the received frames at the head of the window
+//-----------------------------------------------------
+void ReorderWindow::advance()
+{
+    while((!m_missing_since.empty()) && (m_missing_since.front() < 0.0))
+    {
+        m_missing_since.pop_front();
+        m_next++;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double ReorderWindow::now_ms()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+}
+
+//-----------------------------------------------------
@@ -0,0 +1,664 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <math.h>
+#include <algorithm>
+#include "lima/Exceptions.h"
+#include "lima/Timestamp.h"
+#include "UfxcReplayBackend.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+using namespace ufxclib;
+
+static const char * REPLAY_MODEL_PREFIX = "REPLAY:";
+// longest sleep of waiting_built_images (in s), the stop is seen after it
+static const double REPLAY_MAX_SLEEP_S  = 0.001;
+// limits of the registers, the captured detector checked them
+static const double REPLAY_MIN_TIME_MS  = 0.0;
+static const double REPLAY_MAX_TIME_MS  = 1e9;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ReplayBackend::ReplayBackend() :
+m_file(NULL),
+m_next_acquisition(0),
+m_speed(1.0),
+m_acquisition(NULL),
+m_acquisition_speed(1.0),
+m_start_time(0.0),
+m_nb_filled_frames(0),
+m_running(false),
+m_stopped(false)
+{
+    DEB_CONSTRUCTOR();
+
+    for(int id = 0 ; id < CaptureFormat::NbRegisters ; id++)
+        m_registers[id] = NAN;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+ReplayBackend::~ReplayBackend()
+{
+    DEB_DESTRUCTOR();
+
+    if(m_file != NULL)
+        fclose(m_file);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool ReplayBackend::isReplayModel(const std::string& model)
+{
+    return model.compare(0, strlen(REPLAY_MODEL_PREFIX), REPLAY_MODEL_PREFIX) == 0;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ReplayBackend::setSpeed(double speed)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(speed < 0.0)
+        THROW_HW_ERROR(InvalidValue) << "Incorrect replay speed: " << DEB_VAR1(speed);
+
+    AutoMutex aLock(m_mutex);
+    m_speed = speed;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double ReplayBackend::getSpeed() const
+{
+    AutoMutex aLock(m_mutex);
+    return m_speed;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int ReplayBackend::getNbAcquisitions() const
+{
+    return static_cast<int>(m_acquisitions.size());
+}
+
+//-----------------------------------------------------
+// REPLAY:<capture file>
+//-----------------------------------------------------
+void ReplayBackend::open_connection(const std::string& model,
+                                    const ufxclib::DaqCnxConfig& /*tcp_cnx*/ , const ufxclib::DaqCnxConfig& /*sfp1_cnx*/,
+                                    const ufxclib::DaqCnxConfig& /*sfp2_cnx*/, const ufxclib::DaqCnxConfig& /*sfp3_cnx*/,
+                                    unsigned long /*sfp_mtu*/)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(model);
+
+    if(!isReplayModel(model))
+        THROW_HW_ERROR(InvalidValue) << "Not a replay model: " << model;
+
+    loadFile(model.substr(strlen(REPLAY_MODEL_PREFIX)));
+}
+
+void ReplayBackend::close_connection()
+{
+    stop_acquisition();
+}
+
+void ReplayBackend::set_acquisition_registers_names(const std::map<ufxclib::EnumAcquisitionConfigKey, std::string>& /*names*/)
+{
+}
+
+void ReplayBackend::set_detector_registers_names(const std::map<ufxclib::EnumDetectorConfigKey, std::string>& /*names*/)
+{
+}
+
+void ReplayBackend::set_monitoring_registers_names(const std::map<ufxclib::EnumMonitoringKey, std::string>& /*names*/)
+{
+}
+
+void ReplayBackend::set_detector_config_file(const std::string& /*file_name*/)
+{
+}
+
+//-----------------------------------------------------
+// informations of the captured detector
+//-----------------------------------------------------
+std::string ReplayBackend::get_detector_name()
+{
+    return m_header.detector_name;
+}
+
+std::string ReplayBackend::get_detector_type()
+{
+    return m_header.detector_type;
+}
+
+std::string ReplayBackend::get_lib_version()
+{
+    return m_header.lib_version;
+}
+
+std::string ReplayBackend::get_firmware_version()
+{
+    return m_header.firmware_version;
+}
+
+unsigned long ReplayBackend::get_detector_temp()
+{
+    return 0;
+}
+
+ufxclib::EnumDetectorStatus ReplayBackend::get_detector_status()
+{
+    AutoMutex aLock(m_mutex);
+    return (m_running && !end_of_transfer()) ? EnumDetectorStatus::E_DET_BUSY : EnumDetectorStatus::E_DET_READY;
+}
+
+//-----------------------------------------------------
+// registers
+//-----------------------------------------------------
+void ReplayBackend::set_acq_mode(ufxclib::EnumAcquisitionMode mode)
+{
+    setRegister(CaptureFormat::AcqMode, static_cast<double>(static_cast<int>(mode)));
+}
+
+void ReplayBackend::set_counting_time_ms(double time_ms)
+{
+    setRegister(CaptureFormat::CountingTime, time_ms);
+}
+
+double ReplayBackend::get_counting_time_ms()
+{
+    return getRegister(CaptureFormat::CountingTime);
+}
+
+void ReplayBackend::set_waiting_time_ms(double time_ms)
+{
+    setRegister(CaptureFormat::WaitingTime, time_ms);
+}
+
+double ReplayBackend::get_waiting_time_ms()
+{
+    return getRegister(CaptureFormat::WaitingTime);
+}
+
+void ReplayBackend::set_images_number(std::size_t images_number)
+{
+    setRegister(CaptureFormat::ImagesNumber, static_cast<double>(images_number));
+}
+
+std::size_t ReplayBackend::get_images_number()
+{
+    return static_cast<std::size_t>(getRegister(CaptureFormat::ImagesNumber));
+}
+
+void ReplayBackend::set_triggers_number(std::size_t triggers_number)
+{
+    setRegister(CaptureFormat::TriggersNumber, static_cast<double>(triggers_number));
+}
+
+std::size_t ReplayBackend::get_triggers_number()
+{
+    return static_cast<std::size_t>(getRegister(CaptureFormat::TriggersNumber));
+}
+
+void ReplayBackend::set_low_1_threshold(float threshold)
+{
+    setRegister(CaptureFormat::Low1Threshold, threshold);
+}
+
+double ReplayBackend::get_low_1_threshold()
+{
+    return getRegister(CaptureFormat::Low1Threshold);
+}
+
+void ReplayBackend::set_low_2_threshold(float threshold)
+{
+    setRegister(CaptureFormat::Low2Threshold, threshold);
+}
+
+double ReplayBackend::get_low_2_threshold()
+{
+    return getRegister(CaptureFormat::Low2Threshold);
+}
+
+void ReplayBackend::set_high_1_threshold(float threshold)
+{
+    setRegister(CaptureFormat::High1Threshold, threshold);
+}
+
+double ReplayBackend::get_high_1_threshold()
+{
+    return getRegister(CaptureFormat::High1Threshold);
+}
+
+void ReplayBackend::set_high_2_threshold(float threshold)
+{
+    setRegister(CaptureFormat::High2Threshold, threshold);
+}
+
+double ReplayBackend::get_high_2_threshold()
+{
+    return getRegister(CaptureFormat::High2Threshold);
+}
+
+void ReplayBackend::set_pump_probe_frequency_Hz(double frequency)
+{
+    setRegister(CaptureFormat::PumpProbeFrequency, frequency);
+}
+
+double ReplayBackend::get_pump_probe_frequency_Hz()
+{
+    return getRegister(CaptureFormat::PumpProbeFrequency);
+}
+
+void ReplayBackend::set_geometrical_correction(bool enabled)
+{
+    setRegister(CaptureFormat::GeometricalCorrection, enabled ? 1.0 : 0.0);
+}
+
+bool ReplayBackend::get_geometrical_correction()
+{
+    return getRegister(CaptureFormat::GeometricalCorrection) != 0.0;
+}
+
+//-----------------------------------------------------
+// image size of the acquisition played at the next start
+//-----------------------------------------------------
+std::size_t ReplayBackend::get_current_width()
+{
+    const Acquisition * acquisition = getNextAcquisition();
+    return (acquisition != NULL) ? acquisition->width : 0;
+}
+
+std::size_t ReplayBackend::get_current_height()
+{
+    const Acquisition * acquisition = getNextAcquisition();
+    return (acquisition != NULL) ? acquisition->height : 0;
+}
+
+double ReplayBackend::get_min_exposure_time_ms()
+{
+    return REPLAY_MIN_TIME_MS;
+}
+
+double ReplayBackend::get_max_exposure_time_ms()
+{
+    return REPLAY_MAX_TIME_MS;
+}
+
+double ReplayBackend::get_min_latency_time_ms()
+{
+    return REPLAY_MIN_TIME_MS;
+}
+
+double ReplayBackend::get_max_latency_time_ms()
+{
+    return REPLAY_MAX_TIME_MS;
+}
+
+//-----------------------------------------------------
+// plays the next captured acquisition
+//-----------------------------------------------------
+void ReplayBackend::start_acquisition()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_mutex);
+
+    if(m_acquisitions.empty())
+        THROW_HW_ERROR(Error) << "No acquisition in the capture file " << m_file_name << "!";
+
+    const Acquisition& acquisition = m_acquisitions[m_next_acquisition];
+
+    for(int id = 0 ; id < CaptureFormat::NbRegisters ; id++)
+    {
+        double captured = acquisition.registers[id];
+
+        if((!isnan(captured)) && (!isnan(m_registers[id])) && (captured != m_registers[id]))
+        {
+            DEB_WARNING() << "replayed acquisition " << m_next_acquisition << ": " << CaptureFormat::getRegisterName(id)
+                          << " captured " << captured << " - written " << m_registers[id];
+        }
+    }
+
+    DEB_TRACE() << "replayed acquisition " << m_next_acquisition << ": " << acquisition.frames.size() << " frames";
+
+    m_acquisition      = &acquisition;
+    m_next_acquisition = (m_next_acquisition + 1) % m_acquisitions.size();
+    m_acquisition_speed= m_speed;
+    m_nb_filled_frames = 0;
+    m_start_time       = Timestamp::now();
+    m_stopped.store(false, std::memory_order_relaxed);
+    m_running.store(true , std::memory_order_release);
+}
+
+void ReplayBackend::stop_acquisition()
+{
+    m_stopped.store(true, std::memory_order_release);
+}
+
+void ReplayBackend::register_acquisition_customer(const std::string& /*name*/)
+{
+}
+
+void ReplayBackend::unregister_acquisition_customer(const std::string& /*name*/)
+{
+}
+
+//-----------------------------------------------------
+// sleeps until the next frame time
+//-----------------------------------------------------
+void ReplayBackend::waiting_built_images()
+{
+    while((!get_built_images_nb()) && (!end_of_transfer()))
+    {
+        double next_frame = m_start_time + m_acquisition->frames[m_nb_filled_frames].time / m_acquisition_speed;
+        double sleep_time = std::min(REPLAY_MAX_SLEEP_S, next_frame - double(Timestamp::now()));
+
+        if(sleep_time > 0.0)
+            usleep(static_cast<useconds_t>(ceil(sleep_time * 1e6)));
+    }
+}
+
+std::size_t ReplayBackend::get_built_images_nb()
+{
+    if((!m_running.load(std::memory_order_acquire)) || (m_stopped.load(std::memory_order_acquire)))
+        return 0;
+
+    return getNbAvailableFrames() - m_nb_filled_frames;
+}
+
+std::size_t ReplayBackend::get_first_built_image_index()
+{
+    if((m_acquisition == NULL) || (m_nb_filled_frames >= m_acquisition->frames.size()))
+        return m_nb_filled_frames;
+
+    return static_cast<std::size_t>(m_acquisition->frames[m_nb_filled_frames].index);
+}
+
+bool ReplayBackend::fill_image_buffer(char * buffer, int buffer_size)
+{
+    return fillBuffer(false, buffer, buffer_size);
+}
+
+bool ReplayBackend::fill_raw_image_buffer(char * buffer, int buffer_size)
+{
+    return fillBuffer(true, buffer, buffer_size);
+}
+
+bool ReplayBackend::is_raw_images_supported() const
+{
+    return true;
+}
+
+bool ReplayBackend::end_of_transfer()
+{
+    if((!m_running.load(std::memory_order_acquire)) || (m_stopped.load(std::memory_order_acquire)))
+        return true;
+
+    return m_nb_filled_frames >= m_acquisition->frames.size();
+}
+
+//-----------------------------------------------------
+// the failure of the captured acquisition
+//-----------------------------------------------------
+bool ReplayBackend::failed_acquisition()
+{
+    return (m_acquisition != NULL) && (m_acquisition->failed);
+}
+
+void ReplayBackend::log_acquisition_stats()
+{
+    DEB_MEMBER_FUNCT();
+    double elapsed = double(Timestamp::now()) - m_start_time;
+
+    DEB_TRACE() << "replayed frames: " << m_nb_filled_frames << " / "
+                << ((m_acquisition != NULL) ? m_acquisition->frames.size() : 0) << " in " << elapsed << " s";
+}
+
+//-----------------------------------------------------
+// a truncated file (capture not closed) is used up to its last full record
+//-----------------------------------------------------
+void ReplayBackend::loadFile(const std::string& file_name)
+{
+    DEB_MEMBER_FUNCT();
+
+    FILE * file = fopen(file_name.c_str(), "rb");
+
+    if(file == NULL)
+        THROW_HW_ERROR(Error) << "Can not open the capture file " << file_name << ": " << strerror(errno);
+
+    std::vector<Acquisition> acquisitions;
+    double                   registers [CaptureFormat::NbRegisters];
+    double                   start_time = 0.0;
+
+    for(int id = 0 ; id < CaptureFormat::NbRegisters ; id++)
+        registers[id] = NAN;
+
+    try
+    {
+        CaptureFormat::readHeader(file, m_header);
+    }
+    catch(...)
+    {
+        fclose(file);
+        throw;
+    }
+
+    try
+    {
+        CaptureFormat::RecordType type;
+        double                    time;
+
+        while(CaptureFormat::readRecordStart(file, type, time))
+        {
+            switch(type)
+            {
+                case CaptureFormat::Register:
+                {
+                    uint8_t id;
+                    double  value;
+
+                    CaptureFormat::readValue(file, id   );
+                    CaptureFormat::readValue(file, value);
+
+                    if(id < CaptureFormat::NbRegisters)
+                        registers[id] = value;
+                    break;
+                }
+
+                case CaptureFormat::ConfigFile:
+                {
+                    std::string config_file;
+                    CaptureFormat::readString(file, config_file);
+                    break;
+                }
+
+                case CaptureFormat::Start:
+                {
+                    Acquisition acquisition;
+
+                    CaptureFormat::readValue(file, acquisition.width );
+                    CaptureFormat::readValue(file, acquisition.height);
+                    acquisition.failed = false;
+                    memcpy(acquisition.registers, registers, sizeof(registers));
+
+                    acquisitions.push_back(acquisition);
+                    start_time = time;
+                    break;
+                }
+
+                case CaptureFormat::Frame:
+                {
+                    FrameEntry frame;
+                    uint8_t    raw;
+
+                    CaptureFormat::readValue(file, frame.index       );
+                    CaptureFormat::readValue(file, raw               );
+                    CaptureFormat::readValue(file, frame.size        );
+                    CaptureFormat::readValue(file, frame.encoded_size);
+
+                    frame.raw    = (raw != 0);
+                    frame.time   = std::max(0.0, time - start_time);
+                    frame.offset = ftello(file);
+
+                    if(acquisitions.empty())
+                        THROW_HW_ERROR(Error) << "Corrupted capture file: frame before the acquisition start!";
+
+                    if(fseeko(file, frame.encoded_size, SEEK_CUR) != 0)
+                        THROW_HW_ERROR(Error) << "Can not seek in the capture file: " << strerror(errno);
+
+                    acquisitions.back().frames.push_back(frame);
+                    break;
+                }
+
+                case CaptureFormat::Stop:
+                    break;
+
+                case CaptureFormat::Failed:
+                {
+                    uint8_t failed;
+                    CaptureFormat::readValue(file, failed);
+
+                    if(!acquisitions.empty())
+                        acquisitions.back().failed = (failed != 0);
+                    break;
+                }
+
+                default:
+                    THROW_HW_ERROR(Error) << "Corrupted capture file: unknown record " << static_cast<int>(type);
+            }
+        }
+    }
+    catch(Exception& e)
+    {
+        DEB_WARNING() << "capture file " << file_name << " read up to the error: " << e.getErrMsg();
+    }
+
+    // the last frame of a truncated file can be incomplete
+    if(!acquisitions.empty() && !acquisitions.back().frames.empty())
+    {
+        const FrameEntry& last = acquisitions.back().frames.back();
+
+        if(fseeko(file, 0, SEEK_END) == 0 && (last.offset + static_cast<off_t>(last.encoded_size) > ftello(file)))
+            acquisitions.back().frames.pop_back();
+    }
+
+    if(m_file != NULL)
+        fclose(m_file);
+
+    m_file             = file;
+    m_file_name        = file_name;
+    m_acquisitions.swap(acquisitions);
+    m_next_acquisition = 0;
+
+    DEB_TRACE() << "capture file " << file_name << ": " << m_acquisitions.size() << " acquisitions of "
+                << m_header.detector_type;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ReplayBackend::setRegister(CaptureFormat::RegisterId id, double value)
+{
+    AutoMutex aLock(m_mutex);
+    m_registers[id] = value;
+}
+
+//-----------------------------------------------------
+// 0 if the camera did not write it
+//-----------------------------------------------------
+double ReplayBackend::getRegister(CaptureFormat::RegisterId id) const
+{
+    AutoMutex aLock(m_mutex);
+    return isnan(m_registers[id]) ? 0.0 : m_registers[id];
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+const ReplayBackend::Acquisition * ReplayBackend::getNextAcquisition() const
+{
+    AutoMutex aLock(m_mutex);
+    return m_acquisitions.empty() ? NULL : &m_acquisitions[m_next_acquisition];
+}
+
+//-----------------------------------------------------
+// the frames are sorted by time
+//-----------------------------------------------------
+std::size_t ReplayBackend::getNbAvailableFrames() const
+{
+    const std::vector<FrameEntry>& frames = m_acquisition->frames;
+
+    if(m_acquisition_speed <= 0.0)
+        return frames.size();
+
+    double replay_time = (double(Timestamp::now()) - m_start_time) * m_acquisition_speed;
+    std::size_t nb_frames = m_nb_filled_frames;
+
+    while((nb_frames < frames.size()) && (frames[nb_frames].time <= replay_time))
+        nb_frames++;
+
+    return nb_frames;
+}
+
+//-----------------------------------------------------
+// called by the acquisition thread
+//-----------------------------------------------------
+bool ReplayBackend::fillBuffer(bool raw, char * buffer, int buffer_size)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(!get_built_images_nb())
+        return false;
+
+    const FrameEntry& frame = m_acquisition->frames[m_nb_filled_frames];
+
+    if((frame.raw != raw) || (static_cast<int>(frame.size) > buffer_size))
+    {
+        DEB_ERROR() << "The camera does not ask the captured frames: " << DEB_VAR2(raw, buffer_size)
+                    << " - captured: " << DEB_VAR2(frame.raw, frame.size);
+        return false;
+    }
+
+    m_encoded.resize(frame.encoded_size);
+
+    if((fseeko(m_file, frame.offset, SEEK_SET) != 0) ||
+       (frame.encoded_size && (fread(&m_encoded[0], 1, frame.encoded_size, m_file) != frame.encoded_size)) ||
+       (!CaptureFormat::decode(m_encoded.empty() ? NULL : &m_encoded[0], frame.encoded_size, buffer, frame.size)))
+    {
+        DEB_ERROR() << "Can not read the captured frame " << frame.index << " of " << m_file_name;
+        return false;
+    }
+
+    m_nb_filled_frames++;
+    return true;
+}
@@ -0,0 +1,79 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include "UfxcRoiCtrlObj.h"
+#include "UfxcCamera.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+RoiCtrlObj::RoiCtrlObj(Camera& cam):m_cam(cam)
+{
+	DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+RoiCtrlObj::~RoiCtrlObj()
+{
+	DEB_DESTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RoiCtrlObj::checkRoi(const Roi& set_roi, Roi& hw_roi)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_PARAM() << DEB_VAR1(set_roi);
+
+	m_cam.checkRoi(set_roi, hw_roi);
+
+	DEB_RETURN() << DEB_VAR1(hw_roi);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RoiCtrlObj::setRoi(const Roi& set_roi)
+{
+	DEB_MEMBER_FUNCT();
+	DEB_PARAM() << DEB_VAR1(set_roi);
+
+	m_cam.setRoi(set_roi);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RoiCtrlObj::getRoi(Roi& hw_roi)
+{
+	DEB_MEMBER_FUNCT();
+
+	m_cam.getRoi(hw_roi);
+
+	DEB_RETURN() << DEB_VAR1(hw_roi);
+}
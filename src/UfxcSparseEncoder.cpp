@@ -0,0 +1,228 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <algorithm>
+#include "lima/Exceptions.h"
+#include "UfxcSparseEncoder.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// fraction of non zero pixels below which a frame is sparse
+static const double SPARSE_DEFAULT_OCCUPANCY = 0.05;
+
+//-----------------------------------------------------
+// indexes of the non zero pixels, returns -1 if there are more than max_events
+//-----------------------------------------------------
+template<typename T>
+static int findEvents(const T * pixels, int nb_pixels, uint32_t * indexes, int max_events)
+{
+    // the zero words are skipped 8 bytes at a time
+    const int word_pixels = static_cast<int>(sizeof(uint64_t) / sizeof(T));
+    int       nb_events   = 0;
+    int       k           = 0;
+
+    for( ; k + word_pixels <= nb_pixels ; k += word_pixels)
+    {
+        uint64_t word;
+        memcpy(&word, pixels + k, sizeof(word));
+
+        if(!word)
+            continue;
+
+        for(int i = k ; i < k + word_pixels ; i++)
+        {
+            if(!pixels[i])
+                continue;
+
+            if(nb_events == max_events)
+                return -1;
+
+            indexes[nb_events++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    for( ; k < nb_pixels ; k++)
+    {
+        if(!pixels[k])
+            continue;
+
+        if(nb_events == max_events)
+            return -1;
+
+        indexes[nb_events++] = static_cast<uint32_t>(k);
+    }
+
+    return nb_events;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+template<typename T>
+static void gatherCounts(const T * pixels, const uint32_t * indexes, int nb_events, T * counts)
+{
+    for(int k = 0 ; k < nb_events ; k++)
+        counts[k] = pixels[indexes[k]];
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+template<typename T>
+static void scatterCounts(const T * counts, const uint32_t * indexes, int nb_events, T * pixels, int nb_pixels)
+{
+    for(int k = 0 ; k < nb_events ; k++)
+    {
+        if(indexes[k] < static_cast<uint32_t>(nb_pixels))
+            pixels[indexes[k]] = counts[k];
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+SparseEncoder::SparseEncoder() :
+m_occupancy_threshold(SPARSE_DEFAULT_OCCUPANCY)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void SparseEncoder::setOccupancyThreshold(double threshold)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(threshold);
+
+    if((threshold < 0.0) || (threshold > 1.0))
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect occupancy threshold: " << threshold << " (should be in [0, 1])";
+    }
+
+    m_occupancy_threshold = threshold;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double SparseEncoder::getOccupancyThreshold() const
+{
+    return m_occupancy_threshold;
+}
+
+//-----------------------------------------------------
+// called by the fill workers, record_size: bytes of the Lima buffer
+//-----------------------------------------------------
+bool SparseEncoder::encode(int pixel_size, const void * pixels, int nb_pixels, void * record, int record_size) const
+{
+    RecordHeader * header     = static_cast<RecordHeader *>(record);
+    char *         payload    = static_cast<char *>(record) + sizeof(RecordHeader);
+    int            capacity   = std::max(0, record_size - static_cast<int>(sizeof(RecordHeader)));
+    int            max_events = std::min(static_cast<int>(m_occupancy_threshold * nb_pixels),
+                                         capacity / static_cast<int>(sizeof(uint32_t) + pixel_size));
+    uint32_t *     indexes    = reinterpret_cast<uint32_t *>(payload);
+    int            nb_events;
+
+    switch(pixel_size)
+    {
+        case 1 : nb_events = findEvents(static_cast<const uint8_t  *>(pixels), nb_pixels, indexes, max_events); break;
+        case 2 : nb_events = findEvents(static_cast<const uint16_t *>(pixels), nb_pixels, indexes, max_events); break;
+        default: nb_events = findEvents(static_cast<const uint32_t *>(pixels), nb_pixels, indexes, max_events); break;
+    }
+
+    header->magic     = MAGIC;
+    header->nb_pixels = static_cast<uint32_t>(nb_pixels);
+
+    // too many events: the indexes already written are overwritten by the pixels
+    if(nb_events < 0)
+    {
+        header->encoding  = Dense;
+        header->nb_events = 0;
+        memcpy(payload, pixels, static_cast<std::size_t>(pixel_size) * nb_pixels);
+        return false;
+    }
+
+    void * counts = payload + sizeof(uint32_t) * nb_events;
+
+    switch(pixel_size)
+    {
+        case 1 : gatherCounts(static_cast<const uint8_t  *>(pixels), indexes, nb_events, static_cast<uint8_t  *>(counts)); break;
+        case 2 : gatherCounts(static_cast<const uint16_t *>(pixels), indexes, nb_events, static_cast<uint16_t *>(counts)); break;
+        default: gatherCounts(static_cast<const uint32_t *>(pixels), indexes, nb_events, static_cast<uint32_t *>(counts)); break;
+    }
+
+    header->encoding  = Sparse;
+    header->nb_events = static_cast<uint32_t>(nb_events);
+    return true;
+}
+
+//-----------------------------------------------------
+// for the consumers of the records
+//-----------------------------------------------------
+bool SparseEncoder::decode(int pixel_size, const void * record, void * pixels, int nb_pixels)
+{
+    const RecordHeader * header  = static_cast<const RecordHeader *>(record);
+    const char *         payload = static_cast<const char *>(record) + sizeof(RecordHeader);
+
+    // blank frame
+    if(header->magic != MAGIC)
+    {
+        memset(pixels, 0, static_cast<std::size_t>(pixel_size) * nb_pixels);
+        return true;
+    }
+
+    if(header->nb_pixels != static_cast<uint32_t>(nb_pixels))
+        return false;
+
+    if(header->encoding == Dense)
+    {
+        memcpy(pixels, payload, static_cast<std::size_t>(pixel_size) * nb_pixels);
+        return true;
+    }
+
+    int              nb_events = static_cast<int>(header->nb_events);
+    const uint32_t * indexes   = reinterpret_cast<const uint32_t *>(payload);
+    const void *     counts    = payload + sizeof(uint32_t) * nb_events;
+
+    memset(pixels, 0, static_cast<std::size_t>(pixel_size) * nb_pixels);
+
+    switch(pixel_size)
+    {
+        case 1 : scatterCounts(static_cast<const uint8_t  *>(counts), indexes, nb_events, static_cast<uint8_t  *>(pixels), nb_pixels); break;
+        case 2 : scatterCounts(static_cast<const uint16_t *>(counts), indexes, nb_events, static_cast<uint16_t *>(pixels), nb_pixels); break;
+        default: scatterCounts(static_cast<const uint32_t *>(counts), indexes, nb_events, static_cast<uint32_t *>(pixels), nb_pixels); break;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------
+// the dense record is the image shifted by the header
+//-----------------------------------------------------
+int SparseEncoder::getHeaderRows(int width, int pixel_size)
+{
+    int row_size = std::max(1, width * pixel_size);
+    return (static_cast<int>(sizeof(RecordHeader)) + row_size - 1) / row_size;
+}
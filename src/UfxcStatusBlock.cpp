@@ -0,0 +1,204 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <sched.h>
+#include "UfxcStatusBlock.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+StatusBlock::StatusBlock(int status, int fault_status) :
+m_sequence(0),
+m_fault_status(fault_status),
+m_status_generation(0),
+m_status(status),
+m_thread_running(false),
+m_nb_received_frames(0),
+m_nb_acquired_frames(0),
+m_last_frame_timestamp(0.0),
+m_status_timestamp(0.0)
+{
+    m_write_lock.clear();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void StatusBlock::setStatus(int status, bool force)
+{
+    beginWrite();
+
+    if(force || (m_status.load(std::memory_order_relaxed) != m_fault_status))
+        m_status.store(status, std::memory_order_relaxed);
+
+    m_status_generation.fetch_add(1, std::memory_order_relaxed);
+    endWrite();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void StatusBlock::setThreadRunning(bool thread_running)
+{
+    beginWrite();
+    m_thread_running.store(thread_running, std::memory_order_relaxed);
+    endWrite();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void StatusBlock::setNbReceivedFrames(int nb_frames)
+{
+    beginWrite();
+    m_nb_received_frames.store(nb_frames, std::memory_order_relaxed);
+    endWrite();
+}
+
+//-----------------------------------------------------
+// called by the publisher after each frame given to Lima
+//-----------------------------------------------------
+void StatusBlock::frameAcquired(int nb_frames, double timestamp)
+{
+    beginWrite();
+    m_nb_acquired_frames.store  (nb_frames, std::memory_order_relaxed);
+    m_last_frame_timestamp.store(timestamp, std::memory_order_relaxed);
+    endWrite();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void StatusBlock::startAcquisition()
+{
+    beginWrite();
+    m_nb_received_frames.store  (0  , std::memory_order_relaxed);
+    m_nb_acquired_frames.store  (0  , std::memory_order_relaxed);
+    m_last_frame_timestamp.store(0.0, std::memory_order_relaxed);
+    m_status_generation.fetch_add(1, std::memory_order_relaxed);
+    endWrite();
+}
+
+//-----------------------------------------------------
+// called by the status monitor before each detector status read
+//-----------------------------------------------------
+unsigned StatusBlock::getStatusGeneration() const
+{
+    return m_status_generation.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------
+// called by the status monitor after each detector status read,
+// returns false if the read is older than the last status change
+//-----------------------------------------------------
+bool StatusBlock::statusRefreshed(int status, double timestamp, unsigned generation)
+{
+    beginWrite();
+
+    bool refreshed = (generation == m_status_generation.load(std::memory_order_relaxed));
+
+    if(refreshed)
+    {
+        if(m_status.load(std::memory_order_relaxed) != m_fault_status)
+            m_status.store(status, std::memory_order_relaxed);
+
+        m_status_timestamp.store(timestamp, std::memory_order_relaxed);
+    }
+
+    endWrite();
+    return refreshed;
+}
+
+//-----------------------------------------------------
+// retries while a writer is changing the block
+//-----------------------------------------------------
+void StatusBlock::read(StatusSnapshot& snapshot) const
+{
+    unsigned begin_sequence;
+    unsigned end_sequence;
+
+    do
+    {
+        begin_sequence = m_sequence.load(std::memory_order_acquire);
+
+        snapshot.status               = m_status.load              (std::memory_order_relaxed);
+        snapshot.thread_running       = m_thread_running.load      (std::memory_order_relaxed);
+        snapshot.nb_received_frames   = m_nb_received_frames.load  (std::memory_order_relaxed);
+        snapshot.nb_acquired_frames   = m_nb_acquired_frames.load  (std::memory_order_relaxed);
+        snapshot.last_frame_timestamp = m_last_frame_timestamp.load(std::memory_order_relaxed);
+        snapshot.status_timestamp     = m_status_timestamp.load    (std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        end_sequence = m_sequence.load(std::memory_order_relaxed);
+    }
+    while((begin_sequence & 1) || (begin_sequence != end_sequence));
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int StatusBlock::getStatus() const
+{
+    return m_status.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool StatusBlock::isThreadRunning() const
+{
+    return m_thread_running.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int StatusBlock::getNbAcquiredFrames() const
+{
+    return m_nb_acquired_frames.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void StatusBlock::beginWrite()
+{
+    while(m_write_lock.test_and_set(std::memory_order_acquire))
+        sched_yield();
+
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void StatusBlock::endWrite()
+{
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    m_write_lock.clear(std::memory_order_release);
+}
+
+//-----------------------------------------------------
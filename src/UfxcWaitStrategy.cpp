@@ -0,0 +1,262 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <time.h>
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "lima/Exceptions.h"
+#include "UfxcWaitStrategy.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// below this frame period, the wakeup latency of a blocking wait is too high (ms)
+static const double WAIT_SPIN_FRAME_PERIOD_MS     = 1.0  ;
+// below this frame period, the acquisition thread never sleeps (ms)
+static const double WAIT_BUSY_POLL_FRAME_PERIOD_MS= 0.1  ;
+// above this frame period, the end of transfer is checked between the frames (ms)
+static const double WAIT_SLOW_FRAME_PERIOD_MS     = 100.0;
+// weight of the last batch in the measured frame period
+static const double WAIT_MEASURE_WEIGHT           = 0.1  ;
+// default spin budget before blocking (us)
+static const double WAIT_DEFAULT_SPIN_BUDGET_US   = 200.0;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+WaitStrategy::WaitStrategy() :
+m_policy(Auto),
+m_spin_budget_us(WAIT_DEFAULT_SPIN_BUDGET_US),
+m_effective_policy(Blocking),
+m_frame_period_ms(0.0),
+m_last_batch_us(0.0)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void WaitStrategy::setPolicy(Policy policy)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(policy);
+    m_policy = policy;
+
+    if(policy != Auto)
+        m_effective_policy = policy;
+    else
+        m_effective_policy = selectPolicy(m_frame_period_ms);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+WaitStrategy::Policy WaitStrategy::getPolicy() const
+{
+    return static_cast<Policy>(m_policy.load());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void WaitStrategy::setSpinBudget(double spin_budget_us)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(spin_budget_us);
+
+    if(spin_budget_us < 0.0)
+    {
+        THROW_HW_ERROR(InvalidValue) << "Incorrect spin budget!";
+    }
+
+    m_spin_budget_us = spin_budget_us;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double WaitStrategy::getSpinBudget() const
+{
+    return m_spin_budget_us;
+}
+
+//-----------------------------------------------------
+// the configured frame time is the first estimation of the frame period
+//-----------------------------------------------------
+void WaitStrategy::start(double frame_time_ms)
+{
+    DEB_MEMBER_FUNCT();
+
+    m_frame_period_ms = frame_time_ms;
+    m_last_batch_us   = now_us();
+
+    if(getPolicy() == Auto)
+        m_effective_policy = selectPolicy(frame_time_ms);
+    else
+        m_effective_policy = getPolicy();
+
+    DEB_TRACE() << "wait policy: " << m_effective_policy.load() << " for a frame time of " << frame_time_ms << " ms";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::size_t WaitStrategy::wait(DetectorBackend& ufxc_interface)
+{
+    std::size_t built_images_nb = 0;
+
+    switch(static_cast<Policy>(m_effective_policy.load()))
+    {
+        case BusyPoll:
+            while(!ufxc_interface.end_of_transfer())
+            {
+                built_images_nb = ufxc_interface.get_built_images_nb();
+
+                if(built_images_nb)
+                    break;
+
+                cpuRelax();
+            }
+            break;
+
+        case SpinThenBlock:
+        {
+            double deadline_us     = now_us() + m_spin_budget_us;
+            bool   end_of_transfer = false;
+
+            do
+            {
+                built_images_nb = ufxc_interface.get_built_images_nb();
+
+                if(built_images_nb)
+                    break;
+
+                end_of_transfer = ufxc_interface.end_of_transfer();
+
+                if(end_of_transfer)
+                    break;
+
+                cpuRelax();
+            }
+            while(now_us() < deadline_us);
+
+            // no image during the spin budget: blocking wait
+            if((!built_images_nb) && (!end_of_transfer))
+            {
+                ufxc_interface.waiting_built_images();
+                built_images_nb = ufxc_interface.get_built_images_nb();
+            }
+            break;
+        }
+
+        default:
+            // waiting for new images to receive
+            ufxc_interface.waiting_built_images();
+            built_images_nb = ufxc_interface.get_built_images_nb();
+            break;
+    }
+
+    if(built_images_nb)
+        updateMeasure(built_images_nb);
+
+    return built_images_nb;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+WaitStrategy::Policy WaitStrategy::getEffectivePolicy() const
+{
+    return static_cast<Policy>(m_effective_policy.load());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double WaitStrategy::getMeasuredFramePeriod() const
+{
+    return m_frame_period_ms;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool WaitStrategy::checkEndBetweenFrames() const
+{
+    return (m_frame_period_ms >= WAIT_SLOW_FRAME_PERIOD_MS);
+}
+
+//-----------------------------------------------------
+// moving average of the period between the received images
+//-----------------------------------------------------
+void WaitStrategy::updateMeasure(std::size_t built_images_nb)
+{
+    double batch_us  = now_us();
+    double period_ms = (batch_us - m_last_batch_us) / 1000.0 / built_images_nb;
+
+    m_last_batch_us   = batch_us;
+    m_frame_period_ms = (1.0 - WAIT_MEASURE_WEIGHT) * m_frame_period_ms + WAIT_MEASURE_WEIGHT * period_ms;
+
+    if(getPolicy() == Auto)
+        m_effective_policy = selectPolicy(m_frame_period_ms);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+WaitStrategy::Policy WaitStrategy::selectPolicy(double frame_period_ms) const
+{
+    if(frame_period_ms < WAIT_BUSY_POLL_FRAME_PERIOD_MS)
+        return BusyPoll;
+
+    if(frame_period_ms < WAIT_SPIN_FRAME_PERIOD_MS)
+        return SpinThenBlock;
+
+    return Blocking;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+double WaitStrategy::now_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void WaitStrategy::cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    sched_yield();
+#endif
+}
+
+//-----------------------------------------------------
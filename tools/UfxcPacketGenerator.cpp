@@ -0,0 +1,735 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <limits>
+#include <algorithm>
+#include "lima/Exceptions.h"
+#include "UfxcDetectorSimulator.h"
+#include "UfxcPixelUnpacker.h"
+#include "UfxcPacketGenerator.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// IPv4 and UDP headers in the MTU
+static const int    GENERATOR_IP_UDP_HEADERS = 20 + 8;
+// packets of a sendmmsg call
+static const int    GENERATOR_BATCH_SIZE     = 64;
+// socket send buffer (bytes)
+static const int    GENERATOR_SEND_BUFFER    = 8 * 1024 * 1024;
+// retry delay of a full send queue (in us)
+static const int    GENERATOR_RETRY_US       = 10;
+// polling period of the register server (in ms), the stop is seen after it
+static const int    SERVER_POLL_MS           = 100;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static uint32_t nextRandom(uint32_t& seed)
+{
+    seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+    return seed;
+}
+
+//-----------------------------------------------------
+// counting mode of the simulator giving the depth
+//-----------------------------------------------------
+static ufxclib::EnumAcquisitionMode getAcquisitionMode(int depth)
+{
+    switch(depth)
+    {
+        case 2 : return ufxclib::EnumAcquisitionMode::software_continuous_2_raw;
+        case 4 : return ufxclib::EnumAcquisitionMode::software_continuous_4_raw;
+        case 8 : return ufxclib::EnumAcquisitionMode::software_continuous_8_raw;
+        case 28: return ufxclib::EnumAcquisitionMode::software_long_counter_14_raw;
+        case 32: return ufxclib::EnumAcquisitionMode::pump_and_probe_2_raw;
+        default: return ufxclib::EnumAcquisitionMode::software_14_raw;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PacketGeneratorConfig::PacketGeneratorConfig() :
+model("SIMULATOR"),
+depth(14),
+mtu(9000),
+frame_rate(1000.0),
+nb_frames(0),
+loss(0.0),
+reorder_window(1),
+occupancy(0.02)
+{
+    for(int link = 0 ; link < PACKET_GENERATOR_NB_LINKS ; link++)
+    {
+        hosts[link] = "127.0.0.1";
+        ports[link] = 0;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void PacketGeneratorConfig::check() const
+{
+    DEB_MEMBER_FUNCT();
+
+    PacketFormat * format = PacketFormat::create(wire_format);
+
+    // the UFXC format is private to ufxclib, the format must be chosen knowingly
+    if(format == NULL)
+        THROW_HW_ERROR(InvalidValue) << "Unknown wire format \"" << wire_format << "\"!";
+
+    int payload_size = PacketGenerator::getMaxPayloadSize(mtu, *format);
+    delete format;
+
+    if(!DetectorSimulator::isSimulatorModel(model))
+        THROW_HW_ERROR(InvalidValue) << "Incorrect model " << model << ", should be a SIMULATOR label!";
+
+    if(!PixelUnpacker::isDepthSupported(depth))
+        THROW_HW_ERROR(InvalidValue) << "Incorrect depth: " << DEB_VAR1(depth);
+
+    if(payload_size <= 0)
+        THROW_HW_ERROR(InvalidValue) << "MTU too small: " << DEB_VAR1(mtu);
+
+    if(frame_rate <= 0.0)
+        THROW_HW_ERROR(InvalidValue) << "Incorrect frame rate: " << DEB_VAR1(frame_rate);
+
+    if((loss < 0.0) || (loss >= 1.0))
+        THROW_HW_ERROR(InvalidValue) << "Incorrect packet loss: " << DEB_VAR1(loss);
+
+    if(reorder_window < 1)
+        THROW_HW_ERROR(InvalidValue) << "Incorrect reorder window: " << DEB_VAR1(reorder_window);
+
+    if((occupancy < 0.0) || (occupancy > 1.0))
+        THROW_HW_ERROR(InvalidValue) << "Incorrect occupancy: " << DEB_VAR1(occupancy);
+
+    for(int link = 0 ; link < PACKET_GENERATOR_NB_LINKS ; link++)
+    {
+        if((ports[link] <= 0) || (ports[link] > 65535))
+            THROW_HW_ERROR(InvalidValue) << "Incorrect port of the SFP" << (link + 1) << ": " << ports[link];
+    }
+}
+
+/*******************************************************************
+ * \class PacketGenerator::LinkThread
+ * \brief thread sending the packets of a link
+ *******************************************************************/
+class PacketGenerator::LinkThread : public Thread
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "PacketGenerator::LinkThread", "Ufxc");
+
+public:
+    LinkThread(const PacketGeneratorConfig& config, int link);
+    virtual ~LinkThread();
+
+    void      stop();
+    bool      isRunning() const;
+    LinkStats getStats () const;
+
+protected:
+    virtual void threadFunction();
+
+private:
+    void sendFrame(std::vector<char>& packets, int packet_size, int nb_packets);
+
+    PacketGeneratorConfig    m_config    ;
+    PacketFormat *           m_format    ;
+    int                      m_link      ;
+    int                      m_socket    ;
+    uint32_t                 m_seed      ; // loss and reordering
+    std::vector<int>         m_order     ; // packets of a frame
+    std::vector<int>         m_sizes     ; // bytes of each packet, header included
+    std::vector<mmsghdr>     m_messages  ;
+    std::vector<iovec>       m_iovecs    ;
+    std::atomic<bool>        m_stop      ;
+    std::atomic<bool>        m_running   ;
+    std::atomic<std::size_t> m_nb_frames ;
+    std::atomic<std::size_t> m_nb_packets;
+    std::atomic<std::size_t> m_nb_dropped;
+    std::atomic<std::size_t> m_nb_bytes  ;
+    std::atomic<std::size_t> m_nb_errors ;
+};
+
+//-----------------------------------------------------
+// the socket is connected to the SFP address, sendmmsg needs no address
+//-----------------------------------------------------
+PacketGenerator::LinkThread::LinkThread(const PacketGeneratorConfig& config, int link) :
+m_config(config),
+m_format(NULL),
+m_link(link),
+m_socket(-1),
+m_seed(0x9e3779b9U + link),
+m_stop(false),
+m_running(true),
+m_nb_frames(0),
+m_nb_packets(0),
+m_nb_dropped(0),
+m_nb_bytes(0),
+m_nb_errors(0)
+{
+    DEB_CONSTRUCTOR();
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(static_cast<uint16_t>(config.ports[link]));
+
+    if(inet_pton(AF_INET, config.hosts[link].c_str(), &address.sin_addr) != 1)
+        THROW_HW_ERROR(InvalidValue) << "Incorrect address of the SFP" << (link + 1) << ": " << config.hosts[link];
+
+    m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(m_socket < 0)
+        THROW_HW_ERROR(Error) << "Can not create the socket of the SFP" << (link + 1) << ": " << strerror(errno);
+
+    // checked by the config
+    m_format = PacketFormat::create(config.wire_format);
+
+    int send_buffer = GENERATOR_SEND_BUFFER;
+
+    // a smaller buffer is only reported, the kernel limits it
+    if(setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer)) < 0)
+        DEB_WARNING() << "Can not set the send buffer of the SFP" << (link + 1) << ": " << strerror(errno);
+
+    if(connect(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        int error = errno;
+        close(m_socket);
+        delete m_format;
+        THROW_HW_ERROR(Error) << "Can not connect the socket of the SFP" << (link + 1) << ": " << strerror(error);
+    }
+
+    pthread_attr_setscope(&m_thread_attr, PTHREAD_SCOPE_PROCESS);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PacketGenerator::LinkThread::~LinkThread()
+{
+    DEB_DESTRUCTOR();
+
+    stop();
+    join();
+
+    if(m_socket >= 0)
+        close(m_socket);
+
+    delete m_format;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void PacketGenerator::LinkThread::stop()
+{
+    m_stop.store(true, std::memory_order_release);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool PacketGenerator::LinkThread::isRunning() const
+{
+    return m_running.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+LinkStats PacketGenerator::LinkThread::getStats() const
+{
+    LinkStats stats;
+
+    stats.nb_frames  = m_nb_frames .load(std::memory_order_relaxed);
+    stats.nb_packets = m_nb_packets.load(std::memory_order_relaxed);
+    stats.nb_dropped = m_nb_dropped.load(std::memory_order_relaxed);
+    stats.nb_bytes   = m_nb_bytes  .load(std::memory_order_relaxed);
+    stats.nb_errors  = m_nb_errors .load(std::memory_order_relaxed);
+    return stats;
+}
+
+//-----------------------------------------------------
+// the simulator gives the raw frames at the frame rate
+//-----------------------------------------------------
+void PacketGenerator::LinkThread::threadFunction()
+{
+    DEB_MEMBER_FUNCT();
+
+    try
+    {
+        DetectorSimulator      simulator;
+        ufxclib::DaqCnxConfig  cnx;
+
+        simulator.open_connection(m_config.model, cnx, cnx, cnx, cnx, m_config.mtu);
+        simulator.setOccupancy(m_config.occupancy);
+        simulator.set_geometrical_correction(false);
+        simulator.set_acq_mode(getAcquisitionMode(m_config.depth));
+        simulator.set_counting_time_ms(1000.0 / m_config.frame_rate);
+        simulator.set_waiting_time_ms(0.0);
+        simulator.set_pump_probe_frequency_Hz(m_config.frame_rate);
+        simulator.set_triggers_number(1);
+        simulator.set_images_number(m_config.nb_frames ? m_config.nb_frames : std::numeric_limits<std::size_t>::max());
+
+        int nb_pixels    = static_cast<int>(simulator.get_current_width() * simulator.get_current_height());
+        int frame_size   = PixelUnpacker::getPackedSize(m_config.depth, nb_pixels);
+        int payload_size = getMaxPayloadSize(m_config.mtu, *m_format);
+        int header_size  = m_format->getHeaderSize();
+        int packet_size  = header_size + payload_size;
+        int part_offset;
+        int part_size;
+
+        getLinkPart(frame_size, m_link, part_offset, part_size);
+
+        int nb_packets = (part_size + payload_size - 1) / payload_size;
+
+        if(nb_packets > m_format->getMaxNbPackets())
+            THROW_HW_ERROR(InvalidValue) << "Too many packets per frame: " << DEB_VAR1(nb_packets);
+
+        std::vector<char> frame  (frame_size);
+        std::vector<char> packets(static_cast<std::size_t>(nb_packets) * packet_size);
+
+        m_sizes   .resize(nb_packets);
+        m_order   .resize(nb_packets);
+        m_messages.resize(nb_packets);
+        m_iovecs  .resize(nb_packets);
+
+        simulator.start_acquisition();
+
+        while((!m_stop.load(std::memory_order_acquire)) && (!simulator.end_of_transfer()))
+        {
+            simulator.waiting_built_images();
+
+            while((!m_stop.load(std::memory_order_acquire)) && (simulator.get_built_images_nb()))
+            {
+                uint32_t frame_index = static_cast<uint32_t>(simulator.get_first_built_image_index());
+
+                if(!simulator.fill_raw_image_buffer(&frame[0], frame_size))
+                    break;
+
+                for(int index = 0 ; index < nb_packets ; index++)
+                {
+                    char *     packet = &packets[static_cast<std::size_t>(index) * packet_size];
+                    int        offset = index * payload_size;
+                    int        size   = std::min(payload_size, part_size - offset);
+                    PacketInfo info;
+
+                    info.frame_index  = frame_index;
+                    info.offset       = static_cast<uint32_t>(part_offset + offset);
+                    info.link         = m_link;
+                    info.packet_index = index;
+                    info.nb_packets   = nb_packets;
+                    info.payload_size = size;
+
+                    m_format->writeHeader(info, packet);
+                    memcpy(packet + header_size, &frame[part_offset + offset], size);
+                    m_sizes[index] = header_size + size;
+                }
+
+                sendFrame(packets, packet_size, nb_packets);
+                m_nb_frames.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        simulator.stop_acquisition();
+        simulator.close_connection();
+    }
+    catch(Exception& e)
+    {
+        DEB_ERROR() << "SFP" << (m_link + 1) << " generator stopped: " << e.getErrMsg();
+    }
+
+    m_running.store(false, std::memory_order_release);
+}
+
+//-----------------------------------------------------
+// the dropped packets are not sent, the others are shuffled by windows
+//-----------------------------------------------------
+void PacketGenerator::LinkThread::sendFrame(std::vector<char>& packets, int packet_size, int nb_packets)
+{
+    uint32_t loss_threshold = static_cast<uint32_t>(m_config.loss * 4294967295.0);
+    int      window         = m_config.reorder_window;
+    int      nb_messages    = 0;
+
+    for(int index = 0 ; index < nb_packets ; index++)
+        m_order[index] = index;
+
+    if(window > 1)
+    {
+        for(int first = 0 ; first < nb_packets ; first += window)
+        {
+            int size = std::min(window, nb_packets - first);
+
+            for(int index = size - 1 ; index > 0 ; index--)
+                std::swap(m_order[first + index], m_order[first + nextRandom(m_seed) % (index + 1)]);
+        }
+    }
+
+    for(int index = 0 ; index < nb_packets ; index++)
+    {
+        if((loss_threshold) && (nextRandom(m_seed) < loss_threshold))
+        {
+            m_nb_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        m_iovecs[nb_messages].iov_base = &packets[static_cast<std::size_t>(m_order[index]) * packet_size];
+        m_iovecs[nb_messages].iov_len  = m_sizes[m_order[index]];
+
+        memset(&m_messages[nb_messages], 0, sizeof(mmsghdr));
+        m_messages[nb_messages].msg_hdr.msg_iov    = &m_iovecs[nb_messages];
+        m_messages[nb_messages].msg_hdr.msg_iovlen = 1;
+        nb_messages++;
+    }
+
+    for(int first = 0 ; (first < nb_messages) && (!m_stop.load(std::memory_order_relaxed)) ; )
+    {
+        int nb_sent = sendmmsg(m_socket, &m_messages[first], std::min(GENERATOR_BATCH_SIZE, nb_messages - first), 0);
+
+        if(nb_sent < 0)
+        {
+            // full send queue: the rate is higher than the link
+            if((errno == EAGAIN) || (errno == ENOBUFS) || (errno == EINTR))
+            {
+                usleep(GENERATOR_RETRY_US);
+                continue;
+            }
+
+            // nobody listening (ICMP port unreachable) or other error: the packet is lost
+            m_nb_errors.fetch_add(1, std::memory_order_relaxed);
+            nb_sent = 1;
+        }
+        else
+        {
+            std::size_t nb_bytes = 0;
+
+            for(int index = first ; index < first + nb_sent ; index++)
+                nb_bytes += m_iovecs[index].iov_len;
+
+            m_nb_packets.fetch_add(nb_sent , std::memory_order_relaxed);
+            m_nb_bytes  .fetch_add(nb_bytes, std::memory_order_relaxed);
+        }
+
+        first += nb_sent;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PacketGenerator::PacketGenerator()
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+PacketGenerator::~PacketGenerator()
+{
+    DEB_DESTRUCTOR();
+    stop();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void PacketGenerator::start(const PacketGeneratorConfig& config)
+{
+    DEB_MEMBER_FUNCT();
+
+    config.check();
+    stop();
+
+    m_config = config;
+
+    try
+    {
+        for(int link = 0 ; link < PACKET_GENERATOR_NB_LINKS ; link++)
+            m_threads.push_back(new LinkThread(config, link));
+    }
+    catch(...)
+    {
+        stop();
+        throw;
+    }
+
+    for(std::size_t index = 0 ; index < m_threads.size() ; index++)
+        m_threads[index]->start();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void PacketGenerator::stop()
+{
+    for(std::size_t index = 0 ; index < m_threads.size() ; index++)
+        m_threads[index]->stop();
+
+    for(std::size_t index = 0 ; index < m_threads.size() ; index++)
+        delete m_threads[index];
+
+    m_threads.clear();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool PacketGenerator::isRunning() const
+{
+    for(std::size_t index = 0 ; index < m_threads.size() ; index++)
+    {
+        if(m_threads[index]->isRunning())
+            return true;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+LinkStats PacketGenerator::getLinkStats(int link) const
+{
+    DEB_MEMBER_FUNCT();
+
+    if((link < 0) || (link >= static_cast<int>(m_threads.size())))
+        THROW_HW_ERROR(InvalidValue) << "Incorrect link: " << DEB_VAR1(link);
+
+    return m_threads[link]->getStats();
+}
+
+//-----------------------------------------------------
+// thirds of the frame, aligned on 8 bytes
+//-----------------------------------------------------
+void PacketGenerator::getLinkPart(int frame_size, int link, int& offset, int& size)
+{
+    int part_size = ((frame_size / PACKET_GENERATOR_NB_LINKS) + 7) & ~7;
+
+    offset = std::min(link * part_size, frame_size);
+    size   = (link == PACKET_GENERATOR_NB_LINKS - 1) ? frame_size - offset : std::min(part_size, frame_size - offset);
+}
+
+//-----------------------------------------------------
+// aligned on 8 bytes
+//-----------------------------------------------------
+int PacketGenerator::getMaxPayloadSize(unsigned long mtu, const PacketFormat& format)
+{
+    long payload_size = static_cast<long>(mtu) - GENERATOR_IP_UDP_HEADERS - format.getHeaderSize();
+
+    payload_size = std::min(payload_size, static_cast<long>(format.getMaxPayloadSize()));
+    return static_cast<int>(payload_size & ~7L);
+}
+
+/*******************************************************************
+ * \class RegisterServer::ServerThread
+ * \brief thread of the register server
+ *******************************************************************/
+class RegisterServer::ServerThread : public Thread
+{
+public:
+    ServerThread(RegisterServer& server) : m_server(server)
+    {
+        pthread_attr_setscope(&m_thread_attr, PTHREAD_SCOPE_PROCESS);
+    }
+
+    virtual ~ServerThread()
+    {
+        join();
+    }
+
+protected:
+    virtual void threadFunction()
+    {
+        m_server.serve();
+    }
+
+private:
+    RegisterServer& m_server;
+};
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+RegisterServer::RegisterServer() :
+m_socket(-1),
+m_thread(NULL),
+m_protocol(NULL),
+m_stop(false),
+m_nb_requests(0)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+RegisterServer::~RegisterServer()
+{
+    DEB_DESTRUCTOR();
+    stop();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterServer::start(int port, const std::string& protocol)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR2(port, protocol);
+
+    stop();
+
+    m_protocol = RegisterProtocol::create(protocol);
+
+    // the DAQ protocol is private to ufxclib, the protocol must be chosen knowingly
+    if(m_protocol == NULL)
+        THROW_HW_ERROR(InvalidValue) << "Unknown register protocol \"" << protocol << "\"!";
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+
+    if(m_socket < 0)
+        THROW_HW_ERROR(Error) << "Can not create the register server socket: " << strerror(errno);
+
+    int reuse = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if((bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) || (listen(m_socket, 1) < 0))
+    {
+        int error = errno;
+        close(m_socket);
+        m_socket = -1;
+        THROW_HW_ERROR(Error) << "Can not listen on the register port " << port << ": " << strerror(error);
+    }
+
+    m_stop.store(false, std::memory_order_release);
+    m_thread = new ServerThread(*this);
+    m_thread->start();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void RegisterServer::stop()
+{
+    m_stop.store(true, std::memory_order_release);
+
+    if(m_thread != NULL)
+    {
+        delete m_thread;
+        m_thread = NULL;
+    }
+
+    if(m_socket >= 0)
+    {
+        close(m_socket);
+        m_socket = -1;
+    }
+
+    delete m_protocol;
+    m_protocol = NULL;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::size_t RegisterServer::getNbRequests() const
+{
+    return m_nb_requests.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------
+// one client at a time, the stop is checked at each poll
+//-----------------------------------------------------
+void RegisterServer::serve()
+{
+    DEB_MEMBER_FUNCT();
+
+    while(!m_stop.load(std::memory_order_acquire))
+    {
+        pollfd listen_poll = { m_socket, POLLIN, 0 };
+
+        if(poll(&listen_poll, 1, SERVER_POLL_MS) <= 0)
+            continue;
+
+        int client = accept(m_socket, NULL, NULL);
+
+        if(client < 0)
+            continue;
+
+        DEB_TRACE() << "register client connected";
+
+        std::string pending;
+        char        buffer[4096];
+
+        while(!m_stop.load(std::memory_order_acquire))
+        {
+            pollfd client_poll = { client, POLLIN, 0 };
+
+            if(poll(&client_poll, 1, SERVER_POLL_MS) <= 0)
+                continue;
+
+            ssize_t size = recv(client, buffer, sizeof(buffer), 0);
+
+            if(size <= 0)
+                break;
+
+            pending.append(buffer, size);
+
+            std::string request;
+
+            while(m_protocol->nextRequest(pending, request))
+            {
+                std::string reply = execute(request);
+                send(client, reply.c_str(), reply.size(), MSG_NOSIGNAL);
+            }
+        }
+
+        close(client);
+        DEB_TRACE() << "register client disconnected";
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::string RegisterServer::execute(const std::string& request)
+{
+    m_nb_requests.fetch_add(1, std::memory_order_relaxed);
+
+    AutoMutex aLock(m_mutex);
+    return m_protocol->execute(request, m_registers);
+}
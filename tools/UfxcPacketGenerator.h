@@ -0,0 +1,154 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcPacketGenerator.h
+
+#ifndef UFXCPACKETGENERATOR_H_
+#define UFXCPACKETGENERATOR_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+#include "UfxcWireFormat.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+static const int PACKET_GENERATOR_NB_LINKS = 3; // SFP1, SFP2, SFP3
+
+/*******************************************************************
+ * \struct PacketGeneratorConfig
+ * \brief streams of the generator
+ *
+ * Each link sends a third of the raw frame (bit stream of the counting
+ * mode), cut in packets of the MTU with the header of the wire format.
+ *******************************************************************/
+struct PacketGeneratorConfig
+{
+    std::string   wire_format                        ; // PacketFormat name, no default
+    std::string   model                              ; // SIMULATOR label: image size
+    int           depth                              ; // 2, 4, 8, 14, 28 or 32 bits
+    std::string   hosts[PACKET_GENERATOR_NB_LINKS]   ;
+    int           ports[PACKET_GENERATOR_NB_LINKS]   ;
+    unsigned long mtu                                ; // bytes, IP and UDP headers included
+    double        frame_rate                         ; // frames per second
+    std::size_t   nb_frames                          ; // 0: until stopped
+    double        loss                               ; // probability of a dropped packet
+    int           reorder_window                     ; // packets shuffled together, 1: in order
+    double        occupancy                          ; // fraction of the pixels with counts
+
+    PacketGeneratorConfig();
+
+    void check() const;
+};
+
+/*******************************************************************
+ * \struct LinkStats
+ * \brief counters of a link, read while sending
+ *******************************************************************/
+struct LinkStats
+{
+    std::size_t nb_frames ;
+    std::size_t nb_packets;
+    std::size_t nb_dropped; // by the configured loss
+    std::size_t nb_bytes  ; // UDP payloads (headers included)
+    std::size_t nb_errors ; // failed sends
+};
+
+/*******************************************************************
+ * \class PacketGenerator
+ * \brief sends the frames of the detector simulator as UDP packets
+ *
+ * One thread per link, each with its own simulator (same patterns),
+ * sends its third of the frames at the frame rate. The packets of a
+ * frame are sent by batches of sendmmsg. The packets are only
+ * understood by a receiver of the chosen wire format (PacketFormat).
+ *******************************************************************/
+class PacketGenerator
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "PacketGenerator", "Ufxc");
+
+public:
+    PacketGenerator();
+    ~PacketGenerator();
+
+    void start(const PacketGeneratorConfig& config);
+    void stop ();
+    bool isRunning() const; // false when all the frames are sent
+
+    LinkStats getLinkStats(int link) const;
+
+    // part of the raw frame sent by a link
+    static void getLinkPart(int frame_size, int link, int& offset, int& size);
+    static int  getMaxPayloadSize(unsigned long mtu, const PacketFormat& format);
+
+private:
+    class LinkThread;
+
+    PacketGeneratorConfig     m_config ;
+    std::vector<LinkThread *> m_threads;
+};
+
+/*******************************************************************
+ * \class RegisterServer
+ * \brief minimal register server on the TCP configuration port
+ *
+ * One client at a time, requests of the chosen RegisterProtocol.
+ *******************************************************************/
+class RegisterServer
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "RegisterServer", "Ufxc");
+
+public:
+    RegisterServer();
+    ~RegisterServer();
+
+    void start(int port, const std::string& protocol);
+    void stop ();
+
+    std::size_t getNbRequests() const;
+
+private:
+    class ServerThread;
+
+    void        serve  ();
+    std::string execute(const std::string& request);
+
+    int                                m_socket     ;
+    ServerThread *                     m_thread     ;
+    RegisterProtocol *                 m_protocol   ;
+    std::atomic<bool>                  m_stop       ;
+    std::atomic<std::size_t>           m_nb_requests;
+    RegisterProtocol::Registers        m_registers  ;
+    mutable Mutex                      m_mutex      ; // registers
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCPACKETGENERATOR_H_ */
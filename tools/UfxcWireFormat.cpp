@@ -0,0 +1,188 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <string.h>
+#include <limits>
+#include <sstream>
+#include "UfxcWireFormat.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+// names given to --wire-format and --register-protocol
+static const char * STAND_IN_NAME = "stand-in";
+
+/*******************************************************************
+ * \struct StandInHeader
+ * \brief header of the stand-in packets (little-endian)
+ *******************************************************************/
+struct StandInHeader
+{
+    uint32_t magic        ;
+    uint32_t frame_index  ;
+    uint32_t offset       ;
+    uint16_t link         ;
+    uint16_t packet_index ;
+    uint16_t nb_packets   ;
+    uint16_t payload_size ;
+} __attribute__((packed));
+
+//-----------------------------------------------------
+// the real UFXC format will be added here when documented
+//-----------------------------------------------------
+PacketFormat * PacketFormat::create(const std::string& name)
+{
+    if(name == STAND_IN_NAME)
+        return new StandInPacketFormat();
+
+    return NULL;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::vector<std::string> PacketFormat::getNames()
+{
+    return std::vector<std::string>(1, STAND_IN_NAME);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+RegisterProtocol * RegisterProtocol::create(const std::string& name)
+{
+    if(name == STAND_IN_NAME)
+        return new StandInRegisterProtocol();
+
+    return NULL;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::vector<std::string> RegisterProtocol::getNames()
+{
+    return std::vector<std::string>(1, STAND_IN_NAME);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::string StandInPacketFormat::getName() const
+{
+    return STAND_IN_NAME;
+}
+
+int StandInPacketFormat::getHeaderSize() const
+{
+    return static_cast<int>(sizeof(StandInHeader));
+}
+
+int StandInPacketFormat::getMaxPayloadSize() const
+{
+    return std::numeric_limits<uint16_t>::max();
+}
+
+int StandInPacketFormat::getMaxNbPackets() const
+{
+    return std::numeric_limits<uint16_t>::max();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void StandInPacketFormat::writeHeader(const PacketInfo& info, char * packet) const
+{
+    StandInHeader header;
+
+    header.magic        = MAGIC;
+    header.frame_index  = info.frame_index;
+    header.offset       = info.offset;
+    header.link         = static_cast<uint16_t>(info.link);
+    header.packet_index = static_cast<uint16_t>(info.packet_index);
+    header.nb_packets   = static_cast<uint16_t>(info.nb_packets);
+    header.payload_size = static_cast<uint16_t>(info.payload_size);
+
+    memcpy(packet, &header, sizeof(header));
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::string StandInRegisterProtocol::getName() const
+{
+    return STAND_IN_NAME;
+}
+
+//-----------------------------------------------------
+// one request per line
+//-----------------------------------------------------
+bool StandInRegisterProtocol::nextRequest(std::string& received, std::string& request) const
+{
+    std::size_t end = received.find('\n');
+
+    if(end == std::string::npos)
+        return false;
+
+    request = received.substr(0, end);
+    received.erase(0, end + 1);
+
+    if((!request.empty()) && (request[request.size() - 1] == '\r'))
+        request.erase(request.size() - 1);
+
+    return true;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+std::string StandInRegisterProtocol::execute(const std::string& request, Registers& registers) const
+{
+    std::istringstream stream(request);
+    std::string        command;
+    std::string        name;
+
+    stream >> command >> name;
+
+    if(name.empty())
+        return "ERROR missing register name\n";
+
+    if(command == "WRITE")
+    {
+        std::string value;
+        std::getline(stream >> std::ws, value);
+        registers[name] = value;
+        return "OK\n";
+    }
+
+    if(command == "READ")
+    {
+        Registers::const_iterator found = registers.find(name);
+
+        if(found == registers.end())
+            return "ERROR unknown register " + name + "\n";
+
+        return found->second + "\n";
+    }
+
+    return "ERROR unknown command " + command + "\n";
+}
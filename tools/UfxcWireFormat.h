@@ -0,0 +1,144 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2011
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// UfxcWireFormat.h
+
+#ifndef UFXCWIREFORMAT_H_
+#define UFXCWIREFORMAT_H_
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Ufxc
+{
+
+/*******************************************************************
+ * \struct PacketInfo
+ * \brief position of a packet payload in the raw frame
+ *******************************************************************/
+struct PacketInfo
+{
+    uint32_t frame_index ;
+    uint32_t offset      ; // bytes, in the whole raw frame
+    int      link        ; // 0 to 2
+    int      packet_index; // in the frame part of the link
+    int      nb_packets  ; // of the frame part of the link
+    int      payload_size; // bytes
+};
+
+/*******************************************************************
+ * \class PacketFormat
+ * \brief header of the UDP packets sent on the SFP links
+ *
+ * The UFXC packet format is private to ufxclib and the firmware: the
+ * generator only knows the formats registered in create(). A format
+ * must be chosen explicitly, there is no default one.
+ *******************************************************************/
+class PacketFormat
+{
+public:
+    virtual ~PacketFormat() {}
+
+    virtual std::string getName() const = 0;
+    virtual int  getHeaderSize() const = 0; // bytes before the payload
+    virtual int  getMaxPayloadSize() const = 0; // limit of the header fields
+    virtual int  getMaxNbPackets() const = 0; // per frame part of a link
+    virtual void writeHeader(const PacketInfo& info, char * packet) const = 0;
+
+    // NULL if the name is unknown
+    static PacketFormat * create(const std::string& name);
+    static std::vector<std::string> getNames();
+};
+
+/*******************************************************************
+ * \class RegisterProtocol
+ * \brief requests of the TCP configuration port
+ *
+ * The DAQ register protocol is private to ufxclib like the packets:
+ * same registration rule as PacketFormat.
+ *******************************************************************/
+class RegisterProtocol
+{
+public:
+    typedef std::map<std::string, std::string> Registers;
+
+    virtual ~RegisterProtocol() {}
+
+    virtual std::string getName() const = 0;
+
+    // takes a complete request from the received bytes, false if incomplete
+    virtual bool nextRequest(std::string& received, std::string& request) const = 0;
+    // reply with its terminator
+    virtual std::string execute(const std::string& request, Registers& registers) const = 0;
+
+    // NULL if the name is unknown
+    static RegisterProtocol * create(const std::string& name);
+    static std::vector<std::string> getNames();
+};
+
+/*******************************************************************
+ * \class StandInPacketFormat
+ * \brief "stand-in" packets: a header defined by this tool
+ *
+ * NOT the UFXC wire format: ufxclib does not receive these packets.
+ * Only for the tests of the network path (rates, losses, reordering)
+ * with a receiver of this header (little-endian):
+ *   magic (u32) "UFXC", frame_index (u32), offset (u32), link (u16),
+ *   packet_index (u16), nb_packets (u16), payload_size (u16)
+ *******************************************************************/
+class StandInPacketFormat : public PacketFormat
+{
+public:
+    static const uint32_t MAGIC = 0x43584655; // "UFXC"
+
+    virtual std::string getName() const;
+    virtual int  getHeaderSize() const;
+    virtual int  getMaxPayloadSize() const;
+    virtual int  getMaxNbPackets() const;
+    virtual void writeHeader(const PacketInfo& info, char * packet) const;
+};
+
+/*******************************************************************
+ * \class StandInRegisterProtocol
+ * \brief "stand-in" register protocol: text lines defined by this tool
+ *
+ * NOT the DAQ register protocol, ufxclib can not configure through it:
+ *   WRITE <name> <value>  ->  OK
+ *   READ <name>           ->  <value> or ERROR <reason>
+ *******************************************************************/
+class StandInRegisterProtocol : public RegisterProtocol
+{
+public:
+    virtual std::string getName() const;
+    virtual bool nextRequest(std::string& received, std::string& request) const;
+    virtual std::string execute(const std::string& request, Registers& registers) const;
+};
+
+} // namespace Ufxc
+} // namespace lima
+
+#endif /* UFXCWIREFORMAT_H_ */
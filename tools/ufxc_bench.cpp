@@ -0,0 +1,619 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// ufxc_bench: end-to-end throughput of the plugin with the detector
+// simulator, for a sweep of configurations. The results are written
+// as JSON.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <math.h>
+#include <atomic>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lima/Exceptions.h"
+#include "lima/Timestamp.h"
+#include "lima/HwFrameCallback.h"
+#include "UfxcCamera.h"
+#include "UfxcInterface.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+#define BENCH_STRING(x)  #x
+#define BENCH_XSTRING(x) BENCH_STRING(x)
+
+// time given to an acquisition after its expected end (in s)
+static const double BENCH_EXTRA_TIME_S   = 10.0;
+// time given to the camera to come back to Ready (in s)
+static const double BENCH_READY_TIMEOUT_S= 5.0;
+// polling period of the bench (in us)
+static const int    BENCH_POLL_US        = 1000;
+
+/*******************************************************************
+ * counting modes of the sweep: labels of the Camera and pixel types
+ *******************************************************************/
+struct BenchMode
+{
+    const char *          label      ;
+    const char *          short_label;
+    Camera::CountingModes mode       ;
+    int                   depth      ;
+    ImageType             type       ;
+};
+
+static const BenchMode BENCH_MODES[] =
+{
+    { "CONTINUOUS_2"   , "C2" , Camera::Continuous_2  , 2 , Bpp2  },
+    { "CONTINUOUS_4"   , "C4" , Camera::Continuous_4  , 4 , Bpp4  },
+    { "CONTINUOUS_8"   , "C8" , Camera::Continuous_8  , 8 , Bpp8  },
+    { "CONTINUOUS_14"  , "C14", Camera::Continuous_14 , 14, Bpp14 },
+    { "STANDARD_14"    , "S14", Camera::Standard_14   , 14, Bpp14 },
+    { "LONG_COUNTER_28", "L28", Camera::LongCounter_28, 28, Bpp28 },
+};
+
+/*******************************************************************
+ * \struct BenchConfig
+ * \brief one configuration of the sweep
+ *******************************************************************/
+struct BenchConfig
+{
+    std::string       model          ;
+    const BenchMode * mode           ;
+    bool              correction     ;
+    int               nb_buffers     ;
+    double            delay_ms       ; // consumer time of a frame
+    int               nb_frames      ;
+    double            exposure_ms    ;
+};
+
+/*******************************************************************
+ * \struct BenchResult
+ *******************************************************************/
+struct BenchResult
+{
+    Size        image_size     ;
+    double      frame_mem_size ; // bytes
+    int         nb_received    ;
+    double      elapsed        ; // s, start to the last frame
+    double      frames_per_s   ;
+    double      mb_per_s       ;
+    double      latency_p50_ms ;
+    double      latency_p99_ms ;
+    double      latency_max_ms ;
+    int         nb_lost        ; // plugin: missing hardware frames
+    int         nb_dropped     ; // plugin: frames not given to Lima
+    int         nb_overruns    ; // consumer: buffers overwritten before being read
+    bool        timeout        ;
+    std::string error          ;
+};
+
+/*******************************************************************
+ * \class FrameRecorder
+ * \brief latency of the frames given by the plugin to Lima
+ *
+ * The latency is the time between the end of the frame in the
+ * simulator (start + (n + 1) x period, with the start and the period
+ * of the simulated acquisition) and its newFrameReady.
+ *******************************************************************/
+class FrameRecorder : public HwFrameCallback
+{
+public:
+    FrameRecorder() : m_nb_published(0), m_last_time(0.0) {}
+
+    void reset(int nb_frames, double start)
+    {
+        m_ready_times.assign(nb_frames, 0.0);
+        m_last_time = start;
+        m_nb_published.store(0, std::memory_order_release);
+    }
+
+    int    getNbPublished() const { return m_nb_published.load(std::memory_order_acquire); }
+    double getLastTime   () const { return m_last_time; }
+
+    // latencies of the published frames, after the acquisition
+    void getLatencies(double start, double period, std::vector<double>& latencies) const
+    {
+        int nb_published = getNbPublished();
+
+        latencies.resize(nb_published);
+
+        for(int frame = 0 ; frame < nb_published ; frame++)
+            latencies[frame] = m_ready_times[frame] - (start + (frame + 1) * period);
+    }
+
+protected:
+    // the publisher gives the frames in the acquisition order
+    virtual bool newFrameReady(const HwFrameInfoType& frame_info)
+    {
+        double now   = Timestamp::now();
+        int    frame = frame_info.acq_frame_nb;
+
+        if((frame >= 0) && (frame < static_cast<int>(m_ready_times.size())))
+        {
+            m_ready_times[frame] = now;
+            m_last_time          = now;
+            m_nb_published.store(frame + 1, std::memory_order_release);
+        }
+
+        return true;
+    }
+
+private:
+    std::vector<double> m_ready_times ; // newFrameReady of each frame
+    std::atomic<int>    m_nb_published;
+    double              m_last_time   ;
+};
+
+/*******************************************************************
+ * \class SlowConsumer
+ * \brief reads the Lima frames in order, with a delay per frame
+ *
+ * Like the Lima control, a frame whose buffer is reused before it is
+ * read is an overrun.
+ *******************************************************************/
+class SlowConsumer : public Thread
+{
+public:
+    SlowConsumer(const FrameRecorder& recorder, int nb_frames, int nb_buffers, double delay_ms) :
+    m_recorder(recorder), m_nb_frames(nb_frames), m_nb_buffers(nb_buffers), m_delay_ms(delay_ms),
+    m_nb_overruns(0), m_stop(false)
+    {
+        pthread_attr_setscope(&m_thread_attr, PTHREAD_SCOPE_PROCESS);
+    }
+
+    virtual ~SlowConsumer()
+    {
+        stop();
+        join();
+    }
+
+    void stop          ()       { m_stop.store(true, std::memory_order_release); }
+    int  getNbOverruns () const { return m_nb_overruns.load(std::memory_order_acquire); }
+
+protected:
+    virtual void threadFunction()
+    {
+        for(int frame = 0 ; frame < m_nb_frames ; frame++)
+        {
+            while((m_recorder.getNbPublished() <= frame) && (!m_stop.load(std::memory_order_acquire)))
+                usleep(BENCH_POLL_US / 10);
+
+            if(m_recorder.getNbPublished() <= frame)
+                break;
+
+            // the buffer of this frame is reused by the frame + nb buffers
+            if(m_recorder.getNbPublished() > frame + m_nb_buffers)
+            {
+                m_nb_overruns.fetch_add(1, std::memory_order_release);
+                continue;
+            }
+
+            if(m_delay_ms > 0.0)
+                usleep(static_cast<useconds_t>(m_delay_ms * 1000.0));
+        }
+    }
+
+private:
+    const FrameRecorder& m_recorder   ;
+    int                  m_nb_frames  ;
+    int                  m_nb_buffers ;
+    double               m_delay_ms   ;
+    std::atomic<int>     m_nb_overruns;
+    std::atomic<bool>    m_stop       ;
+};
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static const BenchMode * findMode(const std::string& label)
+{
+    for(std::size_t index = 0 ; index < sizeof(BENCH_MODES) / sizeof(BENCH_MODES[0]) ; index++)
+    {
+        if((label == BENCH_MODES[index].label) || (label == BENCH_MODES[index].short_label))
+            return &BENCH_MODES[index];
+    }
+
+    return NULL;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static std::vector<std::string> splitList(const std::string& text)
+{
+    std::vector<std::string> items;
+    std::istringstream       stream(text);
+    std::string              item;
+
+    while(std::getline(stream, item, ','))
+    {
+        if(!item.empty())
+            items.push_back(item);
+    }
+
+    return items;
+}
+
+//-----------------------------------------------------
+// nearest rank
+//-----------------------------------------------------
+static double getPercentile(const std::vector<double>& sorted, double percentile)
+{
+    if(sorted.empty())
+        return 0.0;
+
+    std::size_t rank = static_cast<std::size_t>(ceil(percentile * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank ? rank - 1 : 0)];
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void waitReady(Camera& camera)
+{
+    double         deadline = double(Timestamp::now()) + BENCH_READY_TIMEOUT_S;
+    Camera::Status status;
+
+    camera.getStatus(status);
+
+    while((status == Camera::Busy) && (double(Timestamp::now()) < deadline))
+    {
+        usleep(BENCH_POLL_US);
+        camera.getStatus(status);
+    }
+}
+
+//-----------------------------------------------------
+// one acquisition of the configuration
+//-----------------------------------------------------
+static void runConfig(Interface& hw, Camera& camera, const BenchConfig& config, BenchResult& result)
+{
+    HwBufferCtrlObj * buffer;
+    FrameRecorder     recorder;
+
+    hw.getHwCtrlObj(buffer);
+
+    camera.setImageType(config.mode->type);
+    camera.setCountingMode(config.mode->mode);
+    camera.setGeometricalCorrection(config.correction);
+    camera.setTrigMode(IntTrig);
+    camera.setExpTime(config.exposure_ms * 1e-3);
+    camera.setLatTime(0.0);
+    camera.setNbFrames(config.nb_frames);
+
+    ImageType image_type;
+    camera.getDetectorImageSize(result.image_size);
+    camera.getImageType(image_type);
+
+    FrameDim frame_dim(result.image_size, image_type);
+    result.frame_mem_size = frame_dim.getMemSize();
+
+    buffer->setFrameDim(frame_dim);
+    buffer->setNbConcatFrames(1);
+    buffer->setNbBuffers(config.nb_buffers);
+    buffer->registerFrameCallback(recorder);
+
+    try
+    {
+        hw.prepareAcq();
+
+        double start = Timestamp::now();
+        recorder.reset(config.nb_frames, start);
+
+        SlowConsumer consumer(recorder, config.nb_frames, config.nb_buffers, config.delay_ms);
+        consumer.start();
+        hw.startAcq();
+
+        double deadline = start + config.nb_frames * config.exposure_ms * 2e-3 + BENCH_EXTRA_TIME_S;
+
+        while((recorder.getNbPublished() < config.nb_frames) && (double(Timestamp::now()) < deadline))
+            usleep(BENCH_POLL_US);
+
+        result.timeout = (recorder.getNbPublished() < config.nb_frames);
+
+        if(result.timeout)
+        {
+            hw.stopAcq();
+            consumer.stop();
+        }
+
+        waitReady(camera);
+        consumer.join();
+
+        // the simulated frames are timed from the start of the simulator, after the DAQ transactions of startAcq
+        double sim_start;
+        double sim_period;
+        camera.getSimulatorAcquisitionTiming(sim_start, sim_period);
+
+        result.nb_received  = recorder.getNbPublished();
+        result.elapsed      = std::max(0.0, recorder.getLastTime() - sim_start);
+        result.frames_per_s = (result.elapsed > 0.0) ? result.nb_received / result.elapsed : 0.0;
+        result.mb_per_s     = result.frames_per_s * result.frame_mem_size / (1024.0 * 1024.0);
+        result.nb_overruns  = consumer.getNbOverruns();
+
+        std::vector<double> latencies;
+        recorder.getLatencies(sim_start, sim_period, latencies);
+        std::sort(latencies.begin(), latencies.end());
+
+        result.latency_p50_ms = getPercentile(latencies, 0.50) * 1e3;
+        result.latency_p99_ms = getPercentile(latencies, 0.99) * 1e3;
+        result.latency_max_ms = latencies.empty() ? 0.0 : latencies.back() * 1e3;
+
+        camera.getNbLostFrames   (result.nb_lost   );
+        camera.getNbDroppedFrames(result.nb_dropped);
+    }
+    catch(...)
+    {
+        buffer->unregisterFrameCallback(recorder);
+        throw;
+    }
+
+    buffer->unregisterFrameCallback(recorder);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static std::string getHostName()
+{
+    char name[256];
+
+    if(gethostname(name, sizeof(name)) != 0)
+        return "unknown";
+
+    name[sizeof(name) - 1] = '\0';
+    return name;
+}
+
+//-----------------------------------------------------
+// the labels and messages have no control characters
+//-----------------------------------------------------
+static std::string quote(const std::string& text)
+{
+    std::string quoted("\"");
+
+    for(std::size_t index = 0 ; index < text.size() ; index++)
+    {
+        char character = text[index];
+
+        if((character == '"') || (character == '\\'))
+            quoted += '\\';
+
+        quoted += ((character == '\n') || (character == '\r')) ? ' ' : character;
+    }
+
+    return quoted + "\"";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void writeResult(std::ostream& out, const BenchConfig& config, const BenchResult& result)
+{
+    out << "    {\"model\": "                  << quote(config.model)
+        << ", \"counting_mode\": "             << quote(config.mode->label)
+        << ", \"geometrical_correction\": "    << (config.correction ? "true" : "false")
+        << ", \"nb_buffers\": "                << config.nb_buffers
+        << ", \"consumer_delay_ms\": "         << config.delay_ms
+        << ", \"nb_frames\": "                 << config.nb_frames
+        << ", \"exposure_time_ms\": "          << config.exposure_ms
+        << ",\n     \"width\": "               << result.image_size.getWidth()
+        << ", \"height\": "                    << result.image_size.getHeight()
+        << ", \"frame_bytes\": "               << result.frame_mem_size
+        << ", \"received_frames\": "           << result.nb_received
+        << ", \"frames_per_s\": "              << result.frames_per_s
+        << ", \"mb_per_s\": "                  << result.mb_per_s
+        << ",\n     \"latency_ms\": {\"p50\": " << result.latency_p50_ms
+        << ", \"p99\": "                       << result.latency_p99_ms
+        << ", \"max\": "                       << result.latency_max_ms << "}"
+        << ", \"lost_frames\": "               << result.nb_lost
+        << ", \"dropped_frames\": "            << result.nb_dropped
+        << ", \"overrun_frames\": "            << result.nb_overruns
+        << ", \"timeout\": "                   << (result.timeout ? "true" : "false")
+        << ", \"error\": "                     << (result.error.empty() ? std::string("null") : quote(result.error))
+        << "}";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void usage(const char * program)
+{
+    fprintf(stderr,
+            "usage: %s [options], the lists are comma separated\n"
+            "  --models <list>       SIMULATOR labels (default: SIMULATOR,SIMULATOR_512x512)\n"
+            "  --modes <list>        counting modes C2, C4, C8, C14, S14, L28 (default: C2,C8,S14,L28)\n"
+            "  --corrections <list>  geometrical correction 0/1 (default: 0,1)\n"
+            "  --buffers <list>      Lima buffers numbers (default: 16,128)\n"
+            "  --delays <list>       consumer time of a frame in ms (default: 0,0.1)\n"
+            "  --frames <nb>         frames of an acquisition (default: 2000)\n"
+            "  --exposure <ms>       exposure time of the simulator (default: 0.05)\n"
+            "  --workers <nb>        fill workers of the pipeline (default: plugin default)\n"
+            "  --output <file>       JSON results (default: standard output)\n",
+            program);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int main(int argc, char ** argv)
+{
+    static const struct option options[] =
+    {
+        { "models"     , required_argument, NULL, 'm' },
+        { "modes"      , required_argument, NULL, 'c' },
+        { "corrections", required_argument, NULL, 'g' },
+        { "buffers"    , required_argument, NULL, 'b' },
+        { "delays"     , required_argument, NULL, 'd' },
+        { "frames"     , required_argument, NULL, 'n' },
+        { "exposure"   , required_argument, NULL, 'e' },
+        { "workers"    , required_argument, NULL, 'w' },
+        { "output"     , required_argument, NULL, 'o' },
+        { "help"       , no_argument      , NULL, 'h' },
+        { NULL         , 0                , NULL, 0   }
+    };
+
+    std::vector<std::string> models      = splitList("SIMULATOR,SIMULATOR_512x512");
+    std::vector<std::string> modes       = splitList("C2,C8,S14,L28");
+    std::vector<std::string> corrections = splitList("0,1");
+    std::vector<std::string> buffers     = splitList("16,128");
+    std::vector<std::string> delays      = splitList("0,0.1");
+    int                      nb_frames   = 2000;
+    double                   exposure_ms = 0.05;
+    int                      nb_workers  = 0;
+    std::string              output;
+    int                      option;
+
+    while((option = getopt_long(argc, argv, "h", options, NULL)) != -1)
+    {
+        switch(option)
+        {
+            case 'm': models      = splitList(optarg); break;
+            case 'c': modes       = splitList(optarg); break;
+            case 'g': corrections = splitList(optarg); break;
+            case 'b': buffers     = splitList(optarg); break;
+            case 'd': delays      = splitList(optarg); break;
+            case 'n': nb_frames   = atoi(optarg); break;
+            case 'e': exposure_ms = atof(optarg); break;
+            case 'w': nb_workers  = atoi(optarg); break;
+            case 'o': output      = optarg; break;
+            default : usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    if((nb_frames <= 0) || (exposure_ms <= 0.0))
+    {
+        fprintf(stderr, "Incorrect frames number or exposure time\n");
+        return 1;
+    }
+
+    for(std::size_t index = 0 ; index < modes.size() ; index++)
+    {
+        if(findMode(modes[index]) == NULL)
+        {
+            // the pump-probe-probe mode gives one frame per acquisition
+            fprintf(stderr, "Incorrect counting mode for the bench: %s\n", modes[index].c_str());
+            return 1;
+        }
+    }
+
+    std::ofstream file;
+
+    if(!output.empty())
+    {
+        file.open(output.c_str());
+
+        if(!file)
+        {
+            fprintf(stderr, "Can not write %s\n", output.c_str());
+            return 1;
+        }
+    }
+
+    std::ostream& out = output.empty() ? std::cout : file;
+    time_t        now = time(NULL);
+    char          date[32];
+
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    out << "{\"host\": " << quote(getHostName()) << ", \"plugin_version\": " << quote(BENCH_XSTRING(UFXC_VERSION))
+        << ", \"date\": " << quote(date) << ",\n \"results\": [\n";
+
+    bool first_result = true;
+
+    for(std::size_t model = 0 ; model < models.size() ; model++)
+    {
+        const BenchMode * first_mode = findMode(modes[0]);
+        Camera *          camera     = NULL;
+        Interface *       hw         = NULL;
+
+        try
+        {
+            // the simulator has no network links
+            camera = new Camera(models[model], "127.0.0.1", 0, "127.0.0.1", 0, "127.0.0.1", 0, "127.0.0.1", 0,
+                                9000, 1000, first_mode->depth, first_mode->label);
+            hw     = new Interface(*camera);
+
+            if(nb_workers > 0)
+                camera->setNbFillWorkers(nb_workers);
+        }
+        catch(Exception& e)
+        {
+            fprintf(stderr, "Can not create the camera %s: %s\n", models[model].c_str(), e.getErrMsg().c_str());
+            delete camera;
+            return 1;
+        }
+
+        for(std::size_t mode = 0 ; mode < modes.size() ; mode++)
+        for(std::size_t correction = 0 ; correction < corrections.size() ; correction++)
+        for(std::size_t buffer = 0 ; buffer < buffers.size() ; buffer++)
+        for(std::size_t delay = 0 ; delay < delays.size() ; delay++)
+        {
+            BenchConfig config;
+            BenchResult result = BenchResult();
+
+            config.model       = models[model];
+            config.mode        = findMode(modes[mode]);
+            config.correction  = atoi(corrections[correction].c_str()) != 0;
+            config.nb_buffers  = std::max(1, atoi(buffers[buffer].c_str()));
+            config.delay_ms    = atof(delays[delay].c_str());
+            config.nb_frames   = nb_frames;
+            config.exposure_ms = exposure_ms;
+
+            try
+            {
+                runConfig(*hw, *camera, config, result);
+            }
+            catch(Exception& e)
+            {
+                result.error = e.getErrMsg();
+                waitReady(*camera);
+            }
+
+            if(!first_result)
+                out << ",\n";
+
+            writeResult(out, config, result);
+            out.flush();
+            first_result = false;
+
+            fprintf(stderr, "%s %s correction %d buffers %d delay %g ms: %.0f frames/s%s\n",
+                    config.model.c_str(), config.mode->label, config.correction, config.nb_buffers, config.delay_ms,
+                    result.frames_per_s, result.error.empty() ? "" : " (error)");
+        }
+
+        delete hw;
+        delete camera;
+    }
+
+    out << "\n ]}\n";
+    return 0;
+}
@@ -0,0 +1,645 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// ufxc_control_bench: wall time and DAQ transactions of the control
+// path (Camera setters, Lima sync setters and a prepareAcq/startAcq/
+// stopAcq cycle) with the detector simulator. The results are written
+// as JSON.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lima/Exceptions.h"
+#include "lima/HwFrameCallback.h"
+#include "UfxcCamera.h"
+#include "UfxcInterface.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+#define BENCH_STRING(x)  #x
+#define BENCH_XSTRING(x) BENCH_STRING(x)
+
+// exposure time of the acquisition cycles (in s), one frame each
+static const double BENCH_CYCLE_EXPOSURE_S= 1e-4;
+// time given to the camera to come back to Ready (in s)
+static const double BENCH_READY_TIMEOUT_S = 5.0;
+// polling period of the bench (in us)
+static const int    BENCH_POLL_US         = 100;
+
+/*******************************************************************
+ * \struct ControlContext
+ * \brief objects used by the measured operations
+ *******************************************************************/
+struct ControlContext
+{
+    Interface *     hw    ;
+    Camera *        camera;
+    HwSyncCtrlObj * sync  ;
+};
+
+/*******************************************************************
+ * \struct ControlOperation
+ * \brief one measured call, the iteration alternates two values
+ *        so the registers really change
+ *******************************************************************/
+struct ControlOperation
+{
+    const char * name;
+    void      (* run)(ControlContext& context, int iteration);
+};
+
+static void runCamExpTime    (ControlContext& c, int i) { c.camera->setExpTime((i & 1) ? 2e-3 : 1e-3); }
+static void runCamLatTime    (ControlContext& c, int i) { c.camera->setLatTime((i & 1) ? 1e-4 : 0.0); }
+static void runCamNbFrames   (ControlContext& c, int i) { c.camera->setNbFrames((i & 1) ? 11 : 10); }
+static void runCamTrigMode   (ControlContext& c, int i) { c.camera->setTrigMode((i & 1) ? ExtTrigSingle : IntTrig); }
+static void runCamCountMode  (ControlContext& c, int i) { c.camera->setCountingMode((i & 1) ? Camera::Continuous_14 : Camera::Standard_14); }
+static void runCamCorrection (ControlContext& c, int i) { c.camera->setGeometricalCorrection((i & 1) != 0); }
+static void runCamLow1       (ControlContext& c, int i) { c.camera->set_threshold_Low1 ((i & 1) ? 11.0f : 10.0f); }
+static void runCamLow2       (ControlContext& c, int i) { c.camera->set_threshold_Low2 ((i & 1) ? 11.0f : 10.0f); }
+static void runCamHigh1      (ControlContext& c, int i) { c.camera->set_threshold_High1((i & 1) ? 41.0f : 40.0f); }
+static void runCamHigh2      (ControlContext& c, int i) { c.camera->set_threshold_High2((i & 1) ? 41.0f : 40.0f); }
+static void runCamFrequency  (ControlContext& c, int i) { c.camera->set_pump_probe_trigger_acquisition_frequency((i & 1) ? 2000.0f : 1000.0f); }
+static void runSyncExpTime   (ControlContext& c, int i) { c.sync->setExpTime((i & 1) ? 2e-3 : 1e-3); }
+static void runSyncLatTime   (ControlContext& c, int i) { c.sync->setLatTime((i & 1) ? 1e-4 : 0.0); }
+static void runSyncNbFrames  (ControlContext& c, int i) { c.sync->setNbHwFrames((i & 1) ? 11 : 10); }
+static void runSyncTrigMode  (ControlContext& c, int i) { c.sync->setTrigMode((i & 1) ? ExtTrigSingle : IntTrig); }
+
+static void runSyncValidRanges(ControlContext& c, int /*i*/)
+{
+    HwSyncCtrlObj::ValidRangesType valid_ranges;
+    c.sync->getValidRanges(valid_ranges);
+}
+
+// setters of a step scan point, as called by the Lima control
+static void runScanPoint(ControlContext& c, int i)
+{
+    c.sync->setTrigMode(IntTrig);
+    c.sync->setExpTime((i & 1) ? 2e-3 : 1e-3);
+    c.sync->setNbHwFrames(1);
+}
+
+static const ControlOperation BENCH_OPERATIONS[] =
+{
+    { "Camera::setExpTime"                                   , runCamExpTime     },
+    { "Camera::setLatTime"                                   , runCamLatTime     },
+    { "Camera::setNbFrames"                                  , runCamNbFrames    },
+    { "Camera::setTrigMode"                                  , runCamTrigMode    },
+    { "Camera::setCountingMode"                              , runCamCountMode   },
+    { "Camera::setGeometricalCorrection"                     , runCamCorrection  },
+    { "Camera::set_threshold_Low1"                           , runCamLow1        },
+    { "Camera::set_threshold_Low2"                           , runCamLow2        },
+    { "Camera::set_threshold_High1"                          , runCamHigh1       },
+    { "Camera::set_threshold_High2"                          , runCamHigh2       },
+    { "Camera::set_pump_probe_trigger_acquisition_frequency" , runCamFrequency   },
+    { "SyncCtrlObj::setExpTime"                              , runSyncExpTime    },
+    { "SyncCtrlObj::setLatTime"                              , runSyncLatTime    },
+    { "SyncCtrlObj::setNbHwFrames"                           , runSyncNbFrames   },
+    { "SyncCtrlObj::setTrigMode"                             , runSyncTrigMode   },
+    { "SyncCtrlObj::getValidRanges"                          , runSyncValidRanges},
+    { "scan point (setTrigMode, setExpTime, setNbHwFrames)"  , runScanPoint      },
+};
+
+/*******************************************************************
+ * \struct BenchConfig
+ * \brief one configuration of the sweep
+ *******************************************************************/
+struct BenchConfig
+{
+    std::string model           ;
+    double      transaction_ms  ; // simulated round trip
+    bool        register_cache  ;
+    bool        deferred_writes ;
+    int         nb_iterations   ;
+};
+
+/*******************************************************************
+ * \class OperationResult
+ * \brief wall times and transactions of the calls of an operation
+ *******************************************************************/
+class OperationResult
+{
+public:
+    explicit OperationResult(const std::string& name = std::string()) :
+    m_name(name), m_nb_reads(0), m_nb_writes(0), m_error() {}
+
+    void add(double time, unsigned long nb_reads, unsigned long nb_writes)
+    {
+        m_times.push_back(time);
+        m_nb_reads  += nb_reads ;
+        m_nb_writes += nb_writes;
+    }
+
+    void setError(const std::string& error) { m_error = error; }
+
+    const std::string& getName () const { return m_name ; }
+    const std::string& getError() const { return m_error; }
+    std::size_t        getNbCalls() const { return m_times.size(); }
+
+    // times in us, transactions per call
+    void getStats(double& mean, double& p50, double& p99, double& max, double& reads, double& writes) const;
+
+private:
+    std::string         m_name     ;
+    std::vector<double> m_times    ; // s
+    unsigned long       m_nb_reads ;
+    unsigned long       m_nb_writes;
+    std::string         m_error    ;
+};
+
+/*******************************************************************
+ * \class NullConsumer
+ * \brief accepts the frames of the acquisition cycles
+ *******************************************************************/
+class NullConsumer : public HwFrameCallback
+{
+protected:
+    virtual bool newFrameReady(const HwFrameInfoType& /*frame_info*/) { return true; }
+};
+
+//-----------------------------------------------------
+// monotonic, the setters with a cache last less than a microsecond
+//-----------------------------------------------------
+static double getTime()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//-----------------------------------------------------
+// nearest rank
+//-----------------------------------------------------
+static double getPercentile(const std::vector<double>& sorted, double percentile)
+{
+    if(sorted.empty())
+        return 0.0;
+
+    std::size_t rank = static_cast<std::size_t>(ceil(percentile * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank ? rank - 1 : 0)];
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void OperationResult::getStats(double& mean, double& p50, double& p99, double& max, double& reads, double& writes) const
+{
+    std::vector<double> sorted(m_times);
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+
+    for(std::size_t index = 0 ; index < sorted.size() ; index++)
+        sum += sorted[index];
+
+    double nb_calls = static_cast<double>(std::max<std::size_t>(1, sorted.size()));
+
+    mean   = sum / nb_calls * 1e6;
+    p50    = getPercentile(sorted, 0.50) * 1e6;
+    p99    = getPercentile(sorted, 0.99) * 1e6;
+    max    = sorted.empty() ? 0.0 : sorted.back() * 1e6;
+    reads  = m_nb_reads  / nb_calls;
+    writes = m_nb_writes / nb_calls;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static std::vector<std::string> splitList(const std::string& text)
+{
+    std::vector<std::string> items;
+    std::istringstream       stream(text);
+    std::string              item;
+
+    while(std::getline(stream, item, ','))
+    {
+        if(!item.empty())
+            items.push_back(item);
+    }
+
+    return items;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void waitReady(Camera& camera)
+{
+    double         deadline = getTime() + BENCH_READY_TIMEOUT_S;
+    Camera::Status status;
+
+    camera.getStatus(status);
+
+    while((status == Camera::Busy) && (getTime() < deadline))
+    {
+        usleep(BENCH_POLL_US);
+        camera.getStatus(status);
+    }
+}
+
+//-----------------------------------------------------
+// the same state before each operation, not measured
+//-----------------------------------------------------
+static void applyBaseline(ControlContext& context)
+{
+    context.camera->setImageType(Bpp14);
+    context.camera->setCountingMode(Camera::Standard_14);
+    context.camera->setGeometricalCorrection(false);
+    context.sync->setTrigMode(IntTrig);
+    context.sync->setExpTime(BENCH_CYCLE_EXPOSURE_S);
+    context.sync->setLatTime(0.0);
+    context.sync->setNbHwFrames(1);
+}
+
+//-----------------------------------------------------
+// the transactions of a call are the ones received by the simulator meanwhile
+//-----------------------------------------------------
+static void measure(ControlContext& context, const ControlOperation& operation, int nb_iterations, OperationResult& result)
+{
+    for(int iteration = 0 ; iteration < nb_iterations ; iteration++)
+    {
+        unsigned long reads_before, writes_before, reads_after, writes_after;
+
+        context.camera->getSimulatorTransactionStats(reads_before, writes_before);
+        double start = getTime();
+
+        operation.run(context, iteration);
+
+        double end = getTime();
+        context.camera->getSimulatorTransactionStats(reads_after, writes_after);
+
+        result.add(end - start, reads_after - reads_before, writes_after - writes_before);
+    }
+}
+
+//-----------------------------------------------------
+// prepareAcq, startAcq, end of the frame, stopAcq
+//-----------------------------------------------------
+static void measureCycles(ControlContext& context, int nb_iterations, std::vector<OperationResult>& results)
+{
+    HwBufferCtrlObj * buffer;
+    NullConsumer      consumer;
+    ImageType         image_type;
+    Size              image_size;
+
+    context.hw->getHwCtrlObj(buffer);
+    context.camera->getDetectorImageSize(image_size);
+    context.camera->getImageType(image_type);
+
+    buffer->setFrameDim(FrameDim(image_size, image_type));
+    buffer->setNbConcatFrames(1);
+    buffer->setNbBuffers(4);
+    buffer->registerFrameCallback(consumer);
+
+    OperationResult prepare("Interface::prepareAcq");
+    OperationResult start  ("Interface::startAcq"  );
+    OperationResult stop   ("Interface::stopAcq"   );
+    OperationResult cycle  ("prepareAcq + startAcq + stopAcq");
+
+    try
+    {
+        for(int iteration = 0 ; iteration < nb_iterations ; iteration++)
+        {
+            unsigned long reads[4], writes[4];
+            double        times[4];
+
+            context.camera->getSimulatorTransactionStats(reads[0], writes[0]);
+            times[0] = getTime();
+            context.hw->prepareAcq();
+            times[1] = getTime();
+            context.camera->getSimulatorTransactionStats(reads[1], writes[1]);
+
+            context.hw->startAcq();
+            times[2] = getTime();
+            context.camera->getSimulatorTransactionStats(reads[2], writes[2]);
+
+            waitReady(*context.camera);
+
+            unsigned long reads_ready, writes_ready;
+            context.camera->getSimulatorTransactionStats(reads_ready, writes_ready);
+            double ready = getTime();
+
+            context.hw->stopAcq();
+            times[3] = getTime();
+            context.camera->getSimulatorTransactionStats(reads[3], writes[3]);
+
+            prepare.add(times[1] - times[0], reads[1] - reads[0], writes[1] - writes[0]);
+            start  .add(times[2] - times[1], reads[2] - reads[1], writes[2] - writes[1]);
+            stop   .add(times[3] - ready   , reads[3] - reads_ready, writes[3] - writes_ready);
+
+            // without the frame itself
+            cycle.add((times[2] - times[0]) + (times[3] - ready),
+                      (reads [2] - reads [0]) + (reads [3] - reads_ready),
+                      (writes[2] - writes[0]) + (writes[3] - writes_ready));
+        }
+    }
+    catch(Exception& e)
+    {
+        cycle.setError(e.getErrMsg());
+        waitReady(*context.camera);
+    }
+
+    buffer->unregisterFrameCallback(consumer);
+
+    results.push_back(prepare);
+    results.push_back(start  );
+    results.push_back(stop   );
+    results.push_back(cycle  );
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void runConfig(ControlContext& context, const BenchConfig& config, std::vector<OperationResult>& results)
+{
+    context.camera->setRegisterCacheEnabled(config.register_cache);
+    context.camera->setDeferredRegisterWrites(config.deferred_writes);
+    context.camera->setSimulatorTransactionTime(config.transaction_ms);
+
+    for(std::size_t index = 0 ; index < sizeof(BENCH_OPERATIONS) / sizeof(BENCH_OPERATIONS[0]) ; index++)
+    {
+        OperationResult result(BENCH_OPERATIONS[index].name);
+
+        try
+        {
+            applyBaseline(context);
+            measure(context, BENCH_OPERATIONS[index], config.nb_iterations, result);
+        }
+        catch(Exception& e)
+        {
+            result.setError(e.getErrMsg());
+        }
+
+        results.push_back(result);
+    }
+
+    try
+    {
+        applyBaseline(context);
+        measureCycles(context, config.nb_iterations, results);
+    }
+    catch(Exception& e)
+    {
+        OperationResult result("prepareAcq + startAcq + stopAcq");
+        result.setError(e.getErrMsg());
+        results.push_back(result);
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static std::string getHostName()
+{
+    char name[256];
+
+    if(gethostname(name, sizeof(name)) != 0)
+        return "unknown";
+
+    name[sizeof(name) - 1] = '\0';
+    return name;
+}
+
+//-----------------------------------------------------
+// the labels and messages have no control characters
+//-----------------------------------------------------
+static std::string quote(const std::string& text)
+{
+    std::string quoted("\"");
+
+    for(std::size_t index = 0 ; index < text.size() ; index++)
+    {
+        char character = text[index];
+
+        if((character == '"') || (character == '\\'))
+            quoted += '\\';
+
+        quoted += ((character == '\n') || (character == '\r')) ? ' ' : character;
+    }
+
+    return quoted + "\"";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void writeResult(std::ostream& out, const BenchConfig& config, const OperationResult& result)
+{
+    double mean, p50, p99, max, reads, writes;
+    result.getStats(mean, p50, p99, max, reads, writes);
+
+    out << "    {\"model\": "                  << quote(config.model)
+        << ", \"transaction_time_ms\": "       << config.transaction_ms
+        << ", \"register_cache\": "            << (config.register_cache  ? "true" : "false")
+        << ", \"deferred_writes\": "           << (config.deferred_writes ? "true" : "false")
+        << ",\n     \"operation\": "           << quote(result.getName())
+        << ", \"calls\": "                     << result.getNbCalls()
+        << ", \"time_us\": {\"mean\": "        << mean
+        << ", \"p50\": "                       << p50
+        << ", \"p99\": "                       << p99
+        << ", \"max\": "                       << max << "}"
+        << ", \"daq_reads_per_call\": "        << reads
+        << ", \"daq_writes_per_call\": "       << writes
+        << ", \"error\": "                     << (result.getError().empty() ? std::string("null") : quote(result.getError()))
+        << "}";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void usage(const char * program)
+{
+    fprintf(stderr,
+            "usage: %s [options], the lists are comma separated\n"
+            "  --model <label>        SIMULATOR label (default: SIMULATOR)\n"
+            "  --transactions <list>  simulated round trip of a DAQ transaction in ms (default: 0,0.2)\n"
+            "  --caches <list>        register cache 0/1 (default: 0,1)\n"
+            "  --deferred <list>      register writes deferred to prepareAcq 0/1 (default: 0,1)\n"
+            "  --iterations <nb>      calls of each operation (default: 200)\n"
+            "  --status-period <ms>   period of the status monitor, its reads are counted (default: 60000)\n"
+            "  --output <file>        JSON results (default: standard output)\n",
+            program);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int main(int argc, char ** argv)
+{
+    static const struct option options[] =
+    {
+        { "model"        , required_argument, NULL, 'm' },
+        { "transactions" , required_argument, NULL, 't' },
+        { "caches"       , required_argument, NULL, 'c' },
+        { "deferred"     , required_argument, NULL, 'd' },
+        { "iterations"   , required_argument, NULL, 'n' },
+        { "status-period", required_argument, NULL, 's' },
+        { "output"       , required_argument, NULL, 'o' },
+        { "help"         , no_argument      , NULL, 'h' },
+        { NULL           , 0                , NULL, 0   }
+    };
+
+    std::string              model         = "SIMULATOR";
+    std::vector<std::string> transactions  = splitList("0,0.2");
+    std::vector<std::string> caches        = splitList("0,1");
+    std::vector<std::string> deferred      = splitList("0,1");
+    int                      nb_iterations = 200;
+    double                   status_period = 60000.0;
+    std::string              output;
+    int                      option;
+
+    while((option = getopt_long(argc, argv, "h", options, NULL)) != -1)
+    {
+        switch(option)
+        {
+            case 'm': model         = optarg; break;
+            case 't': transactions  = splitList(optarg); break;
+            case 'c': caches        = splitList(optarg); break;
+            case 'd': deferred      = splitList(optarg); break;
+            case 'n': nb_iterations = atoi(optarg); break;
+            case 's': status_period = atof(optarg); break;
+            case 'o': output        = optarg; break;
+            default : usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    if((nb_iterations <= 0) || (status_period <= 0.0))
+    {
+        fprintf(stderr, "Incorrect iterations number or status period\n");
+        return 1;
+    }
+
+    if(!DetectorSimulator::isSimulatorModel(model))
+    {
+        // the transactions are counted by the simulator
+        fprintf(stderr, "Not a simulator model: %s\n", model.c_str());
+        return 1;
+    }
+
+    std::ofstream file;
+
+    if(!output.empty())
+    {
+        file.open(output.c_str());
+
+        if(!file)
+        {
+            fprintf(stderr, "Can not write %s\n", output.c_str());
+            return 1;
+        }
+    }
+
+    Camera *        camera = NULL;
+    Interface *     hw     = NULL;
+    ControlContext  context;
+
+    try
+    {
+        // the simulator has no network links
+        camera = new Camera(model, "127.0.0.1", 0, "127.0.0.1", 0, "127.0.0.1", 0, "127.0.0.1", 0,
+                            9000, 1000, 14, "STANDARD_14");
+        hw     = new Interface(*camera);
+
+        camera->setStatusRefreshPeriod(status_period);
+
+        context.hw     = hw;
+        context.camera = camera;
+        hw->getHwCtrlObj(context.sync);
+    }
+    catch(Exception& e)
+    {
+        fprintf(stderr, "Can not create the camera %s: %s\n", model.c_str(), e.getErrMsg().c_str());
+        delete hw;
+        delete camera;
+        return 1;
+    }
+
+    std::ostream& out = output.empty() ? std::cout : file;
+    time_t        now = time(NULL);
+    char          date[32];
+
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    out << "{\"host\": " << quote(getHostName()) << ", \"plugin_version\": " << quote(BENCH_XSTRING(UFXC_VERSION))
+        << ", \"date\": " << quote(date) << ", \"status_period_ms\": " << status_period << ",\n \"results\": [\n";
+
+    bool first_result = true;
+
+    for(std::size_t transaction = 0 ; transaction < transactions.size() ; transaction++)
+    for(std::size_t cache = 0 ; cache < caches.size() ; cache++)
+    for(std::size_t defer = 0 ; defer < deferred.size() ; defer++)
+    {
+        BenchConfig                  config;
+        std::vector<OperationResult> results;
+
+        config.model           = model;
+        config.transaction_ms  = atof(transactions[transaction].c_str());
+        config.register_cache  = atoi(caches[cache].c_str()) != 0;
+        config.deferred_writes = atoi(deferred[defer].c_str()) != 0;
+        config.nb_iterations   = nb_iterations;
+
+        try
+        {
+            runConfig(context, config, results);
+        }
+        catch(Exception& e)
+        {
+            OperationResult result("configuration");
+            result.setError(e.getErrMsg());
+            results.push_back(result);
+        }
+
+        for(std::size_t index = 0 ; index < results.size() ; index++)
+        {
+            if(!first_result)
+                out << ",\n";
+
+            writeResult(out, config, results[index]);
+            first_result = false;
+
+            double mean, p50, p99, max, reads, writes;
+            results[index].getStats(mean, p50, p99, max, reads, writes);
+
+            fprintf(stderr, "transaction %g ms cache %d deferred %d %-56s %10.1f us %6.2f reads %6.2f writes%s\n",
+                    config.transaction_ms, config.register_cache, config.deferred_writes, results[index].getName().c_str(),
+                    mean, reads, writes, results[index].getError().empty() ? "" : " (error)");
+        }
+
+        out.flush();
+    }
+
+    out << "\n ]}\n";
+
+    delete hw;
+    delete camera;
+    return 0;
+}
@@ -0,0 +1,252 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2014
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+//
+// ufxc_packet_generator: sends the UFXC frames of the detector simulator
+// on the three SFP UDP streams, and answers the TCP configuration port.
+// The wire formats are pluggable (UfxcWireFormat.h): the stand-in ones
+// are not the UFXC formats and are not understood by ufxclib.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+#include "lima/Exceptions.h"
+#include "lima/Timestamp.h"
+#include "UfxcPacketGenerator.h"
+
+using namespace lima;
+using namespace lima::Ufxc;
+
+static volatile sig_atomic_t g_interrupted = 0;
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void onSignal(int /*signal*/)
+{
+    g_interrupted = 1;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static std::string joinNames(const std::vector<std::string>& names)
+{
+    std::string text;
+
+    for(std::size_t index = 0 ; index < names.size() ; index++)
+        text += ((index > 0) ? ", " : "") + names[index];
+
+    return text;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void usage(const char * program)
+{
+    fprintf(stderr,
+            "usage: %s --wire-format <name> --sfp1 <ip:port> --sfp2 <ip:port> --sfp3 <ip:port> [options]\n"
+            "  --wire-format <name>        packets format, no default (%s)\n"
+            "  --tcp-port <port>           register server port (default: none)\n"
+            "  --register-protocol <name>  register server protocol, no default (%s)\n"
+            "  --model <label>             SIMULATOR or SIMULATOR_<width>x<height> (default: SIMULATOR)\n"
+            "  --depth <bits>              2, 4, 8, 14, 28 or 32 (default: 14)\n"
+            "  --mtu <bytes>               SFP MTU (default: 9000)\n"
+            "  --rate <Hz>                 frame rate (default: 1000)\n"
+            "  --frames <nb>               frames to send, 0 until interrupted (default: 0)\n"
+            "  --loss <p>                  probability of a dropped packet (default: 0)\n"
+            "  --reorder <nb>              packets shuffled together (default: 1, in order)\n"
+            "  --occupancy <f>             fraction of the pixels with counts (default: 0.02)\n"
+            "  --period <s>                statistics period (default: 1)\n"
+            "warning: the stand-in formats are not understood by ufxclib\n",
+            program,
+            joinNames(PacketFormat::getNames()).c_str(),
+            joinNames(RegisterProtocol::getNames()).c_str());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static bool parseAddress(const char * text, std::string& host, int& port)
+{
+    const char * separator = strrchr(text, ':');
+
+    if(separator == NULL)
+        return false;
+
+    host = std::string(text, separator - text);
+    port = atoi(separator + 1);
+    return (!host.empty()) && (port > 0);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+static void printStats(const PacketGenerator& generator, LinkStats (&previous)[PACKET_GENERATOR_NB_LINKS], double elapsed)
+{
+    for(int link = 0 ; link < PACKET_GENERATOR_NB_LINKS ; link++)
+    {
+        LinkStats stats = generator.getLinkStats(link);
+        double    gbps  = (elapsed > 0.0) ? (stats.nb_bytes - previous[link].nb_bytes) * 8e-9 / elapsed : 0.0;
+
+        printf("SFP%d: frames %zu - packets %zu - dropped %zu - errors %zu - %.3f Gbit/s\n",
+               link + 1, stats.nb_frames, stats.nb_packets, stats.nb_dropped, stats.nb_errors, gbps);
+        previous[link] = stats;
+    }
+
+    fflush(stdout);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int main(int argc, char ** argv)
+{
+    static const struct option options[] =
+    {
+        { "wire-format"      , required_argument, NULL, 'w' },
+        { "sfp1"             , required_argument, NULL, '1' },
+        { "sfp2"             , required_argument, NULL, '2' },
+        { "sfp3"             , required_argument, NULL, '3' },
+        { "tcp-port"         , required_argument, NULL, 't' },
+        { "register-protocol", required_argument, NULL, 'g' },
+        { "model"            , required_argument, NULL, 'm' },
+        { "depth"            , required_argument, NULL, 'd' },
+        { "mtu"              , required_argument, NULL, 'u' },
+        { "rate"             , required_argument, NULL, 'r' },
+        { "frames"           , required_argument, NULL, 'n' },
+        { "loss"             , required_argument, NULL, 'l' },
+        { "reorder"          , required_argument, NULL, 'o' },
+        { "occupancy"        , required_argument, NULL, 'c' },
+        { "period"           , required_argument, NULL, 'p' },
+        { "help"             , no_argument      , NULL, 'h' },
+        { NULL               , 0                , NULL, 0   }
+    };
+
+    PacketGeneratorConfig config;
+    std::string           protocol;
+    int                   tcp_port = 0;
+    double                period   = 1.0;
+    int                   option;
+
+    while((option = getopt_long(argc, argv, "h", options, NULL)) != -1)
+    {
+        switch(option)
+        {
+            case '1':
+            case '2':
+            case '3':
+            {
+                int link = option - '1';
+
+                if(!parseAddress(optarg, config.hosts[link], config.ports[link]))
+                {
+                    fprintf(stderr, "Incorrect address of the SFP%d: %s\n", link + 1, optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'w': config.wire_format    = optarg; break;
+            case 't': tcp_port              = atoi(optarg); break;
+            case 'g': protocol              = optarg; break;
+            case 'm': config.model          = optarg; break;
+            case 'd': config.depth          = atoi(optarg); break;
+            case 'u': config.mtu            = strtoul(optarg, NULL, 10); break;
+            case 'r': config.frame_rate     = atof(optarg); break;
+            case 'n': config.nb_frames      = strtoul(optarg, NULL, 10); break;
+            case 'l': config.loss           = atof(optarg); break;
+            case 'o': config.reorder_window = atoi(optarg); break;
+            case 'c': config.occupancy      = atof(optarg); break;
+            case 'p': period                = atof(optarg); break;
+            default : usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    if(config.wire_format.empty())
+    {
+        fprintf(stderr, "Missing --wire-format (%s)\n", joinNames(PacketFormat::getNames()).c_str());
+        return 1;
+    }
+
+    if((tcp_port > 0) && (protocol.empty()))
+    {
+        fprintf(stderr, "Missing --register-protocol (%s)\n", joinNames(RegisterProtocol::getNames()).c_str());
+        return 1;
+    }
+
+    if(period <= 0.0)
+    {
+        fprintf(stderr, "Incorrect statistics period: %g\n", period);
+        return 1;
+    }
+
+    signal(SIGINT , onSignal);
+    signal(SIGTERM, onSignal);
+
+    try
+    {
+        RegisterServer  server;
+        PacketGenerator generator;
+        LinkStats       previous[PACKET_GENERATOR_NB_LINKS];
+
+        memset(previous, 0, sizeof(previous));
+
+        if(tcp_port > 0)
+            server.start(tcp_port, protocol);
+
+        generator.start(config);
+
+        double last_print = Timestamp::now();
+
+        while((!g_interrupted) && (generator.isRunning()))
+        {
+            usleep(10000);
+
+            double now = Timestamp::now();
+
+            if(now - last_print >= period)
+            {
+                printStats(generator, previous, now - last_print);
+                last_print = now;
+            }
+        }
+
+        printStats(generator, previous, double(Timestamp::now()) - last_print);
+        generator.stop();
+        server.stop();
+
+        if(tcp_port > 0)
+            printf("register requests: %zu\n", server.getNbRequests());
+    }
+    catch(Exception& e)
+    {
+        fprintf(stderr, "%s\n", e.getErrMsg().c_str());
+        return 1;
+    }
+
+    return 0;
+}